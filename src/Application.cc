@@ -237,9 +237,9 @@ void Application::updateHierarchyEvents() {
   }};
   for (auto &fn : events.droppedFilenames()) {
     if (auto const ext{get_extension(fn)}; MeshDataManager::CheckExtension(ext)) {
-      if (auto entity = scene.importModel(fn); entity) {
+      scene.importModelAsync(fn, [this](EntityHandle entity) {
         entity->setPosition( camera_.target() );
-      }
+      });
     }
   }
 }
@@ -24,6 +24,7 @@ App::~App() {
   }
 
   // Resources.
+  Resources::Deinitialize();
   Assets::ReleaseAll();
   Resources::ReleaseAll();
 
@@ -63,6 +64,9 @@ int32_t App::run(std::string_view title) {
 
     // Resources watchers for live-reload.
     Resources::WatchUpdate(Assets::UpdateAll);    
+
+    // Finalize resources loaded in the background.
+    Resources::UpdateAsync();
     
     // Update User interface.
     ui_controller_.update(window_); //
@@ -101,6 +105,9 @@ bool App::presetup(std::string_view title) {
   Logger::Initialize();
   Events::Initialize(); //
 
+  // Background resources loader.
+  Resources::Initialize();
+
   // Register the app for events callbacks dispatch.
   Events::Get().registerCallbacks(this);
 
@@ -143,6 +150,9 @@ bool App::presetup(std::string_view title) {
     if (auto ui = renderer_.particle().ui_view; ui) {
       ui_mainview_->push_view( ui );
     }
+    if (auto ui = scene_.animation().ui_view; ui) {
+      ui_mainview_->push_view( ui );
+    }
   }
 
   return true;
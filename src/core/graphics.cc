@@ -2,6 +2,8 @@
 
 #include <array>
 #include <algorithm>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "glm/glm.hpp"
@@ -203,6 +205,23 @@ void InitializeSamplers() {
   CHECK_GX_ERROR();
 }
 
+// Location and type of a program's active uniform.
+struct UniformInfo_t {
+  int32_t location;
+  uint32_t type;
+};
+
+// Uniforms of a program, by name hash.
+using UniformMap_t = std::unordered_map<size_t, UniformInfo_t>;
+
+// Reflected programs' uniforms, by program id.
+static 
+std::unordered_map<uint32_t, UniformMap_t> sProgramUniforms;
+
+inline size_t HashUniformName(std::string_view name) {
+  return std::hash<std::string_view>{}(name);
+}
+
 }  // namespace gx
 
 
@@ -291,6 +310,8 @@ void Deinitialize() {
   if (sSamplers[0] != 0) {
     glDeleteSamplers( kNumSamplerName, sSamplers.data());
   }
+
+  sProgramUniforms.clear();
 }
 
 void Enable(State cap) {
@@ -430,16 +451,91 @@ void UseProgram(uint32_t pgm) {
 
 void LinkProgram(uint32_t pgm) {
   glLinkProgram(pgm);
+  ReflectProgram(pgm);
+}
+
+void ReflectProgram(uint32_t pgm) {
+  GLint status{0};
+  glGetProgramiv(pgm, GL_LINK_STATUS, &status);
+  if (status != GL_TRUE) {
+    ReleaseProgram(pgm);
+    return;
+  }
+
+  auto &uniforms = sProgramUniforms[pgm];
+  uniforms.clear();
+
+  GLint count{0};
+  GLint max_length{0};
+  glGetProgramInterfaceiv(pgm, GL_UNIFORM, GL_ACTIVE_RESOURCES, &count);
+  glGetProgramInterfaceiv(pgm, GL_UNIFORM, GL_MAX_NAME_LENGTH, &max_length);
+
+  std::string name(static_cast<size_t>(max_length), '\0');
+  std::array<GLenum, 3> const props{ GL_BLOCK_INDEX, GL_LOCATION, GL_TYPE };
+  std::array<GLint, 3> values{};
+
+  for (GLint i = 0; i < count; ++i) {
+    glGetProgramResourceiv( 
+      pgm, GL_UNIFORM, i, props.size(), props.data(), values.size(), nullptr, values.data()
+    );
+
+    // (uniforms in blocks and atomic counters have no location)
+    if ((values[0] != -1) || (values[1] < 0)) {
+      continue;
+    }
+
+    GLsizei length{0};
+    glGetProgramResourceName(pgm, GL_UNIFORM, i, max_length, &length, name.data());
+    std::string_view const uniform_name( name.data(), static_cast<size_t>(length));
+
+    UniformInfo_t const info{ values[1], static_cast<uint32_t>(values[2]) };
+    uniforms[HashUniformName(uniform_name)] = info;
+
+    // Arrays are reported by their first element, also register their base name.
+    constexpr std::string_view kArraySuffix{ "[0]" };
+    if ((uniform_name.size() > kArraySuffix.size())
+     && (uniform_name.substr(uniform_name.size() - kArraySuffix.size()) == kArraySuffix)) {
+      auto const basename = uniform_name.substr(0, uniform_name.size() - kArraySuffix.size());
+      uniforms[HashUniformName(basename)] = info;
+    }
+  }
+
+  CHECK_GX_ERROR();
+}
+
+void ReleaseProgram(uint32_t pgm) {
+  sProgramUniforms.erase(pgm);
 }
 
 int32_t UniformLocation(uint32_t pgm, std::string_view name) {
-  int32_t const loc{ glGetUniformLocation(pgm, name.data()) };
+  auto const query_location = [pgm, &name]() {
+    int32_t const loc{ glGetUniformLocation(pgm, name.data()) };
 #ifndef NDEBUG
-  if (loc < 0) {
-    // TODO : retrieve program's fullname from manager.
-    LOG_WARNING( "Uniform missing :", name );
-  }
+    if (loc < 0) {
+      // TODO : retrieve program's fullname from manager.
+      LOG_WARNING( "Uniform missing :", name );
+    }
 #endif
+    return loc;
+  };
+
+  // (programs linked outside of gx are not cached)
+  auto const it = sProgramUniforms.find(pgm);
+  if (it == sProgramUniforms.end()) {
+    return query_location();
+  }
+
+  auto &uniforms = it->second;
+  auto const hash = HashUniformName(name);
+  if (auto info = uniforms.find(hash); info != uniforms.end()) {
+    return info->second.location;
+  }
+
+  // Names not reflected (eg. array elements) are queried once then cached, 
+  // missing ones included.
+  int32_t const loc{ query_location() };
+  uniforms[hash] = { loc, 0u };
+
   return loc;
 }
 
@@ -148,8 +148,16 @@ void UnbindTexture(int unit = 0);
 
 void UseProgram(uint32_t pgm = 0u);
 
+/* Link a program and reflect its active uniforms. */
 void LinkProgram(uint32_t pgm);
 
+/* Cache the locations of a linked program's active uniforms. */
+void ReflectProgram(uint32_t pgm);
+
+/* Discard the uniforms cache of a program, before its deletion. */
+void ReleaseProgram(uint32_t pgm);
+
+/* Return a uniform location, from the program cache when it was reflected. */
 int32_t UniformLocation(uint32_t pgm, std::string_view name);
 
 int32_t AttribLocation(uint32_t pgm, std::string_view name);
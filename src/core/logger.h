@@ -2,6 +2,7 @@
 #define BARBU_CORE_LOGGER_H_
 
 #include <iostream>
+#include <mutex>
 #include <sstream>
 #include <string>
 #include <string_view>
@@ -24,6 +25,8 @@
 //    * Error      : bold red, hashed, display file and line, used in stats.
 //    * FatalError : flashing red, not hashed, exit program instantly. 
 //
+//  Messages can be logged from worker threads.
+//
 class Logger : public Singleton<Logger> {
   friend class Singleton<Logger>;
 
@@ -50,6 +53,8 @@ class Logger : public Singleton<Logger> {
 
   template<typename T, typename ... Args>
   bool log(char const* file, char const* fn, int line, bool useHash, LogType type, T first, Args ... args) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
     // Clear the local stream and retrieve the full current message.
     out_.str(std::string());
     subLog(first, args ...);
@@ -176,6 +181,7 @@ class Logger : public Singleton<Logger> {
 #endif // NDEBUG
   }
 
+  std::mutex mutex_;
   std::stringstream out_;
   std::unordered_map<std::string, bool> error_log_;
   int32_t warning_count_ = 0;
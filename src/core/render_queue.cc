@@ -0,0 +1,121 @@
+#include "core/render_queue.h"
+
+#include <algorithm>
+#include <array>
+
+// ----------------------------------------------------------------------------
+
+namespace {
+
+using Key_t = RenderQueue::Key_t;
+
+// Bit size of each key field, summing to 64.
+static constexpr int32_t kModeBits     = 2;
+static constexpr int32_t kProgramBits  = 10;
+static constexpr int32_t kVariantBits  = 2;
+static constexpr int32_t kMaterialBits = 12;
+static constexpr int32_t kMeshBits     = 14;
+static constexpr int32_t kSubmeshBits  = 6;
+static constexpr int32_t kDepthBits    = 18;
+
+static constexpr int32_t kModeShift = 64 - kModeBits;
+
+// Radix sort digits.
+static constexpr int32_t kDigitBits = 8;
+static constexpr int32_t kNumDigits = 64 / kDigitBits;
+static constexpr int32_t kNumBuckets = 1 << kDigitBits;
+
+/// Truncate a value to the bit size of its field.
+inline Key_t Field(uint32_t const value, int32_t const nbits) {
+  return static_cast<Key_t>(value) & ((Key_t(1) << nbits) - 1u);
+}
+
+} // namespace
+
+// ----------------------------------------------------------------------------
+
+void RenderQueue::clear() {
+  records_.clear();
+  entries_.clear();
+}
+
+void RenderQueue::push(RenderMode const render_mode, float const depth, DrawRecord_t const& record) {
+  entries_.push_back({ MakeKey(render_mode, depth, record), static_cast<int32_t>(records_.size()) });
+  records_.push_back(record);
+}
+
+void RenderQueue::sort() {
+  int32_t const nentries = size();
+  if (nentries < 2) {
+    return;
+  }
+
+  // Count every digits at once.
+  std::array<std::array<int32_t, kNumBuckets>, kNumDigits> histograms{};
+  for (auto const& entry : entries_) {
+    for (int32_t d = 0; d < kNumDigits; ++d) {
+      ++histograms[d][(entry.key >> (d * kDigitBits)) & (kNumBuckets - 1)];
+    }
+  }
+
+  // Stable scatter digit by digit, from the least significant.
+  scratch_.resize(nentries);
+  for (int32_t d = 0; d < kNumDigits; ++d) {
+    auto &histogram = histograms[d];
+    int32_t const shift = d * kDigitBits;
+
+    // (the digit is the same for all keys)
+    if (histogram[(entries_[0].key >> shift) & (kNumBuckets - 1)] == nentries) {
+      continue;
+    }
+
+    int32_t offset = 0;
+    for (auto &count : histogram) {
+      int32_t const n = count;
+      count = offset;
+      offset += n;
+    }
+    for (auto const& entry : entries_) {
+      scratch_[histogram[(entry.key >> shift) & (kNumBuckets - 1)]++] = entry;
+    }
+    entries_.swap(scratch_);
+  }
+}
+
+RenderQueue::Range_t RenderQueue::range(RenderMode const render_mode) const {
+  // (render modes are fewer than 4, hence the next mode key never overflows)
+  Key_t const mode = static_cast<Key_t>(render_mode);
+
+  auto compare = [](Entry_t const& entry, Key_t const key) {
+    return entry.key < key;
+  };
+  auto first = std::lower_bound(entries_.cbegin(), entries_.cend(), mode << kModeShift, compare);
+  auto last  = std::lower_bound(first, entries_.cend(), (mode + 1u) << kModeShift, compare);
+
+  Entry_t const* data = entries_.data();
+  return { data + (first - entries_.cbegin()), data + (last - entries_.cbegin()) };
+}
+
+RenderQueue::Key_t RenderQueue::MakeKey(RenderMode const render_mode, float const depth, DrawRecord_t const& record) {
+  Key_t const mode     = Field(static_cast<uint32_t>(render_mode), kModeBits);
+  Key_t const program  = Field(record.material->program()->id, kProgramBits);
+  Key_t const variant  = Field(static_cast<uint32_t>(record.variant()), kVariantBits);
+  Key_t const material = Field(record.material->uid(), kMaterialBits);
+  Key_t const mesh     = Field(record.mesh->uid(), kMeshBits);
+  Key_t const submesh  = Field(static_cast<uint32_t>(record.submesh), kSubmeshBits);
+
+  Key_t const kMaxDepth = (Key_t(1) << kDepthBits) - 1u;
+  Key_t quantized = static_cast<Key_t>(glm::clamp(depth, 0.0f, 1.0f) * static_cast<float>(kMaxDepth));
+
+  // State first, front to back.
+  Key_t const state = (((((program << kVariantBits | variant) << kMaterialBits | material) << kMeshBits) | mesh) << kSubmeshBits) | submesh;
+  if (RenderMode::Transparent != render_mode) {
+    return (mode << kModeShift) | (state << kDepthBits) | quantized;
+  }
+
+  // Back to front, then state.
+  quantized = kMaxDepth - quantized;
+  return (mode << kModeShift) | (quantized << (kModeShift - kDepthBits)) | state;
+}
+
+// ----------------------------------------------------------------------------
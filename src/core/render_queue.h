@@ -0,0 +1,102 @@
+#ifndef BARBU_CORE_RENDER_QUEUE_H_
+#define BARBU_CORE_RENDER_QUEUE_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "ecs/material.h"
+#include "memory/assets/mesh.h"
+
+// ----------------------------------------------------------------------------
+
+//
+// Submesh draws of a frame, sorted by packed 64-bit keys.
+//
+// Each draw is stored as a POD record referenced by a key packing, from its most
+// significant bits : its render mode, program, skinning variant, material, mesh
+// and submesh, then its quantized view depth. Sorted draws hence minimize the
+// state changes, are front to back for a given state and instances of the same
+// submesh follow each other. Transparent keys put their
+// reversed depth right after the render mode, to be drawn back to front.
+//
+// Keys are sorted each frame by a least significant digit radix sort, skipping
+// the digits shared by every keys.
+//
+class RenderQueue {
+ public:
+  using Key_t = uint64_t;
+
+  // Plain description of a draw.
+  struct DrawRecord_t {
+    Material *material;
+    Mesh const* mesh;
+    glm::mat4 const* world;
+    int32_t submesh;
+    int32_t skinning_offset;        //< first palette texel, -1 when unskinned
+    SkinningMode skinning_mode;
+
+    /* Program variant used by the draw, depending on its skinning. */
+    inline int32_t variant() const noexcept {
+      return (skinning_offset > -1) ? 1 + static_cast<int32_t>(skinning_mode) : 0;
+    }
+  };
+
+  struct Entry_t {
+    Key_t key;
+    int32_t record;
+  };
+
+  // Sorted entries of a single render mode.
+  struct Range_t {
+    Entry_t const* first;
+    Entry_t const* last;
+
+    inline Entry_t const* begin() const noexcept { return first; }
+    inline Entry_t const* end() const noexcept { return last; }
+    inline bool empty() const noexcept { return first == last; }
+  };
+
+ public:
+  RenderQueue() = default;
+
+  void clear();
+
+  /* Add a draw with its view depth normalized to [0, 1]. */
+  void push(RenderMode const render_mode, float const depth, DrawRecord_t const& record);
+
+  /* Sort the draws by their key. */
+  void sort();
+
+  /* Return the sorted draws of a render mode. */
+  Range_t range(RenderMode const render_mode) const;
+
+  /* Return every sorted draws. */
+  inline Range_t entries() const noexcept {
+    return { entries_.data(), entries_.data() + entries_.size() };
+  }
+
+  inline DrawRecord_t const& record(Entry_t const& entry) const noexcept {
+    return records_[entry.record];
+  }
+
+  /* Return the position of a draw in the sorted draws. */
+  inline int32_t index(Entry_t const& entry) const noexcept {
+    return static_cast<int32_t>(&entry - entries_.data());
+  }
+
+  inline int32_t size() const noexcept {
+    return static_cast<int32_t>(entries_.size());
+  }
+
+ private:
+  /* Pack the sorting key of a draw. */
+  static Key_t MakeKey(RenderMode const render_mode, float const depth, DrawRecord_t const& record);
+
+  std::vector<DrawRecord_t> records_;
+  std::vector<Entry_t> entries_;
+  std::vector<Entry_t> scratch_;      //< radix sort buffer
+};
+
+// ----------------------------------------------------------------------------
+
+#endif  // BARBU_CORE_RENDER_QUEUE_H_
@@ -1,5 +1,6 @@
 #include "core/renderer.h"
 #include "core/global_clock.h"
+#include "shaders/generic/interop.h"
 
 #include "ui/views/views.h"
 
@@ -8,20 +9,35 @@
 Renderer::~Renderer() {
   particle_.deinit();
   hair_.deinit();
+  light_clusters_.deinit();
   grid_.deinit();
   skybox_.deinit();
   gizmo_.deinit();
   postprocess_.deinit();
+
+  if (gl_frame_uniforms_id_) {
+    glDeleteBuffers(1u, &gl_frame_uniforms_id_);
+    glDeleteBuffers(1u, &gl_draws_storage_id_);
+    glDeleteBuffers(1u, &gl_draws_indirect_id_);
+  }
 }
 
 void Renderer::init() {
   postprocess_.init();
   gizmo_.init();
   grid_.init();
+  light_clusters_.init();
   skybox_.init();
   particle_.init();  
   hair_.init();
 
+  glCreateBuffers(1u, &gl_frame_uniforms_id_);
+  glNamedBufferStorage(gl_frame_uniforms_id_, sizeof(FrameUniforms_t), nullptr, GL_DYNAMIC_STORAGE_BIT);
+  // (the per-draw buffers are resized every frame)
+  glCreateBuffers(1u, &gl_draws_storage_id_);
+  glCreateBuffers(1u, &gl_draws_indirect_id_);
+  CHECK_GX_ERROR();
+
   ui_view = std::make_shared<views::RendererView>(params_);
 }
 
@@ -85,6 +101,10 @@ void Renderer::draw(SceneHierarchy &scene, Camera &camera) {
   gx::Viewport( camera.width(), camera.height());
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT); //
 
+  updateFrameUniforms(camera);
+  buildRenderQueue(scene, camera);
+  light_clusters_.update(scene, camera);
+
   // "Deferred"-pass, post-process the solid objects.
   postprocess_.begin();
     // Warning : The PostProcess fbo outputs to 2 ColorBuffer, so materials that
@@ -260,50 +280,232 @@ void Renderer::drawPass(RendererPassBit bitmask, SceneHierarchy const& scene, Ca
 // ----------------------------------------------------------------------------
 
 void Renderer::drawEntities(RenderMode render_mode, SceneHierarchy const& scene, Camera const& camera) {
-  auto render_drawables = [this, render_mode, &scene, &camera](EntityHandle drawable) {
-    // global matrix of the entity.
-    auto const& world = scene.globalMatrix(drawable->index());
+  auto const draws = render_queue_.range(render_mode);
+  if (draws.empty()) {
+    return;
+  }
+
+  glBindBufferBase(GL_UNIFORM_BUFFER, UNIFORM_BINDING_FRAME, gl_frame_uniforms_id_);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, STORAGE_BINDING_DRAWS, gl_draws_storage_id_);
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, gl_draws_indirect_id_);
+  light_clusters_.bind();
+
+  // Render attributes shared by all meshes.
+  RenderAttributes attributes;
+  attributes.brdf_lut_texid   = skybox_.textureBRDFLookup()->id;
+  attributes.prefilter_texid  = skybox_.texturePrefilter() ? skybox_.texturePrefilter()->id : 0u;
+  attributes.irradiance_texid = skybox_.textureIrradiance() ? skybox_.textureIrradiance()->id : 0u;
+  //attributes.tonemap_mode   = tonemap_mode; // [todo]
+
+  uint32_t const skinning_texid = scene.skinningPalette().texture_id();
+
+  // True when two indexed draws can be submitted by the same multi-draw.
+  auto share_batch = [](RenderQueue::DrawRecord_t const& a, RenderQueue::DrawRecord_t const& b) {
+    return (a.material == b.material)
+        && (a.variant() == b.variant())
+        && (a.mesh->vao() == b.mesh->vao())
+        && (a.mesh->drawMode() == b.mesh->drawMode())
+        && b.mesh->indexed()
+        ;
+  };
+
+  // Previous material states, to only update those that changed.
+  Material const* last_material = nullptr;
+  uint32_t last_pgm = 0u;
+  int32_t last_variant = -1;
+  int32_t texture_unit = 0;
+
+  for (auto entry = draws.begin(); entry != draws.end();) {
+    auto const& draw = render_queue_.record(*entry);
+    auto *mat = draw.material;
+
+    // Gather the following draws sharing its states and vertex format.
+    auto last = std::next(entry);
+    if (draw.mesh->indexed()) {
+      while ((last != draws.end()) && share_batch(draw, render_queue_.record(*last))) {
+        ++last;
+      }
+    }
+
+    // Material parameters, when the material or its program variant changes.
+    int32_t const variant = draw.variant();
+    uint32_t const pgm{ mat->program()->id };
+    bool const bUseSameProgram{ (last_pgm == pgm) && (last_variant == variant) };
+    if (!bUseSameProgram || (last_material != mat)) {
+      attributes.skinning_texid = (variant > 0) ? skinning_texid : 0u;
+      attributes.skinning_mode  = draw.skinning_mode;
+      texture_unit = mat->updateUniforms(attributes, bUseSameProgram ? texture_unit : 0);
+    }
+    last_material = mat;
+    last_pgm = pgm;
+    last_variant = variant;
+
+    // Per-draw uniforms are fetched by instance, from the commands base instance
+    // or from the first draw index for direct draws.
+    bool const bIndexed = draw.mesh->indexed();
+    int32_t const first_draw = render_queue_.index(*entry);
+    gx::SetUniform( pgm, "uFirstDraw", bIndexed ? 0 : first_draw);
+
+    // Force double-sided rendering when requested.
+    bool const bCullFace{ gx::IsEnabled(gx::State::CullFace) };
+    if (mat->isDoubleSided()) {
+      gx::Disable( gx::State::CullFace );
+    }
+
+    // Draw the batch.
+    if (bIndexed) {
+      int32_t const first_command = entry_commands_[first_draw];
+      int32_t const last_command  = entry_commands_[render_queue_.index(*std::prev(last))];
+      auto const ncommands = static_cast<GLsizei>(last_command - first_command + 1);
+      auto const offset = reinterpret_cast<void const*>(first_command * sizeof(DrawIndirectCommand_t));
+      glBindVertexArray(draw.mesh->vao());
+      glMultiDrawElementsIndirect(draw.mesh->drawMode(), GL_UNSIGNED_INT, offset, ncommands, 0);
+      glBindVertexArray(0u);
+    } else {
+      draw.mesh->drawSubMesh(draw.submesh);
+    }
+
+    // Restore pipeline state.
+    if (bCullFace) {
+      gx::Enable( gx::State::CullFace );
+    }
+
+    entry = last;
+  }
+
+  gx::UseProgram();
+  gx::UnbindTexture();
+
+  light_clusters_.unbind();
+  glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0u);
+  glBindBufferBase(GL_UNIFORM_BUFFER, UNIFORM_BINDING_FRAME, 0u);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, STORAGE_BINDING_DRAWS, 0u);
+
+  CHECK_GX_ERROR();
+}
 
-    // External, per-mesh render attributes.
-    RenderAttributes attributes;
-    // (vertex)
-    attributes.mvp_matrix          = camera.viewproj() * world;
-    attributes.world_matrix        = world;
+void Renderer::buildRenderQueue(SceneHierarchy const& scene, Camera const& camera) {
+  render_queue_.clear();
 
-    // (vertex skinning)
+  // Drawables visible from the camera, already culled by the scene update for its own camera.
+  bool const bCulled = scene.isCullingCamera(camera);
+  SceneHierarchy::EntityList_t culled;
+  if (!bCulled) {
+    scene.cullDrawables(camera, culled);
+  }
+  auto const& drawables = bCulled ? scene.drawables() : culled;
+
+  auto const& eye_pos = camera.position();
+  auto const& eye_dir = camera.direction();
+  float const znear = camera.znear();
+  float const inv_depth_range = 1.0f / (camera.zfar() - znear);
+  auto const& palette = scene.skinningPalette();
+
+  for (auto const& drawable : drawables) {
+    auto &visual = drawable->get<VisualComponent>();
+    auto const& mesh = visual.mesh();
+
+    // Normalized view depth of the entity.
+    float const depth = (glm::dot(eye_dir, scene.globalCentroid(drawable) - eye_pos) - znear) * inv_depth_range;
+
+    RenderQueue::DrawRecord_t draw{};
+    draw.mesh            = mesh.get();
+    draw.world           = &scene.globalMatrix(drawable->index());
+    draw.submesh         = 0;
+    draw.skinning_offset = -1;
+
+    // (vertex skinning, from the palette shared by every skins)
     if (drawable->has<SkinComponent>()) {
       auto const& skin = drawable->get<SkinComponent>();
-      attributes.skinning_texid    = skin.textureID(); //
-      attributes.skinning_mode     = skin.skinningMode();
+      draw.skinning_offset = palette.texel_offset(skin.controller());
+      draw.skinning_mode   = skin.skinningMode();
     }
 
-    // (fragment)
-    attributes.brdf_lut_texid      = skybox_.textureBRDFLookup()->id;
-    attributes.prefilter_texid     = skybox_.texturePrefilter() ? skybox_.texturePrefilter()->id : 0u;
-    attributes.irradiance_texid    = skybox_.textureIrradiance() ? skybox_.textureIrradiance()->id : 0u;
-    attributes.irradiance_matrices = skybox_.hasIrradianceMatrices() ? skybox_.irradianceMatrices() : nullptr;
-    attributes.eye_position        = camera.position();
-    //attributes.tonemap_mode      = tonemap_mode; // [todo]
+    // Special Case : the mesh has no materials.
+    if (!mesh->hasMaterials()) {
+      draw.material = visual.material().get();
+      render_queue_.push(RenderMode::kDefault, depth, draw);
+      continue;
+    }
 
-    // Rendering.
-    auto &visual = drawable->get<VisualComponent>();
-    visual.render( attributes, render_mode );
+    for (int32_t i = 0; i < mesh->numSubMesh(); ++i) {
+      auto const mat{ visual.material(i) };
+      assert(mat != nullptr); //
+
+      draw.material = mat.get();
+      draw.submesh  = i;
+      render_queue_.push(mat->renderMode(), depth, draw);
+    }
+  }
+
+  render_queue_.sort();
+
+  // Per-draw uniforms by sorted index, and the indirect commands.
+  int32_t const ndraws = render_queue_.size();
+  if (0 == ndraws) {
+    return;
+  }
+  draw_uniforms_.resize(ndraws);
+  draw_commands_.clear();
+  entry_commands_.assign(ndraws, -1);
+
+  // True when two draws are instances of the same submesh and states.
+  auto share_instances = [](RenderQueue::DrawRecord_t const& a, RenderQueue::DrawRecord_t const& b) {
+    return (a.mesh == b.mesh)
+        && (a.submesh == b.submesh)
+        && (a.material == b.material)
+        && (a.variant() == b.variant())
+        ;
   };
 
-  auto drawables = scene.drawables();
+  RenderQueue::DrawRecord_t const* previous = nullptr;
+  for (auto const& entry : render_queue_.entries()) {
+    auto const& draw = render_queue_.record(entry);
+    int32_t const index = render_queue_.index(entry);
+
+    auto &uniforms = draw_uniforms_[index];
+    uniforms.mvp            = camera.viewproj() * (*draw.world);
+    uniforms.modelMatrix    = *draw.world;
+    uniforms.skinningOffset = draw.skinning_offset;
+
+    // (non-indexed meshes are drawn directly)
+    if (!draw.mesh->indexed()) {
+      previous = nullptr;
+      continue;
+    }
 
-  // Choose traversal depending on the RenderMode.
-  if (RenderMode::Transparent == render_mode) {
-    // Back to Front.
-    std::for_each(drawables.rbegin(), drawables.rend(), render_drawables);
-  } else {
-    // Front to Back.
-    std::for_each(drawables.begin(), drawables.end(), render_drawables);
+    // Consecutive instances are drawn by the same command, their per-draw
+    // uniforms following its base instance.
+    if ((nullptr != previous) && share_instances(*previous, draw)) {
+      ++draw_commands_.back().instance_count;
+    } else {
+      auto cmd = draw.mesh->drawCommand(draw.submesh);
+      cmd.base_instance = static_cast<uint32_t>(index);
+      draw_commands_.push_back(cmd);
+    }
+    entry_commands_[index] = static_cast<int32_t>(draw_commands_.size()) - 1;
+    previous = &draw;
   }
 
-  gx::UseProgram();
-  gx::UnbindTexture();
+  // (orphan the previous frame buffers)
+  glNamedBufferData(gl_draws_storage_id_, ndraws * sizeof(DrawUniforms_t), draw_uniforms_.data(), GL_STREAM_DRAW);
+  if (!draw_commands_.empty()) {
+    glNamedBufferData(gl_draws_indirect_id_, draw_commands_.size() * sizeof(DrawIndirectCommand_t), draw_commands_.data(), GL_STREAM_DRAW);
+  }
+  CHECK_GX_ERROR();
+}
+
+void Renderer::updateFrameUniforms(Camera const& camera) {
+  FrameUniforms_t frame_uniforms{};
+
+  if (skybox_.hasIrradianceMatrices()) {
+    auto const* matrices = skybox_.irradianceMatrices();
+    std::copy(matrices, matrices + 3, frame_uniforms.irradianceMatrices);
+    frame_uniforms.hasIrradianceMatrices = 1;
+  }
+  frame_uniforms.eyePosWS = camera.position();
 
+  glNamedBufferSubData(gl_frame_uniforms_id_, 0, sizeof(frame_uniforms), &frame_uniforms);
   CHECK_GX_ERROR();
 }
 
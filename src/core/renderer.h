@@ -4,11 +4,13 @@
 #include <functional>
 #include <vector>
 
+#include "core/render_queue.h"
 #include "fx/postprocess/postprocess.h"
 #include "fx/skybox.h"
 #include "fx/grid.h"
 #include "fx/hair.h"
 #include "fx/gpu_particle.h"
+#include "fx/light_clusters.h"
 #include "ecs/scene_hierarchy.h"
 #include "utils/gizmo.h"
 
@@ -83,11 +85,19 @@ class Renderer {
   void drawPass(RendererPassBit bitmask, SceneHierarchy const& scene, Camera const& camera);
   void drawEntities(RenderMode render_mode, SceneHierarchy const& scene, Camera const& camera);
 
+  /* Record and sort the submesh draws of the drawables visible from the camera,
+   * then upload their per-draw uniforms and the indirect commands instancing them. */
+  void buildRenderQueue(SceneHierarchy const& scene, Camera const& camera);
+
+  /* Upload the uniforms shared by every draw of the frame. */
+  void updateFrameUniforms(Camera const& camera);
+
   Postprocess postprocess_;
   Gizmo gizmo_;
 
   Skybox skybox_;
   Grid grid_;
+  LightClusters light_clusters_;
 
   // Experimentals [ futures components ]
   GPUParticle particle_;
@@ -95,6 +105,19 @@ class Renderer {
 
   Parameters_t params_;
 
+  // Sorted entities draws of the frame, with their per-draw data by sorted index,
+  // and the indirect commands instancing them.
+  RenderQueue render_queue_;
+  std::vector<DrawUniforms_t> draw_uniforms_;
+  std::vector<DrawIndirectCommand_t> draw_commands_;
+  std::vector<int32_t> entry_commands_;             //< command of each draw, -1 when direct
+
+  // Uniform buffer of the per-frame block and storage buffer of the per-draw
+  // uniforms of the materials, then the entities indirect draw commands.
+  uint32_t gl_frame_uniforms_id_ = 0u;
+  uint32_t gl_draws_storage_id_ = 0u;
+  uint32_t gl_draws_indirect_id_ = 0u;
+
   // using DrawCallback_t = std::function<void (RendererPassBit bitmask, Camera const& camera)>;
   // void register_draw_cb(DrawCallback_t const& draw_cb);
   // std::vector<DrawCallback_t> draw_callbacks_;
@@ -0,0 +1,135 @@
+#ifndef BARBU_ECS_COMPONENT_POOL_H_
+#define BARBU_ECS_COMPONENT_POOL_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "ecs/component.h"
+
+class Entity;
+
+// ----------------------------------------------------------------------------
+
+//
+//  Type-erased interface of the component pools, used to release the components
+//  of an entity from their type only.
+//
+class ComponentPoolBase {
+ public:
+  virtual ~ComponentPoolBase() = default;
+
+  /* Destroy the component at a slot. */
+  virtual void remove(int32_t const slot) = 0;
+
+  /* Return the pool of a component type, or nullptr when none was created. */
+  static ComponentPoolBase* Get(Component::Type const type) {
+    return Registry()[type];
+  }
+
+ protected:
+  static std::array<ComponentPoolBase*, Component::kCount>& Registry() {
+    static std::array<ComponentPoolBase*, Component::kCount> registry{};
+    return registry;
+  }
+};
+
+// ----------------------------------------------------------------------------
+
+//
+//  Packed storage of every components of a type, used as a sparse set : each
+//  entity holds the slot of its components, kept contiguous by moving the last
+//  component to the slot of a removed one.
+//
+//  Components are allocated by pages, so their address stay valid when others
+//  are added. Only a removal moves (the last) component.
+//
+template<typename T>
+class ComponentPool final : public ComponentPoolBase {
+ public:
+  static constexpr int32_t kPageShift = 7;
+  static constexpr int32_t kPageSize  = 1 << kPageShift;
+
+  /* Return the pool of T, created on first use. */
+  static ComponentPool& Get() {
+    // (never released, as entities can outlive the static objects)
+    static ComponentPool *pool = new ComponentPool();
+    return *pool;
+  }
+
+  ~ComponentPool() {
+    for (int32_t i = 0; i < size(); ++i) {
+      ptr(i)->~T();
+    }
+  }
+
+  /* Create a component owned by an entity, its slot is written to slot and
+   * updated when the component moves. */
+  T& add(Entity *owner, int32_t *slot) {
+    int32_t const index = size();
+    if ((index >> kPageShift) >= static_cast<int32_t>(pages_.size())) {
+      pages_.push_back(std::make_unique<Page_t>());
+    }
+    T *component = new (ptr(index)) T();
+    owners_.push_back(owner);
+    slots_.push_back(slot);
+    *slot = index;
+    return *component;
+  }
+
+  void remove(int32_t const slot) final {
+    int32_t const last = size() - 1;
+    *slots_[slot] = -1;
+
+    // Fill the hole with the last component.
+    if (slot != last) {
+      ptr(slot)->~T();
+      new (ptr(slot)) T(std::move(*ptr(last)));
+      owners_[slot] = owners_[last];
+      slots_[slot]  = slots_[last];
+      *slots_[slot] = slot;
+    }
+
+    ptr(last)->~T();
+    owners_.pop_back();
+    slots_.pop_back();
+  }
+
+  inline T& at(int32_t const slot) noexcept {
+    return *ptr(slot);
+  }
+
+  inline Entity* owner(int32_t const slot) const noexcept {
+    return owners_[slot];
+  }
+
+  inline int32_t size() const noexcept {
+    return static_cast<int32_t>(owners_.size());
+  }
+
+ private:
+  struct Page_t {
+    alignas(T) std::byte data[kPageSize * sizeof(T)];
+  };
+
+  ComponentPool() {
+    Registry()[T::Type] = this;
+  }
+
+  inline T* ptr(int32_t const index) const noexcept {
+    auto *page = pages_[index >> kPageShift].get();
+    return std::launder(reinterpret_cast<T*>(page->data) + (index & (kPageSize - 1)));
+  }
+
+  std::vector<std::unique_ptr<Page_t>> pages_;
+  std::vector<Entity*> owners_;             //< owner of each component
+  std::vector<int32_t*> slots_;             //< owner's slot of each component
+};
+
+// ----------------------------------------------------------------------------
+
+#endif // BARBU_ECS_COMPONENT_POOL_H_
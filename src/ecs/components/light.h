@@ -1,6 +1,8 @@
 #ifndef BARBU_ECS_COMPONENTS_LIGHT_H_
 #define BARBU_ECS_COMPONENTS_LIGHT_H_
 
+#include "glm/gtc/constants.hpp"
+
 #include "ecs/component.h"
 #include "shaders/shared/lighting/interop.h"
 
@@ -9,6 +11,7 @@
 enum class LightType : uint8_t {
   Directional     = LIGHT_TYPE_DIRECTIONAL,
   Point           = LIGHT_TYPE_POINT,
+  Spot            = LIGHT_TYPE_SPOT,
 
   kCount
 };
@@ -19,18 +22,31 @@ class LightComponent final : public ComponentParams<Component::Light> {
  static constexpr LightType kDefaultType      {LightType::Point}; 
  static constexpr glm::vec3 kDefaultColor     {1.0f, 0.984f, 0.941f}; // 0xfffbf0
  static constexpr float     kDefaultIntensity {1.0f};
+ static constexpr float     kDefaultRange     {10.0f};
+ static constexpr float     kDefaultInnerAngle{0.35f};
+ static constexpr float     kDefaultOuterAngle{0.5f};
 
  public:
   LightComponent()
     : type_{kDefaultType}
     , color_{kDefaultColor}
     , intensity_{kDefaultIntensity}
+    , range_{kDefaultRange}
+    , inner_angle_{kDefaultInnerAngle}
+    , outer_angle_{kDefaultOuterAngle}
   {}
 
   inline LightType type() const noexcept { return type_; }
   inline glm::vec3 const& color() const noexcept { return color_; }
   inline float intensity() const noexcept { return intensity_; }
 
+  /* Distance at which point and spot lights are cut off. */
+  inline float range() const noexcept { return range_; }
+
+  /* Spot cone half-angles, in radians, where its falloff begins and ends. */
+  inline float innerAngle() const noexcept { return inner_angle_; }
+  inline float outerAngle() const noexcept { return outer_angle_; }
+
   void setType(LightType type) noexcept {
     type_ = type;
   }
@@ -43,10 +59,22 @@ class LightComponent final : public ComponentParams<Component::Light> {
     intensity_ = intensity;
   }
 
+  void setRange(float range) noexcept {
+    range_ = glm::max(range, 0.0f);
+  }
+
+  void setSpotAngles(float inner_angle, float outer_angle) noexcept {
+    outer_angle_ = glm::clamp(outer_angle, 0.0f, glm::half_pi<float>());
+    inner_angle_ = glm::clamp(inner_angle, 0.0f, outer_angle_);
+  }
+
  private:
   LightType   type_;
   glm::vec3   color_;
   float       intensity_;
+  float       range_;
+  float       inner_angle_;
+  float       outer_angle_;
 };
 
 // ----------------------------------------------------------------------------
@@ -1,86 +1,75 @@
 #include "ecs/components/skin.h"
-
-#include "glm/gtc/type_ptr.hpp"
-#include "core/graphics.h"
+#include "glm/gtc/matrix_transform.hpp"
 
 // ----------------------------------------------------------------------------
 
-SkinComponent::~SkinComponent() {
-  if (0u != buffer_id_) {
-    glDeleteBuffers(1u, &buffer_id_);
-    buffer_id_ = 0u;
-
-    glDeleteTextures(1u, &texture_id_);
-    texture_id_ = 0u;
+void SkinComponent::setBlendTree(std::shared_ptr<BlendTree const> blend_tree) {
+  blend_tree_ = blend_tree;
+  if (blend_tree_) {
+    LOG_CHECK( blend_tree_->compiled() );
+    blend_tree_->init(blend_state_, sequence_);
   }
 }
 
-bool SkinComponent::update(float global_time) {
+bool SkinComponent::prepare(AnimationSystem &animation, float global_time, int32_t lod_level) {
   if (nullptr == skeleton_) {
     LOG_WARNING( "A skeleton was not provided for SkinComponent." );
     return false;
   }
 
   // [optional] Use a blend tree to weight the sequence clips.
-#if 0
-  // Activates each sequence's leaves on the blend tree.
-  // [TODO: set once by the Action State Machine each time a state is entered]
-  blend_tree_->activate_leaves(true, sequence_); //
-
-  // Compute weight for active leaves.
-  blend_tree_->evaluate(1.0f, sequence_);
-#endif
-
-  // Evaluate the skinning data for the given sequence. 
-  bool const hasData{
-    controller_.evaluate( mode_, skeleton_, global_time, sequence_)
-  };
-
-  if (hasData) {
-    updateSkinningBuffer();
+  if (blend_tree_) {
+    blend_tree_->evaluate(blend_state_, global_time, sequence_);
   }
-  
-  return hasData;
-}
 
-void SkinComponent::updateSkinningBuffer() {
-  // [ TODO : use an external wrapper, eg. 'TextureBuffer' ]
+  sampleSequence(global_time);
 
-  // 1) Create an *immutable* device buffer with texture buffer.
-  //    [This is unique to each instance but they could share a larger one instead]
-  if (0u == buffer_id_) {
-    // Upper boundary for skinning data.
-    GLsizeiptr constexpr kElemsize{ static_cast<GLsizeiptr>(glm::max(sizeof(glm::mat3x4), sizeof(glm::dualquat))) }; //
-    GLsizeiptr const kBytesize{ skeleton_->njoints() * kElemsize };
+  // Retrieve the sequence's active clips, to be evaluated with the batch.
+  return animation.add( controller_, mode_, skeleton_, global_time, sequence_, lod_level);
+}
 
-    glCreateBuffers(1u, &buffer_id_);
-    glNamedBufferStorage(buffer_id_, kBytesize, nullptr, GL_DYNAMIC_STORAGE_BIT);
-    glCreateTextures(GL_TEXTURE_BUFFER, 1u, &texture_id_);
-    glTextureBuffer(texture_id_, GL_RGBA32F, buffer_id_);
+void SkinComponent::sampleSequence(float const global_time) {
+  root_motion_ = glm::mat4(1.0f);
+  events_.clear();
 
-    CHECK_GX_ERROR();
+  float const last_time = last_time_;
+  last_time_ = global_time;
+  if ((last_time < 0.0f) || (global_time <= last_time)) {
+    return;
   }
 
-  // 2) Retrieve the underlying data depending on the skinning blending mode.
-  GLsizeiptr bytesize{0};
-  float const* data_ptr{nullptr};
-  
-  if (SkinningMode::DualQuaternion == mode_) {
-    // DUAL QUATERNION BLENDING.
-    auto *const data = controller_.dual_quaternions().data();
-    bytesize = skeleton_->njoints() * sizeof(data[0]);
-    data_ptr = reinterpret_cast<float const*>(data);
-  } else {
-    // LINEAR BLENDING.
-    auto const& data = controller_.skinning_matrices();
-    bytesize = skeleton_->njoints() * sizeof(data[0]);
-    data_ptr = glm::value_ptr(data[0]);
+  // Blend the root motion of the base clips by their weights, clips played in
+  // place contributing none.
+  glm::vec3 translation(0.0f);
+  float yaw = 0.0f;
+  float total_weight = 0.0f;
+
+  for (auto const& sc : sequence_) {
+    if (!sc.bEnable || (sc.weight <= 0.0f) || (nullptr == sc.action_ptr)) {
+      continue;
+    }
+
+    float local_time{0.0f};
+    sc.evaluate_localtime(last_time, global_time, local_time, events_);
+
+    if (!bRootMotion_ || sc.bAdditive) {
+      continue;
+    }
+    total_weight += sc.weight;
+
+    glm::vec3 clip_translation;
+    float clip_yaw;
+    if (sc.evaluate_root_motion(last_time, global_time, clip_translation, clip_yaw)) {
+      translation += sc.weight * clip_translation;
+      yaw += sc.weight * clip_yaw;
+    }
   }
 
-  // 3) Upload skinning data.
-  glNamedBufferSubData(buffer_id_, 0, bytesize, data_ptr);
-  
-  CHECK_GX_ERROR();
+  if (total_weight > 0.0f) {
+    float const inv_weight = 1.0f / total_weight;
+    root_motion_ = glm::translate(glm::mat4(1.0f), inv_weight * translation);
+    root_motion_ = glm::rotate(root_motion_, inv_weight * yaw, glm::vec3(0.0f, 1.0f, 0.0f));
+  }
 }
 
 // ----------------------------------------------------------------------------
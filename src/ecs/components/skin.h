@@ -1,11 +1,14 @@
 #ifndef BARBU_ECS_COMPONENTS_SKIN_H_
 #define BARBU_ECS_COMPONENTS_SKIN_H_
 
+#include <memory>
 #include <vector>
 
 #include "ecs/component.h"
 
 #include "fx/animation/common.h"
+#include "fx/animation/animation_system.h"
+#include "fx/animation/blend_tree.h"
 #include "fx/animation/skeleton.h"
 #include "fx/animation/skeleton_controller.h"
 #include "ecs/entity-fwd.h"
@@ -25,9 +28,8 @@ class SkinComponent final : public ComponentParams<Component::Skin> {
     , skeleton_{ nullptr }
   {}
 
-  ~SkinComponent();
-
-  bool update(float global_time);
+  /* Add the skin to the animation batch at a LOD level, return false when it is not animated. */
+  bool prepare(AnimationSystem &animation, float global_time, int32_t lod_level = 0);
 
   inline void setSkinningMode(SkinningMode const mode) noexcept {
     mode_ = mode;
@@ -37,6 +39,15 @@ class SkinComponent final : public ComponentParams<Component::Skin> {
     skeleton_ = skeleton;
   }
 
+  /* Move the entity with the root motion of its clips, instead of playing them in place. */
+  inline void setRootMotion(bool const enable) noexcept {
+    bRootMotion_ = enable;
+    controller_.set_root_motion(enable);
+  }
+
+  /* Use a compiled blend tree to weight the sequence, which is reset to the tree clips. */
+  void setBlendTree(std::shared_ptr<BlendTree const> blend_tree);
+
   inline SkinningMode skinningMode() const noexcept {
     return mode_;
   }
@@ -53,17 +64,40 @@ class SkinComponent final : public ComponentParams<Component::Skin> {
     return sequence_;
   }
 
+  inline std::shared_ptr<BlendTree const> const& blendTree() const noexcept {
+    return blend_tree_;
+  }
+
+  inline BlendTreeState_t& blendState() noexcept {
+    return blend_state_;
+  }
+
   inline SkeletonController const& controller() const noexcept {
     return controller_;
   }
 
-  inline uint32_t textureID() const noexcept { 
-    return texture_id_; // 
+  inline bool hasRootMotion() const noexcept {
+    return bRootMotion_;
+  }
+
+  /* Mesh space motion of the root since the previous prepare, when enabled. */
+  inline glm::mat4 const& rootMotion() const noexcept {
+    return root_motion_;
+  }
+
+  /* Events crossed by the sequence clips since the previous prepare. */
+  inline EventQueue_t const& events() const noexcept {
+    return events_;
+  }
+
+  /* Mesh space bounds of the skin, as last animated (empty before). */
+  inline BoundingBox_t const& bounds() const noexcept {
+    return controller_.skinned_bounds();
   }
 
  private:
-  /* Create the skinning data device buffer if needed and upload data to it. */
-  void updateSkinningBuffer(); // [fixme]
+  /* Sample the root motion and events of the weighted sequence since the last update. */
+  void sampleSequence(float const global_time);
 
   // Inputs.
   SkinningMode            mode_;
@@ -71,12 +105,18 @@ class SkinComponent final : public ComponentParams<Component::Skin> {
   mutable SkeletonMap_t   skeleton_map_;  //
   mutable Sequence_t      sequence_;      //
 
-  // Outputs.
-  SkeletonController controller_;
+  // [optional] Graph weighting the sequence clips, with its instance data.
+  std::shared_ptr<BlendTree const> blend_tree_;
+  BlendTreeState_t        blend_state_;
 
-  // [ fixme : raw texture buffer handles ]
-  uint32_t buffer_id_  = 0u; //
-  uint32_t texture_id_ = 0u; //
+  // Root motion and events, sampled every frame.
+  bool                    bRootMotion_ = false;
+  float                   last_time_ = -1.0f;
+  glm::mat4               root_motion_{1.0f};
+  EventQueue_t            events_;
+
+  // Outputs, the skinning data being uploaded with every skins (see SkinningPalette).
+  SkeletonController controller_;
 };
 
 // ----------------------------------------------------------------------------
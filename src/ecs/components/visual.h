@@ -1,7 +1,7 @@
 #ifndef BARBU_ECS_COMPONENTS_VISUAL_H_
 #define BARBU_ECS_COMPONENTS_VISUAL_H_
 
-#include <map>
+#include <vector>
 
 #include "ecs/component.h"
 #include "ecs/materials/generic.h"
@@ -18,64 +18,10 @@ class VisualComponent final : public ComponentParams<Component::Visual> {
  public:
   VisualComponent() = default;
 
-  /* Render parts of the mesh matching the RenderMode. */
-  void render(RenderAttributes const& attributes, RenderMode const render_mode) {
-    
-    // Special Case : the mesh has no materials.
-    if (!mesh_->hasMaterials()) {
-      if (render_mode == RenderMode::kDefault) {
-        material()->updateUniforms(attributes);
-        mesh_->draw();
-      }
-      return;
-    }
-
-    // Keep tracks of previous program to avoid useless uniform setup mesh wised.
-    uint32_t last_pgm = 0u;
-    int32_t texture_unit = 0;
-    int32_t const sub_mesh_count{ mesh_->numSubMesh() };
-    for (int32_t i = 0; i < sub_mesh_count; ++i) {
-      auto const mat{ material(i) };
-
-      // Check the material render mode.
-      assert(mat != nullptr); //
-      if (render_mode != mat->renderMode()) {
-        continue;
-      }
-
-      // Set material parameters when needed.
-      uint32_t const pgm{ mat->program()->id };
-      bool const bUseSameProgram{ last_pgm == pgm }; 
-      texture_unit = mat->updateUniforms(attributes, bUseSameProgram ? texture_unit : 0);
-      last_pgm = pgm;
-
-      // Force double-sided rendering when requested.
-      bool const bCullFace{ gx::IsEnabled(gx::State::CullFace) };
-      if (mat->isDoubleSided()) {
-        gx::Disable( gx::State::CullFace );
-      }
-
-      // Draw submesh.
-      mesh_->drawSubMesh(i);
-
-      // Restore pipeline state.
-      if (bCullFace) {
-        gx::Enable( gx::State::CullFace );
-      }
-    }
-  
-    CHECK_GX_ERROR();
-  }
-
   /* Add a mesh with a default material for each submeshes. */
   inline void setMesh(MeshHandle mesh) {
     mesh_ = mesh;
-
-    // materials_.clear();
-    // for (auto& vg : mesh_->vertexGroups()) {
-    //   auto mat = MATERIAL_ASSETS.get( AssetId(vg.name) );
-    //   materials_.insert_or_assign( vg.name, mat->loaded() ? mat : MATERIAL_ASSETS.get_default());
-    // }
+    materials_.clear();
   }
 
   inline void setRig(EntityHandle rig) noexcept {
@@ -94,29 +40,35 @@ class VisualComponent final : public ComponentParams<Component::Visual> {
     return rig_;
   }
 
- private:
+  /* Return the material of a submesh, or the default one when it has none. */
   inline MaterialHandle material(int32_t index = 0) {
-    auto const default_material{ MATERIAL_ASSETS.get_default()->get() };
-
     if (!mesh_->hasMaterials()) {
-      return default_material;
+      return MATERIAL_ASSETS.get_default()->get();
     }
-    
-    auto const& vg{ mesh_->vertexGroup(index) };
-    auto const material_id{ AssetId(vg.name) };
-    return (MATERIAL_ASSETS.has(material_id)) ? MATERIAL_ASSETS.get(material_id)->get()
-                                              : default_material
-                                              ;
+
+    // Resolve the submeshes material assets once.
+    auto const& vgroups{ mesh_->vertexGroups() };
+    if (materials_.size() != vgroups.size()) {
+      materials_.clear();
+      for (auto const& vg : vgroups) {
+        auto const material_id{ AssetId(vg.name) };
+        materials_.push_back( MATERIAL_ASSETS.has(material_id) ? MATERIAL_ASSETS.get(material_id)
+                                                               : MATERIAL_ASSETS.get_default()
+                                                               );
+      }
+    }
+    return materials_[index]->get();
   }
 
+ private:
+
   MeshHandle mesh_ = nullptr; 
 
   // If the entity is skinned, reference its rig here.
   EntityHandle rig_ = nullptr;
 
-  // [right now the mesh access its linked materials at import but we could use
-  // an internal map to access custom one]
-  //std::map< std::string, MaterialAssetHandle > materials_;
+  // Material assets of the submeshes, by vertex group.
+  std::vector<MaterialAssetHandle> materials_;
 };
 
 // ----------------------------------------------------------------------------
@@ -6,6 +6,14 @@
 
 // ----------------------------------------------------------------------------
 
+Entity::~Entity() {
+  for (int32_t type = 0; type < Component::kCount; ++type) {
+    if (auto const slot = components_[type]; slot != kNoComponent) {
+      ComponentPoolBase::Get(static_cast<Component::Type>(type))->remove(slot);
+    }
+  }
+}
+
 glm::vec3 Entity::centroid() const { 
   if (has<VisualComponent>()) {
     return get<VisualComponent>().mesh()->centroid();
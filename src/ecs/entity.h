@@ -8,6 +8,7 @@
 #include <string_view>
 
 #include "ecs/component.h"
+#include "ecs/component_pool.h"
 #include "ecs/components/transform.h"
 
 #include "ecs/entity-fwd.h"
@@ -20,10 +21,10 @@ class SceneHierarchy;
 //  communicate using a set of components.   
 //  Each entities possess at least the transform component.
 //
-//  Note : Ideally an entity should be empty and its components added in
-//         a larger buffer in the SceneHierarchy.
+//  Components are stored packed by type in their ComponentPool, the entity
+//  only holds their slots.
 //
-class Entity {
+class Entity : public std::enable_shared_from_this<Entity> {
  public:
   friend class SceneHierarchy;
 
@@ -38,15 +39,22 @@ class Entity {
   }
 
  public:
-  Entity() = default;
+  Entity() {
+    components_.fill(kNoComponent);
+  }
 
   Entity(std::string_view name)
     : name_(name)
   {
+    components_.fill(kNoComponent);
     add<TransformComponent>();
   }
 
-  virtual ~Entity() {}
+  // (the pools reference the entity components slots)
+  Entity(Entity const&) = delete;
+  Entity& operator=(Entity const&) = delete;
+
+  virtual ~Entity();
 
   virtual void update(float const dt) {}
 
@@ -71,28 +79,29 @@ class Entity {
   /* Return true if the entity possess the component. */
   template<typename T> 
   std::enable_if_t<std::is_base_of_v<Component, T>, bool> has() const noexcept {
-    return static_cast<bool>(components_[T::Type]);
+    return components_[T::Type] != kNoComponent;
   }
   
-  /* Return a reference to the component [ return shared_ptr<T> instead ? ]. */
+  /* Return a reference to the component, valid until a component of the same
+   * type is removed. */
   template<typename T> 
   std::enable_if_t<std::is_base_of_v<Component, T>, T&> get() {
     assert( has<T>() );
-    return static_cast<T&>(*components_[T::Type]);
+    return ComponentPool<T>::Get().at(components_[T::Type]);
   }
 
   /* Return a constant reference to the component. */
   template<typename T> 
   std::enable_if_t<std::is_base_of_v<Component, T>, T const&> get() const {
     assert( has<T>() );
-    return static_cast<T&>(*components_[T::Type]);
+    return ComponentPool<T>::Get().at(components_[T::Type]);
   }
 
   /* Add then return the given component to the entity. */
   template<typename T> 
   std::enable_if_t<std::is_base_of_v<Component, T>, T&> add() {
     if (!has<T>()) {
-      components_[T::Type] = std::make_unique<T>();
+      return ComponentPool<T>::Get().add(this, &components_[T::Type]);
     }
     return get<T>();
   }
@@ -101,7 +110,9 @@ class Entity {
   template<typename T>
   std::enable_if_t<std::is_base_of_v<Component, T>> remove() {
     static_assert(T::Type != Component::Type::Transform);
-    components_[T::Type].reset();
+    if (has<T>()) {
+      ComponentPool<T>::Get().remove(components_[T::Type]);
+    }
   }
 
   // -- Transform component quick access points.
@@ -133,12 +144,30 @@ class Entity {
   int32_t index_ = -1;                //< index in the scene hierarchy per-frame structure.
 
  private:
-  // [ should probably use a map, and be set externally ]
-  using ComponentBuffer = std::array< ComponentHandle, Component::kCount >;
+  static constexpr int32_t kNoComponent = -1;
 
-  ComponentBuffer components_;
+  // Slot of each component type in its pool.
+  using ComponentSlots = std::array< int32_t, Component::kCount >;
+
+  ComponentSlots components_;
 };
 
 // ----------------------------------------------------------------------------
 
+/* Call f(entity, component) for every entity owning a T component and the
+ * Others ones, iterating the packed T components.
+ * Components of type T must not be added or removed by f. */
+template<typename T, typename... Others, typename F>
+void ForEachComponent(F&& f) {
+  auto &pool = ComponentPool<T>::Get();
+  for (int32_t i = 0; i < pool.size(); ++i) {
+    auto &entity = *pool.owner(i);
+    if ((entity.template has<Others>() && ...)) {
+      f(entity, pool.at(i));
+    }
+  }
+}
+
+// ----------------------------------------------------------------------------
+
 #endif // BARBU_ECS_ENTITY_H_
\ No newline at end of file
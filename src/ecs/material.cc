@@ -1,11 +1,18 @@
 #include "ecs/material.h"
 
+#include <atomic>
+
 #include "glm/glm.hpp"
 #include "core/graphics.h"
 #include "core/logger.h"
 
 // ----------------------------------------------------------------------------
 
+uint32_t Material::NextUID() {
+  static std::atomic<uint32_t> sCounter{ 0u };
+  return sCounter++;
+}
+
 int32_t Material::updateUniforms(RenderAttributes const& attributes, int32_t default_unit) {
   texture_unit_ = default_unit; //
 
@@ -23,10 +30,6 @@ int32_t Material::updateUniforms(RenderAttributes const& attributes, int32_t def
       }
     };
 
-    // (vertex)
-    gx::SetUniform( pgm, "uMVP",         attributes.mvp_matrix);
-    gx::SetUniform( pgm, "uModelMatrix", attributes.world_matrix);
-
     // (vertex skinning)
     if (attributes.skinning_texid > 0u) {
       bind_texture( "uSkinningDatas",   attributes.skinning_texid,  gx::SamplerName::LinearClamp);
@@ -45,14 +48,6 @@ int32_t Material::updateUniforms(RenderAttributes const& attributes, int32_t def
     bind_texture( "uBRDFMap",           attributes.brdf_lut_texid,   gx::SamplerName::LinearMipmapClamp); //
     bind_texture( "uPrefilterEnvmap",   attributes.prefilter_texid,  gx::SamplerName::LinearMipmapClamp);
     bind_texture( "uIrradianceEnvmap",  attributes.irradiance_texid, gx::SamplerName::LinearClamp);
-
-    bool const has_irradiance_matrices = (nullptr != attributes.irradiance_matrices);
-    gx::SetUniform( pgm, "uHasIrradianceMatrices", has_irradiance_matrices);
-    if (has_irradiance_matrices) {
-      gx::SetUniform( pgm, "uIrradianceMatrices", attributes.irradiance_matrices, 3);
-    }
-
-    gx::SetUniform( pgm, "uEyePosWS", attributes.eye_position);
     //gx::SetUniform(pgm, "uToneMapMode",       static_cast<int>(attributes.tonemap_mode));
   }
   CHECK_GX_ERROR();
@@ -18,11 +18,9 @@ enum class RenderMode {
 // ----------------------------------------------------------------------------
 
 // Attributes shared by all materials.
+// (matrices and per-frame parameters are passed via the uniform blocks of
+//  "shaders/generic/interop.h", updated by the renderer)
 struct RenderAttributes {
-  // (vertex)
-  glm::mat4 mvp_matrix;
-  glm::mat4 world_matrix;
-
   // (vertex skinning)
   uint32_t skinning_texid = 0u;
   SkinningMode skinning_mode;
@@ -31,8 +29,6 @@ struct RenderAttributes {
   uint32_t brdf_lut_texid = 0u;
   uint32_t prefilter_texid = 0u;
   uint32_t irradiance_texid = 0u;
-  glm::mat4 const* irradiance_matrices = nullptr;
-  glm::vec3 eye_position;
   //int32_t tonemap_mode;
 };
 
@@ -71,6 +67,11 @@ class Material {
     return bDoubleSided_;
   }
 
+  /* Unique identifier of the material instance, used to sort the draws. */
+  inline uint32_t uid() const noexcept {
+    return uid_;
+  }
+
   inline void setRenderMode(RenderMode const& render_mode) noexcept {
     render_mode_ = render_mode;
   }
@@ -89,6 +90,11 @@ class Material {
   EnumArray< uint32_t, SkinningMode > skinning_subroutines_;
   int32_t texture_unit_;
   bool bDoubleSided_;
+
+ private:
+  static uint32_t NextUID();
+
+  uint32_t const uid_ = NextUID();
 };
 
 // ----------------------------------------------------------------------------
@@ -1,6 +1,7 @@
 #include "ecs/scene_hierarchy.h"
 
 #include <algorithm>
+#include <unordered_map>
 #include <vector>
 
 #include "glm/gtc/matrix_inverse.hpp"
@@ -9,6 +10,13 @@
 #include "core/camera.h"
 #include "core/global_clock.h"
 #include "ui/views/ecs/SceneHierarchyView.h"
+#include "utils/simd.h"
+
+#ifdef BARBU_NPROC_MAX
+#define LOOP_NTHREADS  (BARBU_NPROC_MAX)
+#else
+#define LOOP_NTHREADS  4
+#endif
 
 // ----------------------------------------------------------------------------
 
@@ -20,6 +28,53 @@ constexpr int32_t kDebugSphereResolution = 16;
 
 constexpr bool kEnableLoadRigHierarchy = true;
 
+// Number of entities below which transforms are updated on a single thread.
+constexpr int32_t kMinParallelTransforms = 2048;
+
+namespace {
+
+using simd::float4;
+
+/// Multiply a matrix by an affine one, with SIMD columns.
+inline void MultiplyAffine(glm::mat4 const& a, glm::mat4 const& b, glm::mat4 &dst) {
+  float4 const a0 = simd::load(&a[0][0]);
+  float4 const a1 = simd::load(&a[1][0]);
+  float4 const a2 = simd::load(&a[2][0]);
+  float4 const a3 = simd::load(&a[3][0]);
+
+  for (int32_t c = 0; c < 3; ++c) {
+    simd::store(&dst[c][0], a0 * simd::set1(b[c][0])
+                          + a1 * simd::set1(b[c][1])
+                          + a2 * simd::set1(b[c][2]));
+  }
+  simd::store(&dst[3][0], a0 * simd::set1(b[3][0])
+                        + a1 * simd::set1(b[3][1])
+                        + a2 * simd::set1(b[3][2])
+                        + a3);
+}
+
+/// Render a rig joint depending on its number of children, as a prism to its
+/// only child, or a sphere otherwise.
+void RenderDebugJoint(glm::vec3 const& start, glm::vec3 const& end, int32_t const nchildren) {
+  // Color.
+  auto rgb = Im3d::Color((0 == nchildren) ? glm::vec4(1.0f, 0.0f, 0.0f, 1.0f) :    // leaf
+                         (1 == nchildren) ? glm::vec4(0.5f, 1.0f, 0.5f, 1.0f) :    // joint
+                                            glm::vec4(1.0f, 1.0f, 0.9f, 1.0f) );   // node
+
+  // [fixme] the debug shapes should scale depending on some factors.
+  float constexpr scale = 0.02f; //
+
+  Im3d::PushColor( rgb );
+  if (1 == nchildren) {
+    Im3d::DrawPrism( start, end, 1.0f * scale, 5);
+  } else {
+    Im3d::DrawSphere( start, 2.0f * scale, kDebugSphereResolution);
+  }
+  Im3d::PopColor();
+}
+
+} // namespace
+
 // ----------------------------------------------------------------------------
 
 SceneHierarchy::~SceneHierarchy() {
@@ -28,12 +83,12 @@ SceneHierarchy::~SceneHierarchy() {
 
 void SceneHierarchy::init() {
   ui_view = std::make_shared<views::SceneHierarchyView>(*this);
+  animation_.init();
 }
 
 void SceneHierarchy::update(float const dt, Camera const& camera) {
   // Clear per-frame data.
   frame_.clear();
-  frame_.globals.resize(entities_.size(), glm::mat4(1.0f));
 
   // Update the scene entities hierarchically.
   updateHierarchy(dt);
@@ -46,55 +101,69 @@ void SceneHierarchy::update(float const dt, Camera const& camera) {
     if (isSelected(e)) {
       frame_.selected.push_back( e );
     }
-
-    if (e->has<SphereColliderComponent>()) {
-      frame_.colliders.push_back( e );
-    }
   }
+  ForEachComponent<SphereColliderComponent>([this](Entity &e, auto const&) {
+    if (inScene(e)) {
+      frame_.colliders.push_back( e.shared_from_this() );
+    }
+  });
+  ForEachComponent<LightComponent>([this](Entity &e, auto const&) {
+    if (inScene(e)) {
+      frame_.lights.push_back( e.shared_from_this() );
+    }
+  });
 
   // ----------------------------------------
 
-  // Retrieve renderable entities.
-  for (auto& e : entities_) {
-    if (e->has<VisualComponent>()) {
-      frame_.drawables.push_back( e );
-    }
-  }
+  // Retrieve the renderable entities visible from the camera.
+  // (skinned bounds are those of the previous frame, covered by the tree margins)
+  updateDrawablesTree();
+  culling_viewproj_ = camera.viewproj();
+  cullDrawables(camera, frame_.drawables, frame_.depths);
 
-  // Sort the drawables front to back.
-  sortDrawables(camera);
+  frame_.visibles.assign(transforms_.size(), 0u);
+  for (auto const& e : frame_.drawables) {
+    frame_.visibles[e->index()] = 1u;
+  }
 
   // Animate nodes with skinning (for now, suppose them all drawables).
   float const global_time = static_cast<float>(GlobalClock::Get().applicationTime()); //
-  for (auto& e : frame_.drawables) {
-    if (!e->has<SkinComponent>()) {
-      continue;
+  
+  // Screen coverage of an entity's bounding sphere, used to select its animation LOD.
+  float const screen_scale = 1.0f / glm::tan(0.5f * camera.fov());
+  auto calculate_screen_coverage = [this, screen_scale](EntityHandle const& e) {
+    auto const& global = globalMatrix(e->index());
+    float const scale = glm::max( glm::length(global[0]), glm::max( glm::length(global[1]), glm::length(global[2])));
+    float const radius = scale * localBounds(e).radius();
+    float const depth = glm::max( frame_.depths[e->index()], glm::epsilon<float>());
+    return screen_scale * radius / depth;
+  };
+
+  // Gather every active skins, then evaluate them in batch.
+  // Culled skins are still animated, for their root motion and bounds, at the lowest LOD.
+  animation_.clear(global_time);
+  ForEachComponent<SkinComponent, VisualComponent>([&](Entity &entity, SkinComponent &skin) {
+    if (!inScene(entity)) {
+      return;
     }
-    
-    // Calculate skinning matrices.
-    if (auto &skin = e->get<SkinComponent>(); skin.update(global_time)) {
-      // Update rig entity global matrix from skinning.
-      // [ hence we might want to avoid computing their global uselessly beforehand ]
-      auto &visual = e->get<VisualComponent>();
-      if (auto rig = visual.rig(); rig) {
-        auto const& rig_global = globalMatrix(rig->index());
-        auto const& controller = skin.controller();
-        auto const& global_pose_matrices = controller.global_pose_matrices();
-
-        // Map skeleton joint index to their rig entity.
-        auto &skeleton_map = skin.skeletonMap(); //
-        assert(!skeleton_map.empty());
-
-        for (int32_t joint_id = 0; joint_id < controller.njoints(); ++joint_id) {
-          auto const& global_pose = global_pose_matrices[joint_id];
-          auto const entity_index = skeleton_map[joint_id]->index(); //
-          assert( entity_index > -1 );
-
-          frame_.globals[entity_index] = rig_global * global_pose;
-        }
-      }
+    auto const e = entity.shared_from_this();
+    int32_t const lod_level = frame_.visibles[e->index()] ? animation_.lod_level( calculate_screen_coverage(e) )
+                                                          : AnimationSystem::kNumLODs - 1
+                                                          ;
+    skin.prepare(animation_, global_time, lod_level);
+
+    // Move the entity and its sub-hierarchy by its root motion.
+    // (the modified local marks the subtree dirty on the next update)
+    if (skin.hasRootMotion()) {
+      e->localMatrix() *= skin.rootMotion();
+      updateSubtreeGlobals(e->index());
     }
-  }
+  });
+  animation_.evaluate();
+
+  // Upload the skinning data of every skins at once.
+  // (rig entities keep their bind pose, the animated one being held by the skins controller)
+  skinning_palette_.upload(animation_);
 }
 
 void SceneHierarchy::removeEntity(EntityHandle entity, bool bRecursively) {
@@ -136,6 +205,7 @@ void SceneHierarchy::removeEntity(EntityHandle entity, bool bRecursively) {
 
   // Remove entity from the list of entities.
   entities_.remove( entity );
+  bTopologyChanged_ = true;
 
   if (bRecursively) {
     // Remove children recursively.
@@ -199,6 +269,7 @@ EntityHandle SceneHierarchy::importModel(std::string_view filename) {
         // Add a skinning component.
         auto& skin = entity->add<SkinComponent>();
         skin.setSkeleton( skl );
+        skl->calculate_joint_heights();
 
         // [debug]
         // Set the first animation clips on loop.
@@ -264,6 +335,17 @@ EntityHandle SceneHierarchy::importModel(std::string_view filename) {
   return nullptr;
 }
 
+void SceneHierarchy::importModelAsync(std::string_view filename, std::function<void(EntityHandle)> on_import) {
+  // The mesh data and its textures are loaded by a worker, the GPU objects are
+  // then created on the main thread from the registered resources.
+  std::string const fn( filename );
+  Resources::LoadAsync<MeshData>( ResourceId(fn), [this, fn, on_import](auto const&) {
+    if (auto entity = importModel(fn); entity && on_import) {
+      on_import(entity);
+    }
+  });
+}
+
 void SceneHierarchy::toggleSelect(EntityHandle entity, bool status) {
   if (entity->index() < 0) {
     LOG_ERROR( "Entity index is invalid, it must have been created before scene internal update." );
@@ -316,6 +398,35 @@ glm::vec3 SceneHierarchy::centroid(bool selected) const {
   return center;
 }
 
+bool SceneHierarchy::isCullingCamera(Camera const& camera) const {
+  return camera.viewproj() == culling_viewproj_;
+}
+
+void SceneHierarchy::cullDrawables(Camera const& camera, EntityList_t &drawables) const {
+  std::vector<float> depths;
+  cullDrawables(camera, drawables, depths);
+}
+
+BoundingBox_t SceneHierarchy::localBounds(EntityHandle e) const {
+  BoundingBox_t bounds;
+  if (!e->has<VisualComponent>()) {
+    return bounds;
+  }
+
+  // Skinned bounds are known once the skin has been animated.
+  if (e->has<SkinComponent>()) {
+    if (auto const& skinned = e->get<SkinComponent>().bounds(); !skinned.empty()) {
+      return skinned;
+    }
+  }
+
+  // (the mesh bounds are symmetric around its origin)
+  auto const& mesh_bounds = e->get<VisualComponent>().mesh()->bounds();
+  bounds.min = -mesh_bounds;
+  bounds.max = mesh_bounds;
+  return bounds;
+}
+
 
 EntityHandle SceneHierarchy::next(EntityHandle entity, int32_t step) const {
   int32_t const nentities = static_cast<int32_t>(entities_.size());
@@ -335,9 +446,19 @@ EntityHandle SceneHierarchy::next(EntityHandle entity, int32_t step) const {
 void SceneHierarchy::renderDebugRigs() const {
   for (auto e : frame_.drawables) {
     auto &visual = e->get<VisualComponent>();
-    if (auto rig = visual.rig(); rig) {
-      renderDebugNode(rig->child(0));
+    auto rig = visual.rig();
+    if (!rig) {
+      continue;
+    }
+
+    // Animated rigs are rendered from their skin pose.
+    if (e->has<SkinComponent>()) {
+      if (auto const& controller = e->get<SkinComponent>().controller(); controller.njoints() > 0) {
+        renderDebugPose(globalMatrix(rig->index()), controller);
+        continue;
+      }
     }
+    renderDebugNode(rig->child(0));
   }
 }
 
@@ -372,36 +493,151 @@ void SceneHierarchy::processGizmos(bool use_centroid) {
 
 // ----------------------------------------------------------------------------
 
+void SceneHierarchy::rebuildTransforms() {
+  auto &T = transforms_;
+
+  // Keep the culling proxies of the entities still in the hierarchy.
+  std::unordered_map<Entity const*, int32_t> proxies;
+  for (int32_t i = 0; i < T.size(); ++i) {
+    if (AABBTree::kNull != T.proxies[i]) {
+      proxies[T.entities[i]] = T.proxies[i];
+    }
+  }
+
+  T.entities.clear();
+  T.parents.clear();
+  std::vector<int32_t> depths;
+
+  // Depth first traversal, children being pushed reversed to keep their order.
+  struct Node_t {
+    Entity *entity;
+    int32_t parent;
+    int32_t depth;
+  };
+  std::vector<Node_t> stack;
+  for (auto it = root_->children_.rbegin(); it != root_->children_.rend(); ++it) {
+    stack.push_back({ it->get(), -1, 0 });
+  }
+
+  int32_t max_depth = 0;
+  while (!stack.empty()) {
+    auto const node = stack.back();
+    stack.pop_back();
+
+    int32_t const index = T.size();
+    node.entity->index_ = index;
+    T.entities.push_back(node.entity);
+    T.parents.push_back(node.parent);
+    depths.push_back(node.depth);
+    max_depth = std::max(max_depth, node.depth);
+
+    auto const& children = node.entity->children_;
+    for (auto it = children.rbegin(); it != children.rend(); ++it) {
+      stack.push_back({ it->get(), index, node.depth + 1 });
+    }
+  }
+
+  // Sort the indices by depth (counting sort).
+  int32_t const nentities = T.size();
+  T.level_offsets.assign(max_depth + 2, 0);
+  for (auto depth : depths) {
+    ++T.level_offsets[depth + 1];
+  }
+  for (size_t level = 1; level < T.level_offsets.size(); ++level) {
+    T.level_offsets[level] += T.level_offsets[level - 1];
+  }
+  T.depth_order.resize(nentities);
+  {
+    auto cursors = T.level_offsets;
+    for (int32_t i = 0; i < nentities; ++i) {
+      T.depth_order[cursors[depths[i]]++] = i;
+    }
+  }
+
+  T.locals.resize(nentities);
+  T.globals.resize(nentities);
+  T.dirty.assign(nentities, 0u);
+  T.invalid.assign(nentities, 1u);
+
+  T.proxies.assign(nentities, AABBTree::kNull);
+  for (int32_t i = 0; i < nentities; ++i) {
+    if (auto it = proxies.find(T.entities[i]); it != proxies.end()) {
+      T.proxies[i] = it->second;
+      drawables_tree_.set_user_data(it->second, i);
+      proxies.erase(it);
+    }
+  }
+  for (auto const& [entity, proxy] : proxies) {
+    drawables_tree_.remove(proxy);
+  }
+
+  bTopologyChanged_ = false;
+}
+
 void SceneHierarchy::updateHierarchy(float const dt) {
   // (the root is used as a virtual entity and is hence not updated).
-  int32_t index = -1;
+  if (bTopologyChanged_) {
+    rebuildTransforms();
+  }
+  auto &T = transforms_;
+  int32_t const nentities = T.size();
 
-  frame_.matrices_stack.push( glm::mat4(1.0f) );
-  for (auto child : root_->children_) {
-    ++index;
-    subUpdateHierarchy(dt, child, index);
+  for (auto *entity : T.entities) {
+    entity->update(dt);
   }
-  frame_.matrices_stack.pop();    
-}
 
-void SceneHierarchy::subUpdateHierarchy(float const dt, EntityHandle entity, int &index) {
-  // Update entity.
-  entity->index_ = index;
-  entity->update(dt);
+  #pragma omp parallel num_threads(LOOP_NTHREADS) if (nentities > kMinParallelTransforms)
+  {
+    // Retrieve the modified locals.
+    #pragma omp for schedule(static)
+    for (int32_t i = 0; i < nentities; ++i) {
+      auto const& local = T.entities[i]->localMatrix();
+      bool const bModified = T.invalid[i] || (local != T.locals[i]);
+      if (bModified) {
+        T.locals[i] = local;
+      }
+      T.dirty[i] = bModified ? 1u : 0u;
+      T.invalid[i] = 0u;
+    }
 
-  // Update global matrix.
-  auto& global_matrix{ frame_.globals[index] };
-  global_matrix = frame_.matrices_stack.top() 
-                * entity->transform().matrix()
-                ;
+    // Update the globals of modified subtrees, level by level, parents being
+    // updated by the previous level.
+    int32_t const nlevels = static_cast<int32_t>(T.level_offsets.size()) - 1;
+    for (int32_t level = 0; level < nlevels; ++level) {
+      #pragma omp for schedule(static)
+      for (int32_t k = T.level_offsets[level]; k < T.level_offsets[level + 1]; ++k) {
+        int32_t const i = T.depth_order[k];
+        int32_t const parent = T.parents[i];
+
+        if (parent < 0) {
+          if (T.dirty[i]) {
+            T.globals[i] = T.locals[i];
+          }
+        } else if (T.dirty[i] || T.dirty[parent]) {
+          T.dirty[i] = 1u;
+          MultiplyAffine( T.globals[parent], T.locals[i], T.globals[i]);
+        }
+      }
+    }
+  }
+}
 
-  // Sub-hierarchy update.
-  frame_.matrices_stack.push( global_matrix );
-  for (auto child : entity->children_) {
-    ++index;
-    subUpdateHierarchy(dt, child, index);
+void SceneHierarchy::updateSubtreeGlobals(int32_t const index) {
+  auto &T = transforms_;
+
+  // Entities are indexed depth first, so the subtree follows its root until an
+  // entity whose parent precedes it.
+  // (the current locals are used, as other entities may have moved this frame)
+  int32_t const nentities = T.size();
+  for (int32_t i = index; (i < nentities) && ((i == index) || (T.parents[i] >= index)); ++i) {
+    auto const& local = T.entities[i]->localMatrix();
+    int32_t const parent = T.parents[i];
+    if (parent < 0) {
+      T.globals[i] = local;
+    } else {
+      MultiplyAffine( T.globals[parent], local, T.globals[i]);
+    }
   }
-  frame_.matrices_stack.pop();
 }
 
 void SceneHierarchy::updateSelectedLocalMatrices() {
@@ -423,7 +659,52 @@ void SceneHierarchy::updateSelectedLocalMatrices() {
   }
 }
 
-void SceneHierarchy::sortDrawables(Camera const& camera) {
+void SceneHierarchy::updateDrawablesTree() {
+  auto &T = transforms_;
+
+  // Insert new drawables and move those whose global or skinned bounds changed.
+  int32_t ndrawables = 0;
+  ForEachComponent<VisualComponent>([this, &T, &ndrawables](Entity &e, auto const&) {
+    if (!inScene(e)) {
+      return;
+    }
+    ++ndrawables;
+
+    int32_t const index = e.index();
+    auto &proxy = T.proxies[index];
+    if ((AABBTree::kNull != proxy) && !T.dirty[index] && !e.has<SkinComponent>()) {
+      return;
+    }
+
+    auto const bounds = localBounds(e.shared_from_this()).transform(T.globals[index]);
+    if (AABBTree::kNull == proxy) {
+      proxy = drawables_tree_.insert(bounds, index);
+    } else {
+      drawables_tree_.move(proxy, bounds);
+    }
+  });
+
+  // Remove the proxies of entities whose visual component was removed.
+  if (drawables_tree_.size() != ndrawables) {
+    for (int32_t i = 0; i < T.size(); ++i) {
+      if ((AABBTree::kNull != T.proxies[i]) && !T.entities[i]->has<VisualComponent>()) {
+        drawables_tree_.remove(T.proxies[i]);
+        T.proxies[i] = AABBTree::kNull;
+      }
+    }
+  }
+}
+
+void SceneHierarchy::cullDrawables(Camera const& camera, EntityList_t &drawables, std::vector<float> &depths) const {
+  // Retrieve the drawables whose bounds intersect the camera frustum.
+  std::vector<int32_t> indices;
+  drawables_tree_.query(Frustum_t(camera.viewproj()), indices);
+
+  drawables.clear();
+  for (auto index : indices) {
+    drawables.push_back( transforms_.entities[index]->shared_from_this() );
+  }
+
   auto const& eye_pos = camera.position();
   auto const& eye_dir = camera.direction();
 
@@ -434,18 +715,12 @@ void SceneHierarchy::sortDrawables(Camera const& camera) {
     return glm::dot(eye_dir, dir);
   };
 
-  // Store all the drawables dot products.
-  std::vector<float> dotproducts;
-  dotproducts.reserve(frame_.drawables.size());
-  for (auto &e : frame_.drawables) {
-    dotproducts.push_back(calculate_entity_dp(e));
+  // Store all the drawables dot products, indexed by entity.
+  // (draws are sorted by the renderer queue)
+  depths.resize(transforms_.size(), 0.0f);
+  for (auto &e : drawables) {
+    depths[e->index()] = calculate_entity_dp(e);
   }
-
-  // Sort drawables front to back.
-  frame_.drawables.sort([&dotproducts](auto const& A, auto const& B) {
-      return dotproducts[A->index()] < dotproducts[B->index()];
-    }
-  );
 }
 
 void SceneHierarchy::renderDebugNode(EntityHandle node) const {
@@ -455,26 +730,9 @@ void SceneHierarchy::renderDebugNode(EntityHandle node) const {
 
   {
     auto const n = node->nchildren();
-
-    // Color.
-    auto rgb = Im3d::Color((0 == n) ? glm::vec4(1.0f, 0.0f, 0.0f, 1.0f) :    // leaf
-                           (1 == n) ? glm::vec4(0.5f, 1.0f, 0.5f, 1.0f) :    // joint
-                                      glm::vec4(1.0f, 1.0f, 0.9f, 1.0f) );   // node
-
-    // Position.
     auto const start{ globalPosition(node) };
-
-    // [fixme] the debug shapes should scale depending on some factors.
-    float constexpr scale = 0.02f; //
-
-    Im3d::PushColor( rgb );
-    if (1 == n) {
-      auto const end{ globalPosition(node->child(0)) };
-      Im3d::DrawPrism( start, end, 1.0f * scale, 5);
-    } else {
-      Im3d::DrawSphere( start, 2.0f * scale, kDebugSphereResolution);
-    }
-    Im3d::PopColor();
+    auto const end{ (1 == n) ? globalPosition(node->child(0)) : start };
+    RenderDebugJoint(start, end, n);
   }
 
   // Recursively render sub hierarchy.
@@ -483,4 +741,28 @@ void SceneHierarchy::renderDebugNode(EntityHandle node) const {
   }
 }
 
+void SceneHierarchy::renderDebugPose(glm::mat4 const& rig_global, SkeletonController const& controller) const {
+  auto const& parents = controller.skeleton()->parents;
+  auto const& global_pose_matrices = controller.global_pose_matrices();
+  int32_t const njoints = controller.njoints();
+
+  // Count the joints children, keeping the first one.
+  std::vector<int32_t> nchildren(njoints, 0);
+  std::vector<int32_t> first_child(njoints, -1);
+  for (int32_t i = 1; i < njoints; ++i) {
+    if (auto const parent_id = parents[i]; (parent_id > -1) && (0 == nchildren[parent_id]++)) {
+      first_child[parent_id] = i;
+    }
+  }
+
+  auto const position = [&](int32_t const joint_id) {
+    return glm::vec3(rig_global * global_pose_matrices[joint_id][3]);
+  };
+  for (int32_t i = 0; i < njoints; ++i) {
+    auto const start{ position(i) };
+    auto const end{ (1 == nchildren[i]) ? position(first_child[i]) : start };
+    RenderDebugJoint(start, end, nchildren[i]);
+  }
+}
+
 // ----------------------------------------------------------------------------
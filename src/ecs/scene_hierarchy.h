@@ -2,11 +2,13 @@
 #define BARBU_ECS_SCENE_HIERARCHY_H_
 
 #include "ecs/ecs.h"
+#include "fx/animation/skinning_palette.h"
+#include "utils/aabb_tree.h"
 
 #include <cassert>
+#include <functional>
 #include <vector>
 #include <list>
-#include <stack>
 
 class Camera;
 class UIView;
@@ -64,6 +66,7 @@ class SceneHierarchy {
     entity->parent_ = parent;
     parent->children_.push_back( entity );
     entities_.push_back( entity );
+    bTopologyChanged_ = true;
 
     return entity;
   }
@@ -100,6 +103,9 @@ class SceneHierarchy {
   /* Create a model entity by importing an external model file. */
   EntityHandle importModel(std::string_view filename);
 
+  /* Import a model in the background, on_import is called once it is added to the scene. */
+  void importModelAsync(std::string_view filename, std::function<void(EntityHandle)> on_import = nullptr);
+
   /* Select all entities when true, deselect otherwise. */
   void toggleSelect(EntityHandle entity, bool status);
 
@@ -121,8 +127,8 @@ class SceneHierarchy {
   /* Getters */
 
   /* Return the global matrix for the given entity index. */
-  inline glm::mat4& globalMatrix(int32_t index) { return frame_.globals[index]; }
-  inline glm::mat4 const& globalMatrix(int32_t index) const { return frame_.globals[index]; }
+  inline glm::mat4& globalMatrix(int32_t index) { return transforms_.globals[index]; }
+  inline glm::mat4 const& globalMatrix(int32_t index) const { return transforms_.globals[index]; }
 
   /* Return the entity position in world space. */
   inline glm::vec3 globalPosition(EntityHandle e) const {
@@ -134,6 +140,9 @@ class SceneHierarchy {
     return glm::vec3(parentGlobalMatrix(e) * glm::vec4(e->centroid(), 1.0)); //
   }
 
+  /* Return the entity's mesh bounds in its local space, deformed when it is skinned. */
+  BoundingBox_t localBounds(EntityHandle e) const;
+
   /* Return the first entity of the list, if any. */
   inline EntityHandle first() const { return entities_.empty() ? nullptr : entities_.front(); } //
   
@@ -143,12 +152,27 @@ class SceneHierarchy {
   /* Return the list of selected entities. */
   inline EntityList_t const& selected() const { return frame_.selected; }
   
-  /* Return the list of drawable entities. */
+  /* Return the list of drawable entities visible from the update camera. */
   inline EntityList_t const& drawables() const { return frame_.drawables; }
+
+  /* Return true when drawables() was culled from the camera view. */
+  bool isCullingCamera(Camera const& camera) const;
+
+  /* Set the drawables visible from a camera. */
+  void cullDrawables(Camera const& camera, EntityList_t &drawables) const;
   
   /* Return the list of collidable entities. */
   inline EntityList_t const& colliders() const { return frame_.colliders; }
 
+  /* Return the list of light entities. */
+  inline EntityList_t const& lights() const { return frame_.lights; }
+
+  /* Return the skinned characters animation system. */
+  inline AnimationSystem& animation() { return animation_; }
+
+  /* Return the device skinning palettes of the animated entities. */
+  inline SkinningPalette const& skinningPalette() const { return skinning_palette_; }
+
   /* Return true when the entity is selected. */
   bool isSelected(EntityHandle entity) const;
 
@@ -176,42 +200,80 @@ class SceneHierarchy {
   void processGizmos(bool use_centroid = false);
 
  private:
+  // Entities transforms flattened by index (depth first), rebuilt when the
+  // hierarchy topology changes. Globals are updated level by level and only
+  // when their local or an ancestor's one was modified.
+  struct Transforms_t {
+    std::vector<Entity*> entities;          //< entities by index
+    std::vector<int32_t> parents;           //< parent index, -1 for the root's children
+    std::vector<int32_t> depth_order;       //< indices sorted by depth
+    std::vector<int32_t> level_offsets;     //< first depth_order index of each level, then the total
+    std::vector<glm::mat4> locals;          //< locals used by the last update
+    std::vector<glm::mat4> globals;
+    std::vector<uint8_t> dirty;             //< globals modified by the last update
+    std::vector<uint8_t> invalid;           //< globals to recompute on the next update
+    std::vector<int32_t> proxies;           //< drawables tree proxy, or AABBTree::kNull
+
+    inline int32_t size() const noexcept {
+      return static_cast<int32_t>(entities.size());
+    }
+  };
+
   // Set of buffers modified each frame.
   struct PerFrame_t {
-    // Entities' current frame global matrices.
-    std::vector<glm::mat4> globals; //
-
-    // Matrices stack to compute transforms.
-    // [ using the global matrices and parent frame index we could bypass it ]
-    std::stack<glm::mat4> matrices_stack;
-
     // Currently selected entities.
     EntityList_t selected;
 
     // Camera-dependent entities to render.
     EntityList_t drawables;
 
+    // Drawables' depth relative to the camera, indexed by entity.
+    std::vector<float> depths;
+
+    // Drawables visibility from the camera, indexed by entity.
+    std::vector<uint8_t> visibles;
+
     // Entities with colliders.
     EntityList_t colliders;
 
+    // Entities with lights.
+    EntityList_t lights;
+
     void clear() {
-      assert(matrices_stack.empty());
-      globals.clear();
       selected.clear();
       drawables.clear();
+      depths.clear();
+      visibles.clear();
       colliders.clear();
+      lights.clear();
     }
   };
 
-  /* Hierarchically prefix-update entities. */
+  /* Flatten the hierarchy, assigning the entities index in depth first order. */
+  void rebuildTransforms();
+
+  /* Update entities then their global matrices. */
   void updateHierarchy(float const dt);
-  void subUpdateHierarchy(float const dt, EntityHandle entity, int &index);
+
+  /* Recompute the globals of an entity and its sub-hierarchy from their current locals. */
+  void updateSubtreeGlobals(int32_t const index);
 
   /* Update locals matrices based on their modified globals. */
   void updateSelectedLocalMatrices();
 
-  /* Sort drawable entities front to back, relative to the camera. */
-  void sortDrawables(Camera const& camera);
+  /* Update the world bounds of the drawables in the culling tree. */
+  void updateDrawablesTree();
+
+  /* Set the drawables visible from a camera, with their depth by index. */
+  void cullDrawables(Camera const& camera, EntityList_t &drawables, std::vector<float> &depths) const;
+
+  /* Return true when the entity was indexed by the last hierarchy update. */
+  inline bool inScene(Entity const& e) const noexcept {
+    return e.indexed()
+        && (e.index() < transforms_.size())
+        && (transforms_.entities[e.index()] == &e)
+        ;
+  }
 
   /* Return the entity's parent global matrix, or the identity if none exists. */
   inline glm::mat4 const& parentGlobalMatrix(EntityHandle e) const { 
@@ -223,10 +285,19 @@ class SceneHierarchy {
 
   /* Render a node depending on its relations in hierarchy. */
   void renderDebugNode(EntityHandle node) const;
+
+  /* Render the animated pose of a rig from its skin controller. */
+  void renderDebugPose(glm::mat4 const& rig_global, SkeletonController const& controller) const;
   
   EntityHandle root_;                 //< Entry to the entity hierarchy.
   EntityList_t entities_;             //< List of all current entities.
+  Transforms_t transforms_;           //< Flattened entities transforms.
+  bool bTopologyChanged_ = true;      //< True when transforms_ must be rebuilt.
+  AABBTree drawables_tree_;           //< World bounds of the drawables, by entity index.
+  glm::mat4 culling_viewproj_{0.0f};  //< View projection used to cull frame_.drawables.
   PerFrame_t frame_;                  //< Holds per frame data.
+  AnimationSystem animation_;         //< Batch skinning evaluation.
+  SkinningPalette skinning_palette_;  //< Skinning data shared by the draws.
 };
 
 // ----------------------------------------------------------------------------
@@ -0,0 +1,247 @@
+#include "fx/animation/animation_system.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "fx/animation/cpu_skinning.h"
+#include "ui/views/fx/AnimationView.h"
+
+#ifdef BARBU_NPROC_MAX
+#define LOOP_NTHREADS  (BARBU_NPROC_MAX)
+#else
+#define LOOP_NTHREADS  4
+#endif
+
+// -----------------------------------------------------------------------------
+
+namespace {
+
+// Frame duration used before the first frames are measured, and its upper bound.
+static constexpr float kDefaultFrameTime = 1.0f / 60.0f;
+static constexpr float kMaxFrameTime     = 0.1f;
+
+} // namespace
+
+// -----------------------------------------------------------------------------
+
+void AnimationSystem::init() {
+  ui_view = std::make_shared<views::AnimationView>(params_);
+}
+
+void AnimationSystem::clear(float const global_time) {
+  // (controllers may have been destroyed since the last frame, so they are
+  //  not accessed here)
+  controllers_.clear();
+  throttled_.clear();
+  characters_.clear();
+  block_controllers_.clear();
+  njoints_ = 0;
+  bDualQuaternions_ = false;
+
+  float const dt = global_time - global_time_;
+  frame_time_  = ((dt > 0.0f) && (dt < kMaxFrameTime)) ? dt : kDefaultFrameTime;
+  global_time_ = global_time;
+
+  auto &stats = params_.readonly;
+  stats.ncharacters     = 0;
+  stats.nevaluated      = 0;
+  stats.nskipped_joints = 0;
+}
+
+int32_t AnimationSystem::lod_level(float const screen_coverage) const {
+  if (!params_.lod.bEnable) {
+    return 0;
+  }
+  int32_t level = 0;
+  while ((level < kNumLODs - 1) && (screen_coverage < params_.lod.thresholds[level])) {
+    ++level;
+  }
+  return level;
+}
+
+bool AnimationSystem::add(SkeletonController &controller, SkinningMode const mode, SkeletonHandle skeleton, float const global_time, Sequence_t &sequence, int32_t const lod_level) {
+  auto &lod = controller.lod_;
+  int32_t const level = params_.lod.bEnable ? std::clamp(lod_level, 0, kNumLODs - 1) : 0;
+  int32_t const period = 1 << level;
+
+  // Throttled controllers are evaluated once their last key time is reached,
+  // one period ahead, otherwise their palette is only interpolated.
+  bool const bRestart = !lod.bValid
+                     || (level != lod.level)
+                     || (mode != controller.mode_)
+                     || (global_time < lod.key_times[0]);
+  bool const bEvaluate = (level == 0) || bRestart || (global_time >= lod.key_times[1]);
+
+  lod.level  = level;
+  lod.bValid = lod.bValid && !bRestart;
+
+  if (bEvaluate) {
+    float const eval_time = lod.bValid ? global_time + period * frame_time_ : global_time;
+    int32_t const mask_level = params_.lod.joint_mask_level;
+    controller.skip_height_ = (level >= mask_level) ? level - mask_level + 1 : 0;
+
+    if (!controller.prepare(mode, skeleton, eval_time, sequence)) {
+      controller.palette_offset_ = -1;
+      lod.bValid = false;
+      return false;
+    }
+    lod.key_times[0] = lod.bValid ? lod.key_times[1] : global_time;
+    lod.key_times[1] = eval_time;
+
+    int32_t const controller_index = static_cast<int32_t>(controllers_.size());
+    controller.block_offset_ = static_cast<int32_t>(block_controllers_.size());
+    controllers_.push_back(&controller);
+    block_controllers_.insert(block_controllers_.end(), controller.nblocks(), controller_index);
+  } else {
+    controller.block_offset_ = -1;
+  }
+
+  if (level > 0) {
+    throttled_.push_back(&controller);
+  } else {
+    lod.bValid = false;
+  }
+
+  controller.palette_offset_ = njoints_;
+  njoints_ += controller.njoints();
+  characters_.push_back(&controller);
+  bDualQuaternions_ |= (SkinningMode::DualQuaternion == mode);
+
+  auto &stats = params_.readonly;
+  stats.ncharacters += 1;
+  stats.nevaluated += bEvaluate ? 1 : 0;
+  stats.nskipped_joints += bEvaluate ? controller.nskipped_joints_ : controller.njoints();
+
+  return true;
+}
+
+void AnimationSystem::evaluate() {
+  int32_t const ncontrollers = static_cast<int32_t>(controllers_.size());
+  int32_t const nthrottled = static_cast<int32_t>(throttled_.size());
+  int32_t const ncharacters = static_cast<int32_t>(characters_.size());
+  int32_t const nblocks = static_cast<int32_t>(block_controllers_.size());
+
+  auto &stats = params_.readonly;
+  stats.evaluation_ms = 0.0f;
+  stats.saved_ms = 0.0f;
+
+  if (0 == njoints_) {
+    return;
+  }
+
+  // Resize the palettes when needed.
+  if (skinning_matrices_.size() < static_cast<size_t>(njoints_)) {
+    skinning_matrices_.resize(njoints_);
+    dual_quaternions_.resize(njoints_);
+  }
+
+  auto const start_time = std::chrono::steady_clock::now();
+
+  // (a single parallel region, stages are separated by the loops' barriers)
+  #pragma omp parallel num_threads(LOOP_NTHREADS)
+  {
+    // 1) Blend the sampled clips into local poses, per joints block.
+    #pragma omp for schedule(static)
+    for (int32_t i = 0; i < nblocks; ++i) {
+      auto *controller = controllers_[block_controllers_[i]];
+      controller->evaluate_local_pose(i - controller->block_offset_);
+    }
+
+    // 2) Generate the global pose matrices, per character.
+    #pragma omp for schedule(dynamic)
+    for (int32_t i = 0; i < ncontrollers; ++i) {
+      controllers_[i]->generate_global_pose_matrices();
+    }
+
+    // 3) Generate the final skinning data into the palettes, per joints block.
+    #pragma omp for schedule(static)
+    for (int32_t i = 0; i < nblocks; ++i) {
+      auto const *controller = controllers_[block_controllers_[i]];
+      bool const bDualQuaternion = (SkinningMode::DualQuaternion == controller->skinning_mode());
+      int32_t const offset = controller->palette_offset_;
+      controller->generate_skinning_data(
+        i - controller->block_offset_,
+        skinning_matrices_.data() + offset,
+        bDualQuaternion ? dual_quaternions_.data() + offset : nullptr
+      );
+    }
+
+    // 4) Interpolate the palettes of the throttled characters.
+    #pragma omp for schedule(dynamic)
+    for (int32_t i = 0; i < nthrottled; ++i) {
+      update_throttled(*throttled_[i]);
+    }
+
+    // 5) Bound the skinned meshes from their palettes.
+    #pragma omp for schedule(static)
+    for (int32_t i = 0; i < ncharacters; ++i) {
+      auto &controller = *characters_[i];
+      controller.skinned_bounds_ = CalculateSkinnedBounds(
+        *controller.skeleton(), skinning_matrices_.data() + controller.palette_offset_
+      );
+    }
+  }
+
+  // Estimate the time saved by the LOD from the average cost per joint.
+  std::chrono::duration<float, std::milli> const elapsed = std::chrono::steady_clock::now() - start_time;
+  int32_t const nevaluated_joints = std::max(njoints_ - stats.nskipped_joints, 1);
+  stats.evaluation_ms = elapsed.count();
+  stats.saved_ms = stats.evaluation_ms * stats.nskipped_joints / static_cast<float>(nevaluated_joints);
+}
+
+void AnimationSystem::update_throttled(SkeletonController &controller) {
+  auto &lod = controller.lod_;
+  int32_t const njoints = controller.njoints();
+  int32_t const offset = controller.palette_offset_;
+  bool const bDualQuaternion = (SkinningMode::DualQuaternion == controller.skinning_mode());
+
+  auto *matrices = skinning_matrices_.data() + offset;
+  auto *dual_quaternions = dual_quaternions_.data() + offset;
+
+  // Store the newly evaluated palette as the last key.
+  if (controller.block_offset_ > -1) {
+    if (lod.bValid) {
+      lod.skinning_matrices[0].swap(lod.skinning_matrices[1]);
+      lod.dual_quaternions[0].swap(lod.dual_quaternions[1]);
+    }
+    lod.skinning_matrices[1].assign(matrices, matrices + njoints);
+    if (bDualQuaternion) {
+      lod.dual_quaternions[1].assign(dual_quaternions, dual_quaternions + njoints);
+    }
+
+    // On restart both keys are the current palette.
+    if (!lod.bValid) {
+      lod.skinning_matrices[0] = lod.skinning_matrices[1];
+      lod.dual_quaternions[0] = lod.dual_quaternions[1];
+      lod.bValid = true;
+      return;
+    }
+  }
+
+  // Interpolate the palette between the two keys.
+  float const duration = lod.key_times[1] - lod.key_times[0];
+  float const t = (duration > 0.0f) ? glm::clamp((global_time_ - lod.key_times[0]) / duration, 0.0f, 1.0f) : 1.0f;
+
+  auto const& M0 = lod.skinning_matrices[0];
+  auto const& M1 = lod.skinning_matrices[1];
+  for (int32_t i = 0; i < njoints; ++i) {
+    matrices[i] = M0[i] * (1.0f - t) + M1[i] * t;
+  }
+
+  if (bDualQuaternion) {
+    auto const& D0 = lod.dual_quaternions[0];
+    auto const& D1 = lod.dual_quaternions[1];
+    for (int32_t i = 0; i < njoints; ++i) {
+      // Flip the second key to the hemisphere of the first, the sign of the
+      // converted dual quaternions depending on their conversion case.
+      glm::dualquat d1 = D1[i];
+      if (glm::dot(D0[i].real, d1.real) < 0.0f) {
+        d1.real = -d1.real;
+        d1.dual = -d1.dual;
+      }
+      dual_quaternions[i] = glm::normalize(glm::lerp(D0[i], d1, t));
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
@@ -0,0 +1,147 @@
+#ifndef BARBU_ANIMATION_ANIMATION_SYSTEM_H_
+#define BARBU_ANIMATION_ANIMATION_SYSTEM_H_
+
+#include <memory>
+#include <vector>
+
+#include "fx/animation/common.h"
+#include "fx/animation/skeleton_controller.h"
+
+class UIView;
+
+// -----------------------------------------------------------------------------
+
+//
+// Evaluate the skeleton controllers of every animated characters in batch.
+//
+// Controllers are gathered each frame then evaluated together in a single
+// parallel job over (character, joints block) work items, the skinning data of
+// all characters are written to contiguous palette buffers.
+//
+// Distant characters use an animation LOD : they are updated every 2^level
+// frames, ahead of time, with their palettes interpolated in between, and their
+// lowest joints in the hierarchy are not sampled.
+//
+class AnimationSystem {
+ public:
+  // Number of animation LOD levels.
+  static constexpr int32_t kNumLODs = 4;
+
+  struct Parameters_t {
+    struct {
+      bool bEnable = true;
+
+      // Minimum screen coverage of the LOD levels, as the ratio of a character's
+      // projected bounding radius to half the screen height.
+      float thresholds[kNumLODs - 1]{ 0.25f, 0.10f, 0.04f };
+
+      // First level masking the joints, each subsequent level masks one more
+      // layer of joints from the leaves.
+      int32_t joint_mask_level = 2;
+    } lod;
+
+    struct {
+      int32_t ncharacters       = 0;
+      int32_t nevaluated        = 0;    //< characters evaluated this frame
+      int32_t nskipped_joints   = 0;    //< joints throttled or masked by LOD
+      float evaluation_ms       = 0.0f;
+      float saved_ms            = 0.0f; //< estimated from the cost per joint
+    } readonly;
+  };
+
+ public:
+  AnimationSystem() = default;
+
+  void init();
+
+  /* Remove every controllers added for the previous frame, starting a new
+   * frame at global_time. */
+  void clear(float const global_time);
+
+  /* Return the LOD level of a character given its screen coverage. */
+  int32_t lod_level(float const screen_coverage) const;
+
+  /* Add a controller to evaluate, return false when it has no active clips. */
+  bool add(SkeletonController &controller, SkinningMode const mode, SkeletonHandle skeleton, float const global_time, Sequence_t &sequence, int32_t const lod_level = 0);
+
+  /* Evaluate the poses and skinning data of every added controllers. */
+  void evaluate();
+
+  /* Return the skinning matrices of a controller evaluated this frame. */
+  inline glm::mat3x4 const* skinning_matrices(SkeletonController const& controller) const {
+    assert( controller.palette_offset_ > -1 );
+    return skinning_matrices_.data() + controller.palette_offset_;
+  }
+
+  /* Return the dual quaternions of a controller evaluated this frame. */
+  inline glm::dualquat const* dual_quaternions(SkeletonController const& controller) const {
+    assert( controller.palette_offset_ > -1 );
+    assert( SkinningMode::DualQuaternion == controller.skinning_mode() );
+    return dual_quaternions_.data() + controller.palette_offset_;
+  }
+
+  /* Return the skinning matrices of every controllers. */
+  inline glm::mat3x4 const* skinning_matrices() const {
+    return skinning_matrices_.data();
+  }
+
+  /* Return the dual quaternions of every controllers, valid for those using them. */
+  inline glm::dualquat const* dual_quaternions() const {
+    return dual_quaternions_.data();
+  }
+
+  /* Return true when a controller uses dual quaternions this frame. */
+  inline bool has_dual_quaternions() const {
+    return bDualQuaternions_;
+  }
+
+  /* Return the number of joints evaluated this frame. */
+  inline int32_t njoints() const {
+    return njoints_;
+  }
+
+  inline Parameters_t& params() noexcept {
+    return params_;
+  }
+
+  // User interface.
+  std::shared_ptr<UIView> ui_view = nullptr;
+
+ private:
+  /* Update the LOD keys of a throttled controller and interpolate its palette. */
+  void update_throttled(SkeletonController &controller);
+
+  Parameters_t params_;
+
+  // Controllers to evaluate.
+  std::vector<SkeletonController*> controllers_;
+
+  // Controllers with a LOD level, evaluated this frame or not.
+  std::vector<SkeletonController*> throttled_;
+
+  // Every controllers added this frame.
+  std::vector<SkeletonController*> characters_;
+
+  // Work items, mapping each joints block to its controller index.
+  std::vector<int32_t> block_controllers_;
+
+  // Total number of joints in the palettes.
+  int32_t njoints_ = 0;
+  bool bDualQuaternions_ = false;
+
+  // Current frame time and duration.
+  float global_time_ = 0.0f;
+  float frame_time_  = 0.0f;
+
+  // Skinning palettes of all controllers.
+  JointBuffer_t<glm::mat3x4>    skinning_matrices_;
+  JointBuffer_t<glm::dualquat>  dual_quaternions_;
+
+ private:
+  AnimationSystem(AnimationSystem const&) = delete;
+  AnimationSystem(AnimationSystem&&) = delete;
+};
+
+// -----------------------------------------------------------------------------
+
+#endif  // BARBU_ANIMATION_ANIMATION_SYSTEM_H_
@@ -0,0 +1,48 @@
+#ifndef BARBU_ANIMATION_BLEND_NODE_H_
+#define BARBU_ANIMATION_BLEND_NODE_H_
+
+#include <cstdint>
+#include <vector>
+#include "glm/vec2.hpp"
+
+#include "fx/animation/common.h"
+
+// -----------------------------------------------------------------------------
+
+// Types of blend tree nodes, also used as the compiled instructions opcodes.
+enum class BlendNodeType : uint8_t {
+  Clip,             //< leaf referencing an action
+  Blend1D,          //< blend its children placed on a parameter line
+  Blend2D,          //< blend its children placed in a 2D parameter space
+  Additive,         //< add a weighted layer (second child) over a base (first child)
+  StateMachine,     //< crossfade between its children states, one being active
+  kCount
+};
+
+// Authored description of a blend tree node, before compilation.
+struct BlendNode_t {
+  BlendNodeType type = BlendNodeType::Clip;
+
+  std::vector<int32_t> children;            //< children node indices
+  std::vector<glm::vec2> positions;         //< children positions in blend spaces (x only in 1D)
+  int32_t params[2]{ -1, -1 };              //< blend spaces coordinates, additive weight
+
+  Action_t *action = nullptr;               //< clip leaves
+  float crossfade  = 0.0f;                  //< state machines transition duration
+  bool bSync       = false;                 //< state machines sync the entered state on markers
+};
+
+// Compiled node, evaluated in depth-first order.
+struct BlendInstruction_t {
+  BlendNodeType op = BlendNodeType::Clip;
+  bool bAdditive   = false;                 //< clips belonging to an additive layer
+  int32_t skip     = 0;                     //< next instruction after the node subtree
+  int32_t first_child = 0;                  //< offset in the children instructions
+  int32_t nchildren = 0;
+  int32_t params[2]{ -1, -1 };
+  int32_t data = -1;                        //< sequence clip, positions offset or state machine index
+};
+
+// -----------------------------------------------------------------------------
+
+#endif  // BARBU_ANIMATION_BLEND_NODE_H_
@@ -0,0 +1,446 @@
+#include "fx/animation/blend_tree.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "glm/glm.hpp"
+
+// -----------------------------------------------------------------------------
+
+namespace {
+
+// Weight below which a subtree is skipped.
+static constexpr float kMinWeight = 1.0e-5f;
+
+/// Map a phase between the sync markers of two clips : the phase keeps its
+/// relative position in the same markers segment.
+float SyncPhase(std::vector<float> const& src_markers, float phase, std::vector<float> const& dst_markers) {
+  if (src_markers.empty() || dst_markers.empty()) {
+    return phase;
+  }
+  int32_t const nsrc = static_cast<int32_t>(src_markers.size());
+  int32_t const ndst = static_cast<int32_t>(dst_markers.size());
+
+  // Find the source segment, the last one wrapping around to the first marker.
+  int32_t k = static_cast<int32_t>(std::upper_bound(src_markers.cbegin(), src_markers.cend(), phase) - src_markers.cbegin()) - 1;
+  if (k < 0) {
+    k = nsrc - 1;
+    phase += 1.0f;
+  }
+  float const a = src_markers[k];
+  float const b = (k + 1 < nsrc) ? src_markers[k + 1] : src_markers[0] + 1.0f;
+  float const factor = (b > a) ? (phase - a) / (b - a) : 0.0f;
+
+  // Matching destination segment.
+  int32_t const kd = (k == nsrc - 1) ? ndst - 1 : k % ndst;
+  float const c = dst_markers[kd];
+  float const d = (kd + 1 < ndst) ? dst_markers[kd + 1] : dst_markers[0] + 1.0f;
+
+  return glm::fract(c + factor * (d - c));
+}
+
+} // namespace
+
+// -----------------------------------------------------------------------------
+
+int32_t BlendTree::add_parameter(std::string_view name, float const default_value) {
+  parameter_names_.push_back(std::string(name));
+  parameter_defaults_.push_back(default_value);
+  return static_cast<int32_t>(parameter_names_.size()) - 1;
+}
+
+int32_t BlendTree::add_clip(Action_t *action) {
+  assert( nullptr != action );
+
+  BlendNode_t node;
+  node.type   = BlendNodeType::Clip;
+  node.action = action;
+  nodes_.push_back(node);
+  return static_cast<int32_t>(nodes_.size()) - 1;
+}
+
+int32_t BlendTree::add_blend_1d(int32_t const param, std::vector<int32_t> const& children, std::vector<float> const& thresholds) {
+  if (children.empty() || (children.size() != thresholds.size())) {
+    LOG_ERROR( "BlendTree : invalid 1D blend space." );
+    return -1;
+  }
+
+  BlendNode_t node;
+  node.type      = BlendNodeType::Blend1D;
+  node.children  = children;
+  node.params[0] = param;
+  for (auto const x : thresholds) {
+    node.positions.push_back(glm::vec2(x, 0.0f));
+  }
+  nodes_.push_back(node);
+  return static_cast<int32_t>(nodes_.size()) - 1;
+}
+
+int32_t BlendTree::add_blend_2d(int32_t const param_x, int32_t const param_y, std::vector<int32_t> const& children, std::vector<glm::vec2> const& positions) {
+  if (children.empty() || (children.size() != positions.size())) {
+    LOG_ERROR( "BlendTree : invalid 2D blend space." );
+    return -1;
+  }
+
+  BlendNode_t node;
+  node.type      = BlendNodeType::Blend2D;
+  node.children  = children;
+  node.positions = positions;
+  node.params[0] = param_x;
+  node.params[1] = param_y;
+  nodes_.push_back(node);
+  return static_cast<int32_t>(nodes_.size()) - 1;
+}
+
+int32_t BlendTree::add_additive(int32_t const base, int32_t const layer, int32_t const weight_param) {
+  BlendNode_t node;
+  node.type      = BlendNodeType::Additive;
+  node.children  = { base, layer };
+  node.params[0] = weight_param;
+  nodes_.push_back(node);
+  return static_cast<int32_t>(nodes_.size()) - 1;
+}
+
+int32_t BlendTree::add_state_machine(std::vector<int32_t> const& states, float const crossfade, bool const bSync) {
+  if (states.empty()) {
+    LOG_ERROR( "BlendTree : state machines need at least one state." );
+    return -1;
+  }
+
+  BlendNode_t node;
+  node.type      = BlendNodeType::StateMachine;
+  node.children  = states;
+  node.crossfade = crossfade;
+  node.bSync     = bSync;
+  nodes_.push_back(node);
+  return static_cast<int32_t>(nodes_.size()) - 1;
+}
+
+bool BlendTree::compile(int32_t const root) {
+  instructions_.clear();
+  children_.clear();
+  positions_.clear();
+  machines_.clear();
+  clips_.clear();
+  node_machines_.assign(nodes_.size(), -1);
+
+  if (!compile_node(root, false, 0)) {
+    instructions_.clear();
+    return false;
+  }
+
+  // Check the parameters references.
+  int32_t const nparams = static_cast<int32_t>(parameter_names_.size());
+  for (auto const& I : instructions_) {
+    bool const bUseParams = (I.op == BlendNodeType::Blend1D)
+                         || (I.op == BlendNodeType::Blend2D)
+                         || (I.op == BlendNodeType::Additive);
+    int32_t const nused = (I.op == BlendNodeType::Blend2D) ? 2 : 1;
+    for (int32_t i = 0; bUseParams && (i < nused); ++i) {
+      if ((I.params[i] < 0) || (I.params[i] >= nparams)) {
+        LOG_ERROR( "BlendTree : invalid parameter index", I.params[i] );
+        instructions_.clear();
+        return false;
+      }
+    }
+  }
+
+  return true;
+}
+
+bool BlendTree::compile_node(int32_t const node_id, bool const bAdditive, int32_t const depth) {
+  int32_t const nnodes = static_cast<int32_t>(nodes_.size());
+  if ((node_id < 0) || (node_id >= nnodes)) {
+    LOG_ERROR( "BlendTree : invalid node index", node_id );
+    return false;
+  }
+  if (depth >= nnodes) {
+    LOG_ERROR( "BlendTree : the graph has a cycle." );
+    return false;
+  }
+
+  auto const& node = nodes_[node_id];
+  if ((BlendNodeType::Additive == node.type) && (2 != node.children.size())) {
+    LOG_ERROR( "BlendTree : additive nodes need a base and a layer." );
+    return false;
+  }
+
+  BlendInstruction_t I;
+  I.op          = node.type;
+  I.bAdditive   = bAdditive;
+  I.first_child = static_cast<int32_t>(children_.size());
+  I.nchildren   = static_cast<int32_t>(node.children.size());
+  I.params[0]   = node.params[0];
+  I.params[1]   = node.params[1];
+
+  switch (node.type) {
+    case BlendNodeType::Clip:
+      I.data = static_cast<int32_t>(clips_.size());
+      clips_.push_back(node.action);
+    break;
+
+    case BlendNodeType::Blend1D:
+    case BlendNodeType::Blend2D:
+      I.data = static_cast<int32_t>(positions_.size());
+      positions_.insert(positions_.end(), node.positions.cbegin(), node.positions.cend());
+    break;
+
+    case BlendNodeType::StateMachine:
+      I.data = static_cast<int32_t>(machines_.size());
+      machines_.push_back({ node.crossfade, node.bSync });
+      node_machines_[node_id] = I.data;
+    break;
+
+    default:
+    break;
+  }
+
+  int32_t const index = static_cast<int32_t>(instructions_.size());
+  instructions_.push_back(I);
+  children_.resize(children_.size() + node.children.size());
+
+  // Emit the children subtrees right after their parent.
+  for (int32_t i = 0; i < I.nchildren; ++i) {
+    bool const bAdditiveLayer = (BlendNodeType::Additive == node.type) && (1 == i);
+    children_[I.first_child + i] = static_cast<int32_t>(instructions_.size());
+    if (!compile_node(node.children[i], bAdditive || bAdditiveLayer, depth + 1)) {
+      return false;
+    }
+  }
+  instructions_[index].skip = static_cast<int32_t>(instructions_.size());
+
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+
+void BlendTree::init(BlendTreeState_t &state, Sequence_t &sequence) const {
+  assert( compiled() );
+
+  state.parameters = parameter_defaults_;
+  state.weights.assign(instructions_.size(), 0.0f);
+  state.machines.assign(machines_.size(), BlendTreeState_t::Machine_t());
+
+  sequence.clear();
+  for (auto *action : clips_) {
+    sequence.push_back( SequenceClip_t(action) );
+  }
+}
+
+void BlendTree::evaluate(BlendTreeState_t &state, float const global_time, Sequence_t &sequence) const {
+  assert( compiled() );
+  assert( sequence.size() == clips_.size() );
+  assert( state.weights.size() == instructions_.size() );
+
+  for (auto &sc : sequence) {
+    sc.bEnable = false;
+    sc.weight  = 0.0f;
+  }
+
+  auto &weights = state.weights;
+  weights[0] = 1.0f;
+
+  int32_t const ninstructions = static_cast<int32_t>(instructions_.size());
+  for (int32_t i = 0; i < ninstructions;) {
+    auto const& I = instructions_[i];
+    float const w = weights[i];
+
+    // Skip inactive subtrees.
+    if (w < kMinWeight) {
+      i = I.skip;
+      continue;
+    }
+
+    int32_t const* children = children_.data() + I.first_child;
+
+    // Leading clip of the state left by a synced state machine, picked before
+    // the children weights of the previous evaluation are reset.
+    SequenceClip_t const* leader = nullptr;
+    if ((BlendNodeType::StateMachine == I.op) && machines_[I.data].bSync) {
+      auto const& M = state.machines[I.data];
+      if ((M.requested >= 0) && (M.requested < I.nchildren) && (M.requested != M.current)) {
+        leader = find_leader(children[M.current], weights, sequence);
+      }
+    }
+
+    for (int32_t c = 0; c < I.nchildren; ++c) {
+      weights[children[c]] = 0.0f;
+    }
+
+    switch (I.op) {
+      case BlendNodeType::Clip: {
+        auto &sc = sequence[I.data];
+        sc.bEnable   = true;
+        sc.weight    = w;
+        sc.bAdditive = I.bAdditive;
+      }
+      break;
+
+      case BlendNodeType::Blend1D: {
+        // Interpolate the two children surrounding the parameter.
+        float const x = state.parameters[I.params[0]];
+        auto const* thresholds = positions_.data() + I.data;
+        int32_t const last = I.nchildren - 1;
+
+        if (x <= thresholds[0].x) {
+          weights[children[0]] = w;
+        } else if (x >= thresholds[last].x) {
+          weights[children[last]] = w;
+        } else {
+          int32_t k = 0;
+          while (thresholds[k + 1].x <= x) {
+            ++k;
+          }
+          float const t = (x - thresholds[k].x) / (thresholds[k + 1].x - thresholds[k].x);
+          weights[children[k]]     = w * (1.0f - t);
+          weights[children[k + 1]] = w * t;
+        }
+      }
+      break;
+
+      case BlendNodeType::Blend2D: {
+        // Gradient band interpolation.
+        glm::vec2 const p( state.parameters[I.params[0]], state.parameters[I.params[1]] );
+        auto const* positions = positions_.data() + I.data;
+
+        float sum_weights = 0.0f;
+        int32_t nearest = 0;
+        for (int32_t a = 0; a < I.nchildren; ++a) {
+          glm::vec2 const pa = p - positions[a];
+          float influence = 1.0f;
+          for (int32_t b = 0; b < I.nchildren; ++b) {
+            glm::vec2 const ab = positions[b] - positions[a];
+            float const ab2 = glm::dot(ab, ab);
+            if ((a != b) && (ab2 > 0.0f)) {
+              influence = glm::min( influence, 1.0f - glm::dot(pa, ab) / ab2);
+            }
+          }
+          influence = glm::max( influence, 0.0f);
+          weights[children[a]] = influence;
+          sum_weights += influence;
+
+          glm::vec2 const pn = p - positions[nearest];
+          nearest = (glm::dot(pa, pa) < glm::dot(pn, pn)) ? a : nearest;
+        }
+
+        if (sum_weights > 0.0f) {
+          float const scale = w / sum_weights;
+          for (int32_t c = 0; c < I.nchildren; ++c) {
+            weights[children[c]] *= scale;
+          }
+        } else {
+          weights[children[nearest]] = w;
+        }
+      }
+      break;
+
+      case BlendNodeType::Additive: {
+        weights[children[0]] = w;
+        weights[children[1]] = w * glm::clamp(state.parameters[I.params[0]], 0.0f, 1.0f);
+      }
+      break;
+
+      case BlendNodeType::StateMachine: {
+        auto const& machine = machines_[I.data];
+        auto &M = state.machines[I.data];
+
+        // Start a transition to the requested state.
+        if ((M.requested >= 0) && (M.requested < I.nchildren) && (M.requested != M.current)) {
+          M.previous = M.current;
+          M.current  = M.requested;
+          M.transition_start = global_time;
+
+          int32_t const begin = children[M.current];
+          enter_state(begin, instructions_[begin].skip, leader, global_time, sequence);
+        }
+        M.requested = -1;
+
+        // Crossfade the left and entered states.
+        float alpha = 1.0f;
+        if ((M.previous >= 0) && (machine.crossfade > 0.0f)) {
+          float const t = (global_time - M.transition_start) / machine.crossfade;
+          alpha = glm::smoothstep(0.0f, 1.0f, t);
+        }
+        if (alpha >= 1.0f) {
+          M.previous = -1;
+        }
+
+        weights[children[M.current]] = w * alpha;
+        if (M.previous >= 0) {
+          weights[children[M.previous]] = w * (1.0f - alpha);
+        }
+      }
+      break;
+
+      default:
+      break;
+    }
+
+    ++i;
+  }
+}
+
+void BlendTree::request_state(BlendTreeState_t &state, int32_t const machine_node, int32_t const state_id) const {
+  assert( (machine_node >= 0) && (machine_node < static_cast<int32_t>(node_machines_.size())) );
+
+  if (int32_t const machine_id = node_machines_[machine_node]; machine_id > -1) {
+    state.machines[machine_id].requested = state_id;
+  } else {
+    LOG_WARNING( "BlendTree : node", machine_node, "is not a compiled state machine." );
+  }
+}
+
+int32_t BlendTree::parameter_index(std::string_view name) const {
+  for (size_t i = 0; i < parameter_names_.size(); ++i) {
+    if (parameter_names_[i] == name) {
+      return static_cast<int32_t>(i);
+    }
+  }
+  return -1;
+}
+
+SequenceClip_t const* BlendTree::find_leader(int32_t const begin, std::vector<float> const& weights, Sequence_t const& sequence) const {
+  SequenceClip_t const* leader = nullptr;
+  float max_weight = 0.0f;
+  for (int32_t j = begin; j < instructions_[begin].skip;) {
+    auto const& J = instructions_[j];
+    if (weights[j] < kMinWeight) {
+      j = J.skip;
+      continue;
+    }
+    if ((BlendNodeType::Clip == J.op) && !J.bAdditive && (weights[j] > max_weight)) {
+      max_weight = weights[j];
+      leader = &sequence[J.data];
+    }
+    ++j;
+  }
+  return leader;
+}
+
+void BlendTree::enter_state(int32_t const begin, int32_t const end, SequenceClip_t const* leader, float const global_time, Sequence_t &sequence) const {
+  // Phase of the leading clip.
+  float phase = 0.0f;
+  if (nullptr != leader) {
+    float local_time = 0.0f;
+    leader->evaluate_localtime(global_time, local_time);
+    phase = glm::fract(leader->phase(local_time));
+  }
+
+  for (int32_t i = begin; i < end; ++i) {
+    if (BlendNodeType::Clip != instructions_[i].op) {
+      continue;
+    }
+    auto &sc = sequence[instructions_[i].data];
+
+    if (nullptr == leader) {
+      sc.global_start = global_time;
+      continue;
+    }
+    auto const* action = sc.action_ptr;
+    float const dst_phase = SyncPhase(leader->action_ptr->sync_markers, phase, action->sync_markers);
+    float const rate = glm::max(glm::abs(sc.rate), glm::epsilon<float>());
+    sc.global_start = global_time - dst_phase * action->duration() / rate;
+  }
+}
+
+// -----------------------------------------------------------------------------
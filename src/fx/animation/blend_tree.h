@@ -0,0 +1,120 @@
+#ifndef BARBU_ANIMATION_BLEND_TREE_H_
+#define BARBU_ANIMATION_BLEND_TREE_H_
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "fx/animation/blend_node.h"
+#include "fx/animation/common.h"
+
+// -----------------------------------------------------------------------------
+
+// Per instance runtime data of a blend tree, initialized by BlendTree::init.
+struct BlendTreeState_t {
+  // Runtime of a state machine.
+  struct Machine_t {
+    int32_t current   = 0;
+    int32_t previous  = -1;                 //< state faded out, if any
+    int32_t requested = -1;                 //< state to enter on next evaluation
+    float transition_start = 0.0f;
+  };
+
+  std::vector<float> parameters;
+  std::vector<float> weights;               //< per instruction
+  std::vector<Machine_t> machines;
+};
+
+//
+// Blend tree and state machine graph, computing the weights of a sequence of
+// clips.
+//
+// Nodes are first authored then compiled into a flat list of instructions,
+// stored in depth-first order. Weights are propagated from the root to the
+// clips in a single pass without virtual dispatch nor allocation, the
+// subtrees without weight being skipped.
+//
+// Notes :
+//  * A tree can be shared between instances, their runtime data being kept in
+//    a BlendTreeState_t along a sequence with one clip per tree leaf.
+//
+//  * Crossfades interrupted by a new transition restart from the current state.
+//
+class BlendTree {
+ public:
+  BlendTree() = default;
+
+  /* Authoring, return the index of the created parameter or node. */
+
+  int32_t add_parameter(std::string_view name, float const default_value = 0.0f);
+
+  int32_t add_clip(Action_t *action);
+
+  /* Blend the children placed on a 1D line, thresholds must be sorted. */
+  int32_t add_blend_1d(int32_t const param, std::vector<int32_t> const& children, std::vector<float> const& thresholds);
+
+  /* Blend the children placed in a 2D space, with gradient band interpolation. */
+  int32_t add_blend_2d(int32_t const param_x, int32_t const param_y, std::vector<int32_t> const& children, std::vector<glm::vec2> const& positions);
+
+  /* Add a layer over a base, the layer clips being treated as additive. */
+  int32_t add_additive(int32_t const base, int32_t const layer, int32_t const weight_param);
+
+  /* Crossfade between states, when bSync is set the entered state is synced to
+   * the left one using their leading clips sync markers. */
+  int32_t add_state_machine(std::vector<int32_t> const& states, float const crossfade, bool const bSync = false);
+
+  /* Compile the tree from its root node, return false when the tree is invalid. */
+  bool compile(int32_t const root);
+
+  /* Runtime. */
+
+  /* Initialize the runtime data and sequence of an instance. */
+  void init(BlendTreeState_t &state, Sequence_t &sequence) const;
+
+  /* Compute the weights of the sequence clips at global_time. */
+  void evaluate(BlendTreeState_t &state, float const global_time, Sequence_t &sequence) const;
+
+  /* Request a state machine, referenced by its node, to enter a new state. */
+  void request_state(BlendTreeState_t &state, int32_t const machine_node, int32_t const state_id) const;
+
+  /* Return the index of a parameter, or -1 when not found. */
+  int32_t parameter_index(std::string_view name) const;
+
+  inline bool compiled() const noexcept {
+    return !instructions_.empty();
+  }
+
+ private:
+  // Compiled state machine.
+  struct Machine_t {
+    float crossfade;
+    bool bSync;
+  };
+
+  /* Emit the instructions of a node subtree, return false on cycles. */
+  bool compile_node(int32_t const node_id, bool const bAdditive, int32_t const depth);
+
+  /* Return the heaviest base clip of a state subtree with the weights of the
+   * previous evaluation, or nullptr when the state was inactive. */
+  SequenceClip_t const* find_leader(int32_t const begin, std::vector<float> const& weights, Sequence_t const& sequence) const;
+
+  /* Restart the clips of a state, or sync them to a leading clip. */
+  void enter_state(int32_t const begin, int32_t const end, SequenceClip_t const* leader, float const global_time, Sequence_t &sequence) const;
+
+  // Authoring.
+  std::vector<BlendNode_t> nodes_;
+  std::vector<std::string> parameter_names_;
+  std::vector<float> parameter_defaults_;
+
+  // Compiled program.
+  std::vector<BlendInstruction_t> instructions_;
+  std::vector<int32_t> children_;           //< children instruction indices
+  std::vector<glm::vec2> positions_;        //< blend spaces children positions
+  std::vector<Machine_t> machines_;
+  std::vector<int32_t> node_machines_;      //< machine index per node, -1 otherwise
+  std::vector<Action_t*> clips_;            //< action per sequence clip
+};
+
+// -----------------------------------------------------------------------------
+
+#endif  // BARBU_ANIMATION_BLEND_TREE_H_
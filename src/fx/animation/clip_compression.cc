@@ -0,0 +1,421 @@
+#include "fx/animation/clip_compression.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "glm/gtc/matrix_transform.hpp"
+
+#ifdef BARBU_NPROC_MAX
+#define LOOP_NTHREADS  (BARBU_NPROC_MAX)
+#else
+#define LOOP_NTHREADS  4
+#endif
+
+// -----------------------------------------------------------------------------
+
+namespace {
+
+// Maximum number of frames between two keys, bounding the reduction cost.
+static constexpr int32_t kMaxKeySpan = 256;
+
+// Maximum number of frames addressable by the uint16 key frames.
+static constexpr int32_t kMaxFrameCount = 65536;
+
+// Quantization scales.
+static constexpr float kRangeScale = 65535.0f;
+static constexpr float kQuatScale  = 32767.0f;
+static constexpr float kQuatRange  = 0.70710678f; // 1 / sqrt(2)
+
+// -- Quantization.
+
+/// Quantize a value in [offset, offset + extent] to 16 bits.
+inline uint16_t EncodeRange(float const v, float const offset, float const extent) {
+  float const t = (extent > 0.0f) ? (v - offset) / extent : 0.0f;
+  return static_cast<uint16_t>(std::lround(glm::clamp(t, 0.0f, 1.0f) * kRangeScale));
+}
+
+inline float DecodeRange(uint16_t const u, float const offset, float const extent) {
+  return offset + extent * (u / kRangeScale);
+}
+
+/// Quantize a unit quaternion with the smallest-three method : the largest
+/// component is dropped, the three others are stored on 15 bits and the index
+/// of the dropped one on the two remaining high bits.
+void EncodeQuat(glm::quat const& q, uint16_t key[3]) {
+  float v[4]{ q.x, q.y, q.z, q.w };
+
+  int32_t largest = 0;
+  for (int32_t i = 1; i < 4; ++i) {
+    if (std::abs(v[i]) > std::abs(v[largest])) {
+      largest = i;
+    }
+  }
+  // (q and -q are the same rotation, keep the dropped component positive)
+  float const sign = (v[largest] < 0.0f) ? -1.0f : 1.0f;
+
+  for (int32_t i = 0, j = 0; i < 4; ++i) {
+    if (i == largest) {
+      continue;
+    }
+    float const t = 0.5f * (sign * v[i] / kQuatRange) + 0.5f;
+    key[j++] = static_cast<uint16_t>(std::lround(glm::clamp(t, 0.0f, 1.0f) * kQuatScale));
+  }
+  key[0] |= static_cast<uint16_t>((largest & 1) << 15);
+  key[1] |= static_cast<uint16_t>((largest >> 1) << 15);
+}
+
+glm::quat DecodeQuat(uint16_t const key[3]) {
+  int32_t const largest = (key[0] >> 15) | ((key[1] >> 15) << 1);
+
+  float v[4];
+  float sum = 0.0f;
+  for (int32_t i = 0, j = 0; i < 4; ++i) {
+    if (i == largest) {
+      continue;
+    }
+    float const t = (key[j++] & 0x7fff) / kQuatScale;
+    v[i] = (2.0f * t - 1.0f) * kQuatRange;
+    sum += v[i] * v[i];
+  }
+  v[largest] = std::sqrt(std::max(0.0f, 1.0f - sum));
+
+  return glm::quat(v[3], v[0], v[1], v[2]);
+}
+
+// -- Interpolation.
+
+inline glm::quat LerpQuat(glm::quat const& a, glm::quat const& b, float const t) {
+  // (use the shortest path, decoded keys are not on the same hemisphere)
+  float const s = (glm::dot(a, b) < 0.0f) ? -t : t;
+  return glm::normalize(glm::quat(
+    a.w + s * b.w - t * a.w,
+    a.x + s * b.x - t * a.x,
+    a.y + s * b.y - t * a.y,
+    a.z + s * b.z - t * a.z
+  ));
+}
+
+/// Find the key preceding frame in a track and the factor to its successor.
+inline void FindKey(uint16_t const* frames, uint32_t const nkeys, float const frame, uint32_t &key, float &factor) {
+  if (nkeys <= 1u) {
+    key = 0u;
+    factor = 0.0f;
+    return;
+  }
+  auto const it = std::upper_bound(frames, frames + nkeys, frame, [](float f, uint16_t k) { return f < k; });
+  key = static_cast<uint32_t>(std::clamp<ptrdiff_t>((it - frames) - 1, 0, nkeys - 2));
+
+  float const f0 = frames[key];
+  float const f1 = frames[key + 1];
+  factor = glm::clamp((frame - f0) / (f1 - f0), 0.0f, 1.0f);
+}
+
+// -- Keyframe reduction.
+
+/// Select the keys of a track, error(a, b, i) returns the error at frame i of
+/// the interpolation between the frames a and b.
+template<typename ErrorFn>
+void ReduceKeys(int32_t const nframes, float const tolerance, ErrorFn const& error, std::vector<uint16_t> &keys) {
+  keys.clear();
+  keys.push_back(0u);
+
+  // Constant track.
+  bool bConstant = true;
+  for (int32_t i = 1; bConstant && (i < nframes); ++i) {
+    bConstant = error(0, 0, i) <= tolerance;
+  }
+  if (bConstant) {
+    return;
+  }
+
+  // Greedily extend each segment as long as its inner frames fit.
+  auto const fits = [&](int32_t a, int32_t b) {
+    for (int32_t i = a + 1; i < b; ++i) {
+      if (error(a, b, i) > tolerance) {
+        return false;
+      }
+    }
+    return true;
+  };
+
+  for (int32_t a = 0; a < nframes - 1;) {
+    int32_t b = a + 1;
+    while ((b + 1 < nframes) && (b + 1 - a <= kMaxKeySpan) && fits(a, b + 1)) {
+      ++b;
+    }
+    keys.push_back(static_cast<uint16_t>(b));
+    a = b;
+  }
+}
+
+inline float Factor(int32_t const a, int32_t const b, int32_t const i) {
+  return (a == b) ? 0.0f : (i - a) / static_cast<float>(b - a);
+}
+
+// Compressed channels of a single joint, before their concatenation.
+struct JointTracks_t {
+  std::vector<uint16_t> rotation_frames;
+  std::vector<uint16_t> rotation_keys;
+  std::vector<uint16_t> translation_frames;
+  std::vector<uint16_t> translation_keys;
+  std::vector<uint16_t> scale_frames;
+  std::vector<uint16_t> scale_keys;
+  CompressedClip_t::Range_t translation_range;
+  CompressedClip_t::Range_t scale_range;
+};
+
+void CompressJoint(AnimationSampleBuffer_t const& samples, int32_t const joint_id, ClipCompressionParams_t const& params, JointTracks_t &dst) {
+  int32_t const nframes = static_cast<int32_t>(samples.size());
+  auto const joint = [&](int32_t i) -> JointPose_t const& { return samples[i].joints[joint_id]; };
+
+  // Rotations.
+  {
+    std::vector<uint16_t> quantized(3 * nframes);
+    std::vector<glm::quat> decoded(nframes);
+    for (int32_t i = 0; i < nframes; ++i) {
+      EncodeQuat( glm::normalize(joint(i).qRotation), &quantized[3 * i]);
+      decoded[i] = DecodeQuat(&quantized[3 * i]);
+    }
+
+    ReduceKeys( nframes, params.rotation_tolerance, [&](int32_t a, int32_t b, int32_t i) {
+      auto const q = LerpQuat( decoded[a], decoded[b], Factor(a, b, i));
+      float const d = glm::min( std::abs(glm::dot(q, glm::normalize(joint(i).qRotation))), 1.0f);
+      return 2.0f * std::acos(d);
+    }, dst.rotation_frames);
+
+    for (auto const frame : dst.rotation_frames) {
+      dst.rotation_keys.insert( dst.rotation_keys.end(), &quantized[3 * frame], &quantized[3 * frame + 3]);
+    }
+  }
+
+  // Translations.
+  {
+    glm::vec3 vmin( joint(0).vTranslation );
+    glm::vec3 vmax( vmin );
+    for (int32_t i = 1; i < nframes; ++i) {
+      vmin = glm::min( vmin, joint(i).vTranslation);
+      vmax = glm::max( vmax, joint(i).vTranslation);
+    }
+    auto &range = dst.translation_range;
+    range.offset = vmin;
+    range.extent = vmax - vmin;
+
+    std::vector<uint16_t> quantized(3 * nframes);
+    std::vector<glm::vec3> decoded(nframes);
+    for (int32_t i = 0; i < nframes; ++i) {
+      for (int32_t c = 0; c < 3; ++c) {
+        quantized[3 * i + c] = EncodeRange( joint(i).vTranslation[c], range.offset[c], range.extent[c]);
+        decoded[i][c] = DecodeRange( quantized[3 * i + c], range.offset[c], range.extent[c]);
+      }
+    }
+
+    ReduceKeys( nframes, params.translation_tolerance, [&](int32_t a, int32_t b, int32_t i) {
+      auto const v = glm::mix( decoded[a], decoded[b], Factor(a, b, i));
+      return glm::length( v - joint(i).vTranslation );
+    }, dst.translation_frames);
+
+    for (auto const frame : dst.translation_frames) {
+      dst.translation_keys.insert( dst.translation_keys.end(), &quantized[3 * frame], &quantized[3 * frame + 3]);
+    }
+  }
+
+  // Scales.
+  {
+    float smin = joint(0).fScale;
+    float smax = smin;
+    for (int32_t i = 1; i < nframes; ++i) {
+      smin = std::min( smin, joint(i).fScale);
+      smax = std::max( smax, joint(i).fScale);
+    }
+    auto &range = dst.scale_range;
+    range.offset.x = smin;
+    range.extent.x = smax - smin;
+
+    std::vector<uint16_t> quantized(nframes);
+    std::vector<float> decoded(nframes);
+    for (int32_t i = 0; i < nframes; ++i) {
+      quantized[i] = EncodeRange( joint(i).fScale, range.offset.x, range.extent.x);
+      decoded[i] = DecodeRange( quantized[i], range.offset.x, range.extent.x);
+    }
+
+    ReduceKeys( nframes, params.scale_tolerance, [&](int32_t a, int32_t b, int32_t i) {
+      return std::abs( glm::mix( decoded[a], decoded[b], Factor(a, b, i)) - joint(i).fScale );
+    }, dst.scale_frames);
+
+    for (auto const frame : dst.scale_frames) {
+      dst.scale_keys.push_back( quantized[frame] );
+    }
+  }
+}
+
+/// Append a joint channel to the clip buffers and return its track.
+CompressedClip_t::Track_t AppendTrack(std::vector<uint16_t> const& frames,
+                                      std::vector<uint16_t> const& keys,
+                                      std::vector<uint16_t> &dst_frames,
+                                      std::vector<uint16_t> &dst_keys)
+{
+  CompressedClip_t::Track_t track;
+  track.first_key = static_cast<uint32_t>(dst_frames.size());
+  track.nkeys     = static_cast<uint32_t>(frames.size());
+  dst_frames.insert( dst_frames.end(), frames.cbegin(), frames.cend());
+  dst_keys.insert( dst_keys.end(), keys.cbegin(), keys.cend());
+  return track;
+}
+
+/// Compute the model space joint positions of a pose.
+void ComputeJointPositions(Skeleton const& skeleton, JointPose_t const* pose, JointBuffer_t<glm::mat4> &globals, JointBuffer_t<glm::vec3> &positions) {
+  int32_t const njoints = static_cast<int32_t>(globals.size());
+  for (int32_t i = 0; i < njoints; ++i) {
+    auto const& J = pose[i];
+    auto const local = glm::translate( glm::mat4(1.0f), J.vTranslation)
+                     * glm::mat4_cast( glm::normalize(J.qRotation) )
+                     * glm::scale( glm::mat4(1.0f), glm::vec3(J.fScale));
+    int32_t const parent_id = skeleton.parents[i];
+    globals[i] = (parent_id < 0) ? local : globals[parent_id] * local;
+    positions[i] = glm::vec3(globals[i][3]);
+  }
+}
+
+} // namespace
+
+// -----------------------------------------------------------------------------
+
+size_t CompressedClip_t::memory_size() const noexcept {
+  return rotation_tracks.size()     * sizeof(Track_t)
+       + translation_tracks.size()  * sizeof(Track_t)
+       + scale_tracks.size()        * sizeof(Track_t)
+       + translation_ranges.size()  * sizeof(Range_t)
+       + scale_ranges.size()        * sizeof(Range_t)
+       + rotation_frames.size()     * sizeof(uint16_t)
+       + translation_frames.size()  * sizeof(uint16_t)
+       + scale_frames.size()        * sizeof(uint16_t)
+       + rotation_keys.size()       * sizeof(uint16_t)
+       + translation_keys.size()    * sizeof(uint16_t)
+       + scale_keys.size()          * sizeof(uint16_t)
+       ;
+}
+
+void CompressedClip_t::sample(int32_t const first, int32_t const count, float const frame, JointPose_t *poses) const {
+  uint32_t key;
+  float t;
+
+  for (int32_t i = 0; i < count; ++i) {
+    int32_t const joint_id = first + i;
+    auto &pose = poses[i];
+
+    // Rotation.
+    {
+      auto const& track = rotation_tracks[joint_id];
+      FindKey( &rotation_frames[track.first_key], track.nkeys, frame, key, t);
+      uint16_t const* k = &rotation_keys[3u * (track.first_key + key)];
+      pose.qRotation = (t > 0.0f) ? LerpQuat( DecodeQuat(k), DecodeQuat(k + 3), t)
+                                  : DecodeQuat(k);
+    }
+
+    // Translation.
+    {
+      auto const& track = translation_tracks[joint_id];
+      auto const& range = translation_ranges[joint_id];
+      FindKey( &translation_frames[track.first_key], track.nkeys, frame, key, t);
+      uint16_t const* k = &translation_keys[3u * (track.first_key + key)];
+      for (int32_t c = 0; c < 3; ++c) {
+        float const v0 = DecodeRange( k[c], range.offset[c], range.extent[c]);
+        float const v1 = (t > 0.0f) ? DecodeRange( k[c + 3], range.offset[c], range.extent[c]) : v0;
+        pose.vTranslation[c] = glm::mix( v0, v1, t);
+      }
+    }
+
+    // Scale.
+    {
+      auto const& track = scale_tracks[joint_id];
+      auto const& range = scale_ranges[joint_id];
+      FindKey( &scale_frames[track.first_key], track.nkeys, frame, key, t);
+      uint16_t const* k = &scale_keys[track.first_key + key];
+      float const v0 = DecodeRange( k[0], range.offset.x, range.extent.x);
+      float const v1 = (t > 0.0f) ? DecodeRange( k[1], range.offset.x, range.extent.x) : v0;
+      pose.fScale = glm::mix( v0, v1, t);
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+
+bool CompressClip(Skeleton const& skeleton, AnimationClip_t &clip, ClipCompressionParams_t const& params, ClipCompressionReport_t *report) {
+  int32_t const njoints = skeleton.njoints();
+  int32_t const nframes = static_cast<int32_t>(clip.samples.size());
+
+  if ((nframes <= 0) || (nframes > kMaxFrameCount)) {
+    LOG_WARNING( "Clip", clip.name, "has an unsupported number of frames for compression :", nframes );
+    return false;
+  }
+  for (auto const& sample : clip.samples) {
+    if (static_cast<int32_t>(sample.joints.size()) != njoints) {
+      LOG_WARNING( "Clip", clip.name, "does not match its skeleton." );
+      return false;
+    }
+  }
+
+  // Reduce and quantize each joint independently.
+  std::vector<JointTracks_t> joint_tracks(njoints);
+
+  #pragma omp parallel for schedule(dynamic) num_threads(LOOP_NTHREADS)
+  for (int32_t i = 0; i < njoints; ++i) {
+    CompressJoint( clip.samples, i, params, joint_tracks[i]);
+  }
+
+  // Concatenate the joint channels.
+  auto &cc = clip.compressed;
+  cc = CompressedClip_t();
+  cc.rotation_tracks.resize(njoints);
+  cc.translation_tracks.resize(njoints);
+  cc.scale_tracks.resize(njoints);
+  cc.translation_ranges.resize(njoints);
+  cc.scale_ranges.resize(njoints);
+
+  for (int32_t i = 0; i < njoints; ++i) {
+    auto const& src = joint_tracks[i];
+    cc.rotation_tracks[i]    = AppendTrack( src.rotation_frames, src.rotation_keys, cc.rotation_frames, cc.rotation_keys);
+    cc.translation_tracks[i] = AppendTrack( src.translation_frames, src.translation_keys, cc.translation_frames, cc.translation_keys);
+    cc.scale_tracks[i]       = AppendTrack( src.scale_frames, src.scale_keys, cc.scale_frames, cc.scale_keys);
+    cc.translation_ranges[i] = src.translation_range;
+    cc.scale_ranges[i]       = src.scale_range;
+  }
+
+  // Measure the model space joint error of the decoded clip.
+  if (nullptr != report) {
+    *report = ClipCompressionReport_t();
+    report->raw_size        = static_cast<size_t>(nframes) * njoints * sizeof(JointPose_t);
+    report->compressed_size = cc.memory_size();
+    report->nraw_keys       = 3u * static_cast<uint32_t>(nframes * njoints);
+    report->nkeys           = static_cast<uint32_t>(cc.rotation_frames.size()
+                                                  + cc.translation_frames.size()
+                                                  + cc.scale_frames.size());
+
+    JointBuffer_t<JointPose_t> decoded(njoints);
+    JointBuffer_t<glm::mat4> globals(njoints);
+    JointBuffer_t<glm::vec3> raw_positions(njoints);
+    JointBuffer_t<glm::vec3> decoded_positions(njoints);
+
+    for (int32_t frame = 0; frame < nframes; ++frame) {
+      cc.sample( 0, njoints, static_cast<float>(frame), decoded.data());
+      ComputeJointPositions( skeleton, clip.samples[frame].joints.data(), globals, raw_positions);
+      ComputeJointPositions( skeleton, decoded.data(), globals, decoded_positions);
+
+      for (int32_t i = 0; i < njoints; ++i) {
+        float const error = glm::length(decoded_positions[i] - raw_positions[i]);
+        if (error > report->max_error) {
+          report->max_error       = error;
+          report->max_error_joint = i;
+          report->max_error_frame = frame;
+        }
+      }
+    }
+  }
+
+  // Release the raw samples.
+  AnimationSampleBuffer_t().swap(clip.samples);
+
+  return true;
+}
+
+// -----------------------------------------------------------------------------
@@ -0,0 +1,43 @@
+#ifndef BARBU_ANIMATION_CLIP_COMPRESSION_H_
+#define BARBU_ANIMATION_CLIP_COMPRESSION_H_
+
+#include "fx/animation/common.h"
+#include "fx/animation/skeleton.h"
+
+// -----------------------------------------------------------------------------
+
+// Tolerances used to remove the keyframes of a track, a key is removed when the
+// interpolation of its neighbours stays within the tolerance of the raw track.
+struct ClipCompressionParams_t {
+  float rotation_tolerance    = 5.0e-4f;      //< angle, in radians
+  float translation_tolerance = 1.0e-4f;      //< distance, in model units
+  float scale_tolerance       = 1.0e-4f;
+};
+
+// Statistics of a compressed clip.
+struct ClipCompressionReport_t {
+  size_t raw_size         = 0u;               //< size of the raw samples, in bytes
+  size_t compressed_size  = 0u;               //< size of the compressed data, in bytes
+  uint32_t nkeys          = 0u;               //< number of keys kept, all channels
+  uint32_t nraw_keys      = 0u;               //< number of raw keys, all channels
+  float max_error         = 0.0f;             //< max model space joint distance
+  int32_t max_error_joint = -1;
+  int32_t max_error_frame = -1;
+
+  float ratio() const {
+    return (compressed_size > 0u) ? raw_size / static_cast<float>(compressed_size) : 0.0f;
+  }
+};
+
+/* Compress the samples of a clip then release them, return false when the clip
+ * could not be compressed (its raw samples are then kept).
+ * When report is provided it is filled with the compression statistics, the
+ * joint error being measured on the decoded clip. */
+bool CompressClip(Skeleton const& skeleton,
+                  AnimationClip_t &clip,
+                  ClipCompressionParams_t const& params = ClipCompressionParams_t(),
+                  ClipCompressionReport_t *report = nullptr);
+
+// -----------------------------------------------------------------------------
+
+#endif  // BARBU_ANIMATION_CLIP_COMPRESSION_H_
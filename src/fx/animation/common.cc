@@ -1,5 +1,112 @@
 #include "fx/animation/common.h"
 
+#include <algorithm>
+#include <limits>
+
+#include "glm/gtc/matrix_transform.hpp"
+
+// -----------------------------------------------------------------------------
+
+namespace {
+
+// Maximum number of loops accounted for between two updates, longer hitches
+// skip the in-between loops events and root motion.
+static constexpr int32_t kMaxUpdateLoops = 2;
+
+/// Return the time a sequence clip has played at global_time, not looped.
+float PlayTime(SequenceClip_t const& sc, float const global_time, float const finish_time) {
+  float const play_time = glm::max(global_time - sc.global_start, 0.0f) * glm::abs(sc.rate);
+  return glm::min(play_time, finish_time);
+}
+
+/// Return the play time at which a sequence clip ends.
+float FinishTime(SequenceClip_t const& sc, float const clip_duration) {
+  auto const* action = sc.action_ptr;
+  if (action->bLoop && (0 == sc.nloops)) {
+    return std::numeric_limits<float>::max();
+  }
+  int32_t const total_loops = (action->bLoop) ? sc.nloops : 1;
+  return static_cast<float>(total_loops) * clip_duration;
+}
+
+/// Return true when the loop_id-th loop of a sequence clip is played backward.
+bool IsReversed(SequenceClip_t const& sc, int32_t const loop_id) {
+  bool const bReversed_a = (sc.rate < 0.0f);
+  bool const bReversed_b = sc.bPingPong && ((loop_id & 1) == bReversed_a);
+  return bReversed_a != bReversed_b;
+}
+
+} // namespace
+
+// -----------------------------------------------------------------------------
+
+void Action_t::add_event(float time, std::string_view event_name, int32_t id) {
+  auto it = std::upper_bound(events.begin(), events.end(), time, 
+    [](float t, AnimationEvent_t const& e) { return t < e.time; }
+  );
+  events.insert(it, AnimationEvent_t{ time, std::string(event_name), id });
+}
+
+// -----------------------------------------------------------------------------
+
+void RootMotion_t::sample(float const frame, glm::vec3 &translation, float &yaw) const {
+  int32_t const last_frame = static_cast<int32_t>(translations.size()) - 1;
+  if (last_frame < 1) {
+    translation = glm::vec3(0.0f);
+    yaw = 0.0f;
+    return;
+  }
+
+  float const f = glm::clamp(frame, 0.0f, static_cast<float>(last_frame));
+  int32_t const frame_a = std::min(static_cast<int32_t>(f), last_frame - 1);
+  float const factor = f - static_cast<float>(frame_a);
+
+  translation = glm::mix(translations[frame_a], translations[frame_a + 1], factor);
+  yaw = yaws.empty() ? 0.0f : glm::mix(yaws[frame_a], yaws[frame_a + 1], factor);
+}
+
+glm::mat4 RootMotion_t::transform(float const frame) const {
+  if (translations.size() < 2) {
+    return glm::mat4(1.0f);
+  }
+
+  glm::vec3 translation;
+  float yaw;
+  sample(frame, translation, yaw);
+
+  // Rotate around the first frame root, then translate.
+  glm::mat4 m = glm::translate(glm::mat4(1.0f), pivot + translation);
+  m = glm::rotate(m, yaw, glm::vec3(0.0f, 1.0f, 0.0f));
+  return glm::translate(m, -pivot);
+}
+
+glm::mat4 RootMotion_t::delta(float const frame_a, float const frame_b) const {
+  float const framecount = static_cast<float>(translations.size()) - 1.0f;
+  if (framecount < 1.0f) {
+    return glm::mat4(1.0f);
+  }
+
+  // Split the unwrapped frames into loops and frames.
+  float const loop_a = glm::floor(frame_a / framecount);
+  float const loop_b = glm::floor(frame_b / framecount);
+
+  // Motion(frame) = Loop^k * transform(frame - k * framecount).
+  glm::mat4 m = glm::inverse(transform(frame_a - loop_a * framecount));
+
+  int32_t const nloops = glm::clamp(static_cast<int32_t>(loop_b - loop_a), -kMaxUpdateLoops, kMaxUpdateLoops);
+  if (0 != nloops) {
+    auto const loop = transform(framecount);
+    auto const step = (nloops > 0) ? loop : glm::inverse(loop);
+    for (int32_t i = 0; i < glm::abs(nloops); ++i) {
+      m = m * step;
+    }
+  }
+
+  return m * transform(frame_b - loop_b * framecount);
+}
+
+// -----------------------------------------------------------------------------
+
 bool SequenceClip_t::evaluate_localtime(float const global_time, float &local_time) const {
   assert( nullptr != action_ptr );
 
@@ -28,10 +135,7 @@ bool SequenceClip_t::evaluate_localtime(float const global_time, float &local_ti
   }
 
   // Handles reverse playback with ping-pong.
-  bool const bReversed_a = (rate < 0.0f);
-  bool const bReversed_b = bPingPong && ((loop_id & 1) == bReversed_a);
-  bool const bReversed   = bReversed_a != bReversed_b;
-  if (bReversed) {
+  if (IsReversed(*this, loop_id)) {
     local_time = clip_duration - local_time;
   }
 
@@ -46,3 +150,82 @@ bool SequenceClip_t::evaluate_localtime(float const global_time, float &local_ti
 
   return false;
 }
+
+bool SequenceClip_t::evaluate_localtime(float const last_global_time, float const global_time, float &local_time, EventQueue_t &events) const {
+  bool const bEnded = evaluate_localtime(global_time, local_time);
+
+  auto const& action_events = action_ptr->events;
+  if (action_events.empty() || (global_time <= last_global_time)) {
+    return bEnded;
+  }
+
+  // Fire the events whose play time is in [start, end), including the clip
+  // last instant when it ends.
+  float const clip_duration = action_ptr->duration();
+  float const finish_time = FinishTime(*this, clip_duration);
+  float const start = PlayTime(*this, last_global_time, finish_time);
+  float const end   = PlayTime(*this, global_time, finish_time);
+  if (end <= start) {
+    return bEnded;
+  }
+  bool const bFinished = (end >= finish_time);
+
+  auto const is_crossed = [start, end, bFinished](float const play_time) {
+    return (play_time >= start) && ((play_time < end) || (bFinished && (play_time <= end)));
+  };
+
+  // (the previous loop is checked for the events on its end when reversed)
+  int32_t const first_loop = std::max(static_cast<int32_t>(start / clip_duration) - 1, 0);
+  int32_t last_loop = std::min(static_cast<int32_t>(end / clip_duration), first_loop + kMaxUpdateLoops + 1);
+  if (finish_time < std::numeric_limits<float>::max()) {
+    last_loop = std::min(last_loop, static_cast<int32_t>(finish_time / clip_duration + 0.5f) - 1);
+  }
+  for (int32_t loop_id = first_loop; loop_id <= last_loop; ++loop_id) {
+    float const loop_start = static_cast<float>(loop_id) * clip_duration;
+
+    if (IsReversed(*this, loop_id)) {
+      for (auto it = action_events.rbegin(); it != action_events.rend(); ++it) {
+        if (is_crossed(loop_start + clip_duration - it->time)) {
+          events.push(&(*it), action_ptr, weight);
+        }
+      }
+    } else {
+      for (auto const& e : action_events) {
+        if (is_crossed(loop_start + e.time)) {
+          events.push(&e, action_ptr, weight);
+        }
+      }
+    }
+  }
+
+  return bEnded;
+}
+
+bool SequenceClip_t::evaluate_root_motion(float const last_global_time, float const global_time, glm::vec3 &translation, float &yaw) const {
+  assert( nullptr != action_ptr );
+
+  // (ping-pong clips are not moving the root consistently)
+  auto const& root_motion = static_cast<AnimationClip_t const*>(action_ptr)->root_motion;
+  if (root_motion.empty() || bPingPong) {
+    return false;
+  }
+
+  float const clip_duration = action_ptr->duration();
+  float const finish_time = FinishTime(*this, clip_duration);
+
+  // Unwrapped frames, reverse playback starting from the last one.
+  float const framecount = static_cast<float>(root_motion.translations.size() - 1u);
+  float const framerate  = framecount / clip_duration;
+  auto const unwrapped_frame = [&](float const time) {
+    float const frame = PlayTime(*this, time, finish_time) * framerate;
+    return (rate < 0.0f) ? framecount - frame : frame;
+  };
+
+  auto const m = root_motion.delta( unwrapped_frame(last_global_time), unwrapped_frame(global_time));
+  translation = glm::vec3(m[3]);
+  yaw = glm::atan(m[2][0], m[0][0]);
+
+  return true;
+}
+
+// -----------------------------------------------------------------------------
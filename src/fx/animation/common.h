@@ -1,6 +1,8 @@
 #ifndef BARBU_ANIMATION_COMMON_H_
 #define BARBU_ANIMATION_COMMON_H_
 
+#include <array>
+#include <cstdint>
 #include <string>
 #include <vector>
 #include "glm/gtc/quaternion.hpp"
@@ -37,8 +39,113 @@ struct AnimationSample_t {
 
 using AnimationSampleBuffer_t = std::vector<AnimationSample_t>;
 
+// Set of joints transformation stored as structure of arrays, used by the
+// data-oriented kernels. Buffers are padded to a multiple of kLaneWidth joints.
+struct PoseSoA_t {
+  static constexpr int32_t kLaneWidth = 4;
+
+  JointBuffer_t<float> qx, qy, qz, qw;      //< rotations
+  JointBuffer_t<float> tx, ty, tz;          //< translations
+  JointBuffer_t<float> scale;               //< uniform scales, blended but not composed into the matrices
+
+  void resize(int32_t njoints) {
+    size_t const size = static_cast<size_t>(
+      ((njoints + kLaneWidth - 1) / kLaneWidth) * kLaneWidth
+    );
+    for (auto *buffer : { &qx, &qy, &qz, &qw, &tx, &ty, &tz, &scale }) {
+      buffer->resize(size, 0.0f);
+    }
+  }
+
+  size_t size() const noexcept {
+    return qx.size();
+  }
+};
+
+// Joint tracks of an animation clip compressed by keyframe reduction, with
+// smallest-three quantized rotations and range quantized translations / scales.
+// (see fx/animation/clip_compression.h for the encoder)
+struct CompressedClip_t {
+  // Keyframes of a single joint channel, referencing the clip's key buffers.
+  struct Track_t {
+    uint32_t first_key = 0u;
+    uint32_t nkeys     = 0u;
+  };
+
+  // Quantization range of a track, value = offset + extent * quantized / 65535.
+  struct Range_t {
+    glm::vec3 offset = glm::vec3(0.0f);
+    glm::vec3 extent = glm::vec3(0.0f);
+  };
+
+  // Per joint tracks.
+  JointBuffer_t<Track_t> rotation_tracks;
+  JointBuffer_t<Track_t> translation_tracks;
+  JointBuffer_t<Track_t> scale_tracks;
+  JointBuffer_t<Range_t> translation_ranges;
+  JointBuffer_t<Range_t> scale_ranges;                   //< [only x is used]
+
+  // Frame index of each keys, per channel.
+  std::vector<uint16_t> rotation_frames;
+  std::vector<uint16_t> translation_frames;
+  std::vector<uint16_t> scale_frames;
+
+  // Quantized keys, 3 values per rotation and translation, 1 per scale.
+  std::vector<uint16_t> rotation_keys;
+  std::vector<uint16_t> translation_keys;
+  std::vector<uint16_t> scale_keys;
+
+  bool empty() const noexcept {
+    return rotation_tracks.empty();
+  }
+
+  /* Return the memory used by the compressed data, in bytes. */
+  size_t memory_size() const noexcept;
+
+  /* Decode the poses of count joints starting at first, at a (fractional) frame. */
+  void sample(int32_t const first, int32_t const count, float const frame, JointPose_t *poses) const;
+};
+
 // -----------------------------------------------------------------------------
 
+struct Action_t;
+
+// Time-stamped event of an action (eg. a footstep), in seconds of the action local time.
+struct AnimationEvent_t {
+  float time = 0.0f;
+  std::string name;
+  int32_t id = -1;                            //< [optional] user value
+};
+
+// Caller-owned buffer receiving the events crossed by the sequence clips during
+// an update, referencing their actions events so that sampling never allocates.
+// Events past its capacity are dropped.
+struct EventQueue_t {
+  static constexpr int32_t kCapacity = 32;
+
+  struct Entry_t {
+    AnimationEvent_t const* event = nullptr;
+    Action_t const* action = nullptr;
+    float weight = 0.0f;                      //< weight of the clip which fired it
+  };
+
+  std::array<Entry_t, kCapacity> entries;
+  int32_t count = 0;
+
+  void clear() noexcept {
+    count = 0;
+  }
+
+  void push(AnimationEvent_t const* event, Action_t const* action, float weight) noexcept {
+    if (count < kCapacity) {
+      entries[count++] = { event, action, weight };
+    }
+  }
+
+  Entry_t const* begin() const noexcept { return entries.data(); }
+  Entry_t const* end() const noexcept { return entries.data() + count; }
+};
+
 // Abstract structure for specific animation.
 struct Action_t {
   Action_t() = default;
@@ -50,11 +157,43 @@ struct Action_t {
 
   std::string name;                           //< [ pointer to the action name ]
   bool bLoop = false;                         //< true if the action is looping
+  std::vector<float> sync_markers;            //< sorted phases used to sync crossfades
+  std::vector<AnimationEvent_t> events;       //< events sorted by time
+
+  /* Insert an event, keeping them sorted. */
+  void add_event(float time, std::string_view event_name, int32_t id = -1);
+};
+
+// Horizontal motion of a clip's root joint, removed from its samples at import
+// to be applied to the character entity instead (see fx/animation/root_motion.h).
+//
+// Stored per frame relative to the first one, plus a last entry extrapolating
+// the wrap from the last frame to the first, which is the motion of one loop.
+struct RootMotion_t {
+  std::vector<glm::vec3> translations;        //< mesh space, y being 0
+  std::vector<float> yaws;                    //< [optional] unwrapped, in radians
+  glm::vec3 pivot = glm::vec3(0.0f);          //< root position on the first frame
+
+  bool empty() const noexcept {
+    return translations.empty();
+  }
+
+  /* Retrieve the translation and yaw of a frame in [0, framecount]. */
+  void sample(float const frame, glm::vec3 &translation, float &yaw) const;
+
+  /* Return the motion from the first frame to a frame in [0, framecount]. */
+  glm::mat4 transform(float const frame) const;
+
+  /* Return the motion between two unwrapped frames, counting each loop as
+   * framecount frames (negative frames play it backward). */
+  glm::mat4 delta(float const frame_a, float const frame_b) const;
 };
 
 // Set of skinning animation in a timeframe.
 struct AnimationClip_t : Action_t {
-  AnimationSampleBuffer_t samples;            //< buffer of samples
+  AnimationSampleBuffer_t samples;            //< buffer of samples (empty when compressed)
+  CompressedClip_t compressed;                //< compressed samples
+  RootMotion_t root_motion;                   //< [optional] extracted root motion
   int32_t framecount = 0;                     //< total number of frames
   float framerate = 0.0f;                     //< framerate in seconds
   
@@ -72,6 +211,10 @@ struct AnimationClip_t : Action_t {
   float duration() const override {
     return static_cast<float>(framecount) / framerate;
   }
+
+  bool is_compressed() const noexcept {
+    return !compressed.empty();
+  }
 };
 
 // TODO : Expression.
@@ -89,6 +232,7 @@ struct SequenceClip_t {
   int32_t nloops       = 0;
   bool bEnable         = false;
   bool bPingPong       = false;
+  bool bAdditive       = false; //< applied relative to the clip first frame
 
   explicit 
   SequenceClip_t(Action_t* _action_ptr = nullptr)
@@ -100,6 +244,14 @@ struct SequenceClip_t {
   // @return true when the sequence has ended.
   bool evaluate_localtime(float const global_time, float &local_time) const;
 
+  // Same as above, pushing to events the action events crossed since last_global_time.
+  bool evaluate_localtime(float const last_global_time, float const global_time, float &local_time, EventQueue_t &events) const;
+
+  // Retrieve the root motion of the clip between two global times, as a mesh
+  // space translation and yaw.
+  // @return false when the clip has no root motion.
+  bool evaluate_root_motion(float const last_global_time, float const global_time, glm::vec3 &translation, float &yaw) const;
+
   // Return the phase of the animation given the local_time.
   float phase(float const local_time) const {
     assert( nullptr != action_ptr );
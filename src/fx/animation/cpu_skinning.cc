@@ -0,0 +1,285 @@
+#include "fx/animation/cpu_skinning.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "utils/simd.h"
+
+#ifdef BARBU_NPROC_MAX
+#define LOOP_NTHREADS  (BARBU_NPROC_MAX)
+#else
+#define LOOP_NTHREADS  4
+#endif
+
+// -----------------------------------------------------------------------------
+
+namespace {
+
+using simd::float4;
+
+// Joint index of unused influences, as in the vertex shader.
+static constexpr uint32_t kNoJoint = 0xff;
+
+// Minimum weight of the first influence for a vertex to be skinned.
+static constexpr float kMinWeight = 1.0e-6f;
+
+/// Retrieve the four influence weights of a vertex, the last one being derived
+/// from the others. Return false when the vertex is not skinned.
+inline bool GetWeights(MeshData::Skinning_t const& skinning, float w[4]) {
+  auto const& W = skinning.joint_weights;
+  w[0] = W.x;
+  w[1] = W.y;
+  w[2] = W.z;
+  w[3] = 1.0f - (W.x + W.y + W.z);
+  return W.x > kMinWeight;
+}
+
+/// Blend the skinning matrices of a vertex influences, returned as columns
+/// with the translation last.
+void BlendMatrices(glm::mat3x4 const* matrices, uint32_t const njoints, MeshData::Skinning_t const& skinning, float const w[4], float4 columns[4]) {
+  alignas(16) static float const kIdentityRows[3][4]{ {1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0} };
+
+  columns[0] = columns[1] = columns[2] = columns[3] = simd::zero();
+  for (int32_t k = 0; k < 4; ++k) {
+    uint32_t const joint_id = skinning.joint_indices[k];
+    bool const bIdentity = (kNoJoint == joint_id) || (joint_id >= njoints);
+    float4 const weight = simd::set1(w[k]);
+    for (int32_t r = 0; r < 3; ++r) {
+      float const* row = bIdentity ? kIdentityRows[r] : &matrices[joint_id][r][0];
+      columns[r] += weight * simd::load(row);
+    }
+  }
+  simd::transpose(columns[0], columns[1], columns[2], columns[3]);
+}
+
+/// Blend the dual quaternions of a vertex influences, returned as the columns
+/// of the equivalent rigid transform.
+void BlendDualQuaternions(glm::dualquat const* dual_quaternions, uint32_t const njoints, MeshData::Skinning_t const& skinning, float const w[4], float4 columns[4]) {
+  static glm::dualquat const kIdentity{ glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::quat(0.0f, 0.0f, 0.0f, 0.0f) };
+
+  auto const get = [&](int32_t k) -> glm::dualquat const& {
+    uint32_t const joint_id = skinning.joint_indices[k];
+    return ((kNoJoint == joint_id) || (joint_id >= njoints)) ? kIdentity : dual_quaternions[joint_id];
+  };
+
+  // Handles antipodality relative to the last influence, as the vertex shader.
+  auto const& reference = get(3).real;
+
+  float4 A = simd::zero();
+  float4 B = simd::zero();
+  for (int32_t k = 0; k < 4; ++k) {
+    auto const& dq = get(k);
+    float const sign = (k < 3) && (glm::dot(reference, dq.real) < 0.0f) ? -1.0f : 1.0f;
+    alignas(16) float const real[4]{ dq.real.x, dq.real.y, dq.real.z, dq.real.w };
+    alignas(16) float const dual[4]{ dq.dual.x, dq.dual.y, dq.dual.z, dq.dual.w };
+    float4 const weight = simd::set1(sign * w[k]);
+    A += weight * simd::load(real);
+    B += weight * simd::load(dual);
+  }
+
+  // Normalize.
+  alignas(16) float a[4], b[4];
+  simd::store(a, A);
+  simd::store(b, B);
+  float const norm2 = a[0]*a[0] + a[1]*a[1] + a[2]*a[2] + a[3]*a[3];
+  float const inv_norm = (norm2 > 0.0f) ? 1.0f / std::sqrt(norm2) : 0.0f;
+  float const x = a[0] * inv_norm, y = a[1] * inv_norm, z = a[2] * inv_norm, qw = a[3] * inv_norm;
+  float const dx = b[0] * inv_norm, dy = b[1] * inv_norm, dz = b[2] * inv_norm, dw = b[3] * inv_norm;
+
+  // Rotation.
+  alignas(16) float const c0[4]{ 1.0f - 2.0f*(y*y + z*z), 2.0f*(x*y + qw*z), 2.0f*(x*z - qw*y), 0.0f };
+  alignas(16) float const c1[4]{ 2.0f*(x*y - qw*z), 1.0f - 2.0f*(x*x + z*z), 2.0f*(y*z + qw*x), 0.0f };
+  alignas(16) float const c2[4]{ 2.0f*(x*z + qw*y), 2.0f*(y*z - qw*x), 1.0f - 2.0f*(x*x + y*y), 0.0f };
+
+  // Translation, 2 * (w_r * d - w_d * r + r x d).
+  alignas(16) float const c3[4]{
+    2.0f * (qw*dx - dw*x + (y*dz - z*dy)),
+    2.0f * (qw*dy - dw*y + (z*dx - x*dz)),
+    2.0f * (qw*dz - dw*z + (x*dy - y*dx)),
+    0.0f
+  };
+
+  columns[0] = simd::load(c0);
+  columns[1] = simd::load(c1);
+  columns[2] = simd::load(c2);
+  columns[3] = simd::load(c3);
+}
+
+/// Transform a vertex attributes by an affine transform given as columns.
+void TransformVertex(float4 const columns[4], MeshData::Vertex_t const& src, MeshData::Vertex_t &dst) {
+  auto const transform = [&columns](glm::vec3 const& v, float const w) {
+    float4 const r = columns[0] * simd::set1(v.x)
+                   + columns[1] * simd::set1(v.y)
+                   + columns[2] * simd::set1(v.z)
+                   + columns[3] * simd::set1(w);
+    alignas(16) float lanes[4];
+    simd::store(lanes, r);
+    return glm::vec3(lanes[0], lanes[1], lanes[2]);
+  };
+
+  auto const normalize = [](glm::vec3 const& v) {
+    float const len2 = glm::dot(v, v);
+    return (len2 > 0.0f) ? v / std::sqrt(len2) : v;
+  };
+
+  dst = src;
+  dst.position = transform(src.position, 1.0f);
+  dst.normal   = normalize(transform(src.normal, 0.0f));
+  dst.tangent  = glm::vec4(normalize(transform(glm::vec3(src.tangent), 0.0f)), src.tangent.w);
+}
+
+} // namespace
+
+// -----------------------------------------------------------------------------
+
+bool CalculateJointBounds(MeshData const& mesh, Skeleton &skeleton) {
+  int32_t const nvertices = mesh.nvertices();
+  if ((mesh.nskinnings() != nvertices) || (nvertices <= 0)) {
+    return false;
+  }
+
+  uint32_t const njoints = static_cast<uint32_t>(skeleton.njoints());
+  skeleton.joint_bounds.assign(njoints, BoundingBox_t());
+  skeleton.static_bounds = BoundingBox_t();
+
+  auto const* vertices = mesh.vertexData();
+  auto const* skinnings = mesh.skinningData();
+
+  // A vertex extends the bounds of every joint with a non zero influence, so
+  // its skinned position, a convex combination, stays within their union.
+  for (int32_t i = 0; i < nvertices; ++i) {
+    auto const& position = vertices[i].position;
+    auto const& skinning = skinnings[i];
+
+    float w[4];
+    if (!GetWeights(skinning, w)) {
+      skeleton.static_bounds.extend(position);
+      continue;
+    }
+    for (int32_t k = 0; k < 4; ++k) {
+      if (w[k] <= 0.0f) {
+        continue;
+      }
+      uint32_t const joint_id = skinning.joint_indices[k];
+      if ((kNoJoint == joint_id) || (joint_id >= njoints)) {
+        skeleton.static_bounds.extend(position);
+      } else {
+        skeleton.joint_bounds[joint_id].extend(position);
+      }
+    }
+  }
+
+  return true;
+}
+
+BoundingBox_t CalculateSkinnedBounds(Skeleton const& skeleton, glm::mat3x4 const* skinning_matrices) {
+  auto const& joint_bounds = skeleton.joint_bounds;
+  int32_t const njoints = static_cast<int32_t>(joint_bounds.size());
+
+  float4 const zero = simd::zero();
+  float4 bmin[3], bmax[3];
+  for (int32_t r = 0; r < 3; ++r) {
+    bmin[r] = simd::set1(std::numeric_limits<float>::max());
+    bmax[r] = simd::set1(-std::numeric_limits<float>::max());
+  }
+
+  // Transform the joints boxes by block, with Arvo's method : the transformed
+  // center and the extents scaled by the absolute matrix.
+  for (int32_t first = 0; first < njoints; first += simd::kWidth) {
+    int32_t const count = std::min(simd::kWidth, njoints - first);
+
+    alignas(16) float centers[3][simd::kWidth]{};
+    alignas(16) float extents[3][simd::kWidth]{};
+    alignas(16) float valid[simd::kWidth]{};
+    float4 rows[3][simd::kWidth];
+
+    for (int32_t i = 0; i < simd::kWidth; ++i) {
+      bool const bValid = (i < count) && !joint_bounds[first + i].empty();
+      for (int32_t r = 0; r < 3; ++r) {
+        rows[r][i] = bValid ? simd::load(&skinning_matrices[first + i][r][0]) : zero;
+      }
+      if (bValid) {
+        auto const& box = joint_bounds[first + i];
+        glm::vec3 const c = box.center();
+        glm::vec3 const e = box.extents();
+        for (int32_t r = 0; r < 3; ++r) {
+          centers[r][i] = c[r];
+          extents[r][i] = e[r];
+        }
+        valid[i] = 1.0f;
+      }
+    }
+
+    float4 const mask = simd::load(valid) > zero;
+    float4 const cx = simd::load(centers[0]), cy = simd::load(centers[1]), cz = simd::load(centers[2]);
+    float4 const ex = simd::load(extents[0]), ey = simd::load(extents[1]), ez = simd::load(extents[2]);
+
+    for (int32_t r = 0; r < 3; ++r) {
+      // Swizzle the rows to have the lanes per element.
+      auto &R = rows[r];
+      simd::transpose(R[0], R[1], R[2], R[3]);
+
+      float4 const center = R[0] * cx + R[1] * cy + R[2] * cz + R[3];
+      float4 const extent = simd::abs(R[0]) * ex + simd::abs(R[1]) * ey + simd::abs(R[2]) * ez;
+      bmin[r] = simd::select(mask, simd::min(bmin[r], center - extent), bmin[r]);
+      bmax[r] = simd::select(mask, simd::max(bmax[r], center + extent), bmax[r]);
+    }
+  }
+
+  // Reduce the lanes.
+  BoundingBox_t bounds = skeleton.static_bounds;
+  for (int32_t r = 0; r < 3; ++r) {
+    alignas(16) float lmin[simd::kWidth], lmax[simd::kWidth];
+    simd::store(lmin, bmin[r]);
+    simd::store(lmax, bmax[r]);
+    for (int32_t i = 0; i < simd::kWidth; ++i) {
+      bounds.min[r] = std::min(bounds.min[r], lmin[i]);
+      bounds.max[r] = std::max(bounds.max[r], lmax[i]);
+    }
+  }
+
+  return bounds;
+}
+
+bool SkinVertices(MeshData const& mesh,
+                  SkinningMode const mode,
+                  glm::mat3x4 const* skinning_matrices,
+                  glm::dualquat const* dual_quaternions,
+                  MeshData::Vertex_t *dst) {
+  bool const bDualQuaternion = (SkinningMode::DualQuaternion == mode);
+  int32_t const nvertices = mesh.nvertices();
+
+  if ((nullptr == mesh.skeleton) || (mesh.nskinnings() != nvertices)) {
+    LOG_ERROR( "SkinVertices : the mesh is not skinned." );
+    return false;
+  }
+  if ((nullptr == dst) || (bDualQuaternion ? (nullptr == dual_quaternions) : (nullptr == skinning_matrices))) {
+    LOG_ERROR( "SkinVertices : missing skinning data." );
+    return false;
+  }
+
+  uint32_t const njoints = static_cast<uint32_t>(mesh.skeleton->njoints());
+  auto const* vertices = mesh.vertexData();
+  auto const* skinnings = mesh.skinningData();
+
+  #pragma omp parallel for schedule(static) num_threads(LOOP_NTHREADS)
+  for (int32_t i = 0; i < nvertices; ++i) {
+    float w[4];
+    if (!GetWeights(skinnings[i], w)) {
+      dst[i] = vertices[i];
+      continue;
+    }
+
+    float4 columns[4];
+    if (bDualQuaternion) {
+      BlendDualQuaternions(dual_quaternions, njoints, skinnings[i], w, columns);
+    } else {
+      BlendMatrices(skinning_matrices, njoints, skinnings[i], w, columns);
+    }
+    TransformVertex(columns, vertices[i], dst[i]);
+  }
+
+  return true;
+}
+
+// -----------------------------------------------------------------------------
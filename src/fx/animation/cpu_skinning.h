@@ -0,0 +1,39 @@
+#ifndef BARBU_ANIMATION_CPU_SKINNING_H_
+#define BARBU_ANIMATION_CPU_SKINNING_H_
+
+#include "fx/animation/common.h"
+#include "fx/animation/skeleton.h"
+#include "memory/resources/mesh_data.h"
+#include "utils/mathutils.h"
+
+// -----------------------------------------------------------------------------
+//
+// Host counterpart of the vertex shader skinning (shaders/shared/inc_skinning.glsl),
+// used to deform meshes for tools and export, and to bound animated meshes.
+//
+// Notes :
+//  * Skinned bounds are computed from the joints bind pose bounds transformed
+//    by their skinning matrix, which is conservative for linear blending and
+//    a close approximation for dual quaternions.
+//
+// -----------------------------------------------------------------------------
+
+/* Compute the bind pose bounds of the vertices influenced by each joint of a
+ * skinned mesh, return false when the mesh is not skinned. */
+bool CalculateJointBounds(MeshData const& mesh, Skeleton &skeleton);
+
+/* Return the mesh space bounds of a skinned mesh from its skinning matrices. */
+BoundingBox_t CalculateSkinnedBounds(Skeleton const& skeleton, glm::mat3x4 const* skinning_matrices);
+
+/* Deform the vertices of a skinned mesh into dst (of mesh.nvertices() size) with
+ * a skinning palette, positions, normals and tangents being transformed.
+ * dual_quaternions is only used, and required, in DualQuaternion mode. */
+bool SkinVertices(MeshData const& mesh,
+                  SkinningMode const mode,
+                  glm::mat3x4 const* skinning_matrices,
+                  glm::dualquat const* dual_quaternions,
+                  MeshData::Vertex_t *dst);
+
+// -----------------------------------------------------------------------------
+
+#endif  // BARBU_ANIMATION_CPU_SKINNING_H_
@@ -0,0 +1,109 @@
+#include "fx/animation/root_motion.h"
+
+#include "glm/gtc/matrix_transform.hpp"
+
+// -----------------------------------------------------------------------------
+
+namespace {
+
+/// Return the rotation of an affine matrix, regardless of its scale.
+glm::quat ExtractRotation(glm::mat4 const& m) {
+  glm::mat3 const basis(
+    glm::normalize(glm::vec3(m[0])),
+    glm::normalize(glm::vec3(m[1])),
+    glm::normalize(glm::vec3(m[2]))
+  );
+  return glm::normalize(glm::quat_cast(basis));
+}
+
+/// Return the angle of the twist of a rotation around the up axis.
+float ExtractYaw(glm::quat const& q) {
+  return 2.0f * glm::atan(q.y, q.w);
+}
+
+} // namespace
+
+// -----------------------------------------------------------------------------
+
+bool ExtractRootMotion(Skeleton const& skeleton, AnimationClip_t &clip, RootMotionParams_t const& params) {
+  if (clip.is_compressed() || !clip.root_motion.empty()) {
+    return false;
+  }
+
+  int32_t const nframes = static_cast<int32_t>(clip.samples.size());
+  if ((nframes < 2) || (nframes != clip.framecount)) {
+    return false;
+  }
+
+  auto const& parent_matrix = skeleton.root_parent_matrix;
+  auto const parent_rotation = ExtractRotation(parent_matrix);
+  auto const& first_root = clip.samples[0].joints[0];
+
+  // Root position and rotation of the first frame, in mesh space.
+  auto const first_position = glm::vec3(parent_matrix * glm::vec4(first_root.vTranslation, 1.0f));
+  auto const inv_first_rotation = glm::inverse(parent_rotation * first_root.qRotation);
+
+  // Motion of each frame relative to the first one.
+  RootMotion_t root_motion;
+  root_motion.pivot = glm::vec3(first_position.x, 0.0f, first_position.z);
+  root_motion.translations.resize(nframes + 1);
+  if (params.bExtractYaw) {
+    root_motion.yaws.resize(nframes + 1);
+  }
+
+  float max_distance = 0.0f;
+  float max_angle = 0.0f;
+  for (int32_t i = 0; i < nframes; ++i) {
+    auto const& root = clip.samples[i].joints[0];
+    auto const position = glm::vec3(parent_matrix * glm::vec4(root.vTranslation, 1.0f));
+
+    auto &translation = root_motion.translations[i];
+    translation = position - first_position;
+    translation.y = 0.0f;
+    max_distance = glm::max(max_distance, glm::length(translation));
+
+    if (params.bExtractYaw) {
+      // Unwrap the angles to interpolate them continuously.
+      auto const rotation = parent_rotation * root.qRotation * inv_first_rotation;
+      float yaw = ExtractYaw(rotation);
+      if (i > 0) {
+        float const last_yaw = root_motion.yaws[i - 1];
+        yaw = last_yaw + glm::atan(glm::sin(yaw - last_yaw), glm::cos(yaw - last_yaw));
+      }
+      root_motion.yaws[i] = yaw;
+      max_angle = glm::max(max_angle, glm::abs(yaw));
+    }
+  }
+
+  if ((max_distance < params.min_distance) && (max_angle < params.min_angle)) {
+    return false;
+  }
+
+  // Extrapolate the motion of the wrapping frame, from the last to the first.
+  {
+    auto &translations = root_motion.translations;
+    translations[nframes] = 2.0f * translations[nframes - 1] - translations[nframes - 2];
+    if (params.bExtractYaw) {
+      auto &yaws = root_motion.yaws;
+      yaws[nframes] = 2.0f * yaws[nframes - 1] - yaws[nframes - 2];
+    }
+  }
+
+  // Remove the motion from the root samples : L' = P^-1 . Motion^-1 . P . L
+  auto const inv_parent_matrix = glm::inverse(parent_matrix);
+  for (int32_t i = 0; i < nframes; ++i) {
+    auto const correction = inv_parent_matrix
+                          * glm::inverse(root_motion.transform(static_cast<float>(i)))
+                          * parent_matrix
+                          ;
+    auto &root = clip.samples[i].joints[0];
+    root.vTranslation = glm::vec3(correction * glm::vec4(root.vTranslation, 1.0f));
+    root.qRotation = glm::normalize(ExtractRotation(correction) * root.qRotation);
+  }
+
+  clip.root_motion = std::move(root_motion);
+
+  return true;
+}
+
+// -----------------------------------------------------------------------------
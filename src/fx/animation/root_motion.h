@@ -0,0 +1,36 @@
+#ifndef BARBU_ANIMATION_ROOT_MOTION_H_
+#define BARBU_ANIMATION_ROOT_MOTION_H_
+
+#include "fx/animation/common.h"
+#include "fx/animation/skeleton.h"
+
+// -----------------------------------------------------------------------------
+//
+// Root motion is the displacement of a character embedded in the root joint of
+// its clips (eg. a walk cycle moving forward). It is extracted at import on the
+// mesh horizontal plane, so that the clip plays in place while the motion is
+// applied to the character entity (see SkinComponent), keeping loops seamless.
+// Skins not moved by their root motion get it back on their root pose (see
+// SkeletonController).
+//
+// Notes :
+//  * The skeleton root parent transform is expected to have an uniform scale.
+//
+// -----------------------------------------------------------------------------
+
+struct RootMotionParams_t {
+  bool bExtractYaw    = false;                //< extract the root rotation around the up axis too
+  float min_distance  = 1.0e-2f;              //< motion below which a clip is kept as is, in model units
+  float min_angle     = 1.0e-2f;              //< rotation below which a clip is kept as is, in radians
+};
+
+/* Move the horizontal motion of the root joint from the raw samples of a clip
+ * to its root motion, return false when the clip does not move its root or
+ * is already compressed. */
+bool ExtractRootMotion(Skeleton const& skeleton,
+                       AnimationClip_t &clip,
+                       RootMotionParams_t const& params = RootMotionParams_t());
+
+// -----------------------------------------------------------------------------
+
+#endif  // BARBU_ANIMATION_ROOT_MOTION_H_
@@ -1,4 +1,7 @@
 #include "fx/animation/skeleton.h"
+
+#include <algorithm>
+
 #include "core/logger.h"
 
 // -----------------------------------------------------------------------------
@@ -42,4 +45,18 @@ void Skeleton::calculate_global_bind_matrices() {
   }
 }
 
+void Skeleton::calculate_joint_heights() {
+  if (!heights.empty()) {
+    return;
+  }
+
+  heights.resize(njoints(), 0);
+  for (int i = njoints() - 1; i > 0; --i) {
+    auto const parent_id = parents[i];
+    if (parent_id > -1) {
+      heights[parent_id] = std::max( heights[parent_id], heights[i] + 1);
+    }
+  }
+}
+
 // -----------------------------------------------------------------------------
@@ -9,6 +9,7 @@
 #include "glm/glm.hpp"
 
 #include "fx/animation/common.h"
+#include "utils/mathutils.h"
 
 // -----------------------------------------------------------------------------
 
@@ -30,6 +31,19 @@ struct Skeleton {
   JointBuffer_t<glm::mat4>      inverse_bind_matrices;
   JointBuffer_t<glm::mat4>      global_bind_matrices;
 
+  // Transform of the root joint parent, from its local to the skinned mesh space.
+  glm::mat4                     root_parent_matrix{1.0f};
+
+  // Height of each joint in the hierarchy (0 for leaves), used as the joints
+  // LOD mask of the animation system.
+  JointBuffer_t<int32_t>        heights;
+
+  // Mesh space bind pose bounds of the vertices influenced by each joint (empty
+  // for joints without vertices), and of the vertices without influences.
+  // Used to bound the skinned mesh, see fx/animation/cpu_skinning.h.
+  JointBuffer_t<BoundingBox_t>  joint_bounds;
+  BoundingBox_t                 static_bounds;
+
   // LookUp for joint index.
   std::unordered_map<std::string, int32_t> index_map;
 
@@ -64,6 +78,9 @@ struct Skeleton {
 
   // Fill the global bind matrices (used to debug display rest joints).
   void calculate_global_bind_matrices();
+
+  // Fill the joints height, leaves first (parents are stored before their children).
+  void calculate_joint_heights();
 };
 
 using SkeletonHandle = std::shared_ptr<Skeleton>;
@@ -1,53 +1,295 @@
 #include "fx/animation/skeleton_controller.h"
 
+#include <algorithm>
+
 #include "glm/gtc/matrix_transform.hpp"
 #include "glm/gtx/quaternion.hpp"
 
 #include "core/logger.h"
-#include "utils/mathutils.h"
-
-#ifdef BARBU_NPROC_MAX
-#define LOOP_NTHREADS  (BARBU_NPROC_MAX)
-#else
-#define LOOP_NTHREADS  4
-#endif
+#include "utils/simd.h"
 
 // -----------------------------------------------------------------------------
 
 namespace {
 
-/// Apply a linear interpolation on two samples.
-void LerpSamples(const AnimationSample_t &s1,
-                 const AnimationSample_t &s2,
-                 float const factor,
-                 AnimationSample_t &dst_sample)
-{
-  int32_t const njoints_ = static_cast<int32_t>(s1.joints.size());
-  dst_sample.joints.resize(njoints_);
-
-  #pragma omp parallel for schedule(static) num_threads(LOOP_NTHREADS)
-  for (int32_t i = 0; i < njoints_; ++i) {
-    auto const& J1{ s1.joints[i] };
-    auto const& J2{ s2.joints[i] };
-    auto &dst{ dst_sample.joints[i] };
-
-    // (for quaternions use shortMix (slerp) or fastMix (nlerp) but *NOT* mix).
-    dst.qRotation    = glm::shortMix( J1.qRotation,       J2.qRotation,     factor);
-    dst.vTranslation =      glm::mix( J1.vTranslation,    J2.vTranslation,  factor);
-    dst.fScale       =      glm::mix( J1.fScale,          J2.fScale,        factor);
-
-    // LOG_MESSAGE( __FUNCTION__, dst.fScale, J1.fScale, J2.fScale, factor);
-    // LOG_MESSAGE( __FUNCTION__, dst.vTranslation.x, J1.vTranslation.x, J2.vTranslation.x, factor);
+using simd::float4;
+
+// Poses of a block of joints, one per lane.
+struct JointLanes_t {
+  float4 qx, qy, qz, qw;
+  float4 tx, ty, tz;
+  float4 scale;
+};
+
+/// Gather a block of AoS joint poses into lanes, unused lanes are set to identity.
+JointLanes_t GatherJoints(JointPose_t const* joints, int32_t const count) {
+  static JointPose_t const kIdentity{};
+
+  alignas(16) float buffer[8][simd::kWidth];
+  for (int32_t i = 0; i < simd::kWidth; ++i) {
+    auto const& J = (i < count) ? joints[i] : kIdentity;
+    buffer[0][i] = J.qRotation.x;
+    buffer[1][i] = J.qRotation.y;
+    buffer[2][i] = J.qRotation.z;
+    buffer[3][i] = J.qRotation.w;
+    buffer[4][i] = J.vTranslation.x;
+    buffer[5][i] = J.vTranslation.y;
+    buffer[6][i] = J.vTranslation.z;
+    buffer[7][i] = J.fScale;
+  }
+
+  return {
+    simd::load(buffer[0]), simd::load(buffer[1]), simd::load(buffer[2]), simd::load(buffer[3]),
+    simd::load(buffer[4]), simd::load(buffer[5]), simd::load(buffer[6]),
+    simd::load(buffer[7])
+  };
+}
+
+/// Load a block of joints from a SoA pose.
+JointLanes_t LoadJoints(PoseSoA_t const& pose, int32_t const first) {
+  return {
+    simd::load(&pose.qx[first]), simd::load(&pose.qy[first]), simd::load(&pose.qz[first]), simd::load(&pose.qw[first]),
+    simd::load(&pose.tx[first]), simd::load(&pose.ty[first]), simd::load(&pose.tz[first]),
+    simd::load(&pose.scale[first])
+  };
+}
+
+/// Store a block of joints to a SoA pose.
+void StoreJoints(JointLanes_t const& J, int32_t const first, PoseSoA_t &pose) {
+  simd::store(&pose.qx[first], J.qx);
+  simd::store(&pose.qy[first], J.qy);
+  simd::store(&pose.qz[first], J.qz);
+  simd::store(&pose.qw[first], J.qw);
+  simd::store(&pose.tx[first], J.tx);
+  simd::store(&pose.ty[first], J.ty);
+  simd::store(&pose.tz[first], J.tz);
+  simd::store(&pose.scale[first], J.scale);
+}
+
+/// Select the lanes of a where the mask is set, the lanes of b otherwise.
+JointLanes_t SelectJoints(float4 const mask, JointLanes_t const& a, JointLanes_t const& b) {
+  return {
+    simd::select(mask, a.qx, b.qx), simd::select(mask, a.qy, b.qy),
+    simd::select(mask, a.qz, b.qz), simd::select(mask, a.qw, b.qw),
+    simd::select(mask, a.tx, b.tx), simd::select(mask, a.ty, b.ty),
+    simd::select(mask, a.tz, b.tz),
+    simd::select(mask, a.scale, b.scale)
+  };
+}
+
+/// Dot product of the lanes' quaternions.
+inline float4 DotQuat(JointLanes_t const& a, JointLanes_t const& b) {
+  return a.qx * b.qx + a.qy * b.qy + a.qz * b.qz + a.qw * b.qw;
+}
+
+/// Normalize the lanes' quaternions.
+inline void NormalizeQuat(JointLanes_t &J) {
+  float4 const inv_length = simd::set1(1.0f) / simd::sqrt(DotQuat(J, J));
+  J.qx *= inv_length;
+  J.qy *= inv_length;
+  J.qz *= inv_length;
+  J.qw *= inv_length;
+}
+
+/// Interpolate two blocks of joints, using nlerp along the shortest path for rotations.
+JointLanes_t NlerpJoints(JointLanes_t const& a, JointLanes_t const& b, float const factor) {
+  float4 const t  = simd::set1(factor);
+  float4 const ta = simd::set1(1.0f - factor);
+  float4 const tb = t * simd::sign_not_zero(DotQuat(a, b));
+
+  JointLanes_t dst;
+  dst.qx    = ta * a.qx + tb * b.qx;
+  dst.qy    = ta * a.qy + tb * b.qy;
+  dst.qz    = ta * a.qz + tb * b.qz;
+  dst.qw    = ta * a.qw + tb * b.qw;
+  dst.tx    = a.tx + t * (b.tx - a.tx);
+  dst.ty    = a.ty + t * (b.ty - a.ty);
+  dst.tz    = a.tz + t * (b.tz - a.tz);
+  dst.scale = a.scale + t * (b.scale - a.scale);
+  NormalizeQuat(dst);
+
+  return dst;
+}
+
+/// Accumulate a weighted block of joints, its rotations are flipped to the
+/// hemisphere of the reference ones to cope with antipodality.
+void BlendJoints(JointLanes_t const& src, JointLanes_t const& reference, float const weight, JointLanes_t &dst) {
+  float4 const w   = simd::set1(weight);
+  float4 const w_q = w * simd::sign_not_zero(DotQuat(reference, src));
+
+  dst.qx    += w_q * src.qx;
+  dst.qy    += w_q * src.qy;
+  dst.qz    += w_q * src.qz;
+  dst.qw    += w_q * src.qw;
+  dst.tx    += w * src.tx;
+  dst.ty    += w * src.ty;
+  dst.tz    += w * src.tz;
+  dst.scale += w * src.scale;
+}
+
+/// Apply the difference between an additive pose and its reference, scaled by
+/// weight, over dst.
+void AddJoints(JointLanes_t const& add, JointLanes_t const& ref, float const weight, JointLanes_t &dst) {
+  // Delta rotation, conjugate(ref) * add.
+  float4 dw = ref.qw * add.qw + ref.qx * add.qx + ref.qy * add.qy + ref.qz * add.qz;
+  float4 dx = ref.qw * add.qx - ref.qx * add.qw - ref.qy * add.qz + ref.qz * add.qy;
+  float4 dy = ref.qw * add.qy + ref.qx * add.qz - ref.qy * add.qw - ref.qz * add.qx;
+  float4 dz = ref.qw * add.qz - ref.qx * add.qy + ref.qy * add.qx - ref.qz * add.qw;
+
+  // Weight the delta from identity, on the shortest path.
+  float4 const w = simd::sign_not_zero(dw) * simd::set1(weight);
+  dw = dw * w + simd::set1(1.0f - weight);
+  dx *= w;
+  dy *= w;
+  dz *= w;
+  float4 const inv_len = simd::set1(1.0f) / simd::sqrt(dw * dw + dx * dx + dy * dy + dz * dz);
+  dw *= inv_len;
+  dx *= inv_len;
+  dy *= inv_len;
+  dz *= inv_len;
+
+  // Rotate in the joint local space, dst * delta.
+  float4 const qw = dst.qw * dw - dst.qx * dx - dst.qy * dy - dst.qz * dz;
+  float4 const qx = dst.qw * dx + dst.qx * dw + dst.qy * dz - dst.qz * dy;
+  float4 const qy = dst.qw * dy - dst.qx * dz + dst.qy * dw + dst.qz * dx;
+  float4 const qz = dst.qw * dz + dst.qx * dy - dst.qy * dx + dst.qz * dw;
+  dst.qw = qw;
+  dst.qx = qx;
+  dst.qy = qy;
+  dst.qz = qz;
+
+  float4 const w4 = simd::set1(weight);
+  dst.tx += w4 * (add.tx - ref.tx);
+  dst.ty += w4 * (add.ty - ref.ty);
+  dst.tz += w4 * (add.tz - ref.tz);
+  dst.scale += w4 * (add.scale - ref.scale);
+}
+
+/// Compose the translation and rotation of a block of joints into matrices.
+void ComposeMatrices(JointLanes_t const& J, int32_t const count, glm::mat4 *dst) {
+  // [ scaling is not applied ]
+  float4 const one  = simd::set1(1.0f);
+  float4 const zero = simd::zero();
+
+  float4 const x2 = J.qx + J.qx;
+  float4 const y2 = J.qy + J.qy;
+  float4 const z2 = J.qz + J.qz;
+  float4 const xx = J.qx * x2;
+  float4 const yy = J.qy * y2;
+  float4 const zz = J.qz * z2;
+  float4 const xy = J.qx * y2;
+  float4 const xz = J.qx * z2;
+  float4 const yz = J.qy * z2;
+  float4 const wx = J.qw * x2;
+  float4 const wy = J.qw * y2;
+  float4 const wz = J.qw * z2;
+
+  // Columns of the matrices, each row holding the lanes.
+  float4 columns[4][4]{
+    { one - (yy + zz),  xy + wz,          xz - wy,          zero },
+    { xy - wz,          one - (xx + zz),  yz + wx,          zero },
+    { xz + wy,          yz - wx,          one - (xx + yy),  zero },
+    { J.tx,             J.ty,             J.tz,             one  },
+  };
+
+  for (int32_t c = 0; c < 4; ++c) {
+    auto &col = columns[c];
+    simd::transpose(col[0], col[1], col[2], col[3]);
+    for (int32_t i = 0; i < count; ++i) {
+      simd::store(&dst[i][c][0], col[i]);
+    }
+  }
+}
+
+/// Multiply two column-major matrices, the result columns are returned in dst.
+inline void MultiplyMatrices(glm::mat4 const& a, glm::mat4 const& b, float4 dst[4]) {
+  float4 const a0 = simd::load(&a[0][0]);
+  float4 const a1 = simd::load(&a[1][0]);
+  float4 const a2 = simd::load(&a[2][0]);
+  float4 const a3 = simd::load(&a[3][0]);
+
+  for (int32_t c = 0; c < 4; ++c) {
+    dst[c] = a0 * simd::set1(b[c][0])
+           + a1 * simd::set1(b[c][1])
+           + a2 * simd::set1(b[c][2])
+           + a3 * simd::set1(b[c][3])
+           ;
+  }
+}
+
+/// Convert a block of rigid 3x4 row matrices to dual quaternions.
+/// m[r][c] holds the lanes of the element at row r and column c.
+void ConvertDualQuaternions(float4 const m[3][4], int32_t const count, glm::dualquat *dst) {
+  float4 const one  = simd::set1(1.0f);
+  float4 const half = simd::set1(0.5f);
+  float4 const eps  = simd::set1(1.0e-8f);
+
+  float4 const m00 = m[0][0], m01 = m[0][1], m02 = m[0][2];
+  float4 const m10 = m[1][0], m11 = m[1][1], m12 = m[1][2];
+  float4 const m20 = m[2][0], m21 = m[2][1], m22 = m[2][2];
+  float4 const trace = m00 + m11 + m22;
+
+  // Compute the rotation quaternion for every cases, then select per lane
+  // the numerically stable one (unselected lanes are clamped to stay finite).
+  float4 r, s;
+  r = simd::sqrt(simd::max(one + trace, eps)); s = half / r;
+  float4 const x0 = (m21 - m12) * s, y0 = (m02 - m20) * s, z0 = (m10 - m01) * s, w0 = half * r;
+
+  r = simd::sqrt(simd::max(one + m00 - m11 - m22, eps)); s = half / r;
+  float4 const x1 = half * r, y1 = (m10 + m01) * s, z1 = (m02 + m20) * s, w1 = (m21 - m12) * s;
+
+  r = simd::sqrt(simd::max(one + m11 - m00 - m22, eps)); s = half / r;
+  float4 const x2 = (m10 + m01) * s, y2 = half * r, z2 = (m21 + m12) * s, w2 = (m02 - m20) * s;
+
+  r = simd::sqrt(simd::max(one + m22 - m00 - m11, eps)); s = half / r;
+  float4 const x3 = (m02 + m20) * s, y3 = (m21 + m12) * s, z3 = half * r, w3 = (m10 - m01) * s;
+
+  float4 const c0 = trace > simd::zero();
+  float4 const c1 = (m00 > m11) & (m00 > m22);
+  float4 const c2 = m11 > m22;
+
+  auto const pick = [&](float4 v0, float4 v1, float4 v2, float4 v3) {
+    return simd::select(c0, v0, simd::select(c1, v1, simd::select(c2, v2, v3)));
+  };
+  float4 const qx = pick(x0, x1, x2, x3);
+  float4 const qy = pick(y0, y1, y2, y3);
+  float4 const qz = pick(z0, z1, z2, z3);
+  float4 const qw = pick(w0, w1, w2, w3);
+
+  // Dual part, from the translation.
+  float4 const t0 = m[0][3], t1 = m[1][3], t2 = m[2][3];
+  float4 const dx = half * (t0 * qw + t1 * qz - t2 * qy);
+  float4 const dy = half * (t1 * qw + t2 * qx - t0 * qz);
+  float4 const dz = half * (t0 * qy - t1 * qx + t2 * qw);
+  float4 const dw = -(half * (t0 * qx + t1 * qy + t2 * qz));
+
+  alignas(16) float lanes[8][simd::kWidth];
+  float4 const values[8]{ qx, qy, qz, qw, dx, dy, dz, dw };
+  for (int32_t k = 0; k < 8; ++k) {
+    simd::store(lanes[k], values[k]);
+  }
+
+  for (int32_t i = 0; i < count; ++i) {
+    auto &dq = dst[i];
+    dq.real.x = lanes[0][i];
+    dq.real.y = lanes[1][i];
+    dq.real.z = lanes[2][i];
+    dq.real.w = lanes[3][i];
+    dq.dual.x = lanes[4][i];
+    dq.dual.y = lanes[5][i];
+    dq.dual.z = lanes[6][i];
+    dq.dual.w = lanes[7][i];
   }
 }
 
-/// Generate a sample for sequence_clip at global_time.
+/// Find the clip frames to interpolate for sequence_clip at global_time.
 bool ComputePose(float const global_time,
                  SequenceClip_t& sequence_clip,
-                 AnimationSample_t& dst_sample)
+                 AnimationClip_t const*& clip,
+                 int32_t &frame_a,
+                 int32_t &frame_b,
+                 float &lerp_factor)
 {
-  // [todo: handle compressed joints data]
-  
   float local_time{0.0f};
 
   if (sequence_clip.evaluate_localtime(global_time, local_time)) {
@@ -56,21 +298,17 @@ bool ComputePose(float const global_time,
   }
   int32_t const next_frame = +1; //
 
-  auto const* clip = reinterpret_cast<AnimationClip_t const*>(sequence_clip.action_ptr); //
+  clip = reinterpret_cast<AnimationClip_t const*>(sequence_clip.action_ptr); //
 
   // Interpolated frame.
   float const lerped_frame = local_time * clip->framerate;
 
   // Find the frame boundaries.
-  int32_t const frame_a = static_cast<int32_t>(lerped_frame) % clip->framecount;
-  int32_t const frame_b = (frame_a + next_frame) % clip->framecount;
+  frame_a = static_cast<int32_t>(lerped_frame) % clip->framecount;
+  frame_b = (frame_a + next_frame) % clip->framecount;
 
   // Compute the correct time sample for the pose.
-  auto const& s1 = clip->samples[frame_a];
-  auto const& s2 = clip->samples[frame_b];
-  float const lerp_factor = lerped_frame - static_cast<float>(frame_a); // glm::fract(lerped_frame)
-
-  LerpSamples(s1, s2, lerp_factor, dst_sample);
+  lerp_factor = lerped_frame - static_cast<float>(frame_a); // glm::fract(lerped_frame)
 
   // LOG_INFO( "{", lerped_frame, "} =", local_time, "*", clip->framerate);
   // LOG_INFO( "[", frame_a, frame_b, "]", "{", lerped_frame, "}");
@@ -82,185 +320,288 @@ bool ComputePose(float const global_time,
 
 // -----------------------------------------------------------------------------
 
-//
-//  Shared structure to handle sampling a clip from a skinning animation.
-//
-struct SkinningFrame_t {
-  AnimationSampleBuffer_t samples;
-  int32_t num_active_clips;
+bool SkeletonController::prepare(SkinningMode const mode, SkeletonHandle skeleton, float const global_time, Sequence_t &sequence) {
+  if (nullptr == skeleton) {
+    return false;
+  }
 
-  /* Compute the static pose derived from each contributing clips. */
-  void compute_poses(float const global_time, Sequence_t &sequence) {
-    num_active_clips = 0;
-    samples.resize(sequence.size());
+  // Retrieve the samples from each contributing clips, the base clips first
+  // then the additive ones.
+  clip_samples_.clear();
 
+  auto const retrieve_samples = [&](bool const bAdditive) {
     for (auto &sc : sequence) {
-      if (sc.bEnable && ComputePose(global_time, sc, samples[num_active_clips])) {
-        ++num_active_clips;
+      ClipSample_t cs;
+      if (sc.bEnable && (sc.bAdditive == bAdditive)
+       && ComputePose(global_time, sc, cs.clip, cs.frame_a, cs.frame_b, cs.factor)) {
+        cs.weight = sc.weight;
+        cs.bAdditive = sc.bAdditive;
+        clip_samples_.push_back(cs);
       }
     }
-  }
-};
+  };
+  retrieve_samples(false);
+  nbase_samples_ = static_cast<int32_t>(clip_samples_.size());
+  retrieve_samples(true);
 
-static SkinningFrame_t sFrame;
+  if (clip_samples_.empty()) {
+    LOG_DEBUG_INFO( "No animation clips were provided." );
+    return false;
+  }
 
-// -----------------------------------------------------------------------------
+  // Additive clips are treated as base clips when there is none.
+  if (0 == nbase_samples_) {
+    nbase_samples_ = static_cast<int32_t>(clip_samples_.size());
+  }
 
-bool SkeletonController::evaluate(SkinningMode const mode, SkeletonHandle skeleton, float const global_time, Sequence_t &sequence) {
-  if (nullptr == skeleton) {
-    return false;
+  // Normalize the base weights, supposing blending associativity (ie. flat weighted average).
+  float sum_weights = 0.0f;
+  for (int32_t i = 0; i < nbase_samples_; ++i) {
+    sum_weights += clip_samples_[i].weight;
+  }
+  sum_weights = (sum_weights == 0.0f) ? 1.0f : sum_weights; //
+  for (int32_t i = 0; i < nbase_samples_; ++i) {
+    clip_samples_[i].weight /= sum_weights;
+  }
+  for (size_t i = nbase_samples_; i < clip_samples_.size(); ++i) {
+    clip_samples_[i].weight = glm::clamp(clip_samples_[i].weight, 0.0f, 1.0f);
   }
 
-  // 1) Compute the static sampling pose from each contributing clips.
-  sFrame.compute_poses( global_time, sequence);
+  mode_     = mode;
+  skeleton_ = skeleton;
+
+  // Put back the root motion extracted at import when the clips play in place,
+  // blending that of the base clips.
+  // (additive clips are relative to their first frame and keep theirs extracted)
+  root_matrix_ = skeleton->root_parent_matrix;
+  if (!bRootMotion_) {
+    glm::vec3 translation(0.0f);
+    glm::vec3 pivot(0.0f);
+    float yaw = 0.0f;
+    float motion_weight = 0.0f;
+
+    for (int32_t i = 0; i < nbase_samples_; ++i) {
+      auto const& cs = clip_samples_[i];
+      auto const& root_motion = cs.clip->root_motion;
+      if (cs.bAdditive || root_motion.empty()) {
+        continue;
+      }
+      glm::vec3 clip_translation;
+      float clip_yaw;
+      root_motion.sample(static_cast<float>(cs.frame_a) + cs.factor, clip_translation, clip_yaw);
+
+      translation   += cs.weight * clip_translation;
+      yaw           += cs.weight * clip_yaw;
+      pivot         += cs.weight * root_motion.pivot;
+      motion_weight += cs.weight;
+    }
 
-  if (sFrame.num_active_clips <= 0) {
-    LOG_DEBUG_INFO( "No animation clips were provided." );
-    return false;
+    if (motion_weight > 0.0f) {
+      pivot /= motion_weight;
+      glm::mat4 motion = glm::translate(glm::mat4(1.0f), pivot + translation);
+      motion = glm::rotate(motion, yaw, glm::vec3(0.0f, 1.0f, 0.0f));
+      motion = glm::translate(motion, -pivot);
+      root_matrix_ = motion * root_matrix_;
+    }
   }
 
   // Resize buffer data when needed.
   njoints_ = skeleton->njoints();
-  if (local_pose_.joints.size() < static_cast<size_t>(njoints_)) {
-    local_pose_.joints.resize( njoints_ );
+  if (global_pose_matrices_.size() < static_cast<size_t>(njoints_)) {
+    local_pose_.resize( njoints_ );
     global_pose_matrices_.resize( njoints_ );
-    skinning_matrices_.resize( njoints_ );
-    if (SkinningMode::DualQuaternion == mode) {
-      dual_quaternions_.resize( njoints_ );
-    }
+    bPoseInitialized_ = false;
   }
 
-  // 2) Blend between poses to get a unique local pose.
-  blend_poses(sequence);
-
-  // (we could post-process the blend pose before generating the skinning data).
-
-  // 3) Generate the global pose matrices.
-  generate_global_pose_matrices(skeleton);
+  // Joints can only be masked once a full pose has been evaluated.
+  if (!bPoseInitialized_ || skeleton->heights.empty()) {
+    skip_height_ = 0;
+  }
+  bPoseInitialized_ = true;
 
-  // 4) Generate the final skinning datas.
-  generate_skinning_datas(mode, skeleton);
+  nskipped_joints_ = 0;
+  if (skip_height_ > 0) {
+    for (int32_t i = 0; i < njoints_; ++i) {
+      nskipped_joints_ += (skeleton->heights[i] < skip_height_) ? 1 : 0;
+    }
+  }
 
   return true;
 }
 
-
-void SkeletonController::blend_poses(Sequence_t const& sequence) {
-  auto const& samples = sFrame.samples;
-
-  // Bypass the weighting if there is only one active clip.
-  if (1 == sFrame.num_active_clips) {
-    auto const joints_start{ samples[0].joints.cbegin() };
-    std::copy(joints_start, joints_start + njoints_, local_pose_.joints.begin());
-    LOG_DEBUG_INFO( __FUNCTION__, ": single clip copy." );
+void SkeletonController::evaluate_local_pose(int32_t const block_id) {
+  int32_t const first = block_id * PoseSoA_t::kLaneWidth;
+  int32_t const count = std::min(PoseSoA_t::kLaneWidth, njoints_ - first);
+
+  // Check the joints masked by the animation LOD.
+  alignas(16) float lanes[simd::kWidth]{ 1.0f, 1.0f, 1.0f, 1.0f };
+  int32_t nactives = count;
+  if (skip_height_ > 0) {
+    nactives = 0;
+    for (int32_t i = 0; i < count; ++i) {
+      bool const bActive = skeleton_->heights[first + i] >= skip_height_;
+      lanes[i] = bActive ? 1.0f : 0.0f;
+      nactives += bActive ? 1 : 0;
+    }
+  }
+  if (0 == nactives) {
     return;
   }
+  bool const bMasked = nactives < count;
 
-  //
-  // Compute local poses by blending each contributing samples by the factor
-  // previously calculated by the blend tree. 
-  // Suppose blending associativity (ie. flat weighted average).
-  //
+  auto const decode = [&](CompressedClip_t const& compressed, float frame, JointPose_t *poses) {
+    if (!bMasked) {
+      compressed.sample( first, count, frame, poses);
+      return;
+    }
+    for (int32_t i = 0; i < count; ++i) {
+      if (lanes[i] > 0.0f) {
+        compressed.sample( first + i, 1, frame, poses + i);
+      }
+    }
+  };
 
-  // 1) Calculate the total weight for normalization.
-  float sum_weights = 0.0f;
-  
-  // [ we might switch to omp by removing the iterator ]
-  //# pragma omp parallel for reduction(+:sum_weights) schedule(static) num_threads(LOOP_NTHREADS)
-  for (auto const &sc : sequence) {
-    sum_weights += (sc.bEnable) ? sc.weight : 0.0f;
-  }
-  sum_weights = (sum_weights == 0.0f) ? 1.0f : sum_weights; //
+  auto const sample_clip = [&](ClipSample_t const& cs) {
+    auto const& clip = *cs.clip;
 
-  // 2) Copy the first weighted action as base.
-  auto it = sequence.cbegin();
-  {
-    float const w = it->weight / sum_weights;
-    
-    #pragma omp parallel for schedule(static) num_threads(LOOP_NTHREADS)
-    for (int32_t i = 0; i < njoints_; ++i) {
-      auto const &src = samples[0].joints[i];
-            auto &dst = local_pose_.joints[i];
-      
-      dst.qRotation    = w * src.qRotation;
-      dst.vTranslation = w * src.vTranslation;
-      dst.fScale       = w * src.fScale;
+    if (clip.is_compressed()) {
+      JointPose_t poses[2][PoseSoA_t::kLaneWidth];
+
+      // Consecutive frames are interpolated directly by the decoder.
+      if (cs.frame_b == cs.frame_a + 1) {
+        decode( clip.compressed, cs.frame_a + cs.factor, poses[0]);
+        return GatherJoints( poses[0], count);
+      }
+      decode( clip.compressed, static_cast<float>(cs.frame_a), poses[0]);
+      decode( clip.compressed, static_cast<float>(cs.frame_b), poses[1]);
+      return NlerpJoints( GatherJoints(poses[0], count), GatherJoints(poses[1], count), cs.factor);
     }
-  }
 
-  // 3) Blend the rest.
-  int32_t sid = 1;
-  for (it = ++it; sid < sFrame.num_active_clips; ++it, ++sid) {
-    auto const& sample = samples[sid];
+    auto const J1 = GatherJoints( clip.samples[cs.frame_a].joints.data() + first, count);
+    auto const J2 = GatherJoints( clip.samples[cs.frame_b].joints.data() + first, count);
+    return NlerpJoints( J1, J2, cs.factor);
+  };
 
-    // Cope with antipodality by checking the quaternion neighborhood.
-    float const sign_q{ glm::sign(glm::dot(
-      sample.joints[0].qRotation, 
-      sample.joints[njoints_-1].qRotation
-    ))};
+  // Reference pose of additive clips, their first frame.
+  auto const sample_reference = [&](ClipSample_t const& cs) {
+    auto const& clip = *cs.clip;
 
-    float const w   = it->weight / sum_weights;
-    float const w_q = w * sign_q;
+    if (clip.is_compressed()) {
+      JointPose_t poses[PoseSoA_t::kLaneWidth];
+      decode( clip.compressed, 0.0f, poses);
+      return GatherJoints( poses, count);
+    }
+    return GatherJoints( clip.samples[0].joints.data() + first, count);
+  };
+
+  // Masked joints keep their previous pose.
+  auto const store = [&](JointLanes_t const& J) {
+    if (bMasked) {
+      auto const mask = simd::load(lanes) > simd::zero();
+      StoreJoints( SelectJoints( mask, J, LoadJoints(local_pose_, first)), first, local_pose_);
+    } else {
+      StoreJoints( J, first, local_pose_);
+    }
+  };
 
-    // [could swap the 2 loops and do 3 reduces operations instead]
-    #pragma omp parallel for schedule(static) num_threads(LOOP_NTHREADS)
-    for (int32_t i = 0; i < njoints_; ++i) {
-      auto const &src = sample.joints[i];
-            auto &dst = local_pose_.joints[i];
+  auto dst = sample_clip(clip_samples_[0]);
+
+  //
+  // Compute local poses by blending each contributing samples by the factor
+  // previously calculated by the blend tree.
+  //
+  // (bypass the weighting if there is only one base clip)
+  if (nbase_samples_ > 1) {
+    auto const base = dst;
+
+    dst = JointLanes_t{
+      simd::zero(), simd::zero(), simd::zero(), simd::zero(),
+      simd::zero(), simd::zero(), simd::zero(),
+      simd::zero()
+    };
+    BlendJoints( base, base, clip_samples_[0].weight, dst);
 
-      dst.qRotation    += w_q * src.qRotation;
-      dst.vTranslation += w   * src.vTranslation;
-      dst.fScale       += w   * src.fScale;
+    for (int32_t sid = 1; sid < nbase_samples_; ++sid) {
+      auto const& cs = clip_samples_[sid];
+      BlendJoints( sample_clip(cs), base, cs.weight, dst);
     }
 
     // Normalize quaternion lerping.
-    for (auto &joint : local_pose_.joints) {
-      joint.qRotation /= glm::length(joint.qRotation);
-    }
+    NormalizeQuat(dst);
   }
-}
 
-void SkeletonController::generate_global_pose_matrices(SkeletonHandle skeleton) {
-  // [ scaling is not applied ]
+  // Apply the additive layers over the blended pose.
+  for (size_t sid = nbase_samples_; sid < clip_samples_.size(); ++sid) {
+    auto const& cs = clip_samples_[sid];
+    AddJoints( sample_clip(cs), sample_reference(cs), cs.weight, dst);
+  }
+  if (static_cast<size_t>(nbase_samples_) < clip_samples_.size()) {
+    NormalizeQuat(dst);
+  }
 
+  store(dst);
+}
+
+void SkeletonController::generate_global_pose_matrices() {
   // Compute local matrices.
-  #pragma omp parallel for schedule(static) num_threads(LOOP_NTHREADS)
-  for (int32_t i = 0; i < njoints_; ++i) {
-    auto const &joint = local_pose_.joints[i];
-    global_pose_matrices_[i]  = glm::translate(glm::mat4(1.0f), joint.vTranslation)
-                              * glm::mat4_cast(joint.qRotation)
-                              ;
+  for (int32_t first = 0; first < njoints_; first += PoseSoA_t::kLaneWidth) {
+    int32_t const count = std::min(PoseSoA_t::kLaneWidth, njoints_ - first);
+    ComposeMatrices( LoadJoints(local_pose_, first), count, &global_pose_matrices_[first]);
   }
 
-  // The root should use the world matrix.
-  global_pose_matrices_[0] = skeleton->global_bind_matrices[0]; // xxx
-  // global_pose_matrices_[0] = world_matrix * global_pose_matrices_[0];
+  // Bring the root to the mesh space.
+  float4 columns[4];
+  MultiplyMatrices( root_matrix_, global_pose_matrices_[0], columns);
+  for (int32_t c = 0; c < 4; ++c) {
+    simd::store(&global_pose_matrices_[0][c][0], columns[c]);
+  }
 
   // Multiply non-root bones with their parent.
+  // (parents are stored before their children)
   for (int32_t i = 1; i < njoints_; ++i) {
-    auto const parent_id = skeleton->parents[i];
-    global_pose_matrices_[i] = global_pose_matrices_[parent_id] 
-                             * global_pose_matrices_[i]
-                             ;
+    auto const parent_id = skeleton_->parents[i];
+    MultiplyMatrices( global_pose_matrices_[parent_id], global_pose_matrices_[i], columns);
+    for (int32_t c = 0; c < 4; ++c) {
+      simd::store(&global_pose_matrices_[i][c][0], columns[c]);
+    }
   }
 }
 
-void SkeletonController::generate_skinning_datas(SkinningMode const mode, SkeletonHandle skeleton) {
+void SkeletonController::generate_skinning_data(int32_t const block_id, glm::mat3x4 *skinning_matrices, glm::dualquat *dual_quaternions) const {
+  int32_t const first = block_id * PoseSoA_t::kLaneWidth;
+  int32_t const count = std::min(PoseSoA_t::kLaneWidth, njoints_ - first);
+
+  // Rows of the skinning matrices, per lane, initialized to identity.
+  alignas(16) static float const kIdentityRows[3][4]{ {1, 0, 0, 0}, {0, 1, 0, 0}, {0, 0, 1, 0} };
+  float4 rows[3][simd::kWidth];
+  for (int32_t r = 0; r < 3; ++r) {
+    for (auto &lane : rows[r]) {
+      lane = simd::load(kIdentityRows[r]);
+    }
+  }
+
   // Generate skinning matrices, transposed to fill a 3x4 matrix.
-  #pragma omp parallel for schedule(static) num_threads(LOOP_NTHREADS)
-  for (int32_t i = 0; i < njoints_; ++i) {
-    glm::mat4 const skin_matrix{
-      global_pose_matrices_[i] * skeleton->inverse_bind_matrices[i]
-    };
-    skinning_matrices_[i] = glm::mat3x4(glm::transpose(skin_matrix));
+  for (int32_t i = 0; i < count; ++i) {
+    int32_t const joint_id = first + i;
+
+    float4 columns[4];
+    MultiplyMatrices( global_pose_matrices_[joint_id], skeleton_->inverse_bind_matrices[joint_id], columns);
+    simd::transpose(columns[0], columns[1], columns[2], columns[3]);
+
+    auto &skinning_matrix = skinning_matrices[joint_id];
+    for (int32_t r = 0; r < 3; ++r) {
+      rows[r][i] = columns[r];
+      simd::store(&skinning_matrix[r][0], columns[r]);
+    }
   }
 
   // Convert Skinning Matrices to Dual Quaternions.
-  if (SkinningMode::DualQuaternion == mode) {
-    #pragma omp parallel for schedule(static) num_threads(LOOP_NTHREADS)
-    for (int32_t i = 0; i < njoints_; ++i) {
-      dual_quaternions_[i] = glm::dualquat(skinning_matrices_[i]);
+  if (nullptr != dual_quaternions) {
+    // Swizzle the rows to have the lanes per element.
+    for (auto &row : rows) {
+      simd::transpose(row[0], row[1], row[2], row[3]);
     }
+    ConvertDualQuaternions( rows, count, dual_quaternions + first);
   }
 }
 
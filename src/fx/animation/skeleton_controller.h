@@ -7,9 +7,13 @@
 
 // -----------------------------------------------------------------------------
 
-// 
-// The SkeletonController transform a sequence of animation clips into skinning 
-// data for different stages. 
+//
+// The SkeletonController transform a sequence of animation clips into a skeleton
+// pose, evaluated in stages so that many controllers can be processed in batch
+// by the AnimationSystem.
+//
+// A controller holds no shared state, so different controllers can be evaluated
+// concurrently.
 //
 class SkeletonController {
  public:
@@ -19,40 +23,104 @@ class SkeletonController {
     return global_pose_matrices_;
   }
 
-  JointBuffer_t<glm::mat3x4> const& skinning_matrices() const {
-    assert(!skinning_matrices_.empty());
-    return skinning_matrices_;
+  int32_t njoints() const {
+    return njoints_;
   }
 
-  JointBuffer_t<glm::dualquat> const& dual_quaternions() const {
-    assert(!dual_quaternions_.empty());
-    return dual_quaternions_;
+  SkeletonHandle skeleton() const {
+    return skeleton_;
   }
 
-  int32_t njoints() const {
-    return njoints_;
+  SkinningMode skinning_mode() const {
+    return mode_;
+  }
+
+  /* Return the offset of the controller's joints in the AnimationSystem
+   * palettes, -1 when it was not added this frame. */
+  int32_t palette_offset() const {
+    return palette_offset_;
+  }
+
+  /* Return the mesh space bounds of the skinned mesh, computed by the
+   * AnimationSystem with the last skinning data (empty when unknown). */
+  BoundingBox_t const& skinned_bounds() const {
+    return skinned_bounds_;
+  }
+
+  /* Keep the root motion out of the pose when it moves the skin's entity,
+   * otherwise the motion extracted at import is put back on the root. */
+  void set_root_motion(bool const enable) {
+    bRootMotion_ = enable;
   }
 
-  /* Fill the in-between skinning matrices for the given time and sequence. 
-   * Return true when it succeeds, false when no data where computed. */
-  bool evaluate(SkinningMode const mode, SkeletonHandle skeleton, float const global_time, Sequence_t &sequence);
+  /* Retrieve the clips to sample at global_time for the given sequence.
+   * Return false when no clips are active. */
+  bool prepare(SkinningMode const mode, SkeletonHandle skeleton, float const global_time, Sequence_t &sequence);
+
+  /* Return the number of joints blocks processed by the block kernels. */
+  int32_t nblocks() const {
+    return (njoints_ + PoseSoA_t::kLaneWidth - 1) / PoseSoA_t::kLaneWidth;
+  }
+
+  /* Sample and blend the active clips to get the local pose of a joints block. */
+  void evaluate_local_pose(int32_t const block_id);
+
+  /* Generate global pose matrices from the local pose (eg. for post-processing). */
+  void generate_global_pose_matrices();
+
+  /* Generate the final skinning data of a joints block, into buffers indexed by 
+   * joint. dual_quaternions is optional. */
+  void generate_skinning_data(int32_t const block_id, glm::mat3x4 *skinning_matrices, glm::dualquat *dual_quaternions) const;
 
  private:
-  /* Apply a normalized blending on previously sampled clips
-   * and store the final local pose. */
-  void blend_poses(Sequence_t const& sequence);
+  // Pair of frames to interpolate for an active clip.
+  struct ClipSample_t {
+    AnimationClip_t const* clip;
+    int32_t frame_a;
+    int32_t frame_b;
+    float factor;
+    float weight;
+    bool bAdditive;
+  };
+
+  // Skinning data evaluated ahead of time for throttled controllers, the
+  // palettes are interpolated between two keys.
+  struct LODState_t {
+    int32_t level = 0;
+    bool bValid = false;
+    float key_times[2]{ 0.0f, 0.0f };
+    JointBuffer_t<glm::mat3x4>    skinning_matrices[2];
+    JointBuffer_t<glm::dualquat>  dual_quaternions[2];
+  };
 
-  /* Generate global pose matrices (eg. for post-processing). */
-  void generate_global_pose_matrices(SkeletonHandle skeleton);
+  SkinningMode mode_ = SkinningMode::LinearBlending;
+  SkeletonHandle skeleton_ = nullptr;
+  int32_t njoints_ = 0;
 
-  /* Generate final transformation datas for skinning. */
-  void generate_skinning_datas(SkinningMode const mode, SkeletonHandle skeleton);
+  // Transform of the root to the mesh space, with the root motion of the
+  // sampled clips when it is not applied to the entity.
+  bool bRootMotion_ = false;
+  glm::mat4 root_matrix_{1.0f};
 
-  int32_t njoints_;
-  AnimationSample_t             local_pose_;
+  // Joints with a lower height are not sampled and keep their previous pose.
+  int32_t skip_height_ = 0;
+  int32_t nskipped_joints_ = 0;
+  bool bPoseInitialized_ = false;
+
+  LODState_t lod_;
+
+  BoundingBox_t skinned_bounds_;
+
+  std::vector<ClipSample_t>     clip_samples_;
+  int32_t                       nbase_samples_ = 0;   //< followed by the additive ones
+  PoseSoA_t                     local_pose_;
   JointBuffer_t<glm::mat4>      global_pose_matrices_;
-  JointBuffer_t<glm::mat3x4>    skinning_matrices_;
-  JointBuffer_t<glm::dualquat>  dual_quaternions_;
+
+  // Offsets of the controller's joints and blocks in the AnimationSystem batch.
+  int32_t palette_offset_ = -1;
+  int32_t block_offset_ = -1;
+
+  friend class AnimationSystem;
 };
 
 // -----------------------------------------------------------------------------
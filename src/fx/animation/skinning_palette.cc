@@ -0,0 +1,130 @@
+#include "fx/animation/skinning_palette.h"
+
+#include <algorithm>
+#include <cstring>
+
+// -----------------------------------------------------------------------------
+
+namespace {
+
+// Number of floats per RGBA32F texel.
+static constexpr int32_t kTexelSize = 4;
+
+// Number of texels per joint, matching shaders/shared/inc_skinning.glsl.
+static constexpr int32_t kMatrixTexels         = sizeof(glm::mat3x4) / (kTexelSize * sizeof(float));
+static constexpr int32_t kDualQuaternionTexels = sizeof(glm::dualquat) / (kTexelSize * sizeof(float));
+
+// Minimum capacity of a region, in texels.
+static constexpr int32_t kMinRegionTexels = 4096;
+
+// Duration of a single fence wait, in nanoseconds.
+static constexpr GLuint64 kWaitTimeout = 1000000000ull;
+
+} // namespace
+
+// -----------------------------------------------------------------------------
+
+void SkinningPalette::release() {
+  for (auto &fence : fences_) {
+    if (nullptr != fence) {
+      glDeleteSync(fence);
+      fence = nullptr;
+    }
+  }
+
+  if (0u != buffer_id_) {
+    glUnmapNamedBuffer(buffer_id_);
+    glDeleteBuffers(1u, &buffer_id_);
+    glDeleteTextures(1u, &texture_id_);
+    buffer_id_  = 0u;
+    texture_id_ = 0u;
+  }
+  mapped_ptr_    = nullptr;
+  region_texels_ = 0;
+}
+
+void SkinningPalette::upload(AnimationSystem const& animation) {
+  // Fence the region written on the previous frame, its draws being submitted.
+  if ((njoints_ > 0) && (nullptr == fences_[region_])) {
+    fences_[region_] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  }
+
+  njoints_ = animation.njoints();
+  if (0 == njoints_) {
+    return;
+  }
+  bool const bDualQuaternion = animation.has_dual_quaternions();
+
+  // Grow the ring when needed.
+  int32_t const ntexels = njoints_ * (kMatrixTexels + (bDualQuaternion ? kDualQuaternionTexels : 0));
+  if (ntexels > region_texels_) {
+    allocate(ntexels);
+  }
+
+  // Write every palettes to the next region once the device is done with it.
+  region_ = (region_ + 1) % kNumRegions;
+  wait(region_);
+
+  float *dst = mapped_ptr_ + static_cast<size_t>(region_) * region_texels_ * kTexelSize;
+  std::memcpy(dst, animation.skinning_matrices(), njoints_ * sizeof(glm::mat3x4));
+  if (bDualQuaternion) {
+    dst += njoints_ * kMatrixTexels * kTexelSize;
+    std::memcpy(dst, animation.dual_quaternions(), njoints_ * sizeof(glm::dualquat));
+  }
+}
+
+int32_t SkinningPalette::texel_offset(SkeletonController const& controller) const {
+  int32_t const offset = controller.palette_offset();
+  if ((offset < 0) || (offset + controller.njoints() > njoints_)) {
+    return -1;
+  }
+
+  int32_t const base = region_ * region_texels_;
+  if (SkinningMode::DualQuaternion == controller.skinning_mode()) {
+    return base + njoints_ * kMatrixTexels + offset * kDualQuaternionTexels;
+  }
+  return base + offset * kMatrixTexels;
+}
+
+void SkinningPalette::allocate(int32_t const ntexels) {
+  // Wait for the pending reads before releasing the previous ring.
+  for (int32_t i = 0; i < kNumRegions; ++i) {
+    wait(i);
+  }
+  release();
+
+  region_texels_ = std::max(ntexels + ntexels / 2, kMinRegionTexels);
+
+  GLsizeiptr const bytesize{
+    static_cast<GLsizeiptr>(kNumRegions * region_texels_ * kTexelSize * sizeof(float))
+  };
+  GLbitfield const flags{ GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT };
+
+  glCreateBuffers(1u, &buffer_id_);
+  glNamedBufferStorage(buffer_id_, bytesize, nullptr, flags);
+  mapped_ptr_ = static_cast<float*>(glMapNamedBufferRange(buffer_id_, 0, bytesize, flags));
+  LOG_CHECK( nullptr != mapped_ptr_ );
+
+  glCreateTextures(GL_TEXTURE_BUFFER, 1u, &texture_id_);
+  glTextureBuffer(texture_id_, GL_RGBA32F, buffer_id_);
+
+  CHECK_GX_ERROR();
+}
+
+void SkinningPalette::wait(int32_t const region) {
+  auto &fence = fences_[region];
+  if (nullptr == fence) {
+    return;
+  }
+
+  GLenum status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, kWaitTimeout);
+  while (GL_TIMEOUT_EXPIRED == status) {
+    status = glClientWaitSync(fence, 0, kWaitTimeout);
+  }
+  LOG_CHECK( GL_WAIT_FAILED != status );
+
+  glDeleteSync(fence);
+  fence = nullptr;
+}
+
+// -----------------------------------------------------------------------------
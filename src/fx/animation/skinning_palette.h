@@ -0,0 +1,68 @@
+#ifndef BARBU_ANIMATION_SKINNING_PALETTE_H_
+#define BARBU_ANIMATION_SKINNING_PALETTE_H_
+
+#include <array>
+#include <cstdint>
+
+#include "core/graphics.h"
+#include "fx/animation/animation_system.h"
+
+// -----------------------------------------------------------------------------
+
+//
+// Device skinning palettes of every animated characters, shared by their draws.
+//
+// The palettes evaluated by the AnimationSystem are written once per frame into
+// a persistently mapped buffer split into kNumRegions regions used as a ring,
+// guarded by fences, so the host never writes to a region still read by the
+// device. The whole buffer is exposed as a single texture buffer of RGBA32F
+// texels, draws index their palette by its first texel.
+//
+// Each region holds the skinning matrices of all joints (3 texels each),
+// followed by their dual quaternions (2 texels each) when a character uses them.
+//
+class SkinningPalette {
+ public:
+  // Number of frames the device can lag behind the host.
+  static constexpr int32_t kNumRegions = 3;
+
+ public:
+  SkinningPalette() = default;
+
+  ~SkinningPalette() {
+    release();
+  }
+
+  void release();
+
+  /* Write the palettes of the current frame to the next region of the ring. */
+  void upload(AnimationSystem const& animation);
+
+  /* Return the first texel of a controller's palette uploaded this frame, or
+   * -1 when it was not animated. */
+  int32_t texel_offset(SkeletonController const& controller) const;
+
+  inline uint32_t texture_id() const noexcept {
+    return texture_id_;
+  }
+
+ private:
+  /* (Re)create the ring with regions of at least ntexels. */
+  void allocate(int32_t const ntexels);
+
+  /* Block until the device has finished reading a region. */
+  void wait(int32_t const region);
+
+  uint32_t buffer_id_  = 0u;
+  uint32_t texture_id_ = 0u;
+  float *mapped_ptr_   = nullptr;
+
+  int32_t region_texels_ = 0;               //< capacity of a region
+  int32_t region_ = kNumRegions - 1;        //< region written this frame
+  int32_t njoints_ = 0;                     //< joints uploaded this frame
+  std::array<GLsync, kNumRegions> fences_{};
+};
+
+// -----------------------------------------------------------------------------
+
+#endif  // BARBU_ANIMATION_SKINNING_PALETTE_H_
@@ -253,7 +253,7 @@ void Hair::init_simulation(MeshData const& scalpMesh) {
   // (base normals are kept for potential future uses)
   normals_.resize(npoints);
   for (int j = 0; j < nroots_; ++j) {
-    auto const& v = scalpMesh.vertices[j];
+    auto const& v = scalpMesh.vertexData()[j];
     int const rootVertexIndex = j * kNumControlPoints;
     Positions[rootVertexIndex] = glm::vec4(v.position, 0);
     normals_[rootVertexIndex] = v.normal;
@@ -401,7 +401,7 @@ void Hair::init_mesh(MeshData const& scalpMesh) {
   for (int i = 0; i < scalpMesh.nfaces(); ++i) {
     for (int j = 0; j < kNumControlSegments; ++j) {
       for (int k = 0; k < 3; ++k) {
-        int const e = kNumControlPoints * scalpMesh.indices[3*i + k] + j;
+        int const e = kNumControlPoints * scalpMesh.indexData()[3*i + k] + j;
         elements[idx++] = e;
         elements[idx++] = e + 1; 
       }
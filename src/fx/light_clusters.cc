@@ -0,0 +1,280 @@
+#include "fx/light_clusters.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <iterator>
+
+#include "core/camera.h"
+#include "core/graphics.h"
+#include "ecs/scene_hierarchy.h"
+#include "memory/assets/assets.h"
+
+#ifdef BARBU_NPROC_MAX
+#define LOOP_NTHREADS  (BARBU_NPROC_MAX)
+#else
+#define LOOP_NTHREADS  4
+#endif
+
+// ----------------------------------------------------------------------------
+
+namespace {
+
+/// Light used when the scene has none, as the generic material used to hardcode it.
+LightInfo_t DefaultLight() {
+  LightInfo_t light{};
+  light.position  = glm::vec4(-5.0f, 10.0f, 10.0f, LIGHT_TYPE_DIRECTIONAL);
+  light.direction = glm::vec4(-glm::normalize(glm::vec3(light.position)), 0.0f);
+  light.color     = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
+  return light;
+}
+
+/// Size in pixels of the tiles of the clusters grid covering a resolution.
+glm::vec2 TileSize(int32_t const width, int32_t const height) {
+  return glm::vec2(
+    (width  + CLUSTER_GRID_X - 1) / CLUSTER_GRID_X,
+    (height + CLUSTER_GRID_Y - 1) / CLUSTER_GRID_Y
+  );
+}
+
+/// Bounding sphere of a point or spot light, as get_light_bounding_sphere in inc_clusters.glsl.
+glm::vec4 LightBoundingSphere(LightInfo_t const& light, glm::vec3 const& position, glm::vec3 const& direction) {
+  float const range = light.params.x;
+
+  if (static_cast<int32_t>(light.position.w) != LIGHT_TYPE_SPOT) {
+    return glm::vec4(position, range);
+  }
+
+  // Wide cones are bounded by their base, narrow ones by the sphere through their apex and base.
+  float const cos_outer = light.params.y;
+  if (cos_outer < 0.70710678f) {
+    float const sin_outer = std::sqrt(std::max(1.0f - cos_outer * cos_outer, 0.0f));
+    return glm::vec4(position + direction * (range * cos_outer), range * sin_outer);
+  }
+  float const radius = range / (2.0f * cos_outer);
+  return glm::vec4(position + direction * radius, radius);
+}
+
+/// Squared distance from a point to a cluster box.
+float DistanceSquared(glm::vec3 const& p, ClusterBounds_t const& box) {
+  glm::vec3 const d = glm::max(glm::max(glm::vec3(box.minPoint) - p, p - glm::vec3(box.maxPoint)), glm::vec3(0.0f));
+  return glm::dot(d, d);
+}
+
+} // namespace
+
+// ----------------------------------------------------------------------------
+
+void LightClusters::init() {
+  pgm_ = PROGRAM_ASSETS.createCompute( SHADERS_DIR "/light_clusters/cs_assign_lights.glsl" );
+
+  glCreateBuffers(1u, &gl_uniforms_id_);
+  glNamedBufferStorage(gl_uniforms_id_, sizeof(LightClustersUniforms_t), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+  // (the lights buffer is resized every frame)
+  glCreateBuffers(1u, &gl_lights_id_);
+
+  glCreateBuffers(1u, &gl_bounds_id_);
+  glNamedBufferStorage(gl_bounds_id_, kNumClusters * sizeof(ClusterBounds_t), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+  glCreateBuffers(1u, &gl_counts_id_);
+  glNamedBufferStorage(gl_counts_id_, kNumClusters * sizeof(uint32_t), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+  glCreateBuffers(1u, &gl_indices_id_);
+  glNamedBufferStorage(gl_indices_id_, kNumClusters * kMaxClusterLights * sizeof(uint32_t), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+  CHECK_GX_ERROR();
+}
+
+void LightClusters::deinit() {
+  if (gl_uniforms_id_) {
+    glDeleteBuffers(1u, &gl_uniforms_id_);
+    glDeleteBuffers(1u, &gl_lights_id_);
+    glDeleteBuffers(1u, &gl_bounds_id_);
+    glDeleteBuffers(1u, &gl_counts_id_);
+    glDeleteBuffers(1u, &gl_indices_id_);
+    gl_uniforms_id_ = 0u;
+  }
+}
+
+void LightClusters::update(SceneHierarchy const& scene, Camera const& camera) {
+  gatherLights(scene);
+  setupClusters(camera);
+
+  uniforms_.viewMatrix = camera.view();
+  uniforms_.numLights  = static_cast<int32_t>(lights_.size());
+
+  glNamedBufferSubData(gl_uniforms_id_, 0, sizeof(uniforms_), &uniforms_);
+  // (orphan the previous frame buffer)
+  glNamedBufferData(gl_lights_id_, lights_.size() * sizeof(LightInfo_t), lights_.data(), GL_STREAM_DRAW);
+
+  if (bUseHostAssignment_) {
+    AssignLights(uniforms_, lights_, bounds_, counts_, indices_);
+    glNamedBufferSubData(gl_counts_id_, 0, counts_.size() * sizeof(uint32_t), counts_.data());
+    glNamedBufferSubData(gl_indices_id_, 0, indices_.size() * sizeof(uint32_t), indices_.data());
+  } else {
+    bind();
+    gx::UseProgram( pgm_->id );
+      gx::DispatchCompute<CLUSTER_KERNEL_GROUP_WIDTH>(kNumClusters);
+    gx::UseProgram();
+    unbind();
+
+    glMemoryBarrier( GL_SHADER_STORAGE_BARRIER_BIT );
+  }
+
+  CHECK_GX_ERROR();
+}
+
+void LightClusters::bind() const {
+  glBindBufferBase(GL_UNIFORM_BUFFER, UNIFORM_BINDING_LIGHT_CLUSTERS, gl_uniforms_id_);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, STORAGE_BINDING_LIGHTS, gl_lights_id_);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, STORAGE_BINDING_CLUSTER_BOUNDS, gl_bounds_id_);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, STORAGE_BINDING_CLUSTER_COUNTS, gl_counts_id_);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, STORAGE_BINDING_CLUSTER_INDICES, gl_indices_id_);
+}
+
+void LightClusters::unbind() const {
+  glBindBufferBase(GL_UNIFORM_BUFFER, UNIFORM_BINDING_LIGHT_CLUSTERS, 0u);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, STORAGE_BINDING_LIGHTS, 0u);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, STORAGE_BINDING_CLUSTER_BOUNDS, 0u);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, STORAGE_BINDING_CLUSTER_COUNTS, 0u);
+  glBindBufferBase(GL_SHADER_STORAGE_BUFFER, STORAGE_BINDING_CLUSTER_INDICES, 0u);
+}
+
+// ----------------------------------------------------------------------------
+
+void LightClusters::ComputeClusterBounds(glm::mat4 const& proj, int32_t width, int32_t height, float znear, float zfar,
+                                         std::vector<ClusterBounds_t> &bounds) {
+  bounds.resize(kNumClusters);
+
+  glm::mat4 const inv_proj = glm::inverse(proj);
+  glm::vec2 const ndc_tile_size = 2.0f * TileSize(width, height) / glm::vec2(width, height);
+
+  auto unproject = [&inv_proj](glm::vec2 const& ndc, float const z) {
+    glm::vec4 const p = inv_proj * glm::vec4(ndc, z, 1.0f);
+    return glm::vec3(p) / p.w;
+  };
+
+  float const depth_ratio = zfar / znear;
+  for (int32_t z = 0; z < CLUSTER_GRID_Z; ++z) {
+    // Exponential slices, so clusters keep similar proportions with depth.
+    float const slice_near = znear * std::pow(depth_ratio, static_cast<float>(z) / CLUSTER_GRID_Z);
+    float const slice_far  = znear * std::pow(depth_ratio, static_cast<float>(z + 1) / CLUSTER_GRID_Z);
+
+    for (int32_t y = 0; y < CLUSTER_GRID_Y; ++y) {
+      for (int32_t x = 0; x < CLUSTER_GRID_X; ++x) {
+        glm::vec3 box_min(+FLT_MAX);
+        glm::vec3 box_max(-FLT_MAX);
+
+        // Intersect the view-space lines through the tile corners with the slice planes.
+        for (int32_t corner = 0; corner < 4; ++corner) {
+          glm::vec2 const ndc = glm::vec2(-1.0f) + ndc_tile_size * glm::vec2(x + (corner & 1), y + (corner >> 1));
+          glm::vec3 const a = unproject(ndc, -1.0f);
+          glm::vec3 const b = unproject(ndc, +1.0f);
+
+          for (float const depth : { slice_near, slice_far }) {
+            float const t = (-depth - a.z) / (b.z - a.z);
+            glm::vec3 const p = a + t * (b - a);
+            box_min = glm::min(box_min, p);
+            box_max = glm::max(box_max, p);
+          }
+        }
+
+        auto &box = bounds[x + CLUSTER_GRID_X * (y + CLUSTER_GRID_Y * z)];
+        box.minPoint = glm::vec4(box_min, 1.0f);
+        box.maxPoint = glm::vec4(box_max, 1.0f);
+      }
+    }
+  }
+}
+
+void LightClusters::AssignLights(LightClustersUniforms_t const& uniforms,
+                                 std::vector<LightInfo_t> const& lights,
+                                 std::vector<ClusterBounds_t> const& bounds,
+                                 std::vector<uint32_t> &counts,
+                                 std::vector<uint32_t> &indices) {
+  counts.assign(kNumClusters, 0u);
+  indices.assign(kNumClusters * kMaxClusterLights, 0u);
+
+  // View-space bounding spheres of the local lights.
+  int32_t const first_light = uniforms.numDirectionals;
+  int32_t const nspheres = std::max(uniforms.numLights - first_light, 0);
+  std::vector<glm::vec4> spheres(nspheres);
+
+  glm::mat3 const view_basis(uniforms.viewMatrix);
+  for (int32_t i = 0; i < nspheres; ++i) {
+    auto const& light = lights[first_light + i];
+    glm::vec3 const position  = glm::vec3(uniforms.viewMatrix * glm::vec4(glm::vec3(light.position), 1.0f));
+    glm::vec3 const direction = view_basis * glm::vec3(light.direction);
+    spheres[i] = LightBoundingSphere(light, position, direction);
+  }
+
+  // Clusters index their lights in increasing order, until their slots are full.
+  #pragma omp parallel for schedule(static) num_threads(LOOP_NTHREADS)
+  for (int32_t cluster = 0; cluster < kNumClusters; ++cluster) {
+    auto const& box = bounds[cluster];
+    uint32_t *slots = indices.data() + cluster * kMaxClusterLights;
+
+    int32_t count = 0;
+    for (int32_t i = 0; (i < nspheres) && (count < kMaxClusterLights); ++i) {
+      auto const& sphere = spheres[i];
+      if (DistanceSquared(glm::vec3(sphere), box) <= sphere.w * sphere.w) {
+        slots[count++] = static_cast<uint32_t>(first_light + i);
+      }
+    }
+    counts[cluster] = static_cast<uint32_t>(count);
+  }
+}
+
+// ----------------------------------------------------------------------------
+
+void LightClusters::gatherLights(SceneHierarchy const& scene) {
+  lights_.clear();
+
+  for (auto const& e : scene.lights()) {
+    auto const& light = e->get<LightComponent>();
+    auto const& world = scene.globalMatrix(e->index());
+
+    float const cos_outer = std::cos(light.outerAngle());
+    float const cos_inner = std::cos(light.innerAngle());
+
+    LightInfo_t info;
+    info.position  = glm::vec4(glm::vec3(world[3]), static_cast<float>(static_cast<int32_t>(light.type())));
+    info.color     = glm::vec4(light.color(), light.intensity());
+    info.direction = glm::vec4(glm::normalize(-glm::vec3(world[2])), 0.0f);
+    info.params    = glm::vec4(light.range(), cos_outer, 1.0f / std::max(cos_inner - cos_outer, 1e-4f), 0.0f);
+    lights_.push_back(info);
+  }
+
+  if (lights_.empty()) {
+    lights_.push_back(DefaultLight());
+  }
+
+  // Directional lights first, as they are not clustered.
+  auto const it = std::stable_partition(lights_.begin(), lights_.end(), [](LightInfo_t const& info) {
+    return LIGHT_TYPE_DIRECTIONAL == static_cast<int32_t>(info.position.w);
+  });
+  uniforms_.numDirectionals = static_cast<int32_t>(std::distance(lights_.begin(), it));
+}
+
+void LightClusters::setupClusters(Camera const& camera) {
+  glm::ivec2 const resolution(camera.width(), camera.height());
+  if ((resolution == resolution_) && (camera.proj() == proj_)) {
+    return;
+  }
+  proj_       = camera.proj();
+  resolution_ = resolution;
+
+  float const znear = camera.znear();
+  float const zfar  = camera.zfar();
+  float const log_depth_range = std::log(zfar / znear);
+
+  uniforms_.tileSize   = TileSize(resolution.x, resolution.y);
+  uniforms_.sliceScale = CLUSTER_GRID_Z / log_depth_range;
+  uniforms_.sliceBias  = - CLUSTER_GRID_Z * std::log(znear) / log_depth_range;
+
+  ComputeClusterBounds(proj_, resolution.x, resolution.y, znear, zfar, bounds_);
+  glNamedBufferSubData(gl_bounds_id_, 0, bounds_.size() * sizeof(ClusterBounds_t), bounds_.data());
+}
+
+// ----------------------------------------------------------------------------
@@ -0,0 +1,93 @@
+#ifndef BARBU_FX_LIGHT_CLUSTERS_H_
+#define BARBU_FX_LIGHT_CLUSTERS_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "glm/mat4x4.hpp"
+
+#include "memory/assets/program.h"
+#include "shaders/shared/lighting/interop.h"
+
+class Camera;
+class SceneHierarchy;
+
+// ----------------------------------------------------------------------------
+
+//
+// Clustered forward lighting.
+//
+// The scene lights are gathered each frame in a storage buffer, directional
+// lights first. Point and spot lights are then assigned to the clusters of a
+// view-space froxels grid by a compute pass, testing their bounding sphere against
+// the cluster bounds, so forward shaders only iterate the lights of their cluster.
+//
+// Clusters index their lights in fixed-size slots, hence the host reference
+// assignment fills the same slots as the compute pass without needing a device.
+//
+class LightClusters {
+ public:
+  static constexpr int32_t kNumClusters      = CLUSTER_COUNT;
+  static constexpr int32_t kMaxClusterLights = CLUSTER_MAX_LIGHTS;
+
+ public:
+  LightClusters() = default;
+
+  void init();
+  void deinit();
+
+  /* Gather the scene lights then assign them to the clusters of the camera view. */
+  void update(SceneHierarchy const& scene, Camera const& camera);
+
+  /* Bind the lights and clusters buffers used by the forward shaders. */
+  void bind() const;
+  void unbind() const;
+
+  /* Assign the lights on the host instead of the device when true. */
+  inline void setHostAssignment(bool status) noexcept { bUseHostAssignment_ = status; }
+
+  inline std::vector<LightInfo_t> const& lights() const noexcept { return lights_; }
+  inline LightClustersUniforms_t const& uniforms() const noexcept { return uniforms_; }
+  inline std::vector<ClusterBounds_t> const& bounds() const noexcept { return bounds_; }
+
+  /* Compute the view-space bounds of the clusters of a projection and its resolution. */
+  static void ComputeClusterBounds(glm::mat4 const& proj, int32_t width, int32_t height, float znear, float zfar,
+                                   std::vector<ClusterBounds_t> &bounds);
+
+  /* Host reference of the assignment pass, filling the clusters lights count and indices slots. */
+  static void AssignLights(LightClustersUniforms_t const& uniforms,
+                           std::vector<LightInfo_t> const& lights,
+                           std::vector<ClusterBounds_t> const& bounds,
+                           std::vector<uint32_t> &counts,
+                           std::vector<uint32_t> &indices);
+
+ private:
+  /* Fill the lights from the scene light components. */
+  void gatherLights(SceneHierarchy const& scene);
+
+  /* Rebuild the clusters bounds and slices parameters when the projection changed. */
+  void setupClusters(Camera const& camera);
+
+  ProgramHandle pgm_;
+
+  std::vector<LightInfo_t> lights_;
+  std::vector<ClusterBounds_t> bounds_;
+  LightClustersUniforms_t uniforms_{};
+
+  glm::mat4 proj_{0.0f};              //< projection of the current bounds
+  glm::ivec2 resolution_{0};          //< resolution of the current bounds
+
+  bool bUseHostAssignment_ = false;
+  std::vector<uint32_t> counts_;      //< host assignment outputs
+  std::vector<uint32_t> indices_;
+
+  uint32_t gl_uniforms_id_ = 0u;
+  uint32_t gl_lights_id_   = 0u;
+  uint32_t gl_bounds_id_   = 0u;
+  uint32_t gl_counts_id_   = 0u;
+  uint32_t gl_indices_id_  = 0u;
+};
+
+// ----------------------------------------------------------------------------
+
+#endif // BARBU_FX_LIGHT_CLUSTERS_H_
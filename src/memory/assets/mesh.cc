@@ -1,4 +1,7 @@
 #include "memory/assets/mesh.h"
+
+#include <atomic>
+
 #include "core/graphics.h"
 
 // ----------------------------------------------------------------------------
@@ -14,27 +17,41 @@ void Mesh::drawSubMesh(int32_t index, int32_t count, MeshData::PrimitiveType pri
 
   auto const mode = getInternalDrawMode(primitive);
 
-  glBindVertexArray(vao_);
+  glBindVertexArray(vao());
   if (nelems_ > 0) {
-    int32_t nelems{ nelems_ };
-    void* offset{ nullptr };
-
-    if (!vgroups_.empty()) {
-      auto const& vg = vgroups_.at(index);
-      nelems = vg.nelems();
-      offset = reinterpret_cast<void*>(vg.start_index * sizeof(uint32_t));
-    }
-    glDrawElementsInstanced( mode, nelems, GL_UNSIGNED_INT, offset, count);
+    auto const cmd{ drawCommand(index, count) };
+    void* offset{ reinterpret_cast<void*>(cmd.first_index * sizeof(uint32_t)) };
+    glDrawElementsInstancedBaseVertex( mode, cmd.count, GL_UNSIGNED_INT, offset, count, cmd.base_vertex);
   } else {
-    glDrawArraysInstanced(mode, 0u, nvertices_, count);
+    glDrawArraysInstanced(mode, geometry_.base_vertex, nvertices_, count);
   }
   glBindVertexArray(0u);
 
   CHECK_GX_ERROR();
 }
 
+DrawIndirectCommand_t Mesh::drawCommand(int32_t index, int32_t count) const {
+  DrawIndirectCommand_t cmd{};
+  cmd.count          = static_cast<uint32_t>(nelems_);
+  cmd.instance_count = static_cast<uint32_t>(count);
+  cmd.first_index    = static_cast<uint32_t>(geometry_.first_index);
+  cmd.base_vertex    = geometry_.base_vertex;
+
+  if (!vgroups_.empty()) {
+    auto const& vg = vgroups_.at(index);
+    cmd.count        = static_cast<uint32_t>(vg.nelems());
+    cmd.first_index += static_cast<uint32_t>(vg.start_index);
+  }
+  return cmd;
+}
+
 // ----------------------------------------------------------------------------
 
+uint32_t Mesh::NextUID() {
+  static std::atomic<uint32_t> sCounter{ 0u };
+  return sCounter++;
+}
+
 uint32_t Mesh::getInternalDrawMode(MeshData::PrimitiveType primitive) const {
   GLenum mode;
 
@@ -65,24 +82,11 @@ uint32_t Mesh::getInternalDrawMode(MeshData::PrimitiveType primitive) const {
 }
 
 void Mesh::allocate() {
-  if (!loaded()) {
-    glCreateVertexArrays(1u, &vao_);
-    glCreateBuffers(1u, &vbo_);
-    glCreateBuffers(1u, &skin_vbo_);
-    glCreateBuffers(1u, &ibo_);
-  }
-  CHECK_GX_ERROR();
+  // (the geometry is sub-allocated from its vertex format arena on setup)
 }
 
 void Mesh::release() {
-  if (loaded()) {
-    glDeleteBuffers(1u, &vbo_);
-    glDeleteBuffers(1u, &skin_vbo_);
-    glDeleteBuffers(1u, &ibo_);
-    glDeleteVertexArrays(1u, &vao_);
-    vbo_ = skin_vbo_ = ibo_ = vao_ = 0u;
-  }
-  CHECK_GX_ERROR();
+  GeometryArena::Get(format_).release(geometry_);
 }
 
 bool Mesh::setup() {
@@ -98,8 +102,8 @@ bool Mesh::setup() {
 
   // Generic parameters transfer.
   type_       = meshdata.type;
-  nelems_     = static_cast<int32_t>(meshdata.indices.size());
-  nvertices_  = static_cast<int32_t>(meshdata.vertices.size());
+  nelems_     = meshdata.nindices();
+  nvertices_  = meshdata.nvertices();
   nfaces_     = meshdata.nfaces();
   vgroups_    = meshdata.vgroups;
 
@@ -111,83 +115,14 @@ bool Mesh::setup() {
   // [Recenter the mesh to its pivot ?]
   // at least horizontally / XZ plane, or alternatively suggest a default transform.
 
-  // Reallocate buffers if the data are reuploads.
-  if (resource.version > 0 && loaded()) {
-    release();
-    allocate();
-  }
-
-  // [use bindless vao instead ?]
-  glBindVertexArray(vao_);
-  {
-    uint32_t binding_index = 0u;
-    
-    // 1) Generic Vertex Attribs.
-    {
-      uint32_t const bytesize{
-        static_cast<uint32_t>(nvertices_ * (sizeof meshdata.vertices[0u]))
-      };
-      glNamedBufferStorage(vbo_, bytesize, meshdata.vertices.data(), 0);
-      
-      glBindVertexBuffer(binding_index, vbo_, 0u, sizeof(MeshData::Vertex_t));
-      {
-        #define MESH_SetupAttrib(tAttrib, tComponent) \
-        { \
-          auto const ncomp{ static_cast<uint32_t>((sizeof MeshData::Vertex_t::tComponent) / (sizeof MeshData::Vertex_t::tComponent[0u]))}; \
-          glVertexAttribFormat( Mesh::tAttrib, ncomp, GL_FLOAT, GL_FALSE, offsetof(MeshData::Vertex_t, tComponent)); \
-          glVertexAttribBinding( Mesh::tAttrib, binding_index); \
-          glEnableVertexAttribArray( Mesh::tAttrib ); \
-        }
-
-        MESH_SetupAttrib( ATTRIB_POSITION,  position );
-        MESH_SetupAttrib( ATTRIB_TEXCOORD,  texcoord );
-        MESH_SetupAttrib( ATTRIB_NORMAL,    normal );
-        MESH_SetupAttrib( ATTRIB_TANGENT,   tangent );
-
-        #undef MESH_SetupAttrib
-      }
-      ++binding_index;
-    }
-
-    // 2) Skinning Attribs.
-    if (!meshdata.skinnings.empty()) {
-      uint32_t const bytesize{
-        static_cast<uint32_t>(nvertices_ * (sizeof meshdata.skinnings[0u]))
-      };
-      glNamedBufferStorage(skin_vbo_, bytesize, meshdata.skinnings.data(), 0);
-
-      glBindVertexBuffer(binding_index, skin_vbo_, 0, sizeof(MeshData::Skinning_t));
-      {
-        uint32_t attrib_index, num_component;
-
-        attrib_index = Mesh::ATTRIB_JOINT_INDICES;
-        num_component = static_cast<uint32_t>((sizeof MeshData::Skinning_t::joint_indices) / (sizeof MeshData::Skinning_t::joint_indices[0u]));
-        glVertexAttribIFormat(attrib_index, num_component, GL_UNSIGNED_INT, offsetof(MeshData::Skinning_t, joint_indices));
-        glVertexAttribBinding(attrib_index, binding_index);
-        glEnableVertexAttribArray(attrib_index);
-
-        attrib_index = Mesh::ATTRIB_JOINT_WEIGHTS;
-        num_component = static_cast<uint32_t>((sizeof MeshData::Skinning_t::joint_weights) / (sizeof MeshData::Skinning_t::joint_weights[0u]));
-        glVertexAttribFormat(attrib_index, num_component, GL_FLOAT, GL_TRUE/**/, offsetof(MeshData::Skinning_t, joint_weights));
-        glVertexAttribBinding(attrib_index, binding_index);
-        glEnableVertexAttribArray(attrib_index);
-      }
-      ++binding_index;
-    }
-  }
-  glBindVertexArray(0u);
-
-  // Faces indices.
-  if (!meshdata.indices.empty()) {
-    uint32_t const bytesize{
-      static_cast<uint32_t>(nelems_ * (sizeof meshdata.indices[0u]))
-    };
-    glNamedBufferStorage(ibo_, bytesize, meshdata.indices.data(), 0);
-    glVertexArrayElementBuffer(vao_, ibo_);
-  }
-  CHECK_GX_ERROR();
+  // Release the previous ranges if the data are reuploads.
+  release();
 
-  return true;
+  // Upload the geometry to the arena of its vertex format.
+  format_ = (meshdata.nskinnings() > 0) ? GeometryArena::Format::Skinned
+                                        : GeometryArena::Format::Static
+                                        ;
+  return GeometryArena::Get(format_).allocate(meshdata, geometry_);
 }
 
 // ----------------------------------------------------------------------------
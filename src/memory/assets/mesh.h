@@ -2,6 +2,7 @@
 #define BARBU_MEMORY_ASSETS_MESH_H_
 
 #include "memory/asset_factory.h"
+#include "memory/geometry_arena.h"
 #include "memory/resources/mesh_data.h"
 
 #include "shaders/generic/interop.h"
@@ -34,13 +35,21 @@ class Mesh : public Asset<MeshParameters, MeshData> {
   }
 
   inline bool loaded() const noexcept final {
-    return vao_ != 0u;
+    return geometry_.valid();
   }
 
   // Draw the mesh using its internal mode when kInternal is set or the one provided otherwise.
   void draw(int32_t count = 1, MeshData::PrimitiveType primitive = MeshData::kInternal) const;
   void drawSubMesh(int32_t index, int32_t count = 1, MeshData::PrimitiveType primitive = MeshData::kInternal) const;
 
+  // Return the indirect command drawing a submesh of an indexed mesh.
+  DrawIndirectCommand_t drawCommand(int32_t index, int32_t count = 1) const;
+
+  // Return the API draw mode of the mesh primitives.
+  inline uint32_t drawMode() const { return getInternalDrawMode(MeshData::kInternal); }
+
+  inline bool indexed() const noexcept { return nelems_ > 0; }
+
   inline int32_t nfaces() const noexcept { return nfaces_; }
   inline int32_t nvertices() const noexcept { return nvertices_; }
 
@@ -53,6 +62,12 @@ class Mesh : public Asset<MeshParameters, MeshData> {
 
   inline SkeletonHandle skeleton() { return skeleton_; }
 
+  // Unique identifier of the mesh instance, used to sort the draws.
+  inline uint32_t uid() const noexcept { return uid_; }
+
+  // Return the vertex array shared by the meshes of the same vertex format.
+  inline uint32_t vao() const noexcept { return GeometryArena::Get(format_).vao(); }
+
   inline glm::vec3 const& centroid() const noexcept { return centroid_; }
   inline glm::vec3 const& bounds() const noexcept { return bounds_; }
   inline float radius() const noexcept { return radius_; }
@@ -64,11 +79,13 @@ class Mesh : public Asset<MeshParameters, MeshData> {
 
   uint32_t getInternalDrawMode(MeshData::PrimitiveType primitive) const; //
 
-  // Buffer ids.
-  uint32_t vao_ = 0u;
-  uint32_t vbo_ = 0u;
-  uint32_t skin_vbo_ = 0u;
-  uint32_t ibo_ = 0u;
+  static uint32_t NextUID();
+
+  uint32_t const uid_ = NextUID();
+
+  // Ranges of the geometry in its vertex format arena.
+  GeometryArena::Format format_ = GeometryArena::Format::Static;
+  GeometryArena::Allocation_t geometry_;
 
   // Drawing parameters.
   MeshData::PrimitiveType type_;
@@ -1,7 +1,140 @@
 #include "memory/assets/program.h"
 
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
 #include "glm/gtc/type_ptr.hpp"
 #include "core/graphics.h"
+#include "memory/mapped_file.h"
+
+// ----------------------------------------------------------------------------
+//
+// Program binary cache.
+//
+// Linked programs are stored in CACHE_DIR/programs as driver specific binaries,
+// named after a key hashed from the code of their shaders and the driver
+// identification strings. A binary rejected by the driver (eg. after a driver
+// update) is replaced by the one of the newly linked program.
+//
+// ----------------------------------------------------------------------------
+
+namespace {
+
+constexpr uint32_t kBinaryMagic   = 0x4D475042; // "BPGM"
+constexpr uint32_t kBinaryVersion = 1u;
+
+struct BinaryHeader_t {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t key;
+  uint32_t format;
+  uint32_t bytesize;
+};
+
+inline size_t HashCombine(size_t seed, size_t h) {
+  return seed ^ (h + 0x9e3779b9 + (seed << 6u) + (seed >> 2u));
+}
+
+// Return true when the driver supports program binaries.
+bool HasBinaryFormats() {
+  static GLint sNumFormats = -1;
+  if (sNumFormats < 0) {
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &sNumFormats);
+  }
+  return sNumFormats > 0;
+}
+
+// Return the hash of the driver identification strings.
+size_t GetDriverHash() {
+  static size_t sHash = 0u;
+  if (0u == sHash) {
+    for (auto name : { GL_VENDOR, GL_RENDERER, GL_VERSION }) {
+      auto const str = reinterpret_cast<char const*>(glGetString(name));
+      sHash = HashCombine(sHash, std::hash<std::string_view>{}(str ? str : ""));
+    }
+  }
+  return sHash;
+}
+
+std::string GetBinaryFilename(size_t key) {
+  char hexname[32]{};
+  sprintf(hexname, "%016llx.bin", static_cast<unsigned long long>(key));
+  return std::string(CACHE_DIR "/programs/") + hexname;
+}
+
+// Load a program from its binary, return false when missing or rejected.
+bool LoadProgramBinary(uint32_t program, size_t key) {
+  MappedFile file;
+  if (!file.open(GetBinaryFilename(key)) || (file.size() < sizeof(BinaryHeader_t))) {
+    return false;
+  }
+
+  BinaryHeader_t header{};
+  memcpy(&header, file.data(), sizeof(header));
+  if ((header.magic != kBinaryMagic) 
+   || (header.version != kBinaryVersion)
+   || (header.key != key)
+   || (file.size() < sizeof(header) + header.bytesize)) {
+    return false;
+  }
+
+  glProgramBinary(program, header.format, file.data() + sizeof(header), static_cast<GLsizei>(header.bytesize));
+
+  GLint status{0};
+  glGetProgramiv(program, GL_LINK_STATUS, &status);
+  return GL_TRUE == status;
+}
+
+// Store the binary of a linked program.
+bool SaveProgramBinary(uint32_t program, size_t key) {
+  GLint bytesize{0};
+  glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &bytesize);
+  if (bytesize <= 0) {
+    return false;
+  }
+
+  std::vector<char> binary(static_cast<size_t>(bytesize));
+  GLenum format{0};
+  glGetProgramBinary(program, bytesize, nullptr, &format, binary.data());
+
+  BinaryHeader_t header{};
+  header.magic    = kBinaryMagic;
+  header.version  = kBinaryVersion;
+  header.key      = key;
+  header.format   = format;
+  header.bytesize = static_cast<uint32_t>(bytesize);
+
+  auto const filename{ GetBinaryFilename(key) };
+
+  std::error_code ec;
+  fs::create_directories( fs::path(filename).parent_path(), ec);
+
+  // Write to a temporary file renamed afterwards, so a partial file is never read.
+  std::string const tmpname = filename + ".tmp";
+  FILE *fd = fopen( tmpname.c_str(), "wb");
+  if (nullptr == fd) {
+    LOG_WARNING( "Failed to create the program binary :", tmpname );
+    return false;
+  }
+  bool bSucceed = (fwrite(&header, sizeof(header), 1u, fd) == 1u)
+               && (fwrite(binary.data(), 1u, binary.size(), fd) == binary.size())
+               ;
+  fclose(fd);
+
+  if (bSucceed) {
+    fs::rename( fs::path(tmpname), fs::path(filename), ec);
+    bSucceed = !ec;
+  }
+  if (!bSucceed) {
+    LOG_WARNING( "Failed to write the program binary :", filename );
+    fs::remove( fs::path(tmpname), ec);
+  }
+
+  return bSucceed;
+}
+
+} // namespace
 
 // ----------------------------------------------------------------------------
 
@@ -59,6 +192,7 @@ void Program::allocate() {
 
 void Program::release() {
   if (loaded()) {
+    gx::ReleaseProgram(id);
     glDeleteProgram(id);
     id = 0u;
   }
@@ -66,28 +200,53 @@ void Program::release() {
 }
 
 bool Program::setup() {
-  for (auto &info : params.dependencies) {
-
-    // Do not update unmodified dependencies.
-    if ( (info.version > ResourceInfo::kDefaultVersion) 
-      && Resources::Has<Shader>(info.id) 
-      && !Resources::CheckVersion<Shader>(info)) {
-      continue;
-    }
+  // Retrieve the shaders, updating their versions, and the program binary key.
+  std::vector<ResourceHandle<Shader>> handles;
+  handles.reserve(params.dependencies.size());
 
+  size_t key = ProgramFactory::kEnableBinaryCache ? GetDriverHash() : 0u;
+  for (auto &info : params.dependencies) {
     auto h = Resources::GetUpdated<Shader>( info );
     if (!h.is_valid()) {
       return false;
     }
-    auto shader = h.data;
+    key = HashCombine(key, h.data->hash);
+    handles.push_back(h);
+  }
+  binary_key_ = key;
 
-    // When the shader has been updated we flag the previous one for deletion.
-    if (info.version > ResourceInfo::kDefaultVersion+1) {
-      glDeleteShader( shaders_[shader->type] );
-      glDetachShader( id, shaders_[shader->type]);
+  // Detach the shaders of the previous version.
+  auto const detach_shaders = [this]() {
+    for (auto &shader_id : shaders_) {
+      if (shader_id > 0u) {
+        glDetachShader( id, shader_id);
+        shader_id = 0u;
+      }
     }
-    shaders_[shader->type] = shader->id;
+  };
+
+  // Try to bypass compilation with the program binary.
+  bBinaryLoaded_ = ProgramFactory::kEnableBinaryCache 
+                && HasBinaryFormats() 
+                && LoadProgramBinary(id, binary_key_)
+                ;
+  if (bBinaryLoaded_) {
+    detach_shaders();
+    return true;
+  }
 
+  // Compile every shaders before modifying the program, so it is kept 
+  // unchanged when an updated shader is invalid.
+  for (auto &h : handles) {
+    if (!h.data->compile(h.name)) {
+      return false;
+    }
+  }
+
+  detach_shaders();
+  for (auto &h : handles) {
+    auto shader = h.data;
+    shaders_[shader->type] = shader->id;
     glAttachShader( id, shader->id); 
   }
   CHECK_GX_ERROR();
@@ -95,6 +254,32 @@ bool Program::setup() {
   return true;
 }
 
+bool Program::link(std::string_view name) {
+  bool const bUseBinary = ProgramFactory::kEnableBinaryCache && HasBinaryFormats();
+
+  if (!bBinaryLoaded_) {
+    if (bUseBinary) {
+      glProgramParameteri( id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
+    gx::LinkProgram( id );
+  }
+
+  if (!gx::CheckProgramStatus( id, name)) {
+    return false;
+  }
+
+  // (programs linked by gx are already reflected)
+  if (bBinaryLoaded_) {
+    gx::ReflectProgram( id );
+  }
+
+  if (bUseBinary && !bBinaryLoaded_) {
+    SaveProgramBinary( id, binary_key_);
+  }
+
+  return true;
+}
+
 // ----------------------------------------------------------------------------
 
 ProgramFactory::Handle ProgramFactory::createFull(AssetId const& id, ResourceId const& vs, ResourceId const& tcs, ResourceId const& gs, ResourceId const& tes, ResourceId const& fs) {
@@ -119,8 +304,7 @@ ProgramFactory::Handle ProgramFactory::createCompute(AssetId const& id, Resource
 
 bool ProgramFactory::post_setup(AssetId const& assetId, ProgramFactory::Handle h) {
   assert( h->loaded() );
-  gx::LinkProgram( h->id );
-  return gx::CheckProgramStatus( h->id, assetId);
+  return h->link(assetId);
 }
 
 // ----------------------------------------------------------------------------
\ No newline at end of file
@@ -54,10 +54,20 @@ struct Program : Asset<ProgramParameters, Shader> {
   void release() final;
   bool setup() final;
 
+  /* Link the program and store its binary, unless it was loaded from one. */
+  bool link(std::string_view name);
+
   // ids of attached shaders.
-  std::array<uint32_t, kNumShaderType> shaders_; 
+  std::array<uint32_t, kNumShaderType> shaders_{}; 
+
+  // Key of the program binary, hashed from its shaders code and the driver.
+  size_t binary_key_ = 0u;
+
+  // True when the program was loaded from a binary, and is already linked.
+  bool bBinaryLoaded_ = false;
 
   template<typename> friend class AssetFactory;
+  friend class ProgramFactory;
 };
 
 // ----------------------------------------------------------------------------
@@ -68,6 +78,9 @@ using ProgramHandle = AssetHandle<Program>;
 
 class ProgramFactory : public AssetFactory<Program> {
  public:
+  // Store linked programs binaries, to bypass shaders compilation on reload.
+  static constexpr bool kEnableBinaryCache = true;
+
   ~ProgramFactory() { release_all(); }
 
   Handle createFull(AssetId const& id, ResourceId const& vs, ResourceId const& tcs, ResourceId const& gs, ResourceId const& tes, ResourceId const& fs);
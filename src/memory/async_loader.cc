@@ -0,0 +1,100 @@
+#include "memory/async_loader.h"
+
+// ----------------------------------------------------------------------------
+
+void AsyncLoader::init(int32_t nthreads) {
+  deinit();
+
+  bRunning_ = true;
+  workers_.reserve(nthreads);
+  for (int32_t i = 0; i < nthreads; ++i) {
+    workers_.emplace_back([this]() { run(); });
+  }
+}
+
+void AsyncLoader::deinit() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    bRunning_ = false;
+  }
+  cv_.notify_all();
+
+  for (auto &worker : workers_) {
+    worker.join();
+  }
+  workers_.clear();
+
+  // (pending tasks are dropped, their handles will never be ready)
+  pending_.clear();
+  completed_.clear();
+}
+
+void AsyncLoader::push(Job_t job, Finalizer_t finalizer) {
+  if (workers_.empty()) {
+    job();
+    std::lock_guard<std::mutex> lock(mutex_);
+    completed_.push_back(std::move(finalizer));
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_.push_back({ std::move(job), std::move(finalizer) });
+  }
+  cv_.notify_one();
+}
+
+int32_t AsyncLoader::update(int32_t max_finalizers) {
+  int32_t count = 0;
+
+  while (count < max_finalizers) {
+    Finalizer_t finalizer;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (completed_.empty()) {
+        break;
+      }
+      finalizer = std::move(completed_.front());
+      completed_.pop_front();
+    }
+
+    // (a finalizer could push new tasks, so it is run outside the lock)
+    if (finalizer) {
+      finalizer();
+    }
+    ++count;
+  }
+
+  return count;
+}
+
+int32_t AsyncLoader::count() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return static_cast<int32_t>(pending_.size() + completed_.size()) + nrunning_;
+}
+
+// ----------------------------------------------------------------------------
+
+void AsyncLoader::run() {
+  for (;;) {
+    Task_t task;
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      cv_.wait(lock, [this]() { return !bRunning_ || !pending_.empty(); });
+      if (!bRunning_) {
+        return;
+      }
+      task = std::move(pending_.front());
+      pending_.pop_front();
+      ++nrunning_;
+    }
+
+    task.job();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    completed_.push_back(std::move(task.finalizer));
+    --nrunning_;
+  }
+}
+
+// ----------------------------------------------------------------------------
@@ -0,0 +1,77 @@
+#ifndef BARBU_MEMORY_ASYNC_LOADER_H_
+#define BARBU_MEMORY_ASYNC_LOADER_H_
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ----------------------------------------------------------------------------
+
+//
+// Pool of worker threads used to load resources in the background.
+//
+// A task is made of a job, run on a worker thread (file IO, CPU decoding), and
+// of a finalizer, run on the main thread by 'update' once the job is done
+// (registration, GPU upload). The number of finalizers run per call is bounded
+// to spread heavy uploads across frames.
+//
+// When no worker has been started, jobs are run directly on push.
+//
+class AsyncLoader {
+ public:
+  using Job_t       = std::function<void()>;
+  using Finalizer_t = std::function<void()>;
+
+  AsyncLoader() = default;
+
+  ~AsyncLoader() {
+    deinit();
+  }
+
+  /* Start the worker threads. */
+  void init(int32_t nthreads);
+
+  /* Wait for the workers to finish their current job and stop them. */
+  void deinit();
+
+  /* Queue a task. */
+  void push(Job_t job, Finalizer_t finalizer);
+
+  /* Run at most max_finalizers finalizers of completed jobs, return the number run. */
+  int32_t update(int32_t max_finalizers);
+
+  /* Return the number of tasks not finalized yet. */
+  int32_t count() const;
+
+ private:
+  struct Task_t {
+    Job_t job;
+    Finalizer_t finalizer;
+  };
+
+  /* Worker threads main loop. */
+  void run();
+
+  std::vector<std::thread> workers_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable cv_;
+
+  std::deque<Task_t> pending_;
+  std::deque<Finalizer_t> completed_;
+  int32_t nrunning_ = 0;
+
+  bool bRunning_ = false;
+
+ private:
+  AsyncLoader(AsyncLoader const&) = delete;
+  AsyncLoader(AsyncLoader&&) = delete;
+};
+
+// ----------------------------------------------------------------------------
+
+#endif // BARBU_MEMORY_ASYNC_LOADER_H_
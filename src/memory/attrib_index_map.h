@@ -0,0 +1,112 @@
+#ifndef BARBU_MEMORY_ATTRIB_INDEX_MAP_H_
+#define BARBU_MEMORY_ATTRIB_INDEX_MAP_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "glm/vec3.hpp"
+
+// ----------------------------------------------------------------------------
+
+//
+// Open-addressing hash map from a triplet of attribute indices (ie. position,
+// texcoord, normal) to a signed 32bit value, used to weld sparse vertices.
+//
+// Keys are compared exactly and probed linearly in a single flat buffer, the
+// map only supports insertion and is cleared as a whole. Values must be positive.
+//
+class AttribIndexMap {
+ public:
+  using Key_t = glm::ivec3;
+
+  static constexpr int32_t kEmpty = -1;
+
+  /* Hash an attribute triplet, also used to partition keys between threads. */
+  static inline uint32_t Hash(Key_t const& key) noexcept {
+    uint64_t h = static_cast<uint32_t>(key.x);
+    h = (h * 0x9E3779B97F4A7C15ull) ^ static_cast<uint32_t>(key.y);
+    h = (h * 0x9E3779B97F4A7C15ull) ^ static_cast<uint32_t>(key.z);
+    h ^= h >> 32u;
+    h *= 0xD6E8FEB86659FD93ull;
+    h ^= h >> 32u;
+    return static_cast<uint32_t>(h);
+  }
+
+  AttribIndexMap() = default;
+
+  explicit AttribIndexMap(size_t count) {
+    reserve(count);
+  }
+
+  /* Allocate enough slots to insert count keys without rehashing. */
+  void reserve(size_t count) {
+    size_t capacity = kMinCapacity;
+    while (capacity < 2u * count) {
+      capacity <<= 1u;
+    }
+    if (capacity > slots_.size()) {
+      rehash(capacity);
+    }
+  }
+
+  void clear() {
+    slots_.assign(slots_.size(), Slot_t());
+    size_ = 0u;
+  }
+
+  /* Return the value mapped to key, inserting value first when missing. */
+  inline int32_t find_or_insert(Key_t const& key, int32_t value) {
+    if (2u * (size_ + 1u) > slots_.size()) {
+      rehash(slots_.empty() ? kMinCapacity : 2u * slots_.size());
+    }
+
+    size_t const mask = slots_.size() - 1u;
+    for (size_t i = Hash(key) & mask; ; i = (i + 1u) & mask) {
+      auto &slot = slots_[i];
+      if (kEmpty == slot.value) {
+        slot.key   = key;
+        slot.value = value;
+        ++size_;
+        return value;
+      }
+      if (slot.key == key) {
+        return slot.value;
+      }
+    }
+  }
+
+  inline size_t size() const noexcept {
+    return size_;
+  }
+
+ private:
+  static constexpr size_t kMinCapacity = 64u;
+
+  struct Slot_t {
+    Key_t key{};
+    int32_t value = kEmpty;
+  };
+
+  void rehash(size_t capacity) {
+    std::vector<Slot_t> slots(capacity);
+    size_t const mask = capacity - 1u;
+    for (auto const& slot : slots_) {
+      if (kEmpty == slot.value) {
+        continue;
+      }
+      size_t i = Hash(slot.key) & mask;
+      while (kEmpty != slots[i].value) {
+        i = (i + 1u) & mask;
+      }
+      slots[i] = slot;
+    }
+    slots_.swap(slots);
+  }
+
+  std::vector<Slot_t> slots_;
+  size_t size_ = 0u;
+};
+
+// ----------------------------------------------------------------------------
+
+#endif // BARBU_MEMORY_ATTRIB_INDEX_MAP_H_
@@ -0,0 +1,214 @@
+#include "memory/file_watcher.h"
+
+#if defined(__linux__)
+#define BARBU_USE_INOTIFY 1
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "core/logger.h"
+
+// ----------------------------------------------------------------------------
+
+namespace {
+
+// Return the system's last write time of a file, or the deleted marker.
+fs::file_time_type SysLastWrite(std::string const& path) {
+  std::error_code ec;
+  auto const lwt = fs::last_write_time(fs::path(path), ec);
+  return ec ? FileWatcher::kDeletedLastWrite : lwt;
+}
+
+// Return the key used to identify a file path.
+std::string NormalizePath(fs::path const& path) {
+  return path.lexically_normal().string();
+}
+
+} // namespace
+
+// ----------------------------------------------------------------------------
+
+void FileWatcher::start() {
+  if (bRunning_) {
+    return;
+  }
+  bRunning_ = true;
+  thread_ = std::thread([this]() { run(); });
+}
+
+void FileWatcher::stop() {
+  bRunning_ = false;
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+void FileWatcher::watch(std::string const& path) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  registered_.push_back(path);
+}
+
+// ----------------------------------------------------------------------------
+
+void FileWatcher::run() {
+#ifdef BARBU_USE_INOTIFY
+  notify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (notify_fd_ < 0) {
+    LOG_WARNING( "[VERSIONING] inotify is not available, files will be polled." );
+  }
+#endif
+
+  for (int32_t tick = 0; bRunning_; ++tick) {
+    register_files();
+
+    if (notify_fd_ >= 0) {
+      // (when notifications were lost, fallback to a full check)
+      if (!read_notifications()) {
+        stat_files();
+      }
+    } else {
+      if (0 == (tick % kStatPollingPeriod)) {
+        stat_files();
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(kPollMilliseconds));
+    }
+
+    flush_files();
+  }
+
+#ifdef BARBU_USE_INOTIFY
+  if (notify_fd_ >= 0) {
+    close(notify_fd_);
+    notify_fd_ = -1;
+  }
+#endif
+  directories_.clear();
+}
+
+void FileWatcher::register_files() {
+  std::vector<std::string> paths;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    paths.swap(registered_);
+  }
+
+  for (auto const& path : paths) {
+    auto const key = NormalizePath(path);
+    if (files_.find(key) != files_.end()) {
+      continue;
+    }
+
+    File_t file;
+    file.path       = path;
+    file.last_write = SysLastWrite(path);
+    files_[key] = file;
+
+#ifdef BARBU_USE_INOTIFY
+    if (notify_fd_ >= 0) {
+      // Watch the parent directory, as editors often save by replacing files.
+      auto dirname = fs::path(key).parent_path();
+      if (dirname.empty()) {
+        dirname = ".";
+      }
+      uint32_t const mask = IN_CLOSE_WRITE | IN_MODIFY | IN_MOVED_TO | IN_CREATE | IN_DELETE;
+      int const wd = inotify_add_watch(notify_fd_, dirname.c_str(), mask);
+      if (wd < 0) {
+        LOG_WARNING( "[VERSIONING] Could not watch directory :", dirname.string());
+      } else {
+        directories_[wd] = dirname.string();
+      }
+    }
+#endif
+  }
+}
+
+void FileWatcher::stat_files() {
+  for (auto &tuple : files_) {
+    auto &file = tuple.second;
+    if (!file.bDirty && (SysLastWrite(file.path) != file.last_write)) {
+      mark_dirty(tuple.first);
+    }
+  }
+}
+
+bool FileWatcher::read_notifications() {
+#ifdef BARBU_USE_INOTIFY
+  // Wait for events, or a timeout to handle debounced files.
+  pollfd pfd{ notify_fd_, POLLIN, 0 };
+  if (::poll(&pfd, 1, kPollMilliseconds) <= 0) {
+    return true;
+  }
+
+  alignas(inotify_event) char buffer[4096];
+  bool bOverflow = false;
+
+  for (;;) {
+    ssize_t const nbytes = read(notify_fd_, buffer, sizeof(buffer));
+    if (nbytes <= 0) {
+      break;
+    }
+
+    for (char const* ptr = buffer; ptr < buffer + nbytes; ) {
+      auto const* event = reinterpret_cast<inotify_event const*>(ptr);
+      ptr += sizeof(inotify_event) + event->len;
+
+      if (event->mask & IN_Q_OVERFLOW) {
+        bOverflow = true;
+        continue;
+      }
+      if (auto dir = directories_.find(event->wd); (dir != directories_.end()) && (event->len > 0)) {
+        mark_dirty( NormalizePath(fs::path(dir->second) / event->name) );
+      }
+    }
+  }
+
+  return !bOverflow;
+#else
+  return false;
+#endif
+}
+
+void FileWatcher::flush_files() {
+  auto const now = Clock_t::now();
+  auto const span = std::chrono::milliseconds(kLastWriteSpanMilliseconds);
+
+  for (auto &tuple : files_) {
+    auto &file = tuple.second;
+    if (!file.bDirty || ((now - file.dirty_time) < span)) {
+      continue;
+    }
+
+    auto const last_write = SysLastWrite(file.path);
+
+    // The content has not changed (eg. the event was for attributes only).
+    if (last_write == file.last_write) {
+      file.bDirty = false;
+      continue;
+    }
+
+    // Check the file is not currently being saved.
+    if (last_write != kDeletedLastWrite) {
+      auto const elapsed = fs::file_time_type::clock::now() - last_write;
+      if (elapsed < span) {
+        file.dirty_time = now;
+        continue;
+      }
+    }
+
+    // (when the queue is full, the event is posted on the next check)
+    if (events_.push({ file.path, last_write })) {
+      file.last_write = last_write;
+      file.bDirty = false;
+    }
+  }
+}
+
+void FileWatcher::mark_dirty(std::string const& key) {
+  if (auto it = files_.find(key); it != files_.end()) {
+    it->second.bDirty     = true;
+    it->second.dirty_time = Clock_t::now();
+  }
+}
+
+// ----------------------------------------------------------------------------
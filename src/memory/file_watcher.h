@@ -0,0 +1,131 @@
+#ifndef BARBU_MEMORY_FILE_WATCHER_H_
+#define BARBU_MEMORY_FILE_WATCHER_H_
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// filesystem, used for versioning.
+#if __has_include(<filesystem>)
+#include <filesystem>
+namespace fs = std::filesystem;
+#elif __has_include(<experimental/optional>)
+#include <experimental/filesystem>
+namespace fs = std::experimental::filesystem;
+#else
+# ifdef __GNUC__
+#pragma GCC error "std::filesystem is required."
+# else
+#pragma message( "std::filesystem is required." )
+# endif
+#endif
+
+#include "memory/spsc_queue.h"
+
+// ----------------------------------------------------------------------------
+
+//
+// Watch files modifications from a background thread.
+//
+// On Linux the parent directories of watched files are monitored with inotify,
+// otherwise the files are polled periodically. Writes are debounced until a file
+// has not been modified for a short span, then a change event is posted to a
+// lock-free queue to be drained by the main thread.
+//
+class FileWatcher {
+ public:
+  // Minimal span without writes before a file is considered saved.
+  static constexpr int32_t kLastWriteSpanMilliseconds = 250;
+
+  // Interval between two checks of the watcher thread.
+  static constexpr int32_t kPollMilliseconds = 100;
+
+  // Number of checks between two file stats, when inotify is not available.
+  static constexpr int32_t kStatPollingPeriod = 5;
+
+  // Special time used to indicated a file has been deleted.
+  static constexpr fs::file_time_type kDeletedLastWrite = fs::file_time_type::min();
+
+  struct Event_t {
+    std::string path;
+    fs::file_time_type last_write;
+  };
+
+  FileWatcher() = default;
+
+  ~FileWatcher() {
+    stop();
+  }
+
+  /* Start the watcher thread. */
+  void start();
+
+  /* Stop and join the watcher thread. */
+  void stop();
+
+  /* Add a file to watch, can be called from any thread. */
+  void watch(std::string const& path);
+
+  /* Retrieve the next change event, return false when there is none. */
+  inline bool poll(Event_t &event) {
+    return events_.pop(event);
+  }
+
+ private:
+  static constexpr size_t kEventQueueCapacity = 256u;
+
+  using Clock_t = std::chrono::steady_clock;
+
+  struct File_t {
+    std::string path;                     //< watched path, as registered.
+    fs::file_time_type last_write;        //< last known write time.
+    Clock_t::time_point dirty_time;       //< time of the last modification event.
+    bool bDirty = false;
+  };
+
+  /* Watcher thread main loop. */
+  void run();
+
+  /* Move newly registered files to the watched list. */
+  void register_files();
+
+  /* Detect modifications by comparing the files write time. */
+  void stat_files();
+
+  /* Detect modifications from the inotify events, return false on failure. */
+  bool read_notifications();
+
+  /* Post the files which have not been modified for a while. */
+  void flush_files();
+
+  /* Flag a file as being modified. */
+  void mark_dirty(std::string const& key);
+
+  // Files registered by other threads, waiting to be watched.
+  std::mutex mutex_;
+  std::vector<std::string> registered_;
+
+  // Watched files, by normalized path (only accessed by the watcher thread).
+  std::unordered_map<std::string, File_t> files_;
+
+  // inotify watch descriptors to their directory.
+  std::unordered_map<int, std::string> directories_;
+  int notify_fd_ = -1;
+
+  SPSCQueue<Event_t, kEventQueueCapacity> events_;
+
+  std::thread thread_;
+  std::atomic<bool> bRunning_{ false };
+
+ private:
+  FileWatcher(FileWatcher const&) = delete;
+  FileWatcher(FileWatcher&&) = delete;
+};
+
+// ----------------------------------------------------------------------------
+
+#endif // BARBU_MEMORY_FILE_WATCHER_H_
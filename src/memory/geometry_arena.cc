@@ -0,0 +1,231 @@
+#include "memory/geometry_arena.h"
+
+#include <algorithm>
+
+#include "core/graphics.h"
+#include "memory/assets/mesh.h"
+
+// ----------------------------------------------------------------------------
+
+namespace {
+
+// Initial capacity of the buffers, in elements.
+static constexpr int32_t kMinVertices = 1 << 16;
+static constexpr int32_t kMinIndices  = 1 << 18;
+
+// Vertex buffers binding indices.
+static constexpr uint32_t kVertexBinding   = 0u;
+static constexpr uint32_t kSkinningBinding = 1u;
+
+/// Reallocate a buffer to a larger size, keeping its previous content.
+///
+/// This needs no explicit synchronization : the copy is a device command,
+/// ordered after the draws already submitted with the previous buffer, whose
+/// storage is only freed by the driver once they completed. Its name is invalid
+/// afterwards, so the arena buffers must never be referenced outside of it.
+void GrowBuffer(uint32_t &buffer, size_t const bytesize, size_t const new_bytesize) {
+  uint32_t new_buffer = 0u;
+  glCreateBuffers(1u, &new_buffer);
+  glNamedBufferStorage(new_buffer, static_cast<GLsizeiptr>(new_bytesize), nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+  if (0u != buffer) {
+    glCopyNamedBufferSubData(buffer, new_buffer, 0, 0, static_cast<GLsizeiptr>(bytesize));
+    glDeleteBuffers(1u, &buffer);
+  }
+  buffer = new_buffer;
+}
+
+} // namespace
+
+// ----------------------------------------------------------------------------
+
+int32_t GeometryArena::Ranges_t::allocate(int32_t const n) {
+  for (auto it = free_.begin(); it != free_.end(); ++it) {
+    auto const [offset, size] = *it;
+    if (size < n) {
+      continue;
+    }
+    free_.erase(it);
+    if (size > n) {
+      free_[offset + n] = size - n;
+    }
+    return offset;
+  }
+  return -1;
+}
+
+void GeometryArena::Ranges_t::release(int32_t const offset, int32_t const n) {
+  auto it = free_.emplace(offset, n).first;
+
+  // Merge with the next range.
+  if (auto next = std::next(it); (next != free_.end()) && (offset + n == next->first)) {
+    it->second += next->second;
+    free_.erase(next);
+  }
+
+  // Merge with the previous range.
+  if (it != free_.begin()) {
+    if (auto prev = std::prev(it); prev->first + prev->second == offset) {
+      prev->second += it->second;
+      free_.erase(it);
+    }
+  }
+}
+
+void GeometryArena::Ranges_t::grow(int32_t const capacity) {
+  if (capacity > capacity_) {
+    release(capacity_, capacity - capacity_);
+    capacity_ = capacity;
+  }
+}
+
+// ----------------------------------------------------------------------------
+
+GeometryArena& GeometryArena::Get(Format const format) {
+  static GeometryArena *sStatic  = new GeometryArena(Format::Static);
+  static GeometryArena *sSkinned = new GeometryArena(Format::Skinned);
+  return (Format::Skinned == format) ? *sSkinned : *sStatic;
+}
+
+bool GeometryArena::allocate(MeshData const& meshdata, Allocation_t &allocation) {
+  int32_t const nvertices = meshdata.nvertices();
+  int32_t const nindices  = meshdata.nindices();
+  bool const bSkinned = (Format::Skinned == format_);
+
+  if ((nvertices <= 0) || (bSkinned && (meshdata.nskinnings() != nvertices))) {
+    LOG_ERROR( "Invalid mesh geometry for its vertex format." );
+    return false;
+  }
+
+  if (0u == vao_) {
+    init();
+  }
+
+  // Find free ranges, growing the buffers when none are large enough.
+  int32_t base_vertex = vertices_.allocate(nvertices);
+  if (base_vertex < 0) {
+    reserve(vertices_.capacity() + nvertices, 0);
+    base_vertex = vertices_.allocate(nvertices);
+  }
+  int32_t first_index = 0;
+  if (nindices > 0) {
+    first_index = indices_.allocate(nindices);
+    if (first_index < 0) {
+      reserve(0, indices_.capacity() + nindices);
+      first_index = indices_.allocate(nindices);
+    }
+  }
+  LOG_CHECK( (base_vertex >= 0) && (first_index >= 0) );
+
+  // Upload.
+  glNamedBufferSubData(vbo_,
+    static_cast<GLintptr>(base_vertex * sizeof(MeshData::Vertex_t)),
+    static_cast<GLsizeiptr>(nvertices * sizeof(MeshData::Vertex_t)),
+    meshdata.vertexData()
+  );
+  if (bSkinned) {
+    glNamedBufferSubData(skin_vbo_,
+      static_cast<GLintptr>(base_vertex * sizeof(MeshData::Skinning_t)),
+      static_cast<GLsizeiptr>(nvertices * sizeof(MeshData::Skinning_t)),
+      meshdata.skinningData()
+    );
+  }
+  if (nindices > 0) {
+    glNamedBufferSubData(ibo_,
+      static_cast<GLintptr>(first_index * sizeof(uint32_t)),
+      static_cast<GLsizeiptr>(nindices * sizeof(uint32_t)),
+      meshdata.indexData()
+    );
+  }
+  CHECK_GX_ERROR();
+
+  allocation.base_vertex = base_vertex;
+  allocation.nvertices   = nvertices;
+  allocation.first_index = first_index;
+  allocation.nindices    = nindices;
+
+  return true;
+}
+
+void GeometryArena::release(Allocation_t &allocation) {
+  if (!allocation.valid()) {
+    return;
+  }
+
+  vertices_.release(allocation.base_vertex, allocation.nvertices);
+  if (allocation.nindices > 0) {
+    indices_.release(allocation.first_index, allocation.nindices);
+  }
+  allocation = Allocation_t();
+}
+
+void GeometryArena::init() {
+  glCreateVertexArrays(1u, &vao_);
+
+  // 1) Generic Vertex Attribs.
+  {
+    #define ARENA_SetupAttrib(tAttrib, tComponent) \
+    { \
+      auto const ncomp{ static_cast<uint32_t>((sizeof MeshData::Vertex_t::tComponent) / (sizeof MeshData::Vertex_t::tComponent[0u]))}; \
+      glVertexArrayAttribFormat( vao_, Mesh::tAttrib, ncomp, GL_FLOAT, GL_FALSE, offsetof(MeshData::Vertex_t, tComponent)); \
+      glVertexArrayAttribBinding( vao_, Mesh::tAttrib, kVertexBinding); \
+      glEnableVertexArrayAttrib( vao_, Mesh::tAttrib ); \
+    }
+
+    ARENA_SetupAttrib( ATTRIB_POSITION,  position );
+    ARENA_SetupAttrib( ATTRIB_TEXCOORD,  texcoord );
+    ARENA_SetupAttrib( ATTRIB_NORMAL,    normal );
+    ARENA_SetupAttrib( ATTRIB_TANGENT,   tangent );
+
+    #undef ARENA_SetupAttrib
+  }
+
+  // 2) Skinning Attribs.
+  if (Format::Skinned == format_) {
+    uint32_t attrib_index, num_component;
+
+    attrib_index = Mesh::ATTRIB_JOINT_INDICES;
+    num_component = static_cast<uint32_t>((sizeof MeshData::Skinning_t::joint_indices) / (sizeof MeshData::Skinning_t::joint_indices[0u]));
+    glVertexArrayAttribIFormat(vao_, attrib_index, num_component, GL_UNSIGNED_INT, offsetof(MeshData::Skinning_t, joint_indices));
+    glVertexArrayAttribBinding(vao_, attrib_index, kSkinningBinding);
+    glEnableVertexArrayAttrib(vao_, attrib_index);
+
+    attrib_index = Mesh::ATTRIB_JOINT_WEIGHTS;
+    num_component = static_cast<uint32_t>((sizeof MeshData::Skinning_t::joint_weights) / (sizeof MeshData::Skinning_t::joint_weights[0u]));
+    glVertexArrayAttribFormat(vao_, attrib_index, num_component, GL_FLOAT, GL_TRUE/**/, offsetof(MeshData::Skinning_t, joint_weights));
+    glVertexArrayAttribBinding(vao_, attrib_index, kSkinningBinding);
+    glEnableVertexArrayAttrib(vao_, attrib_index);
+  }
+
+  reserve(kMinVertices, kMinIndices);
+}
+
+void GeometryArena::reserve(int32_t const nvertices, int32_t const nindices) {
+  // Grow geometrically to amortize the copies, the vertex array being rebound
+  // to the new buffers so that the meshes keep their ranges and vao.
+  // (like every GL calls, this must run on the rendering thread, see Mesh::setup)
+  if (int32_t const capacity = vertices_.capacity(); nvertices > capacity) {
+    int32_t const new_capacity = std::max(nvertices, 2 * capacity);
+
+    GrowBuffer(vbo_, capacity * sizeof(MeshData::Vertex_t), new_capacity * sizeof(MeshData::Vertex_t));
+    glVertexArrayVertexBuffer(vao_, kVertexBinding, vbo_, 0, sizeof(MeshData::Vertex_t));
+
+    if (Format::Skinned == format_) {
+      GrowBuffer(skin_vbo_, capacity * sizeof(MeshData::Skinning_t), new_capacity * sizeof(MeshData::Skinning_t));
+      glVertexArrayVertexBuffer(vao_, kSkinningBinding, skin_vbo_, 0, sizeof(MeshData::Skinning_t));
+    }
+    vertices_.grow(new_capacity);
+  }
+
+  if (int32_t const capacity = indices_.capacity(); nindices > capacity) {
+    int32_t const new_capacity = std::max(nindices, 2 * capacity);
+
+    GrowBuffer(ibo_, capacity * sizeof(uint32_t), new_capacity * sizeof(uint32_t));
+    glVertexArrayElementBuffer(vao_, ibo_);
+    indices_.grow(new_capacity);
+  }
+
+  CHECK_GX_ERROR();
+}
+
+// ----------------------------------------------------------------------------
@@ -0,0 +1,117 @@
+#ifndef BARBU_MEMORY_GEOMETRY_ARENA_H_
+#define BARBU_MEMORY_GEOMETRY_ARENA_H_
+
+#include <cstdint>
+#include <map>
+
+#include "memory/resources/mesh_data.h"
+
+// ----------------------------------------------------------------------------
+
+// Layout of an indexed indirect draw (DrawElementsIndirectCommand).
+struct DrawIndirectCommand_t {
+  uint32_t count;
+  uint32_t instance_count;
+  uint32_t first_index;
+  int32_t  base_vertex;
+  uint32_t base_instance;
+};
+
+// ----------------------------------------------------------------------------
+
+//
+// Device vertices and indices shared by every meshes of a vertex format.
+//
+// Meshes sub-allocate ranges of a few large buffers bound to a single vertex
+// array, so their draws only differ by their first index and base vertex and
+// can be submitted together with multi-draw indirect commands.
+//
+// Buffers grow by reallocation, keeping the previous ranges in place, and
+// released ranges are reused first-fit. Only the vertex array is exposed, as
+// the buffers are replaced when they grow.
+//
+// Arenas are never destroyed, as meshes release their ranges on destruction.
+//
+class GeometryArena {
+ public:
+  enum class Format {
+    Static,       //< MeshData::Vertex_t
+    Skinned,      //< MeshData::Vertex_t and MeshData::Skinning_t
+    kCount
+  };
+
+  // Ranges of a mesh, indices being relative to its base vertex.
+  struct Allocation_t {
+    int32_t base_vertex = -1;
+    int32_t nvertices   = 0;
+    int32_t first_index = 0;
+    int32_t nindices    = 0;
+
+    inline bool valid() const noexcept {
+      return base_vertex >= 0;
+    }
+  };
+
+ public:
+  /* Return the arena of a vertex format. */
+  static GeometryArena& Get(Format const format);
+
+  /* Upload the geometry of a mesh to new ranges, return false on failure. */
+  bool allocate(MeshData const& meshdata, Allocation_t &allocation);
+
+  /* Release the ranges of a mesh. */
+  void release(Allocation_t &allocation);
+
+  inline uint32_t vao() const noexcept {
+    return vao_;
+  }
+
+ private:
+  // First-fit allocator of element ranges.
+  class Ranges_t {
+   public:
+    /* Return the offset of a free range of n elements, or -1 when none is large enough. */
+    int32_t allocate(int32_t const n);
+
+    void release(int32_t const offset, int32_t const n);
+
+    /* Extend the ranges to a larger capacity. */
+    void grow(int32_t const capacity);
+
+    inline int32_t capacity() const noexcept {
+      return capacity_;
+    }
+
+   private:
+    std::map<int32_t, int32_t> free_;   //< free ranges size by offset
+    int32_t capacity_ = 0;
+  };
+
+  explicit GeometryArena(Format const format)
+    : format_(format)
+  {}
+
+  /* Create the vertex array and its attributes format. */
+  void init();
+
+  /* Grow the buffers to hold at least the given number of elements. */
+  void reserve(int32_t const nvertices, int32_t const nindices);
+
+  Format const format_;
+
+  uint32_t vao_      = 0u;
+  uint32_t vbo_      = 0u;
+  uint32_t skin_vbo_ = 0u;
+  uint32_t ibo_      = 0u;
+
+  Ranges_t vertices_;
+  Ranges_t indices_;
+
+ private:
+  GeometryArena(GeometryArena const&) = delete;
+  GeometryArena(GeometryArena &&) = delete;
+};
+
+// ----------------------------------------------------------------------------
+
+#endif // BARBU_MEMORY_GEOMETRY_ARENA_H_
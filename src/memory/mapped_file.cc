@@ -0,0 +1,100 @@
+#include "memory/mapped_file.h"
+
+#include <cstdio>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define BARBU_USE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "core/logger.h"
+
+// ----------------------------------------------------------------------------
+
+bool MappedFile::open(std::string_view filename) {
+  close();
+
+  // (the filename might not be null-terminated)
+  std::string const fn( filename );
+
+#ifdef BARBU_USE_MMAP
+  int const fd = ::open( fn.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+
+  struct stat st{};
+  if ((fstat(fd, &st) < 0) || (st.st_size <= 0)) {
+    ::close(fd);
+    return false;
+  }
+  size_t const filesize = static_cast<size_t>(st.st_size);
+
+  void *ptr = mmap( nullptr, filesize, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+
+  if (MAP_FAILED == ptr) {
+    LOG_WARNING( "Failed to map file :", fn );
+    return false;
+  }
+
+  data_    = static_cast<char const*>(ptr);
+  size_    = filesize;
+  bMapped_ = true;
+#else
+  FILE *fd = fopen( fn.c_str(), "rb");
+  if (nullptr == fd) {
+    return false;
+  }
+
+  fseek(fd, 0, SEEK_END);
+  long const filesize = ftell(fd);
+  fseek(fd, 0, SEEK_SET);
+
+  if (filesize <= 0) {
+    fclose(fd);
+    return false;
+  }
+
+  char *buffer = new char[filesize];
+  size_t const rbytes = fread(buffer, 1u, static_cast<size_t>(filesize), fd);
+  fclose(fd);
+
+  if (rbytes != static_cast<size_t>(filesize)) {
+    LOG_WARNING( "Failed to read file :", fn );
+    delete [] buffer;
+    return false;
+  }
+
+  data_    = buffer;
+  size_    = static_cast<size_t>(filesize);
+  bMapped_ = false;
+#endif
+
+  return true;
+}
+
+void MappedFile::close() {
+  if (nullptr == data_) {
+    return;
+  }
+
+#ifdef BARBU_USE_MMAP
+  if (bMapped_) {
+    munmap( const_cast<char*>(data_), size_);
+  } else
+#endif
+  {
+    delete [] data_;
+  }
+
+  data_    = nullptr;
+  size_    = 0;
+  bMapped_ = false;
+}
+
+// ----------------------------------------------------------------------------
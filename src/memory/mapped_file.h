@@ -0,0 +1,54 @@
+#ifndef BARBU_MEMORY_MAPPED_FILE_H_
+#define BARBU_MEMORY_MAPPED_FILE_H_
+
+#include <cstddef>
+#include <string_view>
+
+// ----------------------------------------------------------------------------
+
+//
+// Read-only view on a whole file content.
+//
+// On POSIX systems the file is memory-mapped and pages are fetched lazily by
+// the OS, otherwise its content is read into a host buffer.
+//
+// The object is neither copyable nor movable, share it via a smart pointer.
+//
+class MappedFile {
+ public:
+  MappedFile() = default;
+
+  ~MappedFile() {
+    close();
+  }
+
+  MappedFile(MappedFile const&) = delete;
+  MappedFile& operator=(MappedFile const&) = delete;
+
+  /* Map the file content, return false on failure. */
+  bool open(std::string_view filename);
+
+  /* Unmap the file, invalidating all pointers to its data. */
+  void close();
+
+  inline bool is_open() const noexcept {
+    return nullptr != data_;
+  }
+
+  inline char const* data() const noexcept {
+    return data_;
+  }
+
+  inline size_t size() const noexcept {
+    return size_;
+  }
+
+ private:
+  char const* data_ = nullptr;
+  size_t size_      = 0;
+  bool bMapped_     = false;
+};
+
+// ----------------------------------------------------------------------------
+
+#endif // BARBU_MEMORY_MAPPED_FILE_H_
@@ -3,28 +3,14 @@
 
 #include <cassert>
 #include <memory>         // shared_ptr
+#include <mutex>
 #include <string>         // substr, find_last_of
 #include <string_view>
 #include <unordered_map>
 #include <vector>
-#include <thread>
-
-// filesystem, used for versioning.
-#if __has_include(<filesystem>)
-#include <filesystem>
-namespace fs = std::filesystem;
-#elif __has_include(<experimental/optional>)
-#include <experimental/filesystem>
-namespace fs = std::experimental::filesystem;
-#else
-# ifdef __GNUC__
-#pragma GCC error "std::filesystem is required."
-# else
-#pragma message( "std::filesystem is required." )
-# endif
-#endif
 
 #include "core/logger.h"
+#include "memory/file_watcher.h"   // (fs namespace)
 #include "memory/resource_info_list.h"
 
 // ----------------------------------------------------------------------------
@@ -37,11 +23,15 @@ namespace fs = std::experimental::filesystem;
 //
 //    Internally resources have version attached to them, when the user modify
 //    the external data (eg. by changing it in another program), the manager
-//    will try to reupload it and modify its version accordingly.
+//    will try to reupload it and modify its version accordingly. Modifications
+//    are detected by a FileWatcher thread.
 //
 //    When a resource is released its internal data are erased but its stats are
 //    kept. All resources are released after a few frames.
 //
+//    Managers can be accessed from loader threads : their tables are guarded
+//    by a mutex, while the loading itself is done outside the lock.
+//
 //  [ notes ]
 //
 //  * ResourceHandle would probably be changed to be similar to AssetHandle, ie.
@@ -104,18 +94,14 @@ struct ResourceHandle {
 // Most of the time this data are load from memory, but they can also be created directly.
 //
 // Resources are identified by a 'ResourceId' which must be the path of their
-// external data (when it applies). When 'update' is called the manager checks
-// if the data has been modified and load it back as necessary, updating its
-// internal version.
+// external data (when it applies). When 'update' is called with a change event
+// the manager load the data back as necessary, updating its internal version.
 //
 // A user will call 'get' or 'load' to retrieve a resource and 'get_updated'
 // to check if an already retrieved resource has been modified.
 //
 template<typename TResource>
 class ResourceManager {
- private:
-  static constexpr int32_t kLastWriteSpanMilliseconds = 250;
-
  public:
   using Handle = ResourceHandle<TResource>;
 
@@ -127,48 +113,60 @@ class ResourceManager {
 
   // Release resources internal memory but keeps filestat info to track changes.
   inline void release_all() noexcept {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     resources_.clear();
   }
 
-  // Check resources that has been modified.
-  void update() {
-    for (auto tuple : stats_) {
-      auto const id   = tuple.first;
-      auto const stat = tuple.second;
-      auto sys_lw = sys_last_write(id);
-
-      // ----------------
-      auto has_time_elapsed = [](fs::file_time_type timemark, int32_t max_elapsed) -> bool {
-        auto const now = fs::file_time_type::clock::now();
-        auto const elapsed = now - timemark;
-        auto const t = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
-        return t > max_elapsed;
-      };
-      // ----------------
-
-      if (sys_lw != stat.last_write) {
-        if (sys_lw == kDeletedLastWrite) {
-          // (the file is not accessible anymore)
-          update_stat(id);
-          LOG_WARNING( "[VERSIONING] \"", id.path, "\" : file not found.");
-        } else {
-
-          // Check the file is not currently being saved.
-          for (sys_lw = sys_last_write(id); !has_time_elapsed(sys_lw, kLastWriteSpanMilliseconds); sys_lw = sys_last_write(id)) {
-            std::this_thread::sleep_for(std::chrono::milliseconds(kLastWriteSpanMilliseconds));
-          }
-
-          if (load(id).is_valid()) {
-            // (the file has been modified)
-            LOG_INFO( "[VERSIONING]", Logger::TrimFilename(id.path), ": v", version(id));
-          }
-        }
+  // Set the watcher notified of the external files used by the resources.
+  inline void set_watcher(FileWatcher *watcher) noexcept {
+    watcher_ = watcher;
+  }
+
+  // Reload a resource whose external file has been modified.
+  // Return true when the resource was reloaded.
+  bool update(ResourceId const& id, fs::file_time_type sys_lw) {
+    {
+      std::lock_guard<std::recursive_mutex> lock(mutex_);
+      if (auto const tuple = stats_.find(id); (tuple == stats_.end()) || (tuple->second.last_write == sys_lw)) {
+        return false;
       }
     }
+
+    if (sys_lw == kDeletedLastWrite) {
+      // (the file is not accessible anymore)
+      update_stat(id, sys_lw);
+      LOG_WARNING( "[VERSIONING] \"", id.path, "\" : file not found.");
+      return false;
+    }
+
+    return reload(id, sys_lw);
+  }
+
+  // Reload a tracked resource and increment its version, even when its own
+  // file was not modified (eg. when one of its dependencies was).
+  bool reload(ResourceId const& id, fs::file_time_type sys_lw) {
+    auto h = _load(id);
+    if (!h.is_valid()) {
+      return false;
+    }
+
+    {
+      std::lock_guard<std::recursive_mutex> lock(mutex_);
+      resources_[id] = h;
+      auto &stat = stats_[id];
+      stat.last_write = sys_lw;
+      stat.version += 1;
+    }
+
+    // (the file has been modified)
+    LOG_INFO( "[VERSIONING]", Logger::TrimFilename(id.path), ": v", version(id));
+
+    return true;
   }
 
   // Return true if the resource is on memory.
   inline bool has(ResourceId const& id) const noexcept {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     return (stats_.find(id) != stats_.end())              // has resource in memory
         || (resources_.find(id) != resources_.end())      // or just a stat  [ side effects ? ]
         ;
@@ -177,7 +175,26 @@ class ResourceManager {
   // Load a resource in memory and return an handle to it.
   inline Handle load(ResourceId const& id) {
     auto h = _load(id);
+    commit(id, h);
+    return h;
+  }
+
+  // Load a resource in memory without registering it, to be used by loader
+  // threads. Return the registered resource when it is already loaded.
+  inline Handle load_detached(ResourceId const& id) {
+    {
+      std::lock_guard<std::recursive_mutex> lock(mutex_);
+      if (auto const tuple = resources_.find(id); (tuple != resources_.end()) && tuple->second.is_valid()) {
+        return tuple->second;
+      }
+    }
+    return _load(id);
+  }
+
+  // Register a resource loaded by 'load_detached'.
+  inline void commit(ResourceId const& id, Handle const& h) {
     if (h.is_valid()) {
+      std::lock_guard<std::recursive_mutex> lock(mutex_);
       resources_[id] = h;
     
       // Update internal version.
@@ -185,12 +202,12 @@ class ResourceManager {
         update_stat(id);
       }
     }
-    return h;
   }
 
   Handle load_internal(ResourceId const& id, int32_t size, void const* data, std::string_view mime_type) {
     auto h = _load_internal(id, size, data, mime_type);
     if (h.is_valid()) {
+      std::lock_guard<std::recursive_mutex> lock(mutex_);
       resources_[id] = h;
       
       // [check if the internal version works as intended]
@@ -203,17 +220,19 @@ class ResourceManager {
 
   // Retrieve the requested resource, or try reloading it when necessary.
   inline Handle get(ResourceId const& id) {
-    auto const tuple = resources_.find(id);
-    if (tuple == resources_.end()) {        // xxx
-      return load(id);
-    } else if (!(tuple->second).data->loaded()) {
-      return load(id);
+    {
+      std::lock_guard<std::recursive_mutex> lock(mutex_);
+      auto const tuple = resources_.find(id);
+      if ((tuple != resources_.end()) && (tuple->second).data->loaded()) {
+        return tuple->second;
+      }
     }
-    return tuple->second;
+    return load(id);
   }
 
   // Constant retrieval of a resource, without loading.
   inline Handle const get(ResourceId const& id) const {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     assert(has(id) && resources_[id].data->loaded());
     return resources_[id];
   }
@@ -231,6 +250,8 @@ class ResourceManager {
     
     Handle h( id );
     *(h.data) = resource; //
+
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     resources_[id] = h;
     update_stat(id);
     
@@ -239,6 +260,7 @@ class ResourceManager {
 
   // Release access for the specified resource. [rename destroy ?]
   inline void release(ResourceId const& id) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     resources_.erase(id);
   }
 
@@ -248,7 +270,7 @@ class ResourceManager {
 
   // Special time used to indicated a file has been deleted, or does not exists
   // (eg. the data was internally created). Used to avoid logging deleted files ad-aeternum.
-  static constexpr fs::file_time_type kDeletedLastWrite = fs::file_time_type::min();
+  static constexpr fs::file_time_type kDeletedLastWrite = FileWatcher::kDeletedLastWrite;
   
   // Return the system's last write time for the given resource. 
   fs::file_time_type sys_last_write(ResourceId const& id) const noexcept {
@@ -265,12 +287,14 @@ class ResourceManager {
   
   // Return the internal last write time for the file.
   fs::file_time_type last_write(ResourceId const& id) const noexcept {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     auto const& tuple = stats_.find(id);
     return (tuple != stats_.end()) ? tuple->second.last_write : kDeletedLastWrite;
   }
 
   // Return the internal version of a given resource.
   ResourceVersion version(ResourceId const& id) const noexcept {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     auto const& tuple = stats_.find(id);
     return (tuple != stats_.end()) ? tuple->second.version : ResourceInfo::kDefaultVersion;
   }
@@ -296,12 +320,22 @@ class ResourceManager {
 
   // Update the internal stat of a given resource.
   void update_stat(ResourceId const& id) {
+    update_stat(id, sys_last_write(id));
+  }
+
+  // Update the internal stat of a given resource with its known last write time.
+  void update_stat(ResourceId const& id, fs::file_time_type last_write) {
+    std::lock_guard<std::recursive_mutex> lock(mutex_);
     auto const& tuple = stats_.find(id);
-    auto const last_write = sys_last_write(id);
 
     if (tuple == stats_.end()) {
       // (unwritten)
       stats_[id] = FileStat( last_write, 0);      
+
+      // Watch external files for modifications.
+      if (watcher_ && (last_write != kDeletedLastWrite)) {
+        watcher_->watch(id.path);
+      }
     } else if (tuple->second.last_write != last_write) {
       // (modified)
       auto const new_version = tuple->second.version + int((last_write != kDeletedLastWrite));
@@ -333,6 +367,12 @@ class ResourceManager {
   StatHashmap_t stats_;
   ResourceHashmap_t resources_;
 
+  // Guard the tables against loader threads.
+  mutable std::recursive_mutex mutex_;
+
+ protected:
+  FileWatcher *watcher_ = nullptr;
+
  private:
   ResourceManager(ResourceManager const&) = delete;
   ResourceManager(ResourceManager&&) = delete;
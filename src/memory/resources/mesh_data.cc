@@ -3,9 +3,156 @@
 #include "glm/gtc/type_ptr.hpp"
 
 #include "memory/assets/assets.h"
+#include "memory/attrib_index_map.h"
 
-#define MATHUTILS_MAP_VECTOR
-#include "utils/mathutils.h"
+#ifdef BARBU_NPROC_MAX
+#define LOOP_NTHREADS  (BARBU_NPROC_MAX)
+#else
+#define LOOP_NTHREADS  4
+#endif
+
+// ----------------------------------------------------------------------------
+
+namespace {
+
+// Number of elements above which vertices are welded in parallel.
+constexpr size_t kParallelWeldThreshold = 2u << 20u;
+
+// Weld identical attributes triplets to unique vertices.
+//
+// Vertices are numbered by the first occurrence of their triplet, each storing
+// its triplet and the index of that first element into attribIndices.
+void WeldVertices(std::vector<glm::ivec3> const& elems, MeshData::IndexBuffer_t &indices, std::vector<glm::ivec4> &attribIndices) {
+  auto const nelems = static_cast<int32_t>(elems.size());
+
+  // (closed meshes have about half as many vertices as faces, seams add some more)
+  AttribIndexMap map( elems.size() / 3u );
+
+  attribIndices.clear();
+  indices.resize(nelems);
+  for (int32_t i = 0; i < nelems; ++i) {
+    auto const& key = elems[i];
+    auto const vertex_index = static_cast<int32_t>(attribIndices.size());
+    auto const index = map.find_or_insert(key, vertex_index);
+    if (index == vertex_index) {
+      attribIndices.push_back( glm::ivec4(key, i) );
+    }
+    indices[i] = static_cast<uint32_t>(index);
+  }
+}
+
+// Parallel version of WeldVertices, with the same output.
+//
+// Elements are bucketed by key partitions, each welded independently to find
+// the first element of every triplet, which are then numbered in order.
+void WeldVerticesParallel(std::vector<glm::ivec3> const& elems, MeshData::IndexBuffer_t &indices, std::vector<glm::ivec4> &attribIndices) {
+  constexpr int32_t nparts  = LOOP_NTHREADS;
+  constexpr int32_t nchunks = LOOP_NTHREADS;
+  static_assert( nparts <= UINT16_MAX );
+
+  auto const nelems    = static_cast<int32_t>(elems.size());
+  auto const chunksize = (nelems + nchunks - 1) / nchunks;
+
+  // (partitions use the high bits of the hash, the map uses the low ones)
+  auto const get_partition = [](glm::ivec3 const& key) {
+    return static_cast<uint16_t>((uint64_t(AttribIndexMap::Hash(key)) * nparts) >> 32u);
+  };
+
+  // 1) Bucket elements indices per partition, keeping their order.
+  std::vector<uint16_t> partitions(nelems);
+  std::vector<int32_t> offsets(nchunks * nparts, 0);
+
+  #pragma omp parallel for schedule(static) num_threads(LOOP_NTHREADS)
+  for (int32_t c = 0; c < nchunks; ++c) {
+    int32_t const last = std::min(nelems, (c + 1) * chunksize);
+    auto *counts = &offsets[c * nparts];
+    for (int32_t i = c * chunksize; i < last; ++i) {
+      auto const p = get_partition(elems[i]);
+      partitions[i] = p;
+      ++counts[p];
+    }
+  }
+
+  std::vector<int32_t> partition_offsets(nparts + 1, 0);
+  for (int32_t p = 0, offset = 0; p < nparts; ++p) {
+    partition_offsets[p] = offset;
+    for (int32_t c = 0; c < nchunks; ++c) {
+      auto &count = offsets[c * nparts + p];
+      auto const n = count;
+      count = offset;
+      offset += n;
+    }
+    partition_offsets[p + 1] = offset;
+  }
+
+  std::vector<int32_t> order(nelems);
+
+  #pragma omp parallel for schedule(static) num_threads(LOOP_NTHREADS)
+  for (int32_t c = 0; c < nchunks; ++c) {
+    int32_t const last = std::min(nelems, (c + 1) * chunksize);
+    auto *chunk_offsets = &offsets[c * nparts];
+    for (int32_t i = c * chunksize; i < last; ++i) {
+      order[chunk_offsets[partitions[i]]++] = i;
+    }
+  }
+
+  // 2) Find the first element of each triplet.
+  std::vector<int32_t> firsts(nelems);
+
+  #pragma omp parallel for schedule(static) num_threads(LOOP_NTHREADS)
+  for (int32_t p = 0; p < nparts; ++p) {
+    int32_t const first = partition_offsets[p];
+    int32_t const last  = partition_offsets[p + 1];
+
+    AttribIndexMap map( static_cast<size_t>(last - first) / 3u );
+    for (int32_t j = first; j < last; ++j) {
+      auto const i = order[j];
+      firsts[i] = map.find_or_insert(elems[i], i);
+    }
+  }
+
+  // 3) Number vertices by first occurrence.
+  std::vector<int32_t> vertex_offsets(nchunks + 1, 0);
+
+  #pragma omp parallel for schedule(static) num_threads(LOOP_NTHREADS)
+  for (int32_t c = 0; c < nchunks; ++c) {
+    int32_t const last = std::min(nelems, (c + 1) * chunksize);
+    int32_t count = 0;
+    for (int32_t i = c * chunksize; i < last; ++i) {
+      count += (firsts[i] == i) ? 1 : 0;
+    }
+    vertex_offsets[c + 1] = count;
+  }
+  for (int32_t c = 0; c < nchunks; ++c) {
+    vertex_offsets[c + 1] += vertex_offsets[c];
+  }
+
+  // (order is reused to map first elements to their vertex index)
+  auto &vertex_indices = order;
+  attribIndices.resize(vertex_offsets[nchunks]);
+
+  #pragma omp parallel for schedule(static) num_threads(LOOP_NTHREADS)
+  for (int32_t c = 0; c < nchunks; ++c) {
+    int32_t const last = std::min(nelems, (c + 1) * chunksize);
+    int32_t vertex_index = vertex_offsets[c];
+    for (int32_t i = c * chunksize; i < last; ++i) {
+      if (firsts[i] == i) {
+        vertex_indices[i] = vertex_index;
+        attribIndices[vertex_index] = glm::ivec4(elems[i], i);
+        ++vertex_index;
+      }
+    }
+  }
+
+  indices.resize(nelems);
+
+  #pragma omp parallel for schedule(static) num_threads(LOOP_NTHREADS)
+  for (int32_t i = 0; i < nelems; ++i) {
+    indices[i] = static_cast<uint32_t>(vertex_indices[firsts[i]]);
+  }
+}
+
+} // namespace
 
 // ----------------------------------------------------------------------------
 
@@ -317,6 +464,8 @@ void MeshData::Sphere(MeshData &mesh, int xres, int yres, float radius) {
 void MeshData::release() {
   VertexBuffer_t().swap( vertices );
   IndexBuffer_t().swap( indices );
+  std::vector<std::string>().swap( dependencies );
+  cache = MappedCache_t();
 }
 
 // ----------------------------------------------------------------------------
@@ -382,27 +531,10 @@ bool MeshData::setup(PrimitiveType _type, RawMeshData &_raw, bool bNeedTangents)
 
     // Reindexing vertices from sparse input.
     std::vector<glm::ivec4> attribIndices;
-    attribIndices.reserve(_raw.vertices.size());
-
-    indices.reserve(_raw.elementsAttribs.size());
-    {
-      MapVec3<glm::ivec3, size_t> mapVertices;
-
-      auto const nelems = static_cast<int32_t>(_raw.elementsAttribs.size());
-      for (int i = 0; i < nelems; ++i) {
-        auto const& key = _raw.elementsAttribs[i];
-        auto const& it = mapVertices.find(key);  // 
-
-        int index = static_cast<int>(attribIndices.size());
-        if (it == mapVertices.cend()) {
-          mapVertices[key] = index;
-          attribIndices.push_back( glm::ivec4(key, i) );
-        } else {
-          index = static_cast<int32_t>(it->second);  
-        }
-        
-        indices.push_back(index);
-      }
+    if (_raw.elementsAttribs.size() < kParallelWeldThreshold) {
+      WeldVertices(_raw.elementsAttribs, indices, attribIndices);
+    } else {
+      WeldVerticesParallel(_raw.elementsAttribs, indices, attribIndices);
     }
 
     // Create an unique interleaved attribute vertices buffer.
@@ -456,13 +588,16 @@ bool MeshData::setup(RawMeshFile &meshfile, bool bNeedTangents) {
 // ----------------------------------------------------------------------------
 
 void MeshData::calculateBounds(glm::vec3 &pivot, glm::vec3 &bounds, float &radius) const {
-  auto const resultX = std::minmax_element(vertices.begin(), vertices.end(), 
+  auto const first = vertexData();
+  auto const last  = first + nvertices();
+
+  auto const resultX = std::minmax_element(first, last, 
     [](auto const &a, auto const &b) { return a.position.x < b.position.x; }
   );
-  auto const resultY = std::minmax_element(vertices.begin(), vertices.end(), 
+  auto const resultY = std::minmax_element(first, last, 
     [](auto const &a, auto const &b) { return a.position.y < b.position.y; }
   );
-  auto const resultZ = std::minmax_element(vertices.begin(), vertices.end(), 
+  auto const resultZ = std::minmax_element(first, last, 
     [](auto const &a, auto const &b) { return a.position.z < b.position.z; }
   );
 
@@ -1,9 +1,11 @@
 #ifndef BARBU_MEMORY_RESOURCES_MESHDATA_H_
 #define BARBU_MEMORY_RESOURCES_MESHDATA_H_
 
+#include <memory>
 #include <string>
 #include <vector>
 
+#include "memory/mapped_file.h"
 #include "memory/resource_manager.h"
 
 #include "utils/raw_mesh_file.h" // VertexGroups_t, RawMeshFile, MaterialFile
@@ -42,6 +44,11 @@
 //
 //    * All submeshes are considered to use the same primitive type [fixme ?].
 //
+//    * Loaded files are kept in a binary cache (see mesh_data_cache.cc). On a
+//   cache hit the attributes and elements are not copied to the host buffers
+//   but read directly from the mapped cache file, hence the host data should
+//   be accessed via vertexData() / skinningData() / indexData().
+//
 // ----------------------------------------------------------------------------
 
 //
@@ -100,6 +107,22 @@ struct MeshData : public Resource {
   // [tmp ? might become its own resource]
   SkeletonHandle    skeleton = nullptr; //
 
+  // External files the mesh was built from (material file, buffers, textures),
+  // used to invalidate its cache entry.
+  std::vector<std::string> dependencies;
+
+  // Memory-mapped cache file holding the attributes & elements when the mesh
+  // was reloaded from the mesh cache (the host buffers are then left empty).
+  struct MappedCache_t {
+    std::shared_ptr<MappedFile> file;
+    Vertex_t const*   vertices  = nullptr;
+    Skinning_t const* skinnings = nullptr;
+    uint32_t const*   indices   = nullptr;
+    size_t nvertices  = 0;
+    size_t nskinnings = 0;
+    size_t nindices   = 0;
+  } cache;
+
   // -------------------
 
   /* Setup from a RawMeshData of specified primitive type. */
@@ -109,19 +132,41 @@ struct MeshData : public Resource {
   void release() final;
 
   inline bool loaded() const noexcept final { 
-    return !vertices.empty();
+    return nvertices() > 0;
   }
 
   /* Calculate the pivot and bound for the current vertices data. */
   void calculateBounds(glm::vec3 &pivot, glm::vec3 &bounds, float &radius) const;
 
+  // -- Host data accessors, either from the host buffers or the mapped cache.
+
+  inline Vertex_t const* vertexData() const noexcept {
+    return cache.file ? cache.vertices : vertices.data();
+  }
+
+  inline Skinning_t const* skinningData() const noexcept {
+    return cache.file ? cache.skinnings : skinnings.data();
+  }
+
+  inline uint32_t const* indexData() const noexcept {
+    return cache.file ? cache.indices : indices.data();
+  }
+
   inline int32_t nvertices() const { 
-    return static_cast<int32_t>(vertices.size()); 
+    return static_cast<int32_t>(cache.file ? cache.nvertices : vertices.size()); 
+  }
+
+  inline int32_t nskinnings() const { 
+    return static_cast<int32_t>(cache.file ? cache.nskinnings : skinnings.size()); 
+  }
+
+  inline int32_t nindices() const { 
+    return static_cast<int32_t>(cache.file ? cache.nindices : indices.size()); 
   }
   
   /* Return the number of primitives for the whole mesh. */
   inline int32_t nfaces() const { 
-    size_t nelems = indices.size();
+    size_t nelems = static_cast<size_t>(nindices());
     switch (type) {
       case TRIANGLES:
         nelems /= 3;
@@ -161,9 +206,23 @@ struct MeshData : public Resource {
 
 class MeshDataManager : public ResourceManager<MeshData> {
  public:
+  // Store loaded meshes to a binary cache, to bypass their parsing on reload.
+  static constexpr bool kEnableMeshCache = true;
+
+  // Extract the root motion of the skeletal animation clips once loaded.
+  // (it is put back on the root pose of the skins not moved by it)
+  static constexpr bool kEnableRootMotion = true;
+
+  // Compress the skeletal animation clips once loaded.
+  static constexpr bool kEnableClipCompression = true;
+
   /* Return true if the extension is supported by the manager. */
   static bool CheckExtension(std::string_view ext);
 
+  /* Parse an OBJ file to raw meshes, serially or in concurrent chunks (nchunks
+   * forces their count, 0 derives it from the file size). */
+  static bool ParseFileOBJ(std::string_view filename, RawMeshFile &meshfile, bool bChunked = true, int32_t nchunks = 0);
+
  private:
   Handle _load(ResourceId const& id) final;
   Handle _load_internal(ResourceId const& id, int32_t size, void const* data, std::string_view mime_type) final { return Handle(); }
@@ -171,6 +230,21 @@ class MeshDataManager : public ResourceManager<MeshData> {
   /* Load file as single mesh. */
   bool load_obj(std::string_view filename, MeshData &mesh);
   bool load_gltf(std::string_view filename, MeshData &mesh);
+
+  /* Register the textures embedded in a GLTF file, used on mesh cache hits. */
+  bool load_gltf_textures(std::string_view filename);
+
+  /* Reload a mesh from the binary cache, return false when missing or outdated. */
+  bool load_cache(std::string_view filename, MeshData &mesh);
+
+  /* Store a loaded mesh to the binary cache. */
+  bool save_cache(std::string_view filename, MeshData const& mesh);
+
+  /* Move the root motion of the animation clips of a loaded mesh to their tracks. */
+  void extract_root_motion(MeshData &mesh);
+
+  /* Compress the animation clips of a loaded mesh, reporting their statistics. */
+  void compress_clips(MeshData &mesh);
 };
 
 // ----------------------------------------------------------------------------
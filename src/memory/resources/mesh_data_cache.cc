@@ -0,0 +1,610 @@
+#include "memory/resources/mesh_data.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+
+// ----------------------------------------------------------------------------
+//
+// Binary mesh cache.
+//
+// Each loaded mesh file is stored as a single binary file in CACHE_DIR/meshes,
+// named after the hash of its source path :
+//
+//    [ Header ][ Vertices ][ Skinnings ][ Indices ][ Metadata ]
+//
+// Attributes and elements are stored raw and aligned, so they can be used in
+// place once the file is memory-mapped. Metadata (source path, vertex groups,
+// materials and skeleton) are small and deserialized into the MeshData. Clips
+// are stored as processed at import, with their root motion and compressed
+// tracks, so they are not reprocessed on a hit.
+//
+// An entry is valid when its source path and size match, and either its last
+// write time or its content hash match (a touched but unchanged file still hits).
+// The size and last write time of the files the mesh depends on (material file,
+// external buffers and textures) are stored with the source path and must match
+// as well.
+//
+// Note : the cache is specific to the build, it is not meant to be shipped.
+//
+// ----------------------------------------------------------------------------
+
+namespace {
+
+constexpr uint32_t kCacheMagic      = 0x48534D42; // "BMSH"
+constexpr uint32_t kCacheVersion    = 4u;
+constexpr uint64_t kCacheAlignment  = 16u;
+
+// Size stored for a dependency missing when the cache was written.
+constexpr uint64_t kMissingFileSize = ~uint64_t(0u);
+
+struct CacheHeader_t {
+  uint32_t magic;
+  uint32_t version;
+
+  // (used to check the data layout)
+  uint32_t vertex_bytesize;
+  uint32_t skinning_bytesize;
+
+  // Source file identification.
+  uint64_t source_size;
+  int64_t  source_mtime;
+  uint64_t source_hash;
+
+  uint32_t type;
+  uint32_t padding_;
+
+  uint64_t nvertices;
+  uint64_t nskinnings;
+  uint64_t nindices;
+
+  // Sections offsets from the start of the file.
+  uint64_t vertices_offset;
+  uint64_t skinnings_offset;
+  uint64_t indices_offset;
+  uint64_t metadata_offset;
+  uint64_t metadata_size;
+};
+
+inline uint64_t AlignOffset(uint64_t offset) {
+  return (offset + kCacheAlignment - 1u) & ~(kCacheAlignment - 1u);
+}
+
+std::string GetCacheFilename(std::string_view filename) {
+  char hexname[32]{};
+  auto const h = std::hash<std::string_view>{}(filename);
+  sprintf(hexname, "%016llx.bin", static_cast<unsigned long long>(h));
+  return std::string(CACHE_DIR "/meshes/") + hexname;
+}
+
+int64_t GetLastWriteTime(std::string_view filename) {
+  std::error_code ec;
+  auto const t = fs::last_write_time( fs::path(std::string(filename)), ec);
+  return ec ? 0 : static_cast<int64_t>(t.time_since_epoch().count());
+}
+
+// Retrieve the size and last write time of a file, kMissingFileSize when it does not exist.
+void GetFileStamp(std::string const& filename, uint64_t &size, int64_t &mtime) {
+  std::error_code ec;
+  auto const filesize = fs::file_size( fs::path(filename), ec);
+  size  = ec ? kMissingFileSize : static_cast<uint64_t>(filesize);
+  mtime = ec ? 0 : GetLastWriteTime(filename);
+}
+
+// Hash the whole content of a file, return false when it could not be read.
+bool HashFile(std::string_view filename, uint64_t &hash, uint64_t &size) {
+  MappedFile file;
+  if (!file.open(filename)) {
+    return false;
+  }
+  hash = std::hash<std::string_view>{}(std::string_view(file.data(), file.size()));
+  size = file.size();
+  return true;
+}
+
+// Update the source timestamp of a cache file in place.
+void UpdateCacheTimestamp(std::string const& cachename, int64_t mtime) {
+  FILE *fd = fopen( cachename.c_str(), "r+b");
+  if (nullptr == fd) {
+    return;
+  }
+  fseek(fd, static_cast<long>(offsetof(CacheHeader_t, source_mtime)), SEEK_SET);
+  fwrite(&mtime, sizeof(mtime), 1u, fd);
+  fclose(fd);
+}
+
+// ----------------------------------------------------------------------------
+
+// Serialize trivially copyable values, strings and arrays to a byte buffer.
+class BlobWriter {
+ public:
+  template<typename T>
+  void write(T const& v) {
+    static_assert( std::is_trivially_copyable<T>::value, "BlobWriter : unsupported type." );
+    write_bytes(&v, sizeof(T));
+  }
+
+  void write(std::string const& s) {
+    write( static_cast<uint32_t>(s.size()) );
+    write_bytes(s.data(), s.size());
+  }
+
+  template<typename T>
+  void write(std::vector<T> const& v) {
+    write( static_cast<uint32_t>(v.size()) );
+    if constexpr (std::is_trivially_copyable<T>::value) {
+      write_bytes(v.data(), v.size() * sizeof(T));
+    } else {
+      for (auto const& e : v) {
+        write(e);
+      }
+    }
+  }
+
+  inline std::vector<char> const& bytes() const noexcept {
+    return bytes_;
+  }
+
+ private:
+  void write_bytes(void const* data, size_t bytesize) {
+    auto const ptr = static_cast<char const*>(data);
+    bytes_.insert(bytes_.end(), ptr, ptr + bytesize);
+  }
+
+  std::vector<char> bytes_;
+};
+
+// Deserialize data written by a BlobWriter, checking for out of bounds reads.
+class BlobReader {
+ public:
+  BlobReader(char const* data, size_t bytesize)
+    : cur_(data)
+    , end_(data + bytesize)
+  {}
+
+  template<typename T>
+  void read(T &v) {
+    static_assert( std::is_trivially_copyable<T>::value, "BlobReader : unsupported type." );
+    read_bytes(&v, sizeof(T));
+  }
+
+  void read(std::string &s) {
+    uint32_t n = 0u;
+    read(n);
+    if (check(n)) {
+      s.assign(cur_, n);
+      cur_ += n;
+    }
+  }
+
+  template<typename T>
+  void read(std::vector<T> &v) {
+    uint32_t n = 0u;
+    read(n);
+    if constexpr (std::is_trivially_copyable<T>::value) {
+      if (check(n * sizeof(T))) {
+        v.resize(n);
+        memcpy(v.data(), cur_, n * sizeof(T));
+        cur_ += n * sizeof(T);
+      }
+    } else {
+      // (every element takes at least 4 bytes)
+      if (check(n * sizeof(uint32_t))) {
+        v.resize(n);
+        for (auto &e : v) {
+          read(e);
+        }
+      }
+    }
+  }
+
+  inline bool valid() const noexcept {
+    return bValid_;
+  }
+
+ private:
+  bool check(size_t bytesize) {
+    bValid_ = bValid_ && (bytesize <= static_cast<size_t>(end_ - cur_));
+    return bValid_;
+  }
+
+  void read_bytes(void *data, size_t bytesize) {
+    if (check(bytesize)) {
+      memcpy(data, cur_, bytesize);
+      cur_ += bytesize;
+    }
+  }
+
+  char const* cur_;
+  char const* end_;
+  bool bValid_ = true;
+};
+
+} // namespace
+
+// ----------------------------------------------------------------------------
+
+bool MeshDataManager::load_cache(std::string_view filename, MeshData &meshdata) {
+  auto const cachename{ GetCacheFilename(filename) };
+
+  auto file = std::make_shared<MappedFile>();
+  if (!file->open(cachename) || (file->size() < sizeof(CacheHeader_t))) {
+    return false;
+  }
+  auto const filesize = static_cast<uint64_t>(file->size());
+
+  // Check the header.
+  CacheHeader_t header;
+  memcpy(&header, file->data(), sizeof(header));
+
+  if ((header.magic != kCacheMagic)
+   || (header.version != kCacheVersion)
+   || (header.vertex_bytesize != sizeof(MeshData::Vertex_t))
+   || (header.skinning_bytesize != sizeof(MeshData::Skinning_t))
+   || (header.type >= MeshData::kNumPrimitiveType)) {
+    return false;
+  }
+
+  auto const in_bounds = [filesize](uint64_t offset, uint64_t count, uint64_t stride) {
+    return (offset <= filesize) && (count <= (filesize - offset) / stride);
+  };
+  if (!in_bounds(header.vertices_offset,  header.nvertices,     sizeof(MeshData::Vertex_t))
+   || !in_bounds(header.skinnings_offset, header.nskinnings,    sizeof(MeshData::Skinning_t))
+   || !in_bounds(header.indices_offset,   header.nindices,      sizeof(uint32_t))
+   || !in_bounds(header.metadata_offset,  header.metadata_size, 1u)) {
+    LOG_WARNING( "Corrupted mesh cache :", cachename );
+    return false;
+  }
+
+  BlobReader blob( file->data() + header.metadata_offset, header.metadata_size);
+
+  // Check the source path, in case of hash collision.
+  std::string source;
+  blob.read(source);
+  if (!blob.valid() || (source != filename)) {
+    return false;
+  }
+
+  // Check the source has not changed.
+  std::error_code ec;
+  auto const source_size = fs::file_size( fs::path(source), ec);
+  if (ec || (static_cast<uint64_t>(source_size) != header.source_size)) {
+    return false;
+  }
+  if (auto const mtime = GetLastWriteTime(filename); mtime != header.source_mtime) {
+    uint64_t hash = 0u;
+    uint64_t size = 0u;
+    if (!HashFile(filename, hash, size) || (hash != header.source_hash)) {
+      return false;
+    }
+    // The file was touched but is unchanged, avoid hashing it on the next load.
+    UpdateCacheTimestamp( cachename, mtime);
+  }
+
+  // Check the dependencies have not changed.
+  std::vector<std::string> dependencies;
+  {
+    uint32_t count = 0u;
+    blob.read(count);
+    for (uint32_t i = 0u; blob.valid() && (i < count); ++i) {
+      std::string path;
+      uint64_t size = 0u;
+      int64_t mtime = 0;
+      blob.read(path);
+      blob.read(size);
+      blob.read(mtime);
+
+      uint64_t current_size = 0u;
+      int64_t current_mtime = 0;
+      GetFileStamp( path, current_size, current_mtime);
+      if (blob.valid() && ((current_size != size) || (current_mtime != mtime))) {
+        return false;
+      }
+      dependencies.push_back(path);
+    }
+  }
+
+  // -- Metadata.
+
+  // Vertex groups.
+  VertexGroups_t vgroups;
+  {
+    uint32_t count = 0u;
+    blob.read(count);
+    for (uint32_t i = 0u; blob.valid() && (i < count); ++i) {
+      VertexGroup vg;
+      blob.read(vg.name);
+      blob.read(vg.start_index);
+      blob.read(vg.end_index);
+      vgroups.push_back(vg);
+    }
+  }
+
+  // Materials.
+  MaterialFile material;
+  {
+    blob.read(material.id);
+    uint32_t count = 0u;
+    blob.read(count);
+    for (uint32_t i = 0u; blob.valid() && (i < count); ++i) {
+      MaterialInfo info;
+      blob.read(info.name);
+      blob.read(info.diffuse_map);
+      blob.read(info.specular_map);
+      blob.read(info.emissive_map);
+      blob.read(info.metallic_rough_map);
+      blob.read(info.bump_map);
+      blob.read(info.ao_map);
+      blob.read(info.alpha_map);
+      blob.read(info.diffuse_color);
+      blob.read(info.specular_color);
+      blob.read(info.emissive_factor);
+      blob.read(info.metallic);
+      blob.read(info.roughness);
+      blob.read(info.alpha_cutoff);
+      blob.read(info.bAlphaTest);
+      blob.read(info.bBlending);
+      blob.read(info.bDoubleSided);
+      blob.read(info.bUnlit);
+      material.infos.push_back(info);
+    }
+  }
+
+  // Skeleton & animations.
+  SkeletonHandle skeleton = nullptr;
+  {
+    uint8_t has_skeleton = 0u;
+    blob.read(has_skeleton);
+
+    if (has_skeleton) {
+      skeleton = std::make_shared<Skeleton>();
+      blob.read(skeleton->names);
+      blob.read(skeleton->parents);
+      blob.read(skeleton->inverse_bind_matrices);
+      blob.read(skeleton->root_parent_matrix);
+
+      auto const njoints = skeleton->inverse_bind_matrices.size();
+      if ((skeleton->names.size() != njoints) || (skeleton->parents.size() != njoints)) {
+        LOG_WARNING( "Corrupted mesh cache :", cachename );
+        return false;
+      }
+      for (size_t i = 0u; i < njoints; ++i) {
+        skeleton->index_map[skeleton->names[i]] = static_cast<int32_t>(i);
+      }
+
+      uint32_t nclips = 0u;
+      blob.read(nclips);
+      for (uint32_t i = 0u; blob.valid() && (i < nclips); ++i) {
+        AnimationClip_t clip;
+        blob.read(clip.name);
+        blob.read(clip.bLoop);
+        blob.read(clip.framecount);
+        blob.read(clip.framerate);
+
+        // (bound the samples count by the metadata size against corrupted data)
+        uint32_t nsamples = 0u;
+        blob.read(nsamples);
+        clip.samples.resize(blob.valid() ? std::min<size_t>(nsamples, header.metadata_size) : 0u);
+        for (auto &sample : clip.samples) {
+          blob.read(sample.joints);
+        }
+
+        auto &cc = clip.compressed;
+        blob.read(cc.rotation_tracks);
+        blob.read(cc.translation_tracks);
+        blob.read(cc.scale_tracks);
+        blob.read(cc.translation_ranges);
+        blob.read(cc.scale_ranges);
+        blob.read(cc.rotation_frames);
+        blob.read(cc.translation_frames);
+        blob.read(cc.scale_frames);
+        blob.read(cc.rotation_keys);
+        blob.read(cc.translation_keys);
+        blob.read(cc.scale_keys);
+
+        auto &rm = clip.root_motion;
+        blob.read(rm.translations);
+        blob.read(rm.yaws);
+        blob.read(rm.pivot);
+
+        skeleton->clips.push_back(clip);
+      }
+    }
+  }
+
+  if (!blob.valid()) {
+    LOG_WARNING( "Corrupted mesh cache :", cachename );
+    return false;
+  }
+
+  // -- Fill the MeshData, buffers are used directly from the mapped file.
+
+  meshdata.type     = static_cast<MeshData::PrimitiveType>(header.type);
+  meshdata.vgroups  = std::move(vgroups);
+  meshdata.material = std::move(material);
+  meshdata.skeleton = skeleton;
+  meshdata.dependencies = std::move(dependencies);
+
+  auto &cache = meshdata.cache;
+  auto const base = file->data();
+  cache.vertices    = reinterpret_cast<MeshData::Vertex_t const*>(base + header.vertices_offset);
+  cache.skinnings   = (header.nskinnings > 0u) ? reinterpret_cast<MeshData::Skinning_t const*>(base + header.skinnings_offset) : nullptr;
+  cache.indices     = reinterpret_cast<uint32_t const*>(base + header.indices_offset);
+  cache.nvertices   = static_cast<size_t>(header.nvertices);
+  cache.nskinnings  = static_cast<size_t>(header.nskinnings);
+  cache.nindices    = static_cast<size_t>(header.nindices);
+  cache.file        = file;
+
+  return true;
+}
+
+// ----------------------------------------------------------------------------
+
+bool MeshDataManager::save_cache(std::string_view filename, MeshData const& meshdata) {
+  CacheHeader_t header{};
+
+  header.magic              = kCacheMagic;
+  header.version            = kCacheVersion;
+  header.vertex_bytesize    = sizeof(MeshData::Vertex_t);
+  header.skinning_bytesize  = sizeof(MeshData::Skinning_t);
+
+  if (!HashFile(filename, header.source_hash, header.source_size)) {
+    return false;
+  }
+  header.source_mtime = GetLastWriteTime(filename);
+  header.type         = static_cast<uint32_t>(meshdata.type);
+
+  header.nvertices  = static_cast<uint64_t>(meshdata.nvertices());
+  header.nskinnings = static_cast<uint64_t>(meshdata.nskinnings());
+  header.nindices   = static_cast<uint64_t>(meshdata.nindices());
+
+  // -- Metadata.
+  BlobWriter blob;
+  blob.write( std::string(filename) );
+
+  // Dependencies.
+  blob.write( static_cast<uint32_t>(meshdata.dependencies.size()) );
+  for (auto const& path : meshdata.dependencies) {
+    uint64_t size = 0u;
+    int64_t mtime = 0;
+    GetFileStamp( path, size, mtime);
+    blob.write(path);
+    blob.write(size);
+    blob.write(mtime);
+  }
+
+  // Vertex groups.
+  blob.write( static_cast<uint32_t>(meshdata.vgroups.size()) );
+  for (auto const& vg : meshdata.vgroups) {
+    blob.write(vg.name);
+    blob.write(vg.start_index);
+    blob.write(vg.end_index);
+  }
+
+  // Materials.
+  auto const& mtl = meshdata.material;
+  blob.write(mtl.id);
+  blob.write( static_cast<uint32_t>(mtl.infos.size()) );
+  for (auto const& info : mtl.infos) {
+    blob.write(info.name);
+    blob.write(info.diffuse_map);
+    blob.write(info.specular_map);
+    blob.write(info.emissive_map);
+    blob.write(info.metallic_rough_map);
+    blob.write(info.bump_map);
+    blob.write(info.ao_map);
+    blob.write(info.alpha_map);
+    blob.write(info.diffuse_color);
+    blob.write(info.specular_color);
+    blob.write(info.emissive_factor);
+    blob.write(info.metallic);
+    blob.write(info.roughness);
+    blob.write(info.alpha_cutoff);
+    blob.write(info.bAlphaTest);
+    blob.write(info.bBlending);
+    blob.write(info.bDoubleSided);
+    blob.write(info.bUnlit);
+  }
+
+  // Skeleton & animations.
+  auto const& skl = meshdata.skeleton;
+  blob.write( static_cast<uint8_t>(skl ? 1u : 0u) );
+  if (skl) {
+    blob.write(skl->names);
+    blob.write(skl->parents);
+    blob.write(skl->inverse_bind_matrices);
+    blob.write(skl->root_parent_matrix);
+
+    blob.write( static_cast<uint32_t>(skl->clips.size()) );
+    for (auto const& clip : skl->clips) {
+      blob.write(clip.name);
+      blob.write(clip.bLoop);
+      blob.write(clip.framecount);
+      blob.write(clip.framerate);
+      blob.write( static_cast<uint32_t>(clip.samples.size()) );
+      for (auto const& sample : clip.samples) {
+        blob.write(sample.joints);
+      }
+
+      // (empty when the clip is not compressed)
+      auto const& cc = clip.compressed;
+      blob.write(cc.rotation_tracks);
+      blob.write(cc.translation_tracks);
+      blob.write(cc.scale_tracks);
+      blob.write(cc.translation_ranges);
+      blob.write(cc.scale_ranges);
+      blob.write(cc.rotation_frames);
+      blob.write(cc.translation_frames);
+      blob.write(cc.scale_frames);
+      blob.write(cc.rotation_keys);
+      blob.write(cc.translation_keys);
+      blob.write(cc.scale_keys);
+
+      // (empty when the clip has no root motion)
+      auto const& rm = clip.root_motion;
+      blob.write(rm.translations);
+      blob.write(rm.yaws);
+      blob.write(rm.pivot);
+    }
+  }
+
+  // -- Layout.
+  uint64_t const vertices_bytesize  = header.nvertices * sizeof(MeshData::Vertex_t);
+  uint64_t const skinnings_bytesize = header.nskinnings * sizeof(MeshData::Skinning_t);
+  uint64_t const indices_bytesize   = header.nindices * sizeof(uint32_t);
+
+  header.vertices_offset  = AlignOffset(sizeof(CacheHeader_t));
+  header.skinnings_offset = AlignOffset(header.vertices_offset + vertices_bytesize);
+  header.indices_offset   = AlignOffset(header.skinnings_offset + skinnings_bytesize);
+  header.metadata_offset  = AlignOffset(header.indices_offset + indices_bytesize);
+  header.metadata_size    = blob.bytes().size();
+
+  // -- Write.
+  auto const cachename{ GetCacheFilename(filename) };
+
+  std::error_code ec;
+  fs::create_directories( fs::path(cachename).parent_path(), ec);
+
+  // Write to a temporary file renamed afterwards, so a partial file is never read.
+  std::string const tmpname = cachename + ".tmp";
+  FILE *fd = fopen( tmpname.c_str(), "wb");
+  if (nullptr == fd) {
+    LOG_WARNING( "Failed to create the mesh cache :", tmpname );
+    return false;
+  }
+
+  uint64_t cursor = 0u;
+  bool bSucceed = true;
+  auto const write_section = [fd, &cursor, &bSucceed](uint64_t offset, void const* data, uint64_t bytesize) {
+    constexpr char kPadding[kCacheAlignment]{};
+    if (bSucceed && (offset > cursor)) {
+      bSucceed = (fwrite(kPadding, 1u, offset - cursor, fd) == offset - cursor);
+    }
+    if (bSucceed && (bytesize > 0u)) {
+      bSucceed = (fwrite(data, 1u, bytesize, fd) == bytesize);
+    }
+    cursor = offset + bytesize;
+  };
+
+  write_section( 0u,                      &header,                 sizeof(header));
+  write_section( header.vertices_offset,  meshdata.vertexData(),   vertices_bytesize);
+  write_section( header.skinnings_offset, meshdata.skinningData(), skinnings_bytesize);
+  write_section( header.indices_offset,   meshdata.indexData(),    indices_bytesize);
+  write_section( header.metadata_offset,  blob.bytes().data(),     header.metadata_size);
+  fclose(fd);
+
+  if (bSucceed) {
+    fs::rename( fs::path(tmpname), fs::path(cachename), ec);
+    bSucceed = !ec;
+  }
+  if (!bSucceed) {
+    LOG_WARNING( "Failed to write the mesh cache :", cachename );
+    fs::remove( fs::path(tmpname), ec);
+  }
+
+  return bSucceed;
+}
+
+// ----------------------------------------------------------------------------
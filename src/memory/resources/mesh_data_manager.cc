@@ -1,14 +1,27 @@
 #include "memory/resources/mesh_data.h"
 
+#include <algorithm>
 #include <clocale>
+#include <cstdlib>
+#include <cstring>
+#include <type_traits>
 #include "glm/gtc/type_ptr.hpp"
 
 #define CGLTF_IMPLEMENTATION
 #include "cgltf/cgltf.h"
+#include "fx/animation/clip_compression.h"
+#include "fx/animation/cpu_skinning.h"
+#include "fx/animation/root_motion.h"
 
 #include "memory/assets/assets.h"
 #include "utils/mathutils.h"
 
+#ifdef BARBU_NPROC_MAX
+#define LOOP_NTHREADS  (BARBU_NPROC_MAX)
+#else
+#define LOOP_NTHREADS  4
+#endif
+
 // ----------------------------------------------------------------------------
 
 namespace {
@@ -235,6 +248,385 @@ void ParseOBJ(char *input, RawMeshFile &meshfile, bool bSeparateObjects) {
   }
 }
 
+// -- Chunked OBJ parser.
+//
+// The input is split into newline-aligned chunks parsed concurrently, then
+// merged in order. It produces the same RawMeshFile as ParseOBJ (for a single
+// object) with a custom scanner matching sscanf on the formats used.
+//
+// Chunks are parsed in two passes : the first one reads the vertices attributes,
+// the second one the faces, whose format depends on the attributes defined
+// before them in the whole file.
+
+// Minimum bytesize of a chunk.
+constexpr size_t kOBJChunkMinBytesize = 1u << 20u;
+
+// Max length of a name token, as with "%128s".
+constexpr size_t kOBJNameMaxLength = 128u;
+
+struct OBJChunk_t {
+  char const* begin = nullptr;
+  char const* end   = nullptr;
+
+  // Attributes.
+  std::vector<glm::vec3> vertices;
+  std::vector<glm::vec2> texcoords;
+  std::vector<glm::vec3> normals;
+
+  // Faces.
+  std::vector<glm::ivec3> elementsAttribs;
+
+  // Vertex groups started in the chunk, with their first element local index.
+  std::vector<std::pair<std::string, int32_t>> vgroups;
+
+  // Last material file referenced in the chunk, if any.
+  std::string material_id;
+
+  // Start of the first texcoord / normal line in the chunk, or its end.
+  char const* first_texcoord = nullptr;
+  char const* first_normal   = nullptr;
+};
+
+inline bool IsSpace(char c) {
+  return (c == ' ') || (c == '\t') || (c == '\n') || (c == '\r') || (c == '\v') || (c == '\f');
+}
+
+inline bool IsDigit(char c) {
+  return (c >= '0') && (c <= '9');
+}
+
+inline char const* SkipSpaces(char const* p, char const* end) {
+  while ((p < end) && IsSpace(*p)) {
+    ++p;
+  }
+  return p;
+}
+
+// Scan a signed integer as "%d", return nullptr on failure.
+char const* ScanInt(char const* p, char const* end, int32_t &value) {
+  p = SkipSpaces(p, end);
+
+  bool bNegative = false;
+  if ((p < end) && ((*p == '-') || (*p == '+'))) {
+    bNegative = (*p == '-');
+    ++p;
+  }
+  if ((p >= end) || !IsDigit(*p)) {
+    return nullptr;
+  }
+
+  int64_t n = 0;
+  for (; (p < end) && IsDigit(*p); ++p) {
+    n = 10 * n + (*p - '0');
+  }
+  value = static_cast<int32_t>(bNegative ? -n : n);
+
+  return p;
+}
+
+// Scan a floating point value as "%f", return nullptr on failure.
+//
+// Simple decimals exactly representable as a float fraction are computed
+// directly (a single correctly rounded division), others fallback to strtof.
+char const* ScanFloat(char const* p, char const* end, float &value) {
+  constexpr float kPowersOf10[] {
+    1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f
+  };
+  constexpr uint64_t kMaxExactMantissa = 1u << 24u;
+  constexpr int32_t kMaxExactExponent  = 10;
+
+  p = SkipSpaces(p, end);
+  char const* const start = p;
+
+  bool bNegative = false;
+  if ((p < end) && ((*p == '-') || (*p == '+'))) {
+    bNegative = (*p == '-');
+    ++p;
+  }
+
+  uint64_t mantissa = 0u;
+  int32_t ndigits   = 0;
+  int32_t exponent  = 0;
+  for (; (p < end) && IsDigit(*p) && (ndigits < 18); ++p, ++ndigits) {
+    mantissa = 10u * mantissa + static_cast<uint64_t>(*p - '0');
+  }
+  if ((p < end) && (*p == '.')) {
+    for (++p; (p < end) && IsDigit(*p) && (ndigits < 18); ++p, ++ndigits, ++exponent) {
+      mantissa = 10u * mantissa + static_cast<uint64_t>(*p - '0');
+    }
+  }
+
+  bool const bFastPath = (ndigits > 0)
+                      && (mantissa <= kMaxExactMantissa)
+                      && (exponent <= kMaxExactExponent)
+                      && ((p >= end) || IsSpace(*p))
+                      ;
+  if (bFastPath) {
+    value = static_cast<float>(mantissa) / kPowersOf10[exponent];
+    value = bNegative ? -value : value;
+    return p;
+  }
+
+  // Fallback on a null-terminated copy of the token.
+  char token[64]{};
+  size_t len = 0u;
+  for (p = start; (p < end) && !IsSpace(*p) && (len < sizeof(token) - 1u); ++p) {
+    token[len++] = *p;
+  }
+  char *token_end = nullptr;
+  float const v = strtof(token, &token_end);
+  if (token_end == token) {
+    return nullptr;
+  }
+  value = v;
+
+  return start + (token_end - token);
+}
+
+// Scan up to count floating point values separated by spaces, as "%f %f ..".
+void ScanFloats(char const* p, char const* end, float *values, int32_t count) {
+  for (int32_t i = 0; (i < count) && (p = ScanFloat(p, end, values[i])); ++i) {}
+}
+
+// Scan a name token as "%128s".
+std::string ScanName(char const* p, char const* end) {
+  p = SkipSpaces(p, end);
+  char const* first = p;
+  while ((p < end) && !IsSpace(*p) && (static_cast<size_t>(p - first) < kOBJNameMaxLength)) {
+    ++p;
+  }
+  return std::string(first, p);
+}
+
+// Scan up to 4 face vertices as sscanf would with "%d/%d/%d %d/%d/%d ..",
+// "%d/%d ..", "%d//%d .." or "%d ..", depending on available attributes.
+void ScanFace(char const* p, char const* end, bool has_texcoords, bool has_normals, glm::ivec3 (&face)[4]) {
+  for (auto &vertex : face) {
+    if (!(p = ScanInt(p, end, vertex.x))) {
+      return;
+    }
+    if (has_texcoords) {
+      if ((p >= end) || (*p != '/') || !(p = ScanInt(p + 1, end, vertex.y))) {
+        return;
+      }
+    }
+    if (has_normals) {
+      if (!has_texcoords) {
+        if ((end - p < 2) || (p[0] != '/')) {
+          return;
+        }
+        ++p;
+      }
+      if ((p >= end) || (*p != '/') || !(p = ScanInt(p + 1, end, vertex.z))) {
+        return;
+      }
+    }
+  }
+}
+
+// Call func(line_begin, line_end) for each line of the chunk.
+template<typename F>
+void ForEachLineOBJ(OBJChunk_t const& chunk, F func) {
+  for (char const* s = chunk.begin; s < chunk.end;) {
+    auto eol = static_cast<char const*>(memchr(s, '\n', static_cast<size_t>(chunk.end - s)));
+    eol = eol ? eol : chunk.end;
+    func(s, eol);
+    s = eol + 1;
+  }
+}
+
+// First pass : parse vertices attributes & material file.
+void ParseOBJChunkAttributes(OBJChunk_t &chunk) {
+  chunk.first_texcoord = chunk.end;
+  chunk.first_normal   = chunk.end;
+
+  ForEachLineOBJ(chunk, [&chunk](char const* s, char const* eol) {
+    char const c0 = (s < eol) ? s[0] : '\0';
+    char const c1 = (s + 1 < eol) ? s[1] : '\0';
+
+    // MATERIAL FILE ID (mtlib)
+    if ((c0 == 'm') && (c1 == 't')) {
+      chunk.material_id = ScanName(std::min(s + 7, eol), eol);
+      return;
+    }
+    if (c0 != 'v') {
+      return;
+    }
+
+    glm::vec3 v(0.0f);
+    if (c1 == ' ') {
+      ScanFloats(s + 2, eol, glm::value_ptr(v), 3);
+      chunk.vertices.push_back(v);
+    } else if (c1 == 't') {
+      ScanFloats(std::min(s + 3, eol), eol, glm::value_ptr(v), 2);
+      v.y = 1.0f - v.y; // (reverse y)
+      chunk.texcoords.push_back(glm::vec2(v.x, v.y));
+      chunk.first_texcoord = std::min(chunk.first_texcoord, s);
+    } else {
+      ScanFloats(std::min(s + 3, eol), eol, glm::value_ptr(v), 3);
+      chunk.normals.push_back(v);
+      chunk.first_normal = std::min(chunk.first_normal, s);
+    }
+  });
+}
+
+// Second pass : parse faces & vertex groups, given if attributes were defined
+// in previous chunks.
+void ParseOBJChunkFaces(OBJChunk_t &chunk, bool has_prev_texcoords, bool has_prev_normals) {
+  ForEachLineOBJ(chunk, [&](char const* s, char const* eol) {
+    char const c0 = (s < eol) ? s[0] : '\0';
+
+    // MATERIAL ID (usemtl)
+    if (c0 == 'u') {
+      chunk.vgroups.emplace_back(
+        ScanName(std::min(s + 7, eol), eol), static_cast<int32_t>(chunk.elementsAttribs.size())
+      );
+      return;
+    }
+    if (c0 != 'f') {
+      return;
+    }
+
+    bool const has_texcoords = has_prev_texcoords || (chunk.first_texcoord < s);
+    bool const has_normals   = has_prev_normals   || (chunk.first_normal < s);
+
+    // vertex attribute indices, will be set to 0 (-1 after postprocessing)
+    // if none exists.
+    glm::ivec3 face[4]{ glm::ivec3(0), glm::ivec3(0), glm::ivec3(0), glm::ivec3(0) };
+    ScanFace(std::min(s + 2, eol), eol, has_texcoords, has_normals, face);
+
+    auto &elems = chunk.elementsAttribs;
+    elems.push_back(face[0]);
+    elems.push_back(face[1]);
+    elems.push_back(face[2]);
+    if (face[3].x > 0) {
+      elems.push_back(face[2]);
+      elems.push_back(face[3]);
+      elems.push_back(face[0]);
+    }
+  });
+}
+
+// Parse the geometry of a whole OBJ buffer as a single object, in nchunks
+// chunks or in as many as its size needs when 0.
+void ParseOBJChunked(char const* input, size_t bytesize, RawMeshFile &meshfile, int32_t nchunks = 0) {
+  // Split the input into newline-aligned chunks.
+  if (nchunks <= 0) {
+    nchunks = static_cast<int32_t>(
+      std::clamp<size_t>(bytesize / kOBJChunkMinBytesize, 1u, LOOP_NTHREADS)
+    );
+  }
+  std::vector<OBJChunk_t> chunks(nchunks);
+  {
+    char const* const end = input + bytesize;
+    char const* s = input;
+    for (int32_t i = 0; i < nchunks; ++i) {
+      char const* last = (i + 1 < nchunks) ? input + (i + 1) * (bytesize / nchunks) : end;
+      last = std::max(s, last);
+      auto const eol = static_cast<char const*>(memchr(last, '\n', static_cast<size_t>(end - last)));
+      last = eol ? eol + 1 : end;
+      chunks[i].begin = s;
+      chunks[i].end   = last;
+      s = last;
+    }
+  }
+
+  // 1) Attributes.
+  #pragma omp parallel for schedule(static) num_threads(LOOP_NTHREADS)
+  for (int32_t i = 0; i < nchunks; ++i) {
+    ParseOBJChunkAttributes(chunks[i]);
+  }
+
+  // 2) Faces.
+  std::vector<uint8_t> has_prev_texcoords(nchunks, 0u);
+  std::vector<uint8_t> has_prev_normals(nchunks, 0u);
+  for (int32_t i = 1; i < nchunks; ++i) {
+    has_prev_texcoords[i] = has_prev_texcoords[i-1] || !chunks[i-1].texcoords.empty();
+    has_prev_normals[i]   = has_prev_normals[i-1]   || !chunks[i-1].normals.empty();
+  }
+
+  #pragma omp parallel for schedule(static) num_threads(LOOP_NTHREADS)
+  for (int32_t i = 0; i < nchunks; ++i) {
+    ParseOBJChunkFaces(chunks[i], has_prev_texcoords[i], has_prev_normals[i]);
+  }
+
+  // 3) Merge chunks in order.
+  // (OBJ indices are global to the file, only the vertex groups need rebasing)
+  if (meshfile.meshes.empty()) {
+    meshfile.meshes.resize(1);
+  }
+  auto &raw = meshfile.meshes.back();
+  {
+    size_t nvertices = 0u, ntexcoords = 0u, nnormals = 0u, nelems = 0u;
+    for (auto const& chunk : chunks) {
+      nvertices  += chunk.vertices.size();
+      ntexcoords += chunk.texcoords.size();
+      nnormals   += chunk.normals.size();
+      nelems     += chunk.elementsAttribs.size();
+    }
+    raw.vertices.reserve(nvertices);
+    raw.texcoords.reserve(ntexcoords);
+    raw.normals.reserve(nnormals);
+    raw.elementsAttribs.reserve(nelems);
+  }
+
+  for (auto &chunk : chunks) {
+    auto const elems_offset = static_cast<int32_t>(raw.elementsAttribs.size());
+
+    for (auto &[name, start_index] : chunk.vgroups) {
+      int32_t const last_vertex_index = elems_offset + start_index - 1;
+
+      // Set last index of current submesh.
+      if (!raw.vgroups.empty()) {
+        raw.vgroups.back().end_index = last_vertex_index;
+      }
+
+      // Add a new submesh.
+      VertexGroup vg;
+      vg.name = std::move(name);
+      vg.start_index = last_vertex_index + 1;
+      raw.vgroups.push_back(vg);
+    }
+
+    if (!chunk.material_id.empty()) {
+      meshfile.material_id = chunk.material_id;
+    }
+
+    raw.vertices.insert(raw.vertices.end(), chunk.vertices.cbegin(), chunk.vertices.cend());
+    raw.texcoords.insert(raw.texcoords.end(), chunk.texcoords.cbegin(), chunk.texcoords.cend());
+    raw.normals.insert(raw.normals.end(), chunk.normals.cbegin(), chunk.normals.cend());
+    raw.elementsAttribs.insert(raw.elementsAttribs.end(), chunk.elementsAttribs.cbegin(), chunk.elementsAttribs.cend());
+
+    // (release chunk memory early)
+    chunk = OBJChunk_t();
+  }
+
+  // Post-process mesh with indices.
+  if (raw.elementsAttribs.empty()) {
+    return;
+  }
+
+  // Change range of indices from [1, n] to [0, n-1].
+  auto const nelems = static_cast<int32_t>(raw.elementsAttribs.size());
+  #pragma omp parallel for schedule(static) num_threads(LOOP_NTHREADS)
+  for (int32_t i = 0; i < nelems; ++i) {
+    raw.elementsAttribs[i] -= glm::ivec3(1);
+  }
+
+  // Create a default vertex group if none were specified.
+  if (!raw.hasVertexGroups()) {
+    raw.vgroups.resize(1);
+    raw.vgroups[0].name = MeshData::kDefaultGroupName;
+  }
+
+  // Update border groups indices.
+  auto &vgroups = raw.vgroups;
+  vgroups.front().start_index = 0;
+  vgroups.back().end_index = nelems;
+}
+
+// ----------------------------------------------------------------------------
+
 void ParseMTL(char *input, MaterialFile &matfile) {
   // Check if a string match a token.
   auto check_token = [](std::string_view s, std::string_view token) {
@@ -376,25 +768,102 @@ MeshDataManager::Handle MeshDataManager::_load(ResourceId const& id) {
   std::transform(ext.cbegin(), ext.cend(), ext.begin(), ::tolower);
 
   auto &meshdata = *h.data;
+  bool const bGLTF = ("glb" == ext) || ("gltf" == ext);
+
+  // Reload from the binary cache when it is up to date.
+  // (the clips are cached once processed, with their root motion extracted and compressed)
+  if (kEnableMeshCache && load_cache(path, meshdata)) {
+    LOG_DEBUG_INFO( "Mesh reloaded from cache :", path );
+    if (bGLTF) {
+      load_gltf_textures(path);
+    }
+    if (meshdata.skeleton) {
+      CalculateJointBounds(meshdata, *meshdata.skeleton);
+    }
+    return h;
+  }
 
+  bool bLoaded = false;
   if ("obj" == ext) {
-    load_obj(path, meshdata);
-  } else if (("glb" == ext) || ("gltf" == ext)) {
-    load_gltf(path, meshdata);
+    bLoaded = load_obj(path, meshdata);
+  } else if (bGLTF) {
+    bLoaded = load_gltf(path, meshdata);
   } else {
     LOG_WARNING(ext, "models are not supported.");
   }
 
+  if (kEnableRootMotion && bLoaded) {
+    extract_root_motion(meshdata);
+  }
+
+  if (kEnableClipCompression && bLoaded) {
+    compress_clips(meshdata);
+  }
+
+  if (kEnableMeshCache && bLoaded) {
+    save_cache(path, meshdata);
+  }
+
+  // Bound the skinned vertices per joint, to bound the animated mesh.
+  if (bLoaded && meshdata.skeleton) {
+    CalculateJointBounds(meshdata, *meshdata.skeleton);
+  }
+
   return h;
 }
 
+void MeshDataManager::extract_root_motion(MeshData &meshdata) {
+  SkeletonHandle skl{ meshdata.skeleton };
+  if (nullptr == skl) {
+    return;
+  }
+
+  for (auto &clip : skl->clips) {
+    if (ExtractRootMotion(*skl, clip)) {
+      auto const& translations = clip.root_motion.translations;
+      LOG_INFO( "> clip", clip.name, ": root motion of", glm::length(translations.back()), "per loop." );
+    }
+  }
+}
+
+void MeshDataManager::compress_clips(MeshData &meshdata) {
+  SkeletonHandle skl{ meshdata.skeleton };
+  if (nullptr == skl) {
+    return;
+  }
+
+  for (auto &clip : skl->clips) {
+    ClipCompressionReport_t report;
+    if (!clip.is_compressed() && CompressClip(*skl, clip, ClipCompressionParams_t(), &report)) {
+      LOG_INFO( "> clip", clip.name, ": ratio", report.ratio(), "(", report.nkeys, "/", report.nraw_keys, "keys ),",
+                "max joint error", report.max_error, "[ joint", report.max_error_joint, "frame", report.max_error_frame, "]" );
+    }
+  }
+}
+
 // ----------------------------------------------------------------------------
 
-bool MeshDataManager::load_obj(std::string_view filename, MeshData &meshdata) {
-  char *buffer = nullptr;
-  size_t buffersize = 0uL;
+bool MeshDataManager::ParseFileOBJ(std::string_view filename, RawMeshFile &meshfile, bool bChunked, int32_t nchunks) {
+  MappedFile file;
+  if (!file.open(filename)) {
+    return false;
+  }
+
+  if (bChunked) {
+    ParseOBJChunked(file.data(), file.size(), meshfile, nchunks);
+  } else {
+    std::vector<char> input(file.data(), file.data() + file.size());
+    input.push_back('\0');
+    ParseOBJ(input.data(), meshfile, false);
+  }
+
+  return true;
+}
 
-  if (!LoadFile(filename, &buffer, &buffersize)) {
+bool MeshDataManager::load_obj(std::string_view filename, MeshData &meshdata) {
+  MappedFile file;
+  if (!file.open(filename)) {
+    LOG_ERROR( filename, "could not be loaded.");
     return false;
   }
 
@@ -408,7 +877,15 @@ bool MeshDataManager::load_obj(std::string_view filename, MeshData &meshdata) {
 
   // Parse the OBJ for raw mesh data.
   RawMeshFile meshfile;
-  ParseOBJ(buffer, meshfile, bSplitObjects);
+  if constexpr (bSplitObjects) {
+    // (the serial parser needs a writable null-terminated buffer)
+    std::vector<char> input(file.data(), file.data() + file.size());
+    input.push_back('\0');
+    ParseOBJ(input.data(), meshfile, bSplitObjects);
+  } else {
+    ParseOBJChunked(file.data(), file.size(), meshfile);
+  }
+  file.close();
 
   // Handle MTL file materials if any.
   if (!meshfile.material_id.empty()) {
@@ -427,9 +904,12 @@ bool MeshDataManager::load_obj(std::string_view filename, MeshData &meshdata) {
     mtl.id = mtl.id.substr(0, mtl.id.find_last_of('.'));
 
     // Load & Parse the material file.
+    char *buffer = nullptr;
+    size_t buffersize = 0uL;
     if (LoadFile(fn, &buffer, &buffersize)) {
       ParseMTL( buffer, mtl);
     }
+    delete [] buffer;
     meshfile.prefixMaterialVertexGroupNames(mtl);
 
     // Transform relative paths to absolute ones.
@@ -440,6 +920,16 @@ bool MeshDataManager::load_obj(std::string_view filename, MeshData &meshdata) {
       if (auto &m = mat.alpha_map; !m.empty() && m[0] != '/')    m = dirname + "/" + m;
     }
 
+    // Keep track of the external files used, to invalidate the mesh cache.
+    meshdata.dependencies.push_back(fn);
+    for (auto const& mat : mtl.infos) {
+      for (auto const* m : { &mat.diffuse_map, &mat.specular_map, &mat.bump_map, &mat.alpha_map }) {
+        if (!m->empty()) {
+          meshdata.dependencies.push_back(*m);
+        }
+      }
+    }
+
     // Display a debug log.
     if constexpr (debug_log) {
       LOG_INFO( "\nMTL :", mtl.id );
@@ -456,7 +946,6 @@ bool MeshDataManager::load_obj(std::string_view filename, MeshData &meshdata) {
       }
     }
   }
-  delete [] buffer;
 
 #ifdef WIN32
   // reset to previous locale.
@@ -508,6 +997,283 @@ std::string SetupTextureGLTF(cgltf_texture *tex, std::string const& dirname, std
   return texname;
 }
 
+// Primitive to load, with the offsets of its attributes in the joined mesh.
+struct PrimitiveTaskGLTF_t {
+  glm::mat4 world_matrix;
+
+  cgltf_accessor const* positions = nullptr;
+  cgltf_accessor const* normals   = nullptr;
+  cgltf_accessor const* tangents  = nullptr;
+  cgltf_accessor const* texcoords = nullptr;
+  cgltf_accessor const* joints    = nullptr;
+  cgltf_accessor const* weights   = nullptr;
+  cgltf_accessor const* indices   = nullptr;
+
+  size_t vertices_offset  = 0;
+  size_t normals_offset   = 0;
+  size_t tangents_offset  = 0;
+  size_t texcoords_offset = 0;
+  size_t joints_offset    = 0;
+  size_t weights_offset   = 0;
+  size_t elements_offset  = 0;
+};
+
+// Return the address of the first element of an accessor, or nullptr.
+uint8_t const* GetAccessorDataGLTF(cgltf_accessor const* accessor) {
+  auto const* bv = accessor->buffer_view;
+  if (!bv || accessor->is_sparse) {
+    return nullptr;
+  }
+  auto const* data = bv->data ? static_cast<uint8_t const*>(bv->data)
+                   : bv->buffer->data ? static_cast<uint8_t const*>(bv->buffer->data) + bv->offset
+                   : nullptr
+                   ;
+  return data ? data + accessor->offset : nullptr;
+}
+
+// Unpack a float accessor into dst, with T a float vector type.
+// Non-normalized float data are copied directly, others are converted per element.
+template<typename T>
+void UnpackFloatsGLTF(cgltf_accessor const* accessor, T *dst) {
+  constexpr cgltf_size ncomponents = sizeof(T) / sizeof(float);
+  auto const count = accessor->count;
+  auto const* data = GetAccessorDataGLTF(accessor);
+
+  bool const bFastPath = data
+                      && (accessor->component_type == cgltf_component_type_r_32f)
+                      && (cgltf_num_components(accessor->type) == ncomponents)
+                      ;
+  if (!bFastPath) {
+    for (cgltf_size i = 0; i < count; ++i) {
+      cgltf_accessor_read_float( accessor, i, reinterpret_cast<float*>(dst + i), ncomponents);
+    }
+  } else if (accessor->stride == sizeof(T)) {
+    memcpy(dst, data, count * sizeof(T));
+  } else {
+    for (cgltf_size i = 0; i < count; ++i) {
+      memcpy(dst + i, data + i * accessor->stride, sizeof(T));
+    }
+  }
+}
+
+// Unpack an unsigned vec4 accessor (ie. joint indices) into dst.
+void UnpackJointsGLTF(cgltf_accessor const* accessor, glm::uvec4 *dst) {
+  auto const count  = accessor->count;
+  auto const stride = accessor->stride;
+  auto const* data  = GetAccessorDataGLTF(accessor);
+
+  if (!data || (accessor->type != cgltf_type_vec4)) {
+    for (cgltf_size i = 0; i < count; ++i) {
+      cgltf_accessor_read_uint( accessor, i, glm::value_ptr(dst[i]), 4);
+    }
+    return;
+  }
+
+  auto const unpack = [&](auto const* type_ptr) {
+    using Component_t = std::remove_const_t<std::remove_pointer_t<decltype(type_ptr)>>;
+    for (cgltf_size i = 0; i < count; ++i) {
+      Component_t v[4];
+      memcpy(v, data + i * stride, sizeof(v));
+      dst[i] = glm::uvec4(v[0], v[1], v[2], v[3]);
+    }
+  };
+
+  switch (accessor->component_type) {
+    case cgltf_component_type_r_8u:
+      unpack(static_cast<uint8_t const*>(nullptr));
+    break;
+    case cgltf_component_type_r_16u:
+      unpack(static_cast<uint16_t const*>(nullptr));
+    break;
+    case cgltf_component_type_r_32u:
+      unpack(static_cast<uint32_t const*>(nullptr));
+    break;
+    default:
+      for (cgltf_size i = 0; i < count; ++i) {
+        cgltf_accessor_read_uint( accessor, i, glm::value_ptr(dst[i]), 4);
+      }
+    break;
+  }
+}
+
+// Unpack an index accessor into elements, offset by the primitive first vertex.
+void UnpackIndicesGLTF(cgltf_accessor const* accessor, size_t vertex_offset, glm::ivec3 *dst) {
+  auto const count  = accessor->count;
+  auto const stride = accessor->stride;
+  auto const* data  = GetAccessorDataGLTF(accessor);
+
+  auto const unpack = [&](auto const* type_ptr) {
+    using Component_t = std::remove_const_t<std::remove_pointer_t<decltype(type_ptr)>>;
+    for (cgltf_size i = 0; i < count; ++i) {
+      Component_t v;
+      memcpy(&v, data + i * stride, sizeof(v));
+      dst[i] = glm::ivec3( static_cast<int32_t>(vertex_offset + v) );
+    }
+  };
+
+  switch (data ? accessor->component_type : cgltf_component_type_invalid) {
+    case cgltf_component_type_r_8u:
+      unpack(static_cast<uint8_t const*>(nullptr));
+    break;
+    case cgltf_component_type_r_16u:
+      unpack(static_cast<uint16_t const*>(nullptr));
+    break;
+    case cgltf_component_type_r_32u:
+      unpack(static_cast<uint32_t const*>(nullptr));
+    break;
+    default:
+      for (cgltf_size i = 0; i < count; ++i) {
+        auto const vertex_index = cgltf_accessor_read_index(accessor, i);
+        dst[i] = glm::ivec3( static_cast<int32_t>(vertex_offset + vertex_index) );
+      }
+    break;
+  }
+}
+
+// Transform a batch of points (when bPoint is true) or directions by a matrix.
+// The matrix is expanded to scalars, with the same operations order as glm,
+// so the loop can be vectorized by the compiler.
+template<bool bPoint, typename T>
+void TransformBatch(glm::mat4 const& m, T *v, size_t count) {
+  float const m00 = m[0][0], m01 = m[0][1], m02 = m[0][2];
+  float const m10 = m[1][0], m11 = m[1][1], m12 = m[1][2];
+  float const m20 = m[2][0], m21 = m[2][1], m22 = m[2][2];
+  float const m30 = bPoint ? m[3][0] : 0.0f;
+  float const m31 = bPoint ? m[3][1] : 0.0f;
+  float const m32 = bPoint ? m[3][2] : 0.0f;
+
+  #pragma omp simd
+  for (size_t i = 0; i < count; ++i) {
+    float const x = v[i].x;
+    float const y = v[i].y;
+    float const z = v[i].z;
+    v[i].x = (m00 * x + m10 * y) + (m20 * z + m30);
+    v[i].y = (m01 * x + m11 * y) + (m21 * z + m31);
+    v[i].z = (m02 * x + m12 * y) + (m22 * z + m32);
+  }
+}
+
+// Load a primitive attributes & indices into the joined mesh buffers.
+void LoadPrimitiveGLTF(PrimitiveTaskGLTF_t const& task, RawMeshData &raw) {
+  auto const& world_matrix = task.world_matrix;
+
+  if (auto const* accessor = task.positions; accessor) {
+    auto *dst = raw.vertices.data() + task.vertices_offset;
+    UnpackFloatsGLTF( accessor, dst);
+    TransformBatch<true>( world_matrix, dst, accessor->count);
+  }
+  if (auto const* accessor = task.normals; accessor) {
+    auto *dst = raw.normals.data() + task.normals_offset;
+    UnpackFloatsGLTF( accessor, dst);
+    TransformBatch<false>( world_matrix, dst, accessor->count);
+  }
+  if (auto const* accessor = task.tangents; accessor) {
+    auto *dst = raw.tangents.data() + task.tangents_offset;
+    UnpackFloatsGLTF( accessor, dst);
+    TransformBatch<false>( world_matrix, dst, accessor->count);
+  }
+  if (auto const* accessor = task.texcoords; accessor) {
+    UnpackFloatsGLTF( accessor, raw.texcoords.data() + task.texcoords_offset);
+  }
+  if (auto const* accessor = task.joints; accessor) {
+    UnpackJointsGLTF( accessor, raw.joints.data() + task.joints_offset);
+  }
+  if (auto const* accessor = task.weights; accessor) {
+    UnpackFloatsGLTF( accessor, raw.weights.data() + task.weights_offset);
+  }
+  if (auto const* accessor = task.indices; accessor) {
+    UnpackIndicesGLTF( accessor, task.vertices_offset, raw.elementsAttribs.data() + task.elements_offset);
+  }
+}
+
+// Fill a MaterialInfo from a GLTF material, registering its internal textures.
+void SetupMaterialGLTF(cgltf_material const& mat, std::string const& dirname, MaterialInfo &info) {
+  // PBR Metal Roughness.
+  if (mat.has_pbr_metallic_roughness) {
+    auto const& pmr = mat.pbr_metallic_roughness;
+
+    auto const& rgba = pmr.base_color_factor;
+    info.diffuse_color      = glm::vec4(rgba[0], rgba[1], rgba[2], rgba[3]);        
+    info.metallic           = pmr.metallic_factor;
+    info.roughness          = pmr.roughness_factor;
+
+    info.diffuse_map        = SetupTextureGLTF( pmr.base_color_texture.texture,         dirname, info.name + "_diffuse");
+    info.metallic_rough_map = SetupTextureGLTF( pmr.metallic_roughness_texture.texture, dirname, info.name + "_metallic_roughness");
+  }
+
+  // Alpha Test / Blend.
+  switch (mat.alpha_mode) {
+    case cgltf_alpha_mode_blend:
+      info.bBlending = true;
+    break;
+    case cgltf_alpha_mode_mask:
+      info.bAlphaTest = true;
+    break;
+    case cgltf_alpha_mode_opaque:
+    default:
+    break;
+  }
+
+  // Miscs.
+  info.bump_map     = SetupTextureGLTF( mat.normal_texture.texture,    dirname, info.name + "_normal");
+  info.ao_map       = SetupTextureGLTF( mat.occlusion_texture.texture, dirname, info.name + "_occlusion");
+  info.emissive_map = SetupTextureGLTF( mat.emissive_texture.texture,  dirname, info.name + "_emissive");
+  info.alpha_cutoff = mat.alpha_cutoff;
+  info.bDoubleSided = mat.double_sided;
+  info.bUnlit       = mat.unlit;
+
+  auto const emf = mat.emissive_factor;
+  info.emissive_factor = glm::vec3( emf[0], emf[1], emf[2]);
+}
+
+// Map to solve name for unknown materials. Key is material's pointer in datastructure.
+std::unordered_map< cgltf_material const*, std::string > GetMaterialNamesGLTF(std::string const& basename, cgltf_data const* data) {
+  char tmpname[256]{};
+
+  std::unordered_map< cgltf_material const*, std::string > material_names( data->materials_count );
+  for (cgltf_size i = 0; i < data->materials_count; ++i) {
+    cgltf_material const& mat = data->materials[i];
+    sprintf(tmpname, "%s::material_%02d", basename.c_str(), int(i));
+    material_names[ &mat ] = std::string( mat.name ? mat.name : tmpname );
+  }
+  return material_names;
+}
+
+/// Retrieve the local rest pose of the skeleton joints, used by the joints not animated by a clip.
+void LoadRestPoseGLTF(cgltf_data const* data, Skeleton const& skeleton, JointBuffer_t<JointPose_t> &rest_pose) {
+  rest_pose.resize(skeleton.njoints());
+
+  for (cgltf_size i = 0; i < data->nodes_count; ++i) {
+    auto const& node = data->nodes[i];
+    if (nullptr == node.name) {
+      continue;
+    }
+    auto const it = skeleton.index_map.find(node.name);
+    if (it == skeleton.index_map.end()) {
+      continue;
+    }
+
+    auto &joint = rest_pose[it->second];
+    if (node.has_matrix) {
+      glm::mat4 local_matrix;
+      cgltf_node_transform_local( &node, glm::value_ptr(local_matrix));
+      joint.fScale = glm::length(glm::vec3(local_matrix[0]));
+      joint.vTranslation = glm::vec3(local_matrix[3]);
+      joint.qRotation = glm::normalize(glm::quat_cast(glm::mat3(local_matrix) / joint.fScale));
+      continue;
+    }
+    if (node.has_translation) {
+      joint.vTranslation = glm::vec3(node.translation[0], node.translation[1], node.translation[2]);
+    }
+    if (node.has_rotation) {
+      joint.qRotation = glm::quat(node.rotation[3], node.rotation[0], node.rotation[1], node.rotation[2]);
+    }
+    if (node.has_scale) {
+      joint.fScale = node.scale[0];
+    }
+  }
+}
+
 void LoadAnimationGLTF(std::string const& basename, cgltf_data const* data, MeshData &meshdata) {
   std::vector<float> inputs;
   std::vector<float> outputs;
@@ -523,6 +1289,10 @@ void LoadAnimationGLTF(std::string const& basename, cgltf_data const* data, Mesh
   LOG_INFO( "> ", basename, ":", njoints, "joint(s),", data->animations_count, "animation(s).");
 
   skl->clips.resize( data->animations_count );
+
+  // Joints without channels keep their rest pose.
+  JointBuffer_t<JointPose_t> rest_pose;
+  LoadRestPoseGLTF( data, *skl, rest_pose);
   
   for (cgltf_size i = 0; i < data->animations_count; ++i) {
     auto const& anim = data->animations[i];
@@ -570,7 +1340,7 @@ void LoadAnimationGLTF(std::string const& basename, cgltf_data const* data, Mesh
 
         clip = AnimationClip_t(clipname, nsamples, clip_duration);
         for (auto &sample : clip.samples) {
-          sample.joints.resize( njoints );
+          sample.joints = rest_pose;
         }
       }
 
@@ -644,6 +1414,24 @@ bool MeshDataManager::load_gltf(std::string_view filename, MeshData &meshdata) {
     return false;
   }
 
+  // Keep track of the external buffers & images used, to invalidate the mesh cache.
+  {
+    std::string const fn( filename );
+    std::string const dirname = fn.substr(0, fn.find_last_of('/'));
+    auto const add_dependency = [&meshdata, &dirname](char const* uri) {
+      if ((nullptr == uri) || (0 == strncmp(uri, "data:", 5))) {
+        return;
+      }
+      meshdata.dependencies.push_back( (uri[0] != '/') ? dirname + "/" + uri : std::string(uri) );
+    };
+    for (cgltf_size i = 0; i < data->buffers_count; ++i) {
+      add_dependency( data->buffers[i].uri );
+    }
+    for (cgltf_size i = 0; i < data->images_count; ++i) {
+      add_dependency( data->images[i].uri );
+    }
+  }
+
   // Basename we will use to identify the file's data.
   std::string basename(filename);
   basename = Logger::TrimFilename(basename);
@@ -665,16 +1453,18 @@ bool MeshDataManager::load_gltf(std::string_view filename, MeshData &meshdata) {
     
     char tmpname[256]{};
 
-    // Map to solve name for unknown materials. Key is material's pointer in datastructure.
-    std::unordered_map< cgltf_material const*, std::string > material_names( data->materials_count );
-    for (cgltf_size i = 0; i < data->materials_count; ++i) {
-      cgltf_material const& mat = data->materials[i];
-      sprintf(tmpname, "%s::material_%02d", basename.c_str(), int(i));
-      material_names[ &mat ] = std::string( mat.name ? mat.name : tmpname );
-    }
+    // Map to solve name for unknown materials.
+    auto material_names{ GetMaterialNamesGLTF(basename, data) };
 
     // -- MESH ATTRIBUTES & INDICES.
-    cgltf_size last_vertex_index = 0;
+    //
+    // Primitives are first gathered with the offsets of their data in the
+    // joined buffers, then loaded concurrently.
+    std::vector<PrimitiveTaskGLTF_t> tasks;
+    PrimitiveTaskGLTF_t offsets;
+
+    auto &raw = meshfile.meshes.back();
+
     for (cgltf_size node_index = 0; node_index < data->nodes_count; ++node_index) {
       cgltf_node node = data->nodes[node_index];
 
@@ -688,16 +1478,10 @@ bool MeshDataManager::load_gltf(std::string_view filename, MeshData &meshdata) {
       glm::mat4 world_matrix;
       cgltf_node_transform_world( &node, glm::value_ptr(world_matrix));
 
-      // RawMeshData to update.
-      auto &raw = meshfile.meshes.back();
-      
       // Determine a unique name for this raw mesh if none exists.
       sprintf(tmpname, "%s::mesh_%02d", basename.c_str(), static_cast<int32_t>(node_index));
       raw.name = std::string(mesh->name ? mesh->name : node.name ? node.name : tmpname); //
 
-      // When meshes are not joined, we should probably reset this to 0.
-      //last_vertex_index = 0;
-
       // Morph Targets.
       // if (auto ntargets = mesh->target_names_count; ntargets) {
       //   LOG_MESSAGE( basename, "has", ntargets, "targets :");
@@ -754,6 +1538,9 @@ bool MeshDataManager::load_gltf(std::string_view filename, MeshData &meshdata) {
 
         // ------------------------------------
 
+        PrimitiveTaskGLTF_t task( offsets );
+        task.world_matrix = world_matrix;
+
         // Attributes.
         for (cgltf_size attrib_index = 0; attrib_index < prim.attributes_count; ++attrib_index) {
           auto const& attrib = prim.attributes[attrib_index];
@@ -765,49 +1552,20 @@ bool MeshDataManager::load_gltf(std::string_view filename, MeshData &meshdata) {
           }
           //LOG_MESSAGE("Accessor type :", attrib.data->component_type);
 
-          // Used to reserve memory.
-          auto const attribsize = attrib.data->count;
-
           // Positions.
           if (attrib.type == cgltf_attribute_type_position) {
-            LOG_DEBUG( "> loading positions." );
             LOG_CHECK(attrib.data->type == cgltf_type_vec3);
-            raw.vertices.reserve(attribsize);
-            
-            glm::vec3 vertex;
-            for (cgltf_size i = 0; i < attrib.data->count; ++i) {
-              cgltf_accessor_read_float( attrib.data, i, glm::value_ptr(vertex), 3);
-              vertex = glm::vec3(world_matrix * glm::vec4(vertex, 1.0f));
-              raw.vertices.push_back( vertex );
-            }
+            task.positions = attrib.data;
           }
           // Normals.
           else if (attrib.type == cgltf_attribute_type_normal) {
-            LOG_DEBUG( "> loading normals." );
             LOG_CHECK(attrib.data->type == cgltf_type_vec3);
-            raw.normals.reserve(attribsize);
-            
-            glm::vec3 normal;
-            for (cgltf_size i = 0; i < attrib.data->count; ++i) {
-              cgltf_accessor_read_float( attrib.data, i, glm::value_ptr(normal), 3);
-              normal = glm::vec3(world_matrix * glm::vec4(normal, 0.0f));
-              raw.normals.push_back( normal );
-            }
+            task.normals = attrib.data;
           }
           // Tangents
           else if (attrib.type == cgltf_attribute_type_tangent) {
-            LOG_DEBUG( "> loading tangents." );
             LOG_CHECK(attrib.data->type == cgltf_type_vec4);
-            raw.tangents.reserve(attribsize);
-            
-            glm::vec4 tangent;
-            for (cgltf_size i = 0; i < attrib.data->count; ++i) {
-              cgltf_accessor_read_float( attrib.data, i, glm::value_ptr(tangent), 4);
-              glm::vec3 t3 = glm::vec3(tangent);
-                        t3 = glm::vec3(world_matrix * glm::vec4(t3, 0.0f));
-              tangent = glm::vec4(t3, tangent.w);
-              raw.tangents.push_back( tangent );
-            }
+            task.tangents = attrib.data;
           }
           // Texcoords. [check which index is used !]
           else if (attrib.type == cgltf_attribute_type_texcoord) {
@@ -818,73 +1576,50 @@ bool MeshDataManager::load_gltf(std::string_view filename, MeshData &meshdata) {
               LOG_WARNING( "MultiTexturing is not supported yet." );
               continue;
             }
-            LOG_DEBUG( "> loading texture coordinates." );
-
-            raw.texcoords.reserve(attribsize);
-
-            glm::vec2 texcoord;
-            for (cgltf_size i = 0; i < attrib.data->count; ++i) {
-              LOG_CHECK(0 != cgltf_accessor_read_float( attrib.data, i, glm::value_ptr(texcoord), 2));
-              raw.texcoords.push_back( texcoord );
-            }
+            task.texcoords = attrib.data;
           }
           // Joints.
           else if (attrib.type == cgltf_attribute_type_joints) {
-            LOG_DEBUG( "> loading joint indices." );
             LOG_CHECK(attrib.data->type == cgltf_type_vec4);
-            raw.joints.reserve(attribsize);
-            
-            glm::uvec4 joints;
-            for (cgltf_size i = 0; i < attrib.data->count; ++i) {
-              LOG_CHECK(0 != cgltf_accessor_read_uint( attrib.data, i, glm::value_ptr(joints), 4));
-              // LOG_MESSAGE("* joint (", i, ") :", joints.x, joints.y, joints.z, joints.w);
-              
-              raw.joints.push_back( joints );
-            }
+            task.joints = attrib.data;
           }
           // Weights.
           else if (attrib.type == cgltf_attribute_type_weights) {
-            LOG_DEBUG( "> loading joint weights." );
             LOG_CHECK(attrib.data->type == cgltf_type_vec4);
-            raw.weights.reserve(attribsize);
-
-            glm::vec4 weights;
-            for (cgltf_size i = 0; i < attrib.data->count; ++i) {
-              LOG_CHECK(0 != cgltf_accessor_read_float( attrib.data, i, glm::value_ptr(weights), 4));
-              // LOG_MESSAGE("* weights (", i, ") :", weights.x, weights.y, weights.z, weights.w);
-              
-              // weights = glm::vec4(0.0, 0.0, 0.0, 0.0);
-              raw.weights.push_back( weights );
-            }
+            task.weights = attrib.data;
           }
         }
+
+        // Advance the joined buffers offsets.
+        offsets.vertices_offset  += task.positions ? task.positions->count : 0;
+        offsets.normals_offset   += task.normals   ? task.normals->count   : 0;
+        offsets.tangents_offset  += task.tangents  ? task.tangents->count  : 0;
+        offsets.texcoords_offset += task.texcoords ? task.texcoords->count : 0;
+        offsets.joints_offset    += task.joints    ? task.joints->count    : 0;
+        offsets.weights_offset   += task.weights   ? task.weights->count   : 0;
         
         // Indices.
         if (prim.indices) {
           if (prim.indices->is_sparse) {
             LOG_WARNING( "GLTF sparse indexing is not supported." );
           } else {
-            for (cgltf_size i = 0; i < prim.indices->count; ++i) {
-              auto const vertex_index = cgltf_accessor_read_index(prim.indices, i);
-              raw.elementsAttribs.push_back(
-                glm::ivec3( static_cast<int32_t>(last_vertex_index + vertex_index) )
-              );
-            }
+            task.indices = prim.indices;
+            offsets.elements_offset += prim.indices->count;
           }
 
           // Material / Vertex Group.
           if (auto mat = prim.material; mat) {
             VertexGroup vg;
             vg.name = material_names[mat];
-            vg.start_index = static_cast<int32_t>(raw.elementsAttribs.size() - prim.indices->count); // 
-            vg.end_index   = static_cast<int32_t>(raw.elementsAttribs.size()); //
+            vg.start_index = static_cast<int32_t>(offsets.elements_offset - prim.indices->count); // 
+            vg.end_index   = static_cast<int32_t>(offsets.elements_offset); //
             raw.vgroups.push_back(vg);
           }
         } else {
           LOG_WARNING( "GLTF : No indices are associated with file", filename );
         }
 
-        last_vertex_index = raw.vertices.size(); //
+        tasks.push_back(task);
       } // end foreach primitives.
 
       // ----
@@ -938,9 +1673,32 @@ bool MeshDataManager::load_gltf(std::string_view filename, MeshData &meshdata) {
 
         // Transform them to global space.
         skl->transform_inverse_bind_matrices(inverse_world_matrix);
+
+        // Transform of the root joint parent node, to animate the root in global space.
+        skl->root_parent_matrix = world_matrix;
+        if (auto *root_parent = skin->joints[0]->parent; root_parent) {
+          glm::mat4 parent_matrix;
+          cgltf_node_transform_world( root_parent, glm::value_ptr(parent_matrix));
+          skl->root_parent_matrix *= parent_matrix;
+        }
       }
     }
 
+    // Load the primitives data in the joined buffers.
+    raw.vertices.resize(offsets.vertices_offset);
+    raw.normals.resize(offsets.normals_offset);
+    raw.tangents.resize(offsets.tangents_offset);
+    raw.texcoords.resize(offsets.texcoords_offset);
+    raw.joints.resize(offsets.joints_offset);
+    raw.weights.resize(offsets.weights_offset);
+    raw.elementsAttribs.resize(offsets.elements_offset);
+
+    auto const ntasks = static_cast<int32_t>(tasks.size());
+    #pragma omp parallel for schedule(dynamic, 1) num_threads(LOOP_NTHREADS)
+    for (int32_t i = 0; i < ntasks; ++i) {
+      LoadPrimitiveGLTF( tasks[i], raw);
+    }
+
     // -- MATERIALS.
     {
       auto &mtl = meshdata.material;
@@ -952,43 +1710,7 @@ bool MeshDataManager::load_gltf(std::string_view filename, MeshData &meshdata) {
         
         MaterialInfo info;
         info.name = material_names[ &mat ];
-
-        // PBR Metal Roughness.
-        if (mat.has_pbr_metallic_roughness) {
-          auto const& pmr = mat.pbr_metallic_roughness;
-
-          auto const& rgba = pmr.base_color_factor;
-          info.diffuse_color      = glm::vec4(rgba[0], rgba[1], rgba[2], rgba[3]);        
-          info.metallic           = pmr.metallic_factor;
-          info.roughness          = pmr.roughness_factor;
-
-          info.diffuse_map        = SetupTextureGLTF( pmr.base_color_texture.texture,         dirname, info.name + "_diffuse");
-          info.metallic_rough_map = SetupTextureGLTF( pmr.metallic_roughness_texture.texture, dirname, info.name + "_metallic_roughness");
-        }
-
-        // Alpha Test / Blend.
-        switch (mat.alpha_mode) {
-          case cgltf_alpha_mode_blend:
-            info.bBlending = true;
-          break;
-          case cgltf_alpha_mode_mask:
-            info.bAlphaTest = true;
-          break;
-          case cgltf_alpha_mode_opaque:
-          default:
-          break;
-        }
-
-        // Miscs.
-        info.bump_map     = SetupTextureGLTF( mat.normal_texture.texture,    dirname, info.name + "_normal");
-        info.ao_map       = SetupTextureGLTF( mat.occlusion_texture.texture, dirname, info.name + "_occlusion");
-        info.emissive_map = SetupTextureGLTF( mat.emissive_texture.texture,  dirname, info.name + "_emissive");
-        info.alpha_cutoff = mat.alpha_cutoff;
-        info.bDoubleSided = mat.double_sided;
-        info.bUnlit       = mat.unlit;
-
-        auto const emf = mat.emissive_factor;
-        info.emissive_factor = glm::vec3( emf[0], emf[1], emf[2]);
+        SetupMaterialGLTF( mat, dirname, info);
 
         if (!info.bump_map.empty()) {
           bNeedTangents = true; //
@@ -1018,3 +1740,51 @@ bool MeshDataManager::load_gltf(std::string_view filename, MeshData &meshdata) {
 }
 
 // ----------------------------------------------------------------------------
+
+bool MeshDataManager::load_gltf_textures(std::string_view filename) {
+  // The cache holds the materials but not the textures embedded in the file,
+  // so we parse back its headers to register them, without any geometry processing.
+
+  cgltf_options options{};
+  cgltf_data* data = nullptr;
+  cgltf_result result = cgltf_parse_file(&options, filename.data(), &data);
+  if (result != cgltf_result_success) {
+    LOG_WARNING( "GLTF : failed to parse :", filename );
+    return false;
+  }
+
+  bool bHasInternalImages = false;
+  for (cgltf_size i = 0; i < data->images_count; ++i) {
+    bHasInternalImages |= (nullptr != data->images[i].buffer_view);
+  }
+
+  if (bHasInternalImages) {
+    result = cgltf_load_buffers(&options, data, filename.data());
+    if (result != cgltf_result_success) {
+      LOG_WARNING( "GLTF : failed to load buffers :", filename );
+      cgltf_free(data);
+      return false;
+    }
+
+    std::string basename(filename);
+    basename = Logger::TrimFilename(basename);
+    basename = basename.substr(0, basename.find_last_of('.'));
+
+    std::string const fn( filename );
+    std::string const dirname = fn.substr(0, fn.find_last_of('/'));
+
+    auto material_names{ GetMaterialNamesGLTF(basename, data) };
+    for (cgltf_size i = 0; i < data->materials_count; ++i) {
+      auto const& mat = data->materials[i];
+      MaterialInfo info;
+      info.name = material_names[ &mat ];
+      SetupMaterialGLTF( mat, dirname, info);
+    }
+  }
+
+  cgltf_free(data);
+
+  return true;
+}
+
+// ----------------------------------------------------------------------------
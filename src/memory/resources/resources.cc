@@ -1,29 +1,150 @@
 #include "memory/resources/resources.h"
 
+#include <algorithm>
+#include <utility>
+#include <vector>
+
 // ----------------------------------------------------------------------------
 
+namespace {
+
+// Number of threads used to load resources asynchronously.
+constexpr int32_t kAsyncLoaderThreads = 2;
+
+// Resources loaded alongside an asynchronous request, registered with it.
+struct AsyncDependencies_t {
+  std::vector<std::pair<ResourceId, ImageManager::Handle>> images;
+
+  void add_image(ImageManager &manager, std::string const& path) {
+    if (path.empty()) {
+      return;
+    }
+    ResourceId const id( path );
+    auto const it = std::find_if(images.begin(), images.end(), [&id](auto const& dep) {
+      return dep.first == id;
+    });
+    if (it == images.end()) {
+      images.emplace_back(id, manager.load_detached(id));
+    }
+  }
+};
+
+template<typename T>
+void LoadDependencies(ResourceHandle<T> const& h, ImageManager &image_manager, AsyncDependencies_t &deps) {
+  // (no dependencies by default)
+}
+
+// Decode the material textures of a mesh along with it.
+template<>
+void LoadDependencies<MeshData>(ResourceHandle<MeshData> const& h, ImageManager &image_manager, AsyncDependencies_t &deps) {
+  for (auto const& info : h.data->material.infos) {
+    deps.add_image(image_manager, info.diffuse_map);
+    deps.add_image(image_manager, info.specular_map);
+    deps.add_image(image_manager, info.emissive_map);
+    deps.add_image(image_manager, info.metallic_rough_map);
+    deps.add_image(image_manager, info.bump_map);
+    deps.add_image(image_manager, info.ao_map);
+    deps.add_image(image_manager, info.alpha_map);
+  }
+}
+
+template<typename T, typename TManager>
+AsyncResourceHandle<T> LoadAsyncTask(
+  AsyncLoader &loader,
+  TManager &manager,
+  ImageManager &image_manager,
+  ResourceId const& id,
+  std::function<void(ResourceHandle<T>)> on_ready
+) {
+  using State_t = typename AsyncResourceHandle<T>::State_t;
+  using Status  = typename AsyncResourceHandle<T>::Status;
+
+  auto state = std::make_shared<State_t>();
+  auto deps  = std::make_shared<AsyncDependencies_t>();
+
+  // Worker side : file IO and CPU decoding.
+  auto job = [&manager, &image_manager, id, state, deps]() {
+    state->handle = manager.load_detached(id);
+    if (state->handle.is_valid()) {
+      LoadDependencies<T>(state->handle, image_manager, *deps);
+    }
+  };
+
+  // Main thread side : registration, then user defined GPU uploads.
+  auto finalizer = [&manager, &image_manager, id, state, deps, on_ready]() {
+    if (!state->handle.is_valid()) {
+      LOG_WARNING( "Asynchronous load failed for :", id.c_str());
+      state->status = Status::Failed;
+      return;
+    }
+
+    for (auto const& dep : deps->images) {
+      image_manager.commit(dep.first, dep.second);
+    }
+    manager.commit(id, state->handle);
+    state->status = Status::Ready;
+
+    if (on_ready) {
+      on_ready(state->handle);
+    }
+  };
+
+  loader.push(job, finalizer);
+
+  return AsyncResourceHandle<T>(state);
+}
+
+} // namespace
+
+// ----------------------------------------------------------------------------
+
+AsyncLoader Resources::sLoader;
+FileWatcher Resources::sWatcher;
+
+void Resources::Initialize() {
+  sImage.set_watcher(&sWatcher);
+  sMeshData.set_watcher(&sWatcher);
+  sShader.set_watcher(&sWatcher);
+  sWatcher.start();
+
+  sLoader.init(kAsyncLoaderThreads);
+}
+
+void Resources::Deinitialize() {
+  sLoader.deinit();
+  sWatcher.stop();
+}
+
+void Resources::UpdateAsync() {
+  sLoader.update(kMaxAsyncFinalizePerFrame);
+}
+
 void Resources::WatchUpdate(std::function<void()> update_cb) {
-  // [ to put inside a thread, eventually ]
-  // It would be more interesting to have different watch time depending on the resources,
-  // (eg. a shader should be quicker to reload than a texture).
   static float sCurrentTick = 0.0f; //
-  
-  if (1000.0f * sCurrentTick > Resources::kUpdateMilliseconds) {
-    // release internal memory from last frames.
+
+  // Release internal memory from last frames.
+  bool const bTick = (1000.0f * sCurrentTick > Resources::kUpdateMilliseconds);
+  if (bTick) {
     Resources::ReleaseAll(); // 
+    sCurrentTick = 0.0f;
+  }
+  sCurrentTick += static_cast<float>(GlobalClock::Get().deltaTime()); //
 
-    // watch for resource modifications.
-    sImage.update();
-    sMeshData.update();
-    sShader.update();
+  // Reload the resources modified since last frame.
+  bool bUpdated = false;
+  FileWatcher::Event_t event;
+  while (sWatcher.poll(event)) {
+    ResourceId const id( event.path );
+    bUpdated = sShader.update_sources(id, event.last_write) || bUpdated;
+    bUpdated = sImage.update(id, event.last_write)    || bUpdated;
+    bUpdated = sMeshData.update(id, event.last_write) || bUpdated;
+    bUpdated = sShader.update(id, event.last_write)   || bUpdated;
+  }
 
-    // upload newly modified dependencies to their assets.
-    //Assets::UpdateAll();
+  // Upload newly modified dependencies to their assets.
+  if (bTick || bUpdated) {
     update_cb();
-
-    sCurrentTick = 0.0f;
   }
-  sCurrentTick += static_cast<float>(GlobalClock::Get().deltaTime()); //
 }
 
 // ----------------------------------------------------------------------------
@@ -65,4 +186,15 @@ DEFINE_MANAGER(Image)
 DEFINE_MANAGER(MeshData)
 DEFINE_MANAGER(Shader)
 
+// Only managers safe to load from worker threads get an asynchronous loader
+// (shaders share their includes state and are loaded on the main thread).
+#define DEFINE_ASYNC_LOADER(name) \
+  template<> \
+  AsyncResourceHandle< name > Resources::LoadAsync< name >( ResourceId const& id, std::function<void(name##Manager::Handle)> on_ready ) { \
+    return LoadAsyncTask< name >( sLoader, s##name, sImage, id, on_ready ); \
+  }
+
+DEFINE_ASYNC_LOADER(Image)
+DEFINE_ASYNC_LOADER(MeshData)
+
 // ----------------------------------------------------------------------------
\ No newline at end of file
@@ -1,28 +1,85 @@
 #ifndef BARBU_MEMORY_RESOURCES_RESOURCES_H_
 #define BARBU_MEMORY_RESOURCES_RESOURCES_H_
 
+#include <atomic>
 #include <functional>
 
 #include "core/global_clock.h"
+#include "memory/async_loader.h"
+#include "memory/file_watcher.h"
 #include "memory/resources/image.h"
 #include "memory/resources/mesh_data.h"
 #include "memory/resources/shader.h"
 
 // ----------------------------------------------------------------------------
 
+//
+// Handle to a resource requested asynchronously.
+//
+// The handle becomes ready once the resource has been loaded by a worker and
+// registered to its manager on the main thread.
+//
+template<typename TResource>
+class AsyncResourceHandle {
+ public:
+  enum class Status : int32_t {
+    Pending,
+    Ready,
+    Failed,
+  };
+
+  struct State_t {
+    std::atomic<Status> status{ Status::Pending };
+    ResourceHandle<TResource> handle;
+  };
+
+  AsyncResourceHandle() = default;
+
+  AsyncResourceHandle(std::shared_ptr<State_t> state)
+    : state_(state)
+  {}
+
+  inline bool ready() const noexcept {
+    return state_ && (Status::Ready == state_->status.load());
+  }
+
+  inline bool failed() const noexcept {
+    return !state_ || (Status::Failed == state_->status.load());
+  }
+
+  // Return the loaded resource, only valid once ready.
+  inline ResourceHandle<TResource> get() const {
+    return ready() ? state_->handle : ResourceHandle<TResource>();
+  }
+
+ private:
+  std::shared_ptr<State_t> state_;
+};
+
+// ----------------------------------------------------------------------------
+
 //
 //  'Static' class to wrap all the resources loaders.
 //
-// @note :  * Put the file modification watcher in a thread.
-//          * UpdateAll should ideally not be called every frames and have different
-//      elapsed time by resource type.
+//  Files modifications are detected by a watcher thread, 'WatchUpdate' only
+//  reloads the resources it reported.
 //
 class Resources final {
  public:
   static constexpr int32_t kUpdateMilliseconds = 750;
 
+  // Maximum number of asynchronous loads finalized per frame.
+  static constexpr int32_t kMaxAsyncFinalizePerFrame = 1;
+
+  static void Initialize();
+  static void Deinitialize();
+
+  // Reload modified resources and call update_cb when any were, called once per frame.
   static void WatchUpdate(std::function<void()> update_cb);
 
+  // Finalize asynchronous loads on the main thread, called once per frame.
+  static void UpdateAsync();
+
   static void ReleaseAll() {
     sImage.release_all();
     sMeshData.release_all();
@@ -38,6 +95,12 @@ class Resources final {
   template<typename T>
   static typename ResourceManager<T>::Handle Get( ResourceId const& id );
 
+  // Load a resource on a worker thread, on_ready is called on the main thread
+  // by 'UpdateAsync' once the resource is registered.
+  // (only available for MeshData and Image)
+  template<typename T>
+  static AsyncResourceHandle<T> LoadAsync( ResourceId const& id, std::function<void(typename ResourceManager<T>::Handle)> on_ready = nullptr );
+
   template<typename T>
   static typename ResourceManager<T>::Handle GetUpdated( ResourceInfo & info );
 
@@ -48,6 +111,9 @@ class Resources final {
   static bool CheckVersion(ResourceInfo const& info);
 
  private:
+  static AsyncLoader sLoader;
+  static FileWatcher sWatcher;
+
   static ImageManager sImage;
   static MeshDataManager sMeshData;
   static ShaderManager sShader;
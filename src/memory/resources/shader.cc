@@ -1,19 +1,14 @@
 #include "memory/resources/shader.h"
 
+#include <algorithm>
 #include <array>
+#include <cstdio>
+#include <cstring>
 #include <regex>
 #include "core/graphics.h"
 
 // ----------------------------------------------------------------------------
 
-#ifdef BARBU_ENABLE_DEBUG_LOG
-static char spaces[] = "                                ";
-#endif
-
-static int s_debugSpacing = 31;
-
-// ----------------------------------------------------------------------------
-
 namespace {
 
 // Detect the type of shader file by comparing the file's basename to a
@@ -46,26 +41,25 @@ ShaderType GetShaderTypeFromName(std::string const& basename) {
 
 // ----------------------------------------------------------------------------
 
-bool ReadFile(const char* filename, const unsigned int maxsize, char out_[]) {
-  FILE* fd = nullptr;
-  size_t nelems = 0;
-  size_t nreads = 0;
-
-  if (!(fd = fopen(filename, "r"))) {
+/* Read a whole text file. */
+bool ReadFile(std::string const& filename, std::string &out) {
+  FILE* fd = fopen(filename.c_str(), "rb");
+  if (!fd) {
     LOG_WARNING( "\"", filename , "\" not found." ); //
     return false;
   }
-  memset(out_, 0, maxsize);
 
   fseek(fd, 0, SEEK_END);
-  nelems = static_cast<size_t>(ftell(fd));
-  nelems = (nelems > maxsize) ? maxsize : nelems;
+  long const nelems = ftell(fd);
   fseek(fd, 0, SEEK_SET);
 
-  nreads = fread(out_, sizeof(char), nelems, fd);
-  bool const succeed = (nreads == nelems) || (feof(fd) && !ferror(fd));
+  out.resize(static_cast<size_t>((nelems > 0) ? nelems : 0));
+  size_t const nreads = fread(out.data(), sizeof(char), out.size(), fd);
+  bool const succeed = (nreads == out.size()) || (feof(fd) && !ferror(fd));
   fclose(fd);
 
+  out.resize(nreads);
+
   return succeed;
 }
 
@@ -84,108 +78,85 @@ bool IsSpecialFile(char const* fn) {
   return false;
 }
 
-/* Read the shader and process the #include preprocessors. */
-bool ReadShaderFile(char const* filename, unsigned int const maxsize, char out[], int *level) {
-  char const * substr = "#include \"";
-  size_t const len = strlen(substr);
-  char *first = nullptr;
-  char *last = nullptr;
-  char include_fn[64u]{0};
-  char include_path[256u]{0};
-  size_t include_len = 0u;
+std::string_view TrimLeft(std::string_view str) {
+  size_t const first = str.find_first_not_of(" \t");
+  return (first != std::string_view::npos) ? str.substr(first) : std::string_view();
+}
 
-  /* Prevent long recursive includes */
-  if (*level <= 0) {
-    return false;
-  }
-  --(*level);
+bool StartsWith(std::string_view str, std::string_view prefix) {
+  return str.substr(0, prefix.size()) == prefix;
+}
 
-  /* Read the shaders */
-  if (!ReadFile(filename, maxsize, out)) {
-    return false;
+/* Return the identifier following a directive, when the line starts with it. */
+std::string_view DirectiveToken(std::string_view line, std::string_view directive) {
+  if (!StartsWith(line, directive)) {
+    return std::string_view();
   }
+  auto const str = TrimLeft(line.substr(directive.size()));
+  return str.substr(0, str.find_first_of(" \t\r\n/"));
+}
 
-  /* Check for include file an retrieve its name */
-  last = out;
-
-  s_debugSpacing--;
-
-  while (nullptr != (first = strstr(last, substr))) {
-    /* pass commented include directives */
-    if ((first != out) && (*(first-1) != '\n')) {
-      last = first + 1;
-      continue;
-    }
-    first += len;
-
-    last = strchr(first, '"');
-    if (!last) {
-      return false;
-    }
-
-    /* Copy the include file name */
-    include_len = static_cast<size_t>(last-first);
-    strncpy(include_fn, first, include_len);
-    include_fn[include_len] = '\0';
-
-    LOG_DEBUG( &spaces[s_debugSpacing], ">", include_fn );
-
-    /* Set include global path */
-    sprintf(include_path, "%s/%s", SHADERS_DIR, include_fn);
-
-    /* Create memory to hold the include file */
-    char *include_file = reinterpret_cast<char*>(calloc(maxsize, sizeof(char)));
-
-    /* Retrieve the include file */
-    if (!IsSpecialFile(include_path)) {
-      ReadShaderFile(include_path, maxsize, include_file, level);
+/* Return true when the text is wrapped inside an '#ifndef X / #define X / #endif' guard. */
+bool HasIncludeGuard(std::string_view text) {
+  // Retrieve the significant lines, skipping blank and comment lines.
+  std::vector<std::string_view> lines;
+  for (size_t begin = 0u; begin < text.size(); ) {
+    size_t end = text.find('\n', begin);
+    end = (end == std::string_view::npos) ? text.size() : end + 1u;
+    auto const line = TrimLeft(text.substr(begin, end - begin));
+    if (!line.empty() && (line[0] != '\r') && (line[0] != '\n') && !StartsWith(line, "//")) {
+      lines.push_back(line);
     }
-
-    /* Add the line directive to the included file */
-    sprintf(include_file, "%s\n#line 0", include_file);
-
-    /* Add the second part of the shader */
-    last = strchr(last, '\n');
-    sprintf(include_file, "%s\n%s", include_file, last);
-
-    /* Copy it back to the shader buffer */
-    sprintf(first-len, "%s", include_file);
-
-    /* Free include file data */
-    free(include_file);
+    begin = end;
   }
-  s_debugSpacing++;
-
-  return true;
-}
 
-bool ReadShaderFile(std::string_view filename, int32_t const maxsize, char out[]) {
-  /// Simple way to deal with include recursivity, without reading guards.
-  /// Known limitations : do not handle loop well.
-
-  LOG_DEBUG_INFO(filename);
-
-  int max_level = 32;
-  bool const result = ReadShaderFile(filename.data(), maxsize, out, &max_level);
-  if (max_level < 0) {
-    LOG_ERROR( filename, ": too many nested includes found.");
+  if (lines.size() < 3u) {
+    return false;
   }
-  return result;
+  auto const guard = DirectiveToken(lines[0], "#ifndef");
+  return !guard.empty() 
+      && (guard == DirectiveToken(lines[1], "#define"))
+      && StartsWith(lines.back(), "#endif")
+      ;
 }
 
-
 } // namespace
 
 // ----------------------------------------------------------------------------
 
 void Shader::release() {
-  if (loaded()) {
+  if (compiled()) {
     glDeleteShader(id);
     id = 0u;
   }
+  code.clear();
+  files.clear();
   CHECK_GX_ERROR();
 }
 
+bool Shader::compile(std::string_view name) {
+  if (compiled()) {
+    return true;
+  }
+
+  GLchar const* src = code.c_str();
+  id = glCreateShader( target() );
+  glShaderSource(id, 1, &src, nullptr);
+  glCompileShader(id);
+
+  if (!gx::CheckShaderStatus(id, name)) {
+    // Display the files source-string numbers used in the log.
+    for (size_t i = 0u; i < files.size(); ++i) {
+      LOG_MESSAGE( " *", i, ":", files[i] );
+    }
+    glDeleteShader(id);
+    id = 0u;
+    return false;
+  }
+
+  return true;
+}
+
 int Shader::target() const {
   std::array<GLenum, ShaderType::kNumShaderType> constexpr targets{
     GL_VERTEX_SHADER, 
@@ -201,27 +172,222 @@ int Shader::target() const {
 
 // ----------------------------------------------------------------------------
 
+bool ShaderManager::update_sources(ResourceId const& id, fs::file_time_type sys_lw) {
+  // Drop the file content, it will be read back on next use.
+  sources_.erase(id);
+  preprocessed_.erase(id);
+
+  if (includers_.find(id) == includers_.end()) {
+    return false;
+  }
+
+  if (sys_lw == kDeletedLastWrite) {
+    LOG_WARNING( "[VERSIONING] \"", id.path, "\" : file not found.");
+    return false;
+  }
+
+  // Find every files depending on the include, invalidating their preprocessed code.
+  std::vector<ResourceId> stack{ id };
+  DependencySet_t visited{ id };
+  std::vector<ResourceId> roots;
+
+  while (!stack.empty()) {
+    auto const current = stack.back();
+    stack.pop_back();
+
+    if (auto const it = includers_.find(current); it != includers_.end()) {
+      for (auto const& includer : it->second) {
+        if (visited.insert(includer).second) {
+          preprocessed_.erase(includer);
+          roots.push_back(includer);
+          stack.push_back(includer);
+        }
+      }
+    }
+  }
+
+  // Reload the tracked shaders, so their programs are relinked on asset update.
+  bool bUpdated = false;
+  for (auto const& root : roots) {
+    if (has(root)) {
+      bUpdated = reload(root, last_write(root)) || bUpdated;
+    }
+  }
+
+  return bUpdated;
+}
+
 ShaderManager::Handle ShaderManager::_load(ResourceId const& id) {
   ShaderManager::Handle h(id);
 
   std::string const& filename(id.path);
-  if (!ReadShaderFile(filename, kMaxShaderBufferSize, buffer_)) {
-    LOG_WARNING( "ShaderManager : unknown file \"", filename, "\"." );
-    return h;
+
+  // Preprocess the shader, unless it has not been modified.
+  auto it = preprocessed_.find(id);
+  if (it == preprocessed_.end()) {
+    LOG_DEBUG_INFO(filename);
+
+    // Rebuild the shader direct dependencies.
+    clear_dependencies(id);
+
+    Preprocessed_t pp;
+    if (!preprocess(id, pp)) {
+      LOG_WARNING( "ShaderManager : could not preprocess \"", filename, "\"." );
+      return h;
+    }
+    it = preprocessed_.emplace(id, std::move(pp)).first;
   }
+  auto const& pp = it->second;
+
+  // Store the shader, it is compiled when used by a program.
   auto shader = h.data;
+  shader->type  = GetShaderTypeFromName(h.name);
+  shader->hash  = pp.hash;
+  shader->code  = pp.code;
+  shader->files = pp.files;
+
+  return h;
+}
+
+// ----------------------------------------------------------------------------
 
-  // Compile and store the shader.
-  shader->type = GetShaderTypeFromName(h.name);
-  shader->id = glCreateShader( shader->target() );
-  glShaderSource(shader->id, 1, (const GLchar**)&buffer_, nullptr);
-  glCompileShader(shader->id);
-  
-  if (!gx::CheckShaderStatus(shader->id, h.name.c_str())) {
-    shader->release();
+ShaderManager::SourceFile_t const* ShaderManager::get_source(ResourceId const& id) {
+  if (auto const it = sources_.find(id); it != sources_.end()) {
+    return &(it->second);
   }
 
-  return h;
+  SourceFile_t src;
+  if (!ReadFile(id.path, src.text)) {
+    return nullptr;
+  }
+
+  // The file include edges are rebuilt while expanding it.
+  clear_dependencies(id);
+
+  // Retrieve the directives handled by the preprocessor.
+  constexpr std::string_view kIncludeToken{ "#include \"" };
+  constexpr std::string_view kPragmaOnceToken{ "#pragma once" };
+
+  std::string_view const text( src.text );
+  int32_t line = 1;
+  for (size_t begin = 0u; begin < text.size(); ++line) {
+    size_t end = text.find('\n', begin);
+    end = (end == std::string_view::npos) ? text.size() : end + 1u;
+    auto const str = TrimLeft(text.substr(begin, end - begin));
+
+    if (StartsWith(str, kIncludeToken)) {
+      auto const first = kIncludeToken.size();
+      if (auto const last = str.find('"', first); last != std::string_view::npos) {
+        // (includes path are relative to the shaders directory)
+        std::string const path = std::string(SHADERS_DIR "/") + std::string(str.substr(first, last - first));
+        src.directives.push_back({ 
+          begin, end, line, IsSpecialFile(path.c_str()) ? ResourceId(nullptr) : ResourceId(path)
+        });
+      } else {
+        LOG_WARNING( id.path, ": invalid include directive at line", line );
+      }
+    } else if (StartsWith(str, kPragmaOnceToken)) {
+      src.bOnce = true;
+      src.directives.push_back({ begin, end, line, ResourceId(nullptr) });
+    }
+
+    begin = end;
+  }
+  src.bOnce = src.bOnce || HasIncludeGuard(text);
+
+  return &(sources_.insert_or_assign(id, std::move(src)).first->second);
 }
 
-// ----------------------------------------------------------------------------
\ No newline at end of file
+bool ShaderManager::preprocess(ResourceId const& id, Preprocessed_t &out) {
+  DependencySet_t once;
+  out.code.clear();
+  out.files.assign(1u, id.path);
+
+  if (!expand(id, 0, 0, once, out)) {
+    return false;
+  }
+  out.hash = std::hash<std::string>{}(out.code);
+
+  return true;
+}
+
+bool ShaderManager::expand(ResourceId const& id, int32_t file_index, int32_t depth, DependencySet_t &once, Preprocessed_t &out) {
+  auto const* src = get_source(id);
+  if (nullptr == src) {
+    return false;
+  }
+  if (src->bOnce) {
+    once.insert(id);
+  }
+
+  auto const& text = src->text;
+  size_t cursor = 0u;
+
+  for (auto const& directive : src->directives) {
+    out.code.append(text, cursor, directive.begin - cursor);
+    cursor = directive.end;
+
+    // (directives are replaced by blank lines to keep the lines count)
+    auto const& include = directive.include;
+    if (include.path.empty()) {
+      out.code += '\n';
+      continue;
+    }
+
+    add_dependency(id, include);
+
+    // Skip files included only once.
+    if (once.find(include) != once.end()) {
+      out.code += '\n';
+      continue;
+    }
+
+    if (depth >= kMaxIncludeDepth) {
+      LOG_ERROR( id.path, ": too many nested includes found.");
+      return false;
+    }
+
+    LOG_DEBUG( std::string(2 * depth, ' '), ">", Logger::TrimFilename(include.path) );
+
+    // Retrieve the include source-string number.
+    auto const file = std::find(out.files.begin(), out.files.end(), include.path);
+    auto const include_index = static_cast<int32_t>(std::distance(out.files.begin(), file));
+    if (file == out.files.end()) {
+      out.files.push_back(include.path);
+    }
+
+    out.code += "#line 1 " + std::to_string(include_index) + "\n";
+    if (!expand(include, include_index, depth + 1, once, out)) {
+      return false;
+    }
+    if (out.code.back() != '\n') {
+      out.code += '\n';
+    }
+    out.code += "#line " + std::to_string(directive.line + 1) + " " + std::to_string(file_index) + "\n";
+  }
+  out.code.append(text, cursor, std::string::npos);
+
+  return true;
+}
+
+void ShaderManager::add_dependency(ResourceId const& includer, ResourceId const& include) {
+  includes_[includer].insert(include);
+
+  // Watch new include files for modifications.
+  auto &includers = includers_[include];
+  if (includers.empty() && watcher_) {
+    watcher_->watch(include.path);
+  }
+  includers.insert(includer);
+}
+
+void ShaderManager::clear_dependencies(ResourceId const& includer) {
+  if (auto const it = includes_.find(includer); it != includes_.end()) {
+    for (auto const& include : it->second) {
+      includers_[include].erase(includer);
+    }
+    includes_.erase(it);
+  }
+}
+
+// ----------------------------------------------------------------------------
@@ -1,16 +1,27 @@
 #ifndef BARBU_MEMORY_RESOURCES_SHADER_H_
 #define BARBU_MEMORY_RESOURCES_SHADER_H_
 
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
 #include "memory/resource_manager.h"
 
 // ----------------------------------------------------------------------------
 //
-//  Note : Include shaders are not live-tracked for now, their root files should
-//         be touched to be hot-reloaded.
+//  Note : Include shaders are live-tracked via a dependency graph between the
+//         shader files and their includes. When an include is modified only the
+//         shaders depending on it, directly or not, are reloaded.
+//
+//         Source files are parsed once and the preprocessed code of each shader
+//         is kept until one of its files is modified, so shaders are reloaded
+//         without accessing the disk.
 //
-//         An easy implementation would track the includers of each includee in
-//         a separate hashmap of set of resourceId, and on reload, if the shader
-//         is an include, reload back its parents.
+//         The preprocessor splices '#include "path"' directives (relative to the
+//         shaders directory) and include files only once when they have a
+//         '#pragma once' or an include guard. '#line' directives use the index
+//         of the file in the preprocessed file table as source-string number.
 //
 // ----------------------------------------------------------------------------
 
@@ -27,9 +38,16 @@ enum /*class*/ ShaderType {
   kNumShaderType
 };
 
+//
+// A shader is loaded as preprocessed code and compiled on demand, so programs
+// restored from a binary do not compile it.
+//
 struct Shader : public Resource {
   ShaderType type;
   uint32_t id = 0;
+  size_t hash = 0u;                 //< hash of the preprocessed code.
+  std::string code;                 //< preprocessed code.
+  std::vector<std::string> files;   //< source-string numbers used by '#line'.
 
   ~Shader() {
     release();
@@ -38,6 +56,13 @@ struct Shader : public Resource {
   void release() final;
 
   bool loaded() const noexcept final {
+    return !code.empty();
+  }
+
+  // Compile the shader when it was not already, return true on success.
+  bool compile(std::string_view name);
+
+  inline bool compiled() const noexcept {
     return id > 0;
   }
 
@@ -49,24 +74,68 @@ struct Shader : public Resource {
 
 class ShaderManager : public ResourceManager<Shader> {
  public:
-  // Maximum size per shader file with includes (64 Kb).
-  static constexpr int32_t kMaxShaderBufferSize = 64 * 1024;
-
- public:
-  ShaderManager() {
-    buffer_ = new char[kMaxShaderBufferSize]{};
-  }
+  // Maximum depth of nested includes.
+  static constexpr int32_t kMaxIncludeDepth = 32;
 
-  ~ShaderManager() {
-    delete [] buffer_;
-    buffer_ = nullptr;
-  }
+  // Invalidate the cached sources of a modified file and reload the shaders
+  // including it. Return true when any shader was reloaded.
+  bool update_sources(ResourceId const& id, fs::file_time_type sys_lw);
 
  private:
+  using DependencySet_t = std::unordered_set<ResourceId>;
+  using DependencyMap_t = std::unordered_map<ResourceId, DependencySet_t>;
+
+  // Source file read and parsed once, until it is modified.
+  struct SourceFile_t {
+    // Line holding a directive handled by the preprocessor.
+    struct Directive_t {
+      size_t begin = 0u;    //< offset of the line.
+      size_t end   = 0u;    //< offset past the line.
+      int32_t line = 0;     //< line number, starting at 1.
+      ResourceId include{ nullptr };  //< included file, empty for removed directives.
+    };
+
+    std::string text;
+    std::vector<Directive_t> directives;
+    bool bOnce = false;     //< has '#pragma once' or an include guard.
+  };
+
+  // Preprocessed code of a shader.
+  struct Preprocessed_t {
+    std::string code;
+    std::vector<std::string> files;   //< source-string numbers used by '#line'.
+    size_t hash = 0u;                 //< hash of the code.
+  };
+
   Handle _load(ResourceId const& id) final;
   Handle _load_internal(ResourceId const& id, int32_t size, void const* data, std::string_view mime_type) final { return Handle(); }
 
-  char *buffer_ = nullptr;
+  /* Return the parsed source file, reading it when it is not cached. */
+  SourceFile_t const* get_source(ResourceId const& id);
+
+  /* Preprocess a shader file, splicing its includes. */
+  bool preprocess(ResourceId const& id, Preprocessed_t &out);
+
+  /* Append a file and its includes recursively to the output. */
+  bool expand(ResourceId const& id, int32_t file_index, int32_t depth, DependencySet_t &once, Preprocessed_t &out);
+
+  /* Add an include edge to the dependency graph. */
+  void add_dependency(ResourceId const& includer, ResourceId const& include);
+
+  /* Remove the include edges starting from a file. */
+  void clear_dependencies(ResourceId const& includer);
+
+  // Files directly included by a file.
+  DependencyMap_t includes_;
+
+  // Files directly including a file.
+  DependencyMap_t includers_;
+
+  // Source files, by path.
+  std::unordered_map<ResourceId, SourceFile_t> sources_;
+
+  // Preprocessed shaders, by path.
+  std::unordered_map<ResourceId, Preprocessed_t> preprocessed_;
 };
 
 // ----------------------------------------------------------------------------
@@ -0,0 +1,67 @@
+#ifndef BARBU_MEMORY_SPSC_QUEUE_H_
+#define BARBU_MEMORY_SPSC_QUEUE_H_
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+// ----------------------------------------------------------------------------
+
+//
+// Bounded lock-free queue with a single producer thread and a single consumer
+// thread.
+//
+// The capacity must be a power of two, one slot is always kept free.
+//
+template<typename T, size_t kCapacity>
+class SPSCQueue {
+  static_assert((kCapacity >= 2u) && (0u == (kCapacity & (kCapacity - 1u))),
+    "Capacity must be a power of two."
+  );
+
+ public:
+  SPSCQueue() = default;
+
+  /* Producer side, return false when the queue is full. */
+  bool push(T value) {
+    size_t const tail = tail_.load(std::memory_order_relaxed);
+    size_t const next = (tail + 1u) & kMask;
+    if (next == head_.load(std::memory_order_acquire)) {
+      return false;
+    }
+    buffer_[tail] = std::move(value);
+    tail_.store(next, std::memory_order_release);
+    return true;
+  }
+
+  /* Consumer side, return false when the queue is empty. */
+  bool pop(T &value) {
+    size_t const head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire)) {
+      return false;
+    }
+    value = std::move(buffer_[head]);
+    head_.store((head + 1u) & kMask, std::memory_order_release);
+    return true;
+  }
+
+  inline bool empty() const noexcept {
+    return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+  }
+
+ private:
+  static constexpr size_t kMask = kCapacity - 1u;
+
+  std::array<T, kCapacity> buffer_;
+  alignas(64) std::atomic<size_t> head_{0u};
+  alignas(64) std::atomic<size_t> tail_{0u};
+
+ private:
+  SPSCQueue(SPSCQueue const&) = delete;
+  SPSCQueue(SPSCQueue&&) = delete;
+};
+
+// ----------------------------------------------------------------------------
+
+#endif // BARBU_MEMORY_SPSC_QUEUE_H_
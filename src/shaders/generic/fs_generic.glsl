@@ -17,6 +17,7 @@ layout(location = 1) out vec4 fragExtra;
 // ----------------------------------------------------------------------------
 
 #include "shared/lighting/inc_pbr.glsl"
+#include "shared/lighting/inc_clusters.glsl"
 #include "shared/structs/inc_fraginfo.glsl"
 #include "shared/structs/inc_material.glsl"
 #include "shared/inc_tonemapping.glsl"
@@ -26,11 +27,19 @@ layout(location = 1) out vec4 fragExtra;
 uniform sampler2D uBRDFMap;
 uniform samplerCube uPrefilterEnvmap;
 uniform samplerCube uIrradianceEnvmap;
-uniform mat4 uIrradianceMatrices[3];
-uniform bool uHasIrradianceMatrices;
-uniform vec3 uEyePosWS;
+layout(std140, binding = UNIFORM_BINDING_FRAME) uniform FrameBlock {
+  FrameUniforms_t uFrame;
+};
 uniform int uToneMapMode = TONEMAPPING_NONE;
 
+// Lights indices of the view clusters.
+layout(std430, binding = STORAGE_BINDING_CLUSTER_COUNTS) readonly buffer ClusterCountBuffer {
+  uint uClusterCounts[];
+};
+layout(std430, binding = STORAGE_BINDING_CLUSTER_INDICES) readonly buffer ClusterIndexBuffer {
+  uint uClusterIndices[];
+};
+
 // Uniforms : Generic Material.
 uniform int uColorMode;
 uniform vec4 uColor;
@@ -86,7 +95,7 @@ FragInfo_t get_worldspace_fraginfo() {
   
   frag.P        = inPositionWS;
   frag.N        = get_normal();
-  frag.V        = normalize( uEyePosWS - frag.P );
+  frag.V        = normalize( uFrame.eyePosWS - frag.P );
   frag.R        = reflect( -frag.V, frag.N);
   frag.uv       = inTexcoord.xy;
   frag.n_dot_v  = dot(frag.N, frag.V); //
@@ -104,12 +113,12 @@ FragInfo_t get_worldspace_fraginfo() {
 vec3 get_irradiance(in vec3 normal_ws) {
   vec3 irradiance = vec3(0.0);
 
-  if (uHasIrradianceMatrices) {
+  if (uFrame.hasIrradianceMatrices != 0) {
     const vec4 n = vec4( normal_ws, 1.0);
     irradiance = vec3(
-      dot( n, uIrradianceMatrices[0] * n),
-      dot( n, uIrradianceMatrices[1] * n),
-      dot( n, uIrradianceMatrices[2] * n)
+      dot( n, uFrame.irradianceMatrices[0] * n),
+      dot( n, uFrame.irradianceMatrices[1] * n),
+      dot( n, uFrame.irradianceMatrices[2] * n)
     );
   } else {
     const float kIrradianceMapFactor = 0.5; //
@@ -169,13 +178,37 @@ Material_t get_material(in FragInfo_t frag) {
 
 // ----------------------------------------------------------------------------
 
+// Reflected radiance of the directional lights and of the local lights of the fragment's cluster.
+vec3 get_direct_lighting(in FragInfo_t frag, in Material_t mat) {
+  const BRDFMaterial_t brdf_mat = get_brdf_material(mat);
+  vec3 L0 = vec3(0.0);
+
+  for (int i = 0; i < uClusters.numDirectionals; ++i) {
+    L0 += get_pbr_radiance( get_fraglight_params(uLights[i], frag), frag, brdf_mat);
+  }
+
+  const float view_depth = - (uClusters.viewMatrix * vec4(frag.P, 1.0)).z;
+  const int cluster = get_cluster_index( gl_FragCoord.xy, view_depth);
+  const uint first = uint(cluster * CLUSTER_MAX_LIGHTS);
+  const uint count = uClusterCounts[cluster];
+
+  for (uint i = 0u; i < count; ++i) {
+    const LightInfo_t light = uLights[uClusterIndices[first + i]];
+    L0 += get_pbr_radiance( get_fraglight_params(light, frag), frag, brdf_mat);
+  }
+
+  return L0;
+}
+
+// ----------------------------------------------------------------------------
+
 vec4 colorize(in int color_mode, in FragInfo_t frag, in Material_t mat) {
   vec3 rgb;
 
   switch (color_mode) {
     default:
     case MATERIAL_GENERIC_COLOR_MODE_PBR:
-      rgb = colorize_pbr( frag, mat); 
+      rgb = colorize_pbr( frag, mat, get_direct_lighting(frag, mat)); 
     break;
 
     case MATERIAL_GENERIC_COLOR_MODE_UNLIT:
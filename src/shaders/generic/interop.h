@@ -1,6 +1,11 @@
 #ifndef SHADERS_GENERIC_INTEROP_H_
 #define SHADERS_GENERIC_INTEROP_H_
 
+#ifdef __cplusplus
+#include "glm/glm.hpp"
+using namespace glm;
+#endif
+
 // ----------------------------------------------------------------------------
 
 #define MATERIAL_GENERIC_COLOR_MODE_PBR           0
@@ -19,6 +24,32 @@
 #define VERTEX_ATTRIB_JOINT_INDICES               4
 #define VERTEX_ATTRIB_JOINT_WEIGHTS               5
 
+#define UNIFORM_BINDING_FRAME                     0
+
+#define STORAGE_BINDING_DRAWS                     0
+
+// ----------------------------------------------------------------------------
+
+// Uniform blocks use the std140 layout and storage blocks the std430 one :
+// members are ordered to avoid implicit padding, so the structs match on both sides.
+
+/* Uniforms shared by every draw of a frame. */
+struct FrameUniforms_t {
+  mat4 irradianceMatrices[3];
+  vec3 eyePosWS;
+  int hasIrradianceMatrices;
+};
+
+/* Uniforms specific to a draw, stored for every draws of a frame. */
+struct DrawUniforms_t {
+  mat4 mvp;
+  mat4 modelMatrix;
+  int skinningOffset;     // first texel of the skinning palette, -1 when unskinned
+  int _pad0;
+  int _pad1;
+  int _pad2;
+};
+
 // ----------------------------------------------------------------------------
 
 #endif // SHADERS_GENERIC_INTEROP_H_
\ No newline at end of file
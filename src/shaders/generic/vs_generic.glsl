@@ -1,4 +1,5 @@
 #version 430 core
+#extension GL_ARB_shader_draw_parameters : require
 
 #include "generic/interop.h"
 
@@ -22,29 +23,35 @@ layout(location = 3) out vec4 outTangentWS;
 
 #include "shared/inc_skinning.glsl"
 
-// Uniforms.
-uniform mat4 uModelMatrix;
-uniform mat4 uMVP; // [use viewProj instead ?]
+// Per-draw uniforms of the frame, indexed by instance.
+layout(std430, binding = STORAGE_BINDING_DRAWS) readonly buffer DrawBuffer {
+  DrawUniforms_t uDraws[];
+};
+
+// Index of the first draw, for direct draws without base instance.
+uniform int uFirstDraw;
 
 // ----------------------------------------------------------------------------
 
 void main() {
+  const DrawUniforms_t uDraw = uDraws[uFirstDraw + gl_BaseInstanceARB + gl_InstanceID];
+
   vec4 position = vec4(inPosition, 1.0);
   vec3 normal   = inNormal;
   vec3 tangent  = inTangent.xyz;
 
   // [should transform BTN too]
-  apply_skinning(inJointIndices, inJointWeights, position.xyz, normal); //
+  apply_skinning(uDraw.skinningOffset, inJointIndices, inJointWeights, position.xyz, normal); //
   
   // Transform vectors.
-  const mat3 normalMatrix = mat3(uModelMatrix);
+  const mat3 normalMatrix = mat3(uDraw.modelMatrix);
   normal  = normalize(normalMatrix * normal);
   tangent = normalize(normalMatrix * tangent);
 
   // Outputs.
-  gl_Position   = uMVP * position;
+  gl_Position   = uDraw.mvp * position;
   outTexcoord   = inTexcoord;
-  outPositionWS = (uModelMatrix * position).xyz;
+  outPositionWS = (uDraw.modelMatrix * position).xyz;
   outNormalWS   = normal;
   outTangentWS  = vec4(tangent, inTangent.w);
 }
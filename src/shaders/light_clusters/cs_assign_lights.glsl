@@ -0,0 +1,93 @@
+#version 430 core
+
+// ============================================================================
+
+/*
+ * Assign the local lights of the frame to the view-space clusters.
+ *
+ * Each thread tests the lights bounding sphere against the bounds of a single
+ * cluster, the lights being loaded in view-space by batches in shared memory.
+ * Lights indices are written in the fixed-size slots of the cluster, in
+ * increasing order and up to CLUSTER_MAX_LIGHTS, as with the host reference
+ * implementation (cf. LightClusters::AssignLights).
+ */
+
+// ============================================================================
+
+#include "shared/lighting/inc_clusters.glsl"
+
+// ----------------------------------------------------------------------------
+
+layout(std430, binding = STORAGE_BINDING_CLUSTER_BOUNDS)
+readonly buffer ClusterBoundsBuffer {
+  ClusterBounds_t bounds[];
+};
+
+layout(std430, binding = STORAGE_BINDING_CLUSTER_COUNTS)
+writeonly buffer ClusterCountBuffer {
+  uint counts[];
+};
+
+layout(std430, binding = STORAGE_BINDING_CLUSTER_INDICES)
+writeonly buffer ClusterIndexBuffer {
+  uint indices[];
+};
+
+shared vec4 sSpheres[CLUSTER_KERNEL_GROUP_WIDTH];
+
+// ----------------------------------------------------------------------------
+
+/* Squared distance from a point to a box. */
+float distance_sqr(in vec3 p, in vec3 box_min, in vec3 box_max) {
+  const vec3 d = max(max(box_min - p, p - box_max), vec3(0.0));
+  return dot(d, d);
+}
+
+// ----------------------------------------------------------------------------
+
+layout(local_size_x = CLUSTER_KERNEL_GROUP_WIDTH) in;
+void main() {
+  const uint cluster = gl_GlobalInvocationID.x;
+  const uint lid = gl_LocalInvocationID.x;
+  const bool bValid = cluster < uint(CLUSTER_COUNT);
+
+  vec3 box_min = vec3(0.0);
+  vec3 box_max = vec3(0.0);
+  if (bValid) {
+    box_min = bounds[cluster].minPoint.xyz;
+    box_max = bounds[cluster].maxPoint.xyz;
+  }
+
+  const uint first = cluster * uint(CLUSTER_MAX_LIGHTS);
+  uint count = 0u;
+
+  for (int batch = uClusters.numDirectionals; batch < uClusters.numLights; batch += CLUSTER_KERNEL_GROUP_WIDTH) {
+    // Load a batch of view-space bounding spheres.
+    const int light_index = batch + int(lid);
+    if (light_index < uClusters.numLights) {
+      const LightInfo_t light = uLights[light_index];
+      const vec3 position  = (uClusters.viewMatrix * vec4(light.position.xyz, 1.0)).xyz;
+      const vec3 direction = mat3(uClusters.viewMatrix) * light.direction.xyz;
+      sSpheres[lid] = get_light_bounding_sphere( light, position, direction);
+    }
+    barrier();
+
+    // Test them against the cluster bounds.
+    const int nlights = min(CLUSTER_KERNEL_GROUP_WIDTH, uClusters.numLights - batch);
+    for (int i = 0; bValid && (i < nlights); ++i) {
+      const vec4 sphere = sSpheres[i];
+      if ((count < uint(CLUSTER_MAX_LIGHTS))
+       && (distance_sqr(sphere.xyz, box_min, box_max) <= sphere.w * sphere.w)) {
+        indices[first + count] = uint(batch + i);
+        ++count;
+      }
+    }
+    barrier();
+  }
+
+  if (bValid) {
+    counts[cluster] = count;
+  }
+}
+
+// ----------------------------------------------------------------------------
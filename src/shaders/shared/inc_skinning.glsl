@@ -5,6 +5,8 @@
 
 // ----------------------------------------------------------------------------
 
+// Skinning palettes of every skinned draws, each draw indexes its own from its
+// first texel offset.
 layout(binding = 0) uniform samplerBuffer uSkinningDatas;
 
 // layout(std430, binding = SSBO_SKINNING_DATA_READ)
@@ -12,30 +14,30 @@ layout(binding = 0) uniform samplerBuffer uSkinningDatas;
 //   vec4 read_skinning[];
 // };
 
-subroutine void skinning_subroutine(in uvec4 _indices, in vec4 _weights, inout vec3 v, inout vec3 n);
+subroutine void skinning_subroutine(in int _offset, in uvec4 _indices, in vec4 _weights, inout vec3 v, inout vec3 n);
 subroutine uniform skinning_subroutine uSkinning;
 
 const int kNoJoint = 0xff;
 
 // ----------------------------------------------------------------------------
 
-void apply_skinning(in uvec4 _indices, in vec4 _weights, inout vec3 position, inout vec3 normal) {
-  if (_weights.x <= Epsilon()) {
+void apply_skinning(in int _offset, in uvec4 _indices, in vec4 _weights, inout vec3 position, inout vec3 normal) {
+  if ((_offset < 0) || (_weights.x <= Epsilon())) {
     return;
   }
 
   // (we can send only three weights and derive the 4th from them)
   _weights.w = 1.0f - (_weights.x + _weights.y + _weights.z);
 
-  uSkinning(_indices, _weights, position, normal);
+  uSkinning(_offset, _indices, _weights, position, normal);
 }
 
 ///----------------------------------------------------------------------------
 /// SKINNING : DUAL QUATERNION BLENDING
 ///----------------------------------------------------------------------------
 
-void get_dual_quaternions_matrices(in uvec4 _indices, out mat4 Ma, out mat4 Mb) {
-  const ivec4 indices = 2 * ivec4(_indices);
+void get_dual_quaternions_matrices(in int _offset, in uvec4 _indices, out mat4 Ma, out mat4 Mb) {
+  const ivec4 indices = _offset + 2 * ivec4(_indices);
 
   /// Retrieve the real (Ma) and dual (Mb) part of the dual-quaternions.
   Ma[0] = texelFetch(uSkinningDatas, indices.x+0);
@@ -52,14 +54,14 @@ void get_dual_quaternions_matrices(in uvec4 _indices, out mat4 Ma, out mat4 Mb)
 }
 
 subroutine(skinning_subroutine)
-void skinning_DQBS(in uvec4 _indices, in vec4 _weights, inout vec3 v, inout vec3 n) {
+void skinning_DQBS(in int _offset, in uvec4 _indices, in vec4 _weights, inout vec3 v, inout vec3 n) {
   /// Paper :
   ///   "Geometric Skinning with Approximate Dual Quaternion Blending"
   ///   - Kavan et al 2008
 
   // Retrieve the dual quaternions.
   mat4 Ma, Mb;
-  get_dual_quaternions_matrices(_indices, Ma, Mb);
+  get_dual_quaternions_matrices(_offset, _indices, Ma, Mb);
 
   // Handles antipodality by sticking joints in the same neighbourhood.
   _weights.xyz *= sign(Ma[3] * mat3x4(Ma));
@@ -86,23 +88,23 @@ void skinning_DQBS(in uvec4 _indices, in vec4 _weights, inout vec3 v, inout vec3
 /// SKINNING : LINEAR BLENDING
 ///----------------------------------------------------------------------------
 
-void get_skinning_matrix(in uint _jointId, out mat3x4 skMatrix) {
+void get_skinning_matrix(in int _offset, in uint _jointId, out mat3x4 skMatrix) {
   if (_jointId == kNoJoint) {
     skMatrix = mat3x4(1.0f);
     return;
   }
 
-  const int matrixId = 3 * int(_jointId);
+  const int matrixId = _offset + 3 * int(_jointId);
   skMatrix[0] = texelFetch(uSkinningDatas, matrixId + 0);
   skMatrix[1] = texelFetch(uSkinningDatas, matrixId + 1);
   skMatrix[2] = texelFetch(uSkinningDatas, matrixId + 2);
 }
 
-void get_skinning_matrices(in uvec4 _indices, out mat3x4 matrices[4]) {
-  get_skinning_matrix(_indices.x, matrices[0]);
-  get_skinning_matrix(_indices.y, matrices[1]);
-  get_skinning_matrix(_indices.z, matrices[2]);
-  get_skinning_matrix(_indices.w, matrices[3]);
+void get_skinning_matrices(in int _offset, in uvec4 _indices, out mat3x4 matrices[4]) {
+  get_skinning_matrix(_offset, _indices.x, matrices[0]);
+  get_skinning_matrix(_offset, _indices.y, matrices[1]);
+  get_skinning_matrix(_offset, _indices.z, matrices[2]);
+  get_skinning_matrix(_offset, _indices.w, matrices[3]);
 }
 
 vec3 apply_skinning_matrices(in vec4 _vertex, in mat3x4 _matrices[4], in vec4 _weights) {
@@ -118,10 +120,10 @@ vec3 apply_skinning_matrices(in vec4 _vertex, in mat3x4 _matrices[4], in vec4 _w
 }
 
 subroutine(skinning_subroutine)
-void skinning_LBS(in uvec4 _indices, in vec4 _weights, inout vec3 v, inout vec3 n) {
+void skinning_LBS(in int _offset, in uvec4 _indices, in vec4 _weights, inout vec3 v, inout vec3 n) {
   // Retrieve skinning matrices.
   mat3x4 jointMatrices[4];
-  get_skinning_matrices( _indices, jointMatrices);
+  get_skinning_matrices( _offset, _indices, jointMatrices);
 
   // Transforms.
   v = apply_skinning_matrices( vec4(v, 1.0), jointMatrices, _weights);
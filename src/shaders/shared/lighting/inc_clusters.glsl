@@ -0,0 +1,50 @@
+#ifndef SHADERS_SHARED_LIGHTING_INC_CLUSTERS_GLSL_
+#define SHADERS_SHARED_LIGHTING_INC_CLUSTERS_GLSL_
+
+#include "shared/lighting/interop.h"          // LightInfo_t, LightClustersUniforms_t
+#include "shared/inc_constants.glsl"          // Epsilon()
+
+// ----------------------------------------------------------------------------
+
+layout(std140, binding = UNIFORM_BINDING_LIGHT_CLUSTERS) uniform LightClustersBlock {
+  LightClustersUniforms_t uClusters;
+};
+
+// Lights of the frame, directional ones first.
+layout(std430, binding = STORAGE_BINDING_LIGHTS) readonly buffer LightBuffer {
+  LightInfo_t uLights[];
+};
+
+// ----------------------------------------------------------------------------
+
+/* Return the index of the cluster containing a fragment, from its window coordinates and view depth. */
+int get_cluster_index(in vec2 frag_coord, in float view_depth) {
+  const ivec3 grid_dim = ivec3(CLUSTER_GRID_X, CLUSTER_GRID_Y, CLUSTER_GRID_Z);
+
+  const int slice = int(floor(log(max(view_depth, Epsilon())) * uClusters.sliceScale + uClusters.sliceBias));
+  const ivec3 cell = clamp(ivec3(frag_coord / uClusters.tileSize, slice), ivec3(0), grid_dim - 1);
+
+  return cell.x + grid_dim.x * (cell.y + grid_dim.y * cell.z);
+}
+
+/* Return the bounding sphere of a point or spot light, in the space of its position and direction. */
+vec4 get_light_bounding_sphere(in LightInfo_t light, in vec3 position, in vec3 direction) {
+  const float range = light.params.x;
+
+  if (int(light.position.w) != LIGHT_TYPE_SPOT) {
+    return vec4(position, range);
+  }
+
+  // Wide cones are bounded by their base, narrow ones by the sphere through their apex and base.
+  const float cos_outer = light.params.y;
+  if (cos_outer < 0.70710678) {
+    const float sin_outer = sqrt(max(1.0 - cos_outer * cos_outer, 0.0));
+    return vec4(position + direction * (range * cos_outer), range * sin_outer);
+  }
+  const float radius = range / (2.0 * cos_outer);
+  return vec4(position + direction * radius, radius);
+}
+
+// ----------------------------------------------------------------------------
+
+#endif // SHADERS_SHARED_LIGHTING_INC_CLUSTERS_GLSL_
@@ -7,12 +7,6 @@
 
 // ----------------------------------------------------------------------------
 
-// const int kMaxNumLights = 4;
-// uniform LightInfo_t uLightInfos[kMaxNumLights];
-// uniform int uNumLights = 0;
-
-// ----------------------------------------------------------------------------
-
 /* Fragment specific light parameters. */
 struct FragLight_t {
   vec3 L;               //< Fragment to light vector (normalized).
@@ -28,12 +22,23 @@ FragLight_t get_fraglight_params(in LightInfo_t light_info, in FragInfo_t frag_i
 
   const int light_type = int(light_info.position.w);
 
-  if (light_type == LIGHT_TYPE_POINT) 
+  if ((light_type == LIGHT_TYPE_POINT) || (light_type == LIGHT_TYPE_SPOT)) 
   {
     const vec3 to_light = light_info.position.xyz - frag_info.P; 
     const float d_sqr   = max(dot( to_light, to_light), Epsilon());
     light.L             = to_light * inversesqrt(d_sqr);
-    light.radiance      = light_info.color.rgb / d_sqr;
+
+    // Inverse square falloff, windowed to reach zero at the light range.
+    const float range_sqr = max(light_info.params.x * light_info.params.x, Epsilon());
+    const float window    = clamp(1.0 - pow(d_sqr / range_sqr, 2.0), 0.0, 1.0);
+    light.radiance        = light_info.color.rgb * (window * window / d_sqr);
+
+    // Angular falloff of the spot cone.
+    if (light_type == LIGHT_TYPE_SPOT) {
+      const float cos_angle = dot( -light.L, light_info.direction.xyz);
+      const float t = clamp((cos_angle - light_info.params.y) * light_info.params.z, 0.0, 1.0);
+      light.radiance *= t * t;
+    }
   } 
   else if (light_type == LIGHT_TYPE_DIRECTIONAL) 
   {
@@ -94,64 +94,30 @@ BRDFMaterial_t get_brdf_material(in Material_t mat) {
 
 // ----------------------------------------------------------------------------
 
-vec3 colorize_pbr(in FragInfo_t frag_info, in Material_t mat) {
-  //-----------
-  LightInfo_t uLightInfos[4];
-  const int uNumLights = 1;
-
-  LightInfo_t dirlight;
-  dirlight.position       = vec4(-5.0, 10.0, 10.0, LIGHT_TYPE_DIRECTIONAL);
-  dirlight.direction      = vec4(-normalize(dirlight.position.xyz), 1.0);
-  dirlight.color          = vec4(1.0, 1.0, 1.0, 1.0);
-
-  LightInfo_t keylight;
-  keylight.position       = vec4(0.0, 0.0, 0.0, LIGHT_TYPE_POINT);
-  keylight.direction      = vec4(-normalize(keylight.position.xyz), 1.0);
-  keylight.color          = vec4(1.0, 0.0, 0.0, 10.0);
-
-  LightInfo_t filllight;
-  filllight.position      = vec4(+4.0, -5.0, +8.0, LIGHT_TYPE_POINT);
-  filllight.direction     = vec4(-normalize(filllight.position.xyz), 1.0);
-  filllight.color         = vec4(0.0, 1.0, 0.0, 10.0);
-
-  LightInfo_t backlight;
-  backlight.position      = vec4(-10.0, 15.0, -6.0, LIGHT_TYPE_POINT);
-  backlight.direction     = vec4(-normalize(backlight.position.xyz), 1.0);
-  backlight.color         = vec4(0.1, 0.1, 1.0, 50.0);
-
-
-  uLightInfos[0] = dirlight;
-  uLightInfos[1] = keylight;
-  uLightInfos[2] = filllight;
-  uLightInfos[3] = backlight;
-  //-----------
+// Reflected radiance of a single light.
+vec3 get_pbr_radiance(in FragLight_t light, in FragInfo_t frag_info, in BRDFMaterial_t brdf_mat) {
+  // Choose between reflection angles.
+  const float cosTheta = max(dot( light.H, frag_info.V), 0); 
+                       // light.n_dot_l;
 
-  // Derived the BRDF specific materials from global ones.
-  const BRDFMaterial_t brdf_mat = get_brdf_material(mat);
+  // Fresnel term.
+  const vec3 F = f_Schlick( cosTheta, brdf_mat.F0);
 
-  // Sum reflectance contribution.
-  vec3 L0 = vec3(0.0);
-  for (int i = 0; i < uNumLights; ++i)
-  {
-    // Retrieve fragment specific light parameters.
-    FragLight_t light = get_fraglight_params( uLightInfos[i], frag_info );
-    
-    // Choose between reflection angles.
-    const float cosTheta = max(dot( light.H, frag_info.V), 0); 
-                         // light.n_dot_l;
+  // Deduct the diffuse term from it.
+  const vec3 kD = (1.0 - F) * brdf_mat.albedo / Pi();
+
+  // Calculate the BRDF specular term.
+  const vec3 kS = brdf_CookTorranceSpecular( light, frag_info.n_dot_v, F, brdf_mat.roughness_sqr);
 
-    // Fresnel term.
-    const vec3 F = f_Schlick( cosTheta, brdf_mat.F0);
- 
-    // Deduct the diffuse term from it.
-    const vec3 kD = (1.0 - F) * brdf_mat.albedo / Pi();
+  return (kD + kS) * light.radiance.rgb * light.n_dot_l;
+}
 
-    // Calculate the BRDF specular term.
-    const vec3 kS = brdf_CookTorranceSpecular( light, frag_info.n_dot_v, F, brdf_mat.roughness_sqr);
+// ----------------------------------------------------------------------------
 
-    // Add contribution.
-    L0 += (kD + kS) * light.radiance.rgb * light.n_dot_l;
-  }
+// Combine the reflected radiance of the lights L0 with the ambient and emissive ones.
+vec3 colorize_pbr(in FragInfo_t frag_info, in Material_t mat, in vec3 L0) {
+  // Derived the BRDF specific materials from global ones.
+  const BRDFMaterial_t brdf_mat = get_brdf_material(mat);
 
   // Ambient contribution from Image Based Lighting.
   vec3 ambient = vec3(0.0);
@@ -12,6 +12,26 @@ using namespace glm;
 #define LIGHT_TYPE_POINT            1
 #define LIGHT_TYPE_SPOT             2
 
+// View-space froxels grid, depth slices being exponentially distributed.
+#define CLUSTER_GRID_X              16
+#define CLUSTER_GRID_Y              9
+#define CLUSTER_GRID_Z              24
+#define CLUSTER_COUNT               (CLUSTER_GRID_X * CLUSTER_GRID_Y * CLUSTER_GRID_Z)
+
+// Maximum number of lights indexed by a cluster.
+#define CLUSTER_MAX_LIGHTS          128
+
+// Kernel group width of the light assignment pass.
+#define CLUSTER_KERNEL_GROUP_WIDTH  64
+
+// (bindings 0 are used by the generic frame and draws blocks)
+#define UNIFORM_BINDING_LIGHT_CLUSTERS    1
+
+#define STORAGE_BINDING_LIGHTS            1
+#define STORAGE_BINDING_CLUSTER_BOUNDS    2
+#define STORAGE_BINDING_CLUSTER_COUNTS    3
+#define STORAGE_BINDING_CLUSTER_INDICES   4
+
 // Data in a ShaderStorage buffer must be layed out using atomic type,
 // ie. float[3] instead of vec3, to avoid unwanted padding, otherwise use vec4.
 
@@ -19,8 +39,26 @@ using namespace glm;
 struct LightInfo_t {
   vec4 position;        //< XYZ Position + W Type
   vec4 color;           //< XYZ RGB Color + W intensity
-  vec4 direction; //
-  vec4 params;
+  vec4 direction;       //< XYZ normalized direction, for directional and spot lights
+  vec4 params;          //< X range, Y spot cosine outer angle, Z spot inverse cosine falloff
+};
+
+/* View-space bounding box of a cluster. */
+struct ClusterBounds_t {
+  vec4 minPoint;
+  vec4 maxPoint;
+};
+
+/* Uniforms of the clustered lights of a frame (std140). */
+struct LightClustersUniforms_t {
+  mat4 viewMatrix;
+  vec2 tileSize;        //< tile size in pixels
+  float sliceScale;     //< slice = log(view depth) * scale + bias
+  float sliceBias;
+  int numLights;
+  int numDirectionals;  //< directional lights come first and are not clustered
+  int _pad0;
+  int _pad1;
 };
 
 // ----------------------------------------------------------------------------
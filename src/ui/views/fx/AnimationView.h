@@ -0,0 +1,53 @@
+#ifndef BARBU_UI_VIEWS_ANIMATION_H_
+#define BARBU_UI_VIEWS_ANIMATION_H_
+
+#include <string>
+
+#include "ui/ui_view.h"
+#include "ui/imgui_wrapper.h"
+#include "fx/animation/animation_system.h"
+
+namespace views {
+
+class AnimationView : public ParametrizedUIView<AnimationSystem::Parameters_t> {
+ public:
+  AnimationView(TParameters &params) : ParametrizedUIView(params) {}
+
+  void render() override {
+    if (!ImGui::CollapsingHeader("Animation")) {
+      return;
+    }
+
+    {
+      auto const& stats = params_.readonly;
+
+      ImGui::Spacing();
+      ImGui::Text("characters (evaluated) : %d (%d)", stats.ncharacters, stats.nevaluated);
+      ImGui::Text("skipped joints         : %d", stats.nskipped_joints);
+      ImGui::Text("evaluation time        : %.3f ms", stats.evaluation_ms);
+      ImGui::Text("saved time (estimated) : %.3f ms", stats.saved_ms);
+      ImGui::Spacing();
+    }
+
+    ImGui::Separator();
+    ImGui::SetNextItemOpen(true, ImGuiCond_Once);
+    if (ImGui::TreeNode("Level of details")) {
+      auto &lod = params_.lod;
+
+      ImGui::Checkbox("enable", &lod.bEnable);
+      for (int32_t i = 0; i < AnimationSystem::kNumLODs - 1; ++i) {
+        std::string const label{ "1/" + std::to_string(2 << i) + " rate below" };
+        float const upper = (i > 0) ? lod.thresholds[i - 1] : 1.0f;
+        float const lower = (i < AnimationSystem::kNumLODs - 2) ? lod.thresholds[i + 1] : 0.0f;
+        ImGui::DragFloat(label.c_str(), &lod.thresholds[i], 0.001f, lower, upper);
+      }
+      ImGui::DragInt("joints mask from level", &lod.joint_mask_level, 0.05f, 1, AnimationSystem::kNumLODs);
+
+      ImGui::TreePop();
+    }
+  }
+};
+
+}  // namespace views
+
+#endif  // BARBU_UI_VIEWS_ANIMATION_H_
@@ -8,6 +8,7 @@ class RenderView;
 
 class TexturesView;
 
+class AnimationView;
 class HairView;
 class MarschnerView;
 
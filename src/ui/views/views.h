@@ -6,6 +6,7 @@
 
 //#include "ui/views/assets/TexturesView.h"
 
+#include "ui/views/fx/AnimationView.h"
 #include "ui/views/fx/HairView.h"
 #include "ui/views/fx/MarschnerView.h"
 
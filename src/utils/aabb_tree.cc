@@ -0,0 +1,332 @@
+#include "utils/aabb_tree.h"
+
+#include <algorithm>
+#include <cassert>
+
+// ----------------------------------------------------------------------------
+
+namespace {
+
+/// Return the union of two boxes.
+inline BoundingBox_t Union(BoundingBox_t const& a, BoundingBox_t const& b) {
+  BoundingBox_t box{ a };
+  box.extend(b);
+  return box;
+}
+
+/// Return the leaf box of an object box.
+inline BoundingBox_t Fatten(BoundingBox_t const& box, float const scale) {
+  glm::vec3 const margin = scale * AABBTree::kFatRatio * box.extents() + glm::vec3(1.0e-3f);
+  return { box.min - margin, box.max + margin };
+}
+
+} // namespace
+
+// ----------------------------------------------------------------------------
+
+void AABBTree::clear() {
+  nodes_.clear();
+  root_      = kNull;
+  free_list_ = kNull;
+  nleaves_   = 0;
+}
+
+int32_t AABBTree::insert(BoundingBox_t const& box, int32_t const user_data) {
+  int32_t const leaf = allocate_node();
+  auto &node = nodes_[leaf];
+  node.box       = Fatten(box, 1.0f);
+  node.user_data = user_data;
+  node.height    = 0;
+
+  insert_leaf(leaf);
+  ++nleaves_;
+
+  return leaf;
+}
+
+void AABBTree::remove(int32_t const proxy) {
+  assert( nodes_[proxy].is_leaf() );
+  remove_leaf(proxy);
+  release_node(proxy);
+  --nleaves_;
+}
+
+bool AABBTree::move(int32_t const proxy, BoundingBox_t const& box) {
+  auto const& fat_box = nodes_[proxy].box;
+
+  // Keep the leaf while it contains the box without being too loose.
+  if (fat_box.contains(box) && Fatten(box, 4.0f).contains(fat_box)) {
+    return false;
+  }
+
+  remove_leaf(proxy);
+  nodes_[proxy].box = Fatten(box, 1.0f);
+  insert_leaf(proxy);
+
+  return true;
+}
+
+void AABBTree::query(Frustum_t const& frustum, std::vector<int32_t> &results) const {
+  if (kNull == root_) {
+    return;
+  }
+
+  // Nodes to visit, with a flag telling if they are fully inside the frustum.
+  int32_t stack[kMaxStackSize];
+  bool inside[kMaxStackSize];
+  int32_t count = 0;
+
+  stack[count] = root_;
+  inside[count] = false;
+  ++count;
+
+  while (count > 0) {
+    --count;
+    auto const& node = nodes_[stack[count]];
+
+    bool bInside = inside[count];
+    if (!bInside) {
+      auto const test = frustum.test(node.box);
+      if (Frustum_t::Outside == test) {
+        continue;
+      }
+      bInside = (Frustum_t::Inside == test);
+    }
+
+    if (node.is_leaf()) {
+      results.push_back(node.user_data);
+    } else {
+      assert( count + 2 <= kMaxStackSize );
+      stack[count] = node.child1; inside[count] = bInside; ++count;
+      stack[count] = node.child2; inside[count] = bInside; ++count;
+    }
+  }
+}
+
+void AABBTree::query(BoundingBox_t const& box, std::vector<int32_t> &results) const {
+  if (kNull == root_) {
+    return;
+  }
+
+  int32_t stack[kMaxStackSize];
+  int32_t count = 0;
+  stack[count++] = root_;
+
+  while (count > 0) {
+    auto const& node = nodes_[stack[--count]];
+    if (!node.box.overlaps(box)) {
+      continue;
+    }
+
+    if (node.is_leaf()) {
+      results.push_back(node.user_data);
+    } else {
+      assert( count + 2 <= kMaxStackSize );
+      stack[count++] = node.child1;
+      stack[count++] = node.child2;
+    }
+  }
+}
+
+// ----------------------------------------------------------------------------
+
+int32_t AABBTree::allocate_node() {
+  if (kNull == free_list_) {
+    nodes_.emplace_back();
+    return static_cast<int32_t>(nodes_.size()) - 1;
+  }
+
+  int32_t const index = free_list_;
+  free_list_ = nodes_[index].parent;
+  nodes_[index] = Node_t();
+  return index;
+}
+
+void AABBTree::release_node(int32_t const index) {
+  auto &node = nodes_[index];
+  node.parent = free_list_;
+  node.height = -1;
+  free_list_ = index;
+}
+
+void AABBTree::insert_leaf(int32_t const leaf) {
+  if (kNull == root_) {
+    root_ = leaf;
+    nodes_[root_].parent = kNull;
+    return;
+  }
+
+  // Descend to the sibling with the lowest surface area cost.
+  BoundingBox_t const leaf_box{ nodes_[leaf].box };
+  int32_t index = root_;
+  while (!nodes_[index].is_leaf()) {
+    auto const& node = nodes_[index];
+
+    float const area = node.box.area();
+    float const combined_area = Union(node.box, leaf_box).area();
+
+    // Cost of making a new parent for this node and the leaf.
+    float const cost = 2.0f * combined_area;
+
+    // Minimum cost of pushing the leaf further down.
+    float const inheritance_cost = 2.0f * (combined_area - area);
+
+    auto child_cost = [&](int32_t const child_index) {
+      auto const& child = nodes_[child_index];
+      float const child_area = Union(child.box, leaf_box).area();
+      return inheritance_cost + (child.is_leaf() ? child_area : child_area - child.box.area());
+    };
+    float const cost1 = child_cost(node.child1);
+    float const cost2 = child_cost(node.child2);
+
+    if ((cost < cost1) && (cost < cost2)) {
+      break;
+    }
+    index = (cost1 < cost2) ? node.child1 : node.child2;
+  }
+  int32_t const sibling = index;
+
+  // Create a new parent for the leaf and its sibling.
+  // (allocation can invalidate the nodes references)
+  int32_t const old_parent = nodes_[sibling].parent;
+  int32_t const new_parent = allocate_node();
+  {
+    auto &node = nodes_[new_parent];
+    node.parent = old_parent;
+    node.box    = Union(leaf_box, nodes_[sibling].box);
+    node.height = nodes_[sibling].height + 1;
+    node.child1 = sibling;
+    node.child2 = leaf;
+  }
+
+  if (kNull != old_parent) {
+    auto &parent = nodes_[old_parent];
+    if (parent.child1 == sibling) {
+      parent.child1 = new_parent;
+    } else {
+      parent.child2 = new_parent;
+    }
+  } else {
+    root_ = new_parent;
+  }
+  nodes_[sibling].parent = new_parent;
+  nodes_[leaf].parent = new_parent;
+
+  refit_ancestors(nodes_[leaf].parent);
+}
+
+void AABBTree::remove_leaf(int32_t const leaf) {
+  if (leaf == root_) {
+    root_ = kNull;
+    return;
+  }
+
+  int32_t const parent = nodes_[leaf].parent;
+  int32_t const grand_parent = nodes_[parent].parent;
+  int32_t const sibling = (nodes_[parent].child1 == leaf) ? nodes_[parent].child2 
+                                                          : nodes_[parent].child1;
+
+  // Replace the parent by the sibling.
+  if (kNull != grand_parent) {
+    auto &node = nodes_[grand_parent];
+    if (node.child1 == parent) {
+      node.child1 = sibling;
+    } else {
+      node.child2 = sibling;
+    }
+    nodes_[sibling].parent = grand_parent;
+    release_node(parent);
+
+    refit_ancestors(grand_parent);
+  } else {
+    root_ = sibling;
+    nodes_[sibling].parent = kNull;
+    release_node(parent);
+  }
+}
+
+void AABBTree::refit_ancestors(int32_t index) {
+  while (kNull != index) {
+    index = balance(index);
+
+    auto &node = nodes_[index];
+    auto const& child1 = nodes_[node.child1];
+    auto const& child2 = nodes_[node.child2];
+    node.height = 1 + std::max(child1.height, child2.height);
+    node.box    = Union(child1.box, child2.box);
+
+    index = node.parent;
+  }
+}
+
+int32_t AABBTree::balance(int32_t const iA) {
+  auto &A = nodes_[iA];
+  if (A.is_leaf() || (A.height < 2)) {
+    return iA;
+  }
+
+  int32_t const iB = A.child1;
+  int32_t const iC = A.child2;
+  auto &B = nodes_[iB];
+  auto &C = nodes_[iC];
+  int32_t const balance = C.height - B.height;
+
+  // Move the grand child of the higher child in place of the lower child.
+  auto rotate = [this, iA](int32_t const iUp, int32_t const iLow, bool const bUpIsChild2) {
+    auto &A  = nodes_[iA];
+    auto &Up = nodes_[iUp];
+    auto &Low = nodes_[iLow];
+    int32_t const iF = Up.child1;
+    int32_t const iG = Up.child2;
+    auto &F = nodes_[iF];
+    auto &G = nodes_[iG];
+
+    // Swap A and Up.
+    Up.child1 = iA;
+    Up.parent = A.parent;
+    A.parent  = iUp;
+
+    if (kNull != Up.parent) {
+      auto &parent = nodes_[Up.parent];
+      if (parent.child1 == iA) {
+        parent.child1 = iUp;
+      } else {
+        parent.child2 = iUp;
+      }
+    } else {
+      root_ = iUp;
+    }
+
+    // Keep the highest grand child under Up, the other replaces Up under A.
+    bool const bKeepF = (F.height > G.height);
+    int32_t const iKept  = bKeepF ? iF : iG;
+    int32_t const iMoved = bKeepF ? iG : iF;
+    auto &Kept  = nodes_[iKept];
+    auto &Moved = nodes_[iMoved];
+
+    Up.child2 = iKept;
+    if (bUpIsChild2) {
+      A.child2 = iMoved;
+    } else {
+      A.child1 = iMoved;
+    }
+    Moved.parent = iA;
+
+    A.box     = Union(Low.box, Moved.box);
+    A.height  = 1 + std::max(Low.height, Moved.height);
+    Up.box    = Union(A.box, Kept.box);
+    Up.height = 1 + std::max(A.height, Kept.height);
+  };
+
+  if (balance > 1) {
+    rotate(iC, iB, true);
+    return iC;
+  }
+  if (balance < -1) {
+    rotate(iB, iC, false);
+    return iB;
+  }
+  return iA;
+}
+
+// ----------------------------------------------------------------------------
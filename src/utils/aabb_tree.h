@@ -0,0 +1,104 @@
+#ifndef BARBU_UTILS_AABB_TREE_H_
+#define BARBU_UTILS_AABB_TREE_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "utils/mathutils.h"
+
+// ----------------------------------------------------------------------------
+
+//
+// Dynamic bounding volume hierarchy of axis-aligned boxes, used to cull
+// moving objects.
+//
+// Objects are inserted as proxies whose leaf stores an enlarged box, so that
+// small motions only refit nothing and larger ones re-insert the leaf. Leaves
+// are inserted next to the sibling minimizing the surface area cost, and the
+// tree is kept balanced by rotations.
+//
+class AABBTree {
+ public:
+  static constexpr int32_t kNull = -1;
+
+  // Fraction of a box extents added to each side of its leaf box.
+  static constexpr float kFatRatio = 0.1f;
+
+ public:
+  AABBTree() = default;
+
+  void clear();
+
+  /* Add an object with its bounds, returning its proxy. */
+  int32_t insert(BoundingBox_t const& box, int32_t const user_data);
+
+  /* Remove an object by its proxy. */
+  void remove(int32_t const proxy);
+
+  /* Update the bounds of an object, return true when its leaf was re-inserted. */
+  bool move(int32_t const proxy, BoundingBox_t const& box);
+
+  /* Append the user data of every objects whose leaf box is visible in the frustum. */
+  void query(Frustum_t const& frustum, std::vector<int32_t> &results) const;
+
+  /* Append the user data of every objects whose leaf box overlaps box. */
+  void query(BoundingBox_t const& box, std::vector<int32_t> &results) const;
+
+  inline int32_t user_data(int32_t const proxy) const noexcept {
+    return nodes_[proxy].user_data;
+  }
+
+  inline void set_user_data(int32_t const proxy, int32_t const user_data) noexcept {
+    nodes_[proxy].user_data = user_data;
+  }
+
+  inline BoundingBox_t const& fat_bounds(int32_t const proxy) const noexcept {
+    return nodes_[proxy].box;
+  }
+
+  inline int32_t size() const noexcept {
+    return nleaves_;
+  }
+
+  inline int32_t height() const noexcept {
+    return (kNull == root_) ? 0 : nodes_[root_].height;
+  }
+
+ private:
+  // Maximum depth of the traversal stacks, the balanced tree staying far below.
+  static constexpr int32_t kMaxStackSize = 256;
+
+  struct Node_t {
+    BoundingBox_t box;
+    int32_t parent    = kNull;                //< next free node when released
+    int32_t child1    = kNull;
+    int32_t child2    = kNull;
+    int32_t height    = 0;                    //< 0 for leaves, -1 when released
+    int32_t user_data = -1;
+
+    inline bool is_leaf() const noexcept {
+      return kNull == child1;
+    }
+  };
+
+  int32_t allocate_node();
+  void release_node(int32_t const index);
+
+  void insert_leaf(int32_t const leaf);
+  void remove_leaf(int32_t const leaf);
+
+  /* Rotate the subtree of an unbalanced node, returning its new root. */
+  int32_t balance(int32_t const index);
+
+  /* Refit the boxes and heights of the ancestors of a node, balancing them. */
+  void refit_ancestors(int32_t index);
+
+  std::vector<Node_t> nodes_;
+  int32_t root_      = kNull;
+  int32_t free_list_ = kNull;
+  int32_t nleaves_   = 0;
+};
+
+// ----------------------------------------------------------------------------
+
+#endif // BARBU_UTILS_AABB_TREE_H_
@@ -2,6 +2,7 @@
 #define BARBU_UTILS_MATHUTILS_H_
 
 #include <cmath>
+#include <limits>
 #include "glm/glm.hpp"
 
 // ----------------------------------------------------------------------------
@@ -23,6 +24,120 @@ constexpr bool almost_equal(T const& a, T const& b, T const eps = std::numeric_l
 
 // ----------------------------------------------------------------------------
 
+/* Axis-aligned bounding box, empty when its minimum exceeds its maximum. */
+struct BoundingBox_t {
+  glm::vec3 min = glm::vec3(std::numeric_limits<float>::max());
+  glm::vec3 max = glm::vec3(-std::numeric_limits<float>::max());
+
+  inline bool empty() const noexcept {
+    return (min.x > max.x) || (min.y > max.y) || (min.z > max.z);
+  }
+
+  inline void extend(glm::vec3 const& p) noexcept {
+    min = glm::min(min, p);
+    max = glm::max(max, p);
+  }
+
+  inline void extend(BoundingBox_t const& box) noexcept {
+    min = glm::min(min, box.min);
+    max = glm::max(max, box.max);
+  }
+
+  inline glm::vec3 center() const noexcept {
+    return 0.5f * (max + min);
+  }
+
+  inline glm::vec3 extents() const noexcept {
+    return 0.5f * (max - min);
+  }
+
+  /* Radius of the bounding sphere centered on the box. */
+  inline float radius() const noexcept {
+    return empty() ? 0.0f : glm::length(extents());
+  }
+
+  inline float area() const noexcept {
+    glm::vec3 const d = max - min;
+    return 2.0f * (d.x * d.y + d.y * d.z + d.z * d.x);
+  }
+
+  inline bool contains(BoundingBox_t const& box) const noexcept {
+    return glm::all(glm::lessThanEqual(min, box.min))
+        && glm::all(glm::lessThanEqual(box.max, max));
+  }
+
+  inline bool overlaps(BoundingBox_t const& box) const noexcept {
+    return glm::all(glm::lessThanEqual(min, box.max))
+        && glm::all(glm::lessThanEqual(box.min, max));
+  }
+
+  /* Return the axis-aligned bounds of the box transformed by an affine matrix. */
+  inline BoundingBox_t transform(glm::mat4 const& m) const noexcept {
+    // (Arvo's method, using the absolute linear part on the extents)
+    glm::vec3 const c = glm::vec3(m * glm::vec4(center(), 1.0f));
+    glm::vec3 const e = glm::abs(glm::vec3(m[0])) * extents().x
+                      + glm::abs(glm::vec3(m[1])) * extents().y
+                      + glm::abs(glm::vec3(m[2])) * extents().z
+                      ;
+    return { c - e, c + e };
+  }
+};
+
+// ----------------------------------------------------------------------------
+
+/* Clipping planes of a view frustum, pointing inward. */
+struct Frustum_t {
+  enum Test_t {
+    Outside,
+    Intersect,
+    Inside
+  };
+
+  glm::vec4 planes[6];
+
+  Frustum_t() = default;
+
+  /* Extract the planes of a view projection matrix (Gribb & Hartmann). */
+  explicit Frustum_t(glm::mat4 const& viewproj) {
+    glm::vec4 const row_x(viewproj[0][0], viewproj[1][0], viewproj[2][0], viewproj[3][0]);
+    glm::vec4 const row_y(viewproj[0][1], viewproj[1][1], viewproj[2][1], viewproj[3][1]);
+    glm::vec4 const row_z(viewproj[0][2], viewproj[1][2], viewproj[2][2], viewproj[3][2]);
+    glm::vec4 const row_w(viewproj[0][3], viewproj[1][3], viewproj[2][3], viewproj[3][3]);
+
+    planes[0] = row_w + row_x;
+    planes[1] = row_w - row_x;
+    planes[2] = row_w + row_y;
+    planes[3] = row_w - row_y;
+    planes[4] = row_w + row_z;
+    planes[5] = row_w - row_z;
+    for (auto &plane : planes) {
+      plane /= glm::length(glm::vec3(plane));
+    }
+  }
+
+  /* Classify a non empty box against the frustum. */
+  inline Test_t test(BoundingBox_t const& box) const noexcept {
+    glm::vec3 const c = box.center();
+    glm::vec3 const e = box.extents();
+
+    Test_t result = Inside;
+    for (auto const& plane : planes) {
+      glm::vec3 const n(plane);
+      float const distance = glm::dot(n, c) + plane.w;
+      float const radius = glm::dot(glm::abs(n), e);
+      if (distance < -radius) {
+        return Outside;
+      }
+      if (distance < radius) {
+        result = Intersect;
+      }
+    }
+    return result;
+  }
+};
+
+// ----------------------------------------------------------------------------
+
 /* Vertex ordering functor, used to reindex vertices from raw data. */
 
 template<typename T>
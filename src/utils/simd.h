@@ -0,0 +1,161 @@
+#ifndef BARBU_UTILS_SIMD_H_
+#define BARBU_UTILS_SIMD_H_
+
+#include <cmath>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define BARBU_USE_SSE 1
+#include <emmintrin.h>
+#else
+#include <cstring>
+#endif
+
+// ----------------------------------------------------------------------------
+//
+// Minimal 4-wide float vector used by the data-oriented kernels, mapped to SSE
+// when available and to plain loops otherwise.
+//
+// ----------------------------------------------------------------------------
+
+namespace simd {
+
+static constexpr int32_t kWidth = 4;
+
+#ifdef BARBU_USE_SSE
+
+struct float4 {
+  __m128 v;
+};
+
+inline float4 set1(float x)                     { return { _mm_set1_ps(x) }; }
+inline float4 zero()                            { return { _mm_setzero_ps() }; }
+inline float4 load(float const* p)              { return { _mm_loadu_ps(p) }; }
+inline void   store(float *p, float4 a)         { _mm_storeu_ps(p, a.v); }
+
+inline float4 operator+(float4 a, float4 b)     { return { _mm_add_ps(a.v, b.v) }; }
+inline float4 operator-(float4 a, float4 b)     { return { _mm_sub_ps(a.v, b.v) }; }
+inline float4 operator*(float4 a, float4 b)     { return { _mm_mul_ps(a.v, b.v) }; }
+inline float4 operator/(float4 a, float4 b)     { return { _mm_div_ps(a.v, b.v) }; }
+inline float4 sqrt(float4 a)                    { return { _mm_sqrt_ps(a.v) }; }
+inline float4 max(float4 a, float4 b)           { return { _mm_max_ps(a.v, b.v) }; }
+inline float4 min(float4 a, float4 b)           { return { _mm_min_ps(a.v, b.v) }; }
+inline float4 abs(float4 a)                     { return { _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v) }; }
+
+/* Comparisons return a mask with all bits set for true lanes. */
+inline float4 operator>(float4 a, float4 b)     { return { _mm_cmpgt_ps(a.v, b.v) }; }
+inline float4 operator<(float4 a, float4 b)     { return { _mm_cmplt_ps(a.v, b.v) }; }
+inline float4 operator&(float4 a, float4 b)     { return { _mm_and_ps(a.v, b.v) }; }
+inline float4 andnot(float4 m, float4 a)        { return { _mm_andnot_ps(m.v, a.v) }; }
+
+/* Return a where the mask is set, b otherwise. */
+inline float4 select(float4 m, float4 a, float4 b) {
+  return { _mm_or_ps(_mm_and_ps(m.v, a.v), _mm_andnot_ps(m.v, b.v)) };
+}
+
+/* Transpose 4 vectors as the rows of a 4x4 matrix. */
+inline void transpose(float4 &a, float4 &b, float4 &c, float4 &d) {
+  _MM_TRANSPOSE4_PS(a.v, b.v, c.v, d.v);
+}
+
+#else
+
+struct float4 {
+  float v[kWidth];
+};
+
+namespace internal {
+
+template<typename F>
+inline float4 map(float4 a, float4 b, F f) {
+  float4 r;
+  for (int32_t i = 0; i < kWidth; ++i) {
+    r.v[i] = f(a.v[i], b.v[i]);
+  }
+  return r;
+}
+
+inline float mask(bool b) {
+  uint32_t const bits = b ? 0xffffffffu : 0u;
+  float f;
+  std::memcpy(&f, &bits, sizeof(f));
+  return f;
+}
+
+inline uint32_t bits(float f) {
+  uint32_t u;
+  std::memcpy(&u, &f, sizeof(u));
+  return u;
+}
+
+inline float from_bits(uint32_t u) {
+  float f;
+  std::memcpy(&f, &u, sizeof(f));
+  return f;
+}
+
+} // namespace internal
+
+inline float4 set1(float x)                     { return { {x, x, x, x} }; }
+inline float4 zero()                            { return set1(0.0f); }
+inline float4 load(float const* p)              { return { {p[0], p[1], p[2], p[3]} }; }
+inline void   store(float *p, float4 a)         { for (int32_t i = 0; i < kWidth; ++i) { p[i] = a.v[i]; } }
+
+inline float4 operator+(float4 a, float4 b)     { return internal::map(a, b, [](float x, float y) { return x + y; }); }
+inline float4 operator-(float4 a, float4 b)     { return internal::map(a, b, [](float x, float y) { return x - y; }); }
+inline float4 operator*(float4 a, float4 b)     { return internal::map(a, b, [](float x, float y) { return x * y; }); }
+inline float4 operator/(float4 a, float4 b)     { return internal::map(a, b, [](float x, float y) { return x / y; }); }
+inline float4 sqrt(float4 a)                    { return internal::map(a, a, [](float x, float) { return std::sqrt(x); }); }
+inline float4 max(float4 a, float4 b)           { return internal::map(a, b, [](float x, float y) { return (x > y) ? x : y; }); }
+inline float4 min(float4 a, float4 b)           { return internal::map(a, b, [](float x, float y) { return (x < y) ? x : y; }); }
+inline float4 abs(float4 a)                     { return internal::map(a, a, [](float x, float) { return std::fabs(x); }); }
+
+inline float4 operator>(float4 a, float4 b)     { return internal::map(a, b, [](float x, float y) { return internal::mask(x > y); }); }
+inline float4 operator<(float4 a, float4 b)     { return internal::map(a, b, [](float x, float y) { return internal::mask(x < y); }); }
+
+inline float4 operator&(float4 a, float4 b) {
+  return internal::map(a, b, [](float x, float y) {
+    return internal::from_bits(internal::bits(x) & internal::bits(y));
+  });
+}
+
+inline float4 andnot(float4 m, float4 a) {
+  return internal::map(m, a, [](float x, float y) {
+    return internal::from_bits(~internal::bits(x) & internal::bits(y));
+  });
+}
+
+inline float4 select(float4 m, float4 a, float4 b) {
+  float4 r;
+  for (int32_t i = 0; i < kWidth; ++i) {
+    r.v[i] = internal::bits(m.v[i]) ? a.v[i] : b.v[i];
+  }
+  return r;
+}
+
+inline void transpose(float4 &a, float4 &b, float4 &c, float4 &d) {
+  float4 const r[4]{ a, b, c, d };
+  for (int32_t i = 0; i < kWidth; ++i) {
+    a.v[i] = r[i].v[0];
+    b.v[i] = r[i].v[1];
+    c.v[i] = r[i].v[2];
+    d.v[i] = r[i].v[3];
+  }
+}
+
+#endif // BARBU_USE_SSE
+
+inline float4 operator-(float4 a)               { return zero() - a; }
+inline float4& operator+=(float4 &a, float4 b)  { return a = a + b; }
+inline float4& operator*=(float4 &a, float4 b)  { return a = a * b; }
+
+/* Return -1 for negative lanes, +1 otherwise. */
+inline float4 sign_not_zero(float4 a) {
+  return select(a < zero(), set1(-1.0f), set1(1.0f));
+}
+
+} // namespace simd
+
+// ----------------------------------------------------------------------------
+
+#endif // BARBU_UTILS_SIMD_H_
@@ -0,0 +1,152 @@
+// ----------------------------------------------------------------------------
+//
+// Time the AABBTree build, update and queries on 100k random boxes, the
+// queries being compared with a linear scan of the boxes.
+//
+// ----------------------------------------------------------------------------
+
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "glm/gtc/matrix_transform.hpp"
+
+#include "common.h"
+#include "utils/aabb_tree.h"
+
+namespace {
+
+constexpr int32_t kNumObjects = 100000;
+constexpr int32_t kNumQueries = 100;
+constexpr float   kWorldSize  = 500.0f;
+
+/// Random box in the world, with extents up to max_extent.
+BoundingBox_t RandomBox(std::mt19937 &gen, float const max_extent) {
+  std::uniform_real_distribution<float> position(-kWorldSize, kWorldSize);
+  std::uniform_real_distribution<float> extent(0.1f, max_extent);
+  glm::vec3 const c(position(gen), position(gen), position(gen));
+  glm::vec3 const e(extent(gen), extent(gen), extent(gen));
+  return { c - e, c + e };
+}
+
+/// Random camera frustum looking at the world.
+Frustum_t RandomFrustum(std::mt19937 &gen) {
+  std::uniform_real_distribution<float> position(-kWorldSize, kWorldSize);
+  glm::vec3 const eye(position(gen), position(gen), position(gen));
+  glm::vec3 const target(position(gen), position(gen), position(gen));
+  auto const view = glm::lookAt(eye, target, glm::vec3(0.0f, 1.0f, 0.0f));
+  auto const proj = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 0.5f * kWorldSize);
+  return Frustum_t(proj * view);
+}
+
+} // namespace
+
+// ----------------------------------------------------------------------------
+
+int main() {
+  std::mt19937 gen(11u);
+
+  std::vector<BoundingBox_t> boxes(kNumObjects);
+  for (auto &box : boxes) {
+    box = RandomBox(gen, 3.0f);
+  }
+
+  std::vector<Frustum_t> frustums(kNumQueries);
+  std::vector<BoundingBox_t> query_boxes(kNumQueries);
+  for (int32_t q = 0; q < kNumQueries; ++q) {
+    frustums[q]    = RandomFrustum(gen);
+    query_boxes[q] = RandomBox(gen, 50.0f);
+  }
+
+  AABBTree tree;
+  std::vector<int32_t> proxies(kNumObjects);
+
+  // -- Build.
+  double const build_ms = test::Measure([&] {
+    tree.clear();
+    for (int32_t i = 0; i < kNumObjects; ++i) {
+      proxies[i] = tree.insert(boxes[i], i);
+    }
+  });
+
+  // -- Update : every box jitters, one in ten moves far enough to be re-inserted.
+  std::vector<glm::vec3> deltas(kNumObjects);
+  {
+    std::uniform_real_distribution<float> jitter(-0.005f, 0.005f);
+    std::uniform_real_distribution<float> offset(-10.0f, 10.0f);
+    for (int32_t i = 0; i < kNumObjects; ++i) {
+      deltas[i] = (0 == (i % 10)) ? glm::vec3(offset(gen), offset(gen), offset(gen))
+                                  : glm::vec3(jitter(gen), jitter(gen), jitter(gen));
+    }
+  }
+  int32_t nreinserted = 0;
+  double const update_ms = test::Measure([&] {
+    nreinserted = 0;
+    for (int32_t i = 0; i < kNumObjects; ++i) {
+      auto &box = boxes[i];
+      box = { box.min + deltas[i], box.max + deltas[i] };
+      nreinserted += tree.move(proxies[i], box) ? 1 : 0;
+    }
+  }, 1);
+
+  // -- Frustum queries.
+  std::vector<int32_t> results;
+  results.reserve(kNumObjects);
+
+  size_t nvisibles = 0u;
+  double const tree_frustum_ms = test::Measure([&] {
+    nvisibles = 0u;
+    for (auto const& frustum : frustums) {
+      results.clear();
+      tree.query(frustum, results);
+      nvisibles += results.size();
+    }
+  });
+  double const scan_frustum_ms = test::Measure([&] {
+    for (auto const& frustum : frustums) {
+      results.clear();
+      for (int32_t i = 0; i < kNumObjects; ++i) {
+        if (Frustum_t::Outside != frustum.test(boxes[i])) {
+          results.push_back(i);
+        }
+      }
+    }
+  });
+
+  // -- Box queries.
+  size_t noverlaps = 0u;
+  double const tree_box_ms = test::Measure([&] {
+    noverlaps = 0u;
+    for (auto const& query_box : query_boxes) {
+      results.clear();
+      tree.query(query_box, results);
+      noverlaps += results.size();
+    }
+  });
+  double const scan_box_ms = test::Measure([&] {
+    for (auto const& query_box : query_boxes) {
+      results.clear();
+      for (int32_t i = 0; i < kNumObjects; ++i) {
+        if (query_box.overlaps(boxes[i])) {
+          results.push_back(i);
+        }
+      }
+    }
+  });
+
+  printf("AABBTree, %d boxes (height %d)\n", kNumObjects, tree.height());
+  printf("  build          : %9.3f ms\n", build_ms);
+  printf("  update         : %9.3f ms (%d re-inserted)\n", update_ms, nreinserted);
+  printf("  frustum query  : %9.3f ms / query, linear scan %9.3f ms (%.1f visible)\n",
+    tree_frustum_ms / kNumQueries, scan_frustum_ms / kNumQueries,
+    static_cast<double>(nvisibles) / kNumQueries
+  );
+  printf("  box query      : %9.3f ms / query, linear scan %9.3f ms (%.1f overlaps)\n",
+    tree_box_ms / kNumQueries, scan_box_ms / kNumQueries,
+    static_cast<double>(noverlaps) / kNumQueries
+  );
+
+  return EXIT_SUCCESS;
+}
+
+// ----------------------------------------------------------------------------
@@ -0,0 +1,187 @@
+// ----------------------------------------------------------------------------
+//
+// Compare the serial and the chunked OBJ parsers on a large generated OBJ and
+// on the models of the assets directory (or on the files passed as arguments).
+//
+// The chunked parser must output the same raw meshes as the serial one, with a
+// single chunk, with the chunks count derived from the file size and with a
+// forced count splitting even small files. It is expected to be faster on
+// large files.
+//
+// ----------------------------------------------------------------------------
+
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "common.h"
+#include "memory/resources/mesh_data.h"
+
+namespace {
+
+// Number of chunks forced on every file, to run the multi-chunk path on the
+// files smaller than the minimum chunk size.
+constexpr int32_t kForcedChunks = 7;
+
+// Grid resolution of the generated OBJ, about 23 MiB.
+constexpr int32_t kGridWidth  = 512;
+constexpr int32_t kGridHeight = 256;
+
+/// Write a grid mesh as an OBJ, interleaving the attributes of each row with
+/// the faces of the previous one, alternating quads and triangles, material
+/// groups and line endings so that chunks boundaries fall anywhere.
+bool WriteGridOBJ(std::string const& filename) {
+  FILE *fd = fopen(filename.c_str(), "wb");
+  if (nullptr == fd) {
+    return false;
+  }
+
+  std::mt19937 gen(3u);
+  std::uniform_real_distribution<float> noise(-1.0f, 1.0f);
+
+  fprintf(fd, "# generated by bench_obj_parser\nmtllib grid.mtl\no grid\n");
+  for (int32_t y = 0; y < kGridHeight; ++y) {
+    char const* eol = (0 == (y % 5)) ? "\r\n" : "\n";
+
+    for (int32_t x = 0; x < kGridWidth; ++x) {
+      fprintf(fd, "v %.6f %.6f %.6f%s", x * 0.25f, noise(gen), y * 0.25f, eol);
+    }
+    for (int32_t x = 0; x < kGridWidth; ++x) {
+      fprintf(fd, "vt %.5f %.5f%s", x / static_cast<float>(kGridWidth - 1), y / static_cast<float>(kGridHeight - 1), eol);
+    }
+    for (int32_t x = 0; x < kGridWidth; ++x) {
+      fprintf(fd, "vn %g %g %g%s", 0.1f * noise(gen), 1.0f, 1e-5f * noise(gen), eol);
+    }
+    if (0 == y) {
+      continue;
+    }
+
+    if (0 == (y % 64)) {
+      fprintf(fd, "usemtl material_%d%s", y / 64, eol);
+    }
+    for (int32_t x = 1; x < kGridWidth; ++x) {
+      // (OBJ indices are 1-based)
+      int32_t const i00 = (y - 1) * kGridWidth + x;
+      int32_t const i01 = i00 + 1;
+      int32_t const i10 = i00 + kGridWidth;
+      int32_t const i11 = i10 + 1;
+      if (0 == (x % 2)) {
+        fprintf(fd, "f %d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d%s",
+          i00, i00, i00, i01, i01, i01, i11, i11, i11, i10, i10, i10, eol
+        );
+      } else {
+        fprintf(fd, "f %d/%d/%d %d/%d/%d %d/%d/%d%s", i00, i00, i00, i01, i01, i01, i11, i11, i11, eol);
+        fprintf(fd, "f %d/%d/%d %d/%d/%d %d/%d/%d%s", i00, i00, i00, i11, i11, i11, i10, i10, i10, eol);
+      }
+    }
+  }
+
+  return 0 == fclose(fd);
+}
+
+template<typename T>
+bool SameArray(std::vector<T> const& a, std::vector<T> const& b) {
+  return (a.size() == b.size())
+      && (a.empty() || (0 == memcmp(a.data(), b.data(), a.size() * sizeof(T))));
+}
+
+bool SameMeshFile(RawMeshFile const& a, RawMeshFile const& b) {
+  if ((a.material_id != b.material_id) || (a.meshes.size() != b.meshes.size())) {
+    return false;
+  }
+  for (size_t i = 0u; i < a.meshes.size(); ++i) {
+    auto const& ma = a.meshes[i];
+    auto const& mb = b.meshes[i];
+    if ((ma.name != mb.name)
+     || !SameArray(ma.vertices, mb.vertices)
+     || !SameArray(ma.texcoords, mb.texcoords)
+     || !SameArray(ma.normals, mb.normals)
+     || !SameArray(ma.elementsAttribs, mb.elementsAttribs)
+     || (ma.vgroups.size() != mb.vgroups.size())) {
+      return false;
+    }
+    for (size_t j = 0u; j < ma.vgroups.size(); ++j) {
+      auto const& va = ma.vgroups[j];
+      auto const& vb = mb.vgroups[j];
+      if ((va.name != vb.name) || (va.start_index != vb.start_index) || (va.end_index != vb.end_index)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+// ----------------------------------------------------------------------------
+
+int main(int argc, char *argv[]) {
+  std::vector<std::string> filenames(argv + 1, argv + argc);
+  std::string grid_filename;
+  if (filenames.empty()) {
+    std::error_code ec;
+    grid_filename = (fs::temp_directory_path(ec) / "bench_obj_parser_grid.obj").string();
+    if (WriteGridOBJ(grid_filename)) {
+      filenames.push_back(grid_filename);
+    } else {
+      fprintf(stderr, "%s could not be written.\n", grid_filename.c_str());
+      ++test::Failures();
+    }
+    for (auto const& entry : fs::recursive_directory_iterator(ASSETS_DIR "/models", ec)) {
+      if (entry.path().extension() == ".obj") {
+        filenames.push_back(entry.path().string());
+      }
+    }
+  }
+
+  printf("%-48s %12s %12s %12s %8s\n", "file", "size (KiB)", "serial (ms)", "chunked (ms)", "speedup");
+
+  for (auto const& filename : filenames) {
+    RawMeshFile serial;
+    RawMeshFile single_chunk;
+    RawMeshFile chunked;
+    RawMeshFile forced_chunks;
+    if (!MeshDataManager::ParseFileOBJ(filename, serial, false)
+     || !MeshDataManager::ParseFileOBJ(filename, single_chunk, true, 1)
+     || !MeshDataManager::ParseFileOBJ(filename, chunked, true)
+     || !MeshDataManager::ParseFileOBJ(filename, forced_chunks, true, kForcedChunks)) {
+      fprintf(stderr, "%s could not be loaded.\n", filename.c_str());
+      ++test::Failures();
+      continue;
+    }
+    if (!SameMeshFile(serial, single_chunk)
+     || !SameMeshFile(single_chunk, chunked)
+     || !SameMeshFile(single_chunk, forced_chunks)) {
+      fprintf(stderr, "%s : the chunked parser output differs.\n", filename.c_str());
+      ++test::Failures();
+    }
+
+    double const serial_ms = test::Measure([&filename] {
+      RawMeshFile meshfile;
+      MeshDataManager::ParseFileOBJ(filename, meshfile, false);
+    });
+    double const chunked_ms = test::Measure([&filename] {
+      RawMeshFile meshfile;
+      MeshDataManager::ParseFileOBJ(filename, meshfile, true);
+    });
+
+    std::error_code ec;
+    auto const filesize = fs::file_size(filename, ec);
+    printf("%-48s %12.1f %12.3f %12.3f %7.2fx\n",
+      fs::path(filename).filename().string().c_str(),
+      ec ? 0.0 : static_cast<double>(filesize) / 1024.0,
+      serial_ms, chunked_ms, serial_ms / chunked_ms
+    );
+  }
+
+  if (!grid_filename.empty()) {
+    std::error_code ec;
+    fs::remove(grid_filename, ec);
+  }
+
+  return (test::Failures() > 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+// ----------------------------------------------------------------------------
@@ -0,0 +1,193 @@
+// ----------------------------------------------------------------------------
+//
+// Compare the SkeletonController structure-of-arrays 4-wide kernels with the
+// former per-joint glm path (kept here as the scalar reference), blending two
+// clips into dual quaternion skinning data for 64, 256 and 1024 joints.
+//
+// ----------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "glm/gtc/matrix_transform.hpp"
+#include "glm/gtx/quaternion.hpp"
+
+#include "common.h"
+#include "fx/animation/skeleton.h"
+#include "fx/animation/skeleton_controller.h"
+
+namespace {
+
+constexpr int32_t kNumFrames    = 32;
+constexpr float   kDuration     = 1.0f;
+constexpr float   kGlobalTime   = 0.3f;   //< between frames 9 and 10
+constexpr int32_t kNumRuns      = 200;
+
+/// Random rigid pose of a joint.
+JointPose_t RandomPose(std::mt19937 &gen) {
+  std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+  JointPose_t pose;
+  pose.qRotation    = glm::normalize(glm::quat(dist(gen), dist(gen), dist(gen), dist(gen)));
+  pose.vTranslation = glm::vec3(dist(gen), dist(gen), dist(gen));
+  return pose;
+}
+
+/// Build a skeleton with random parents and two looping clips of small
+/// rotations between consecutive frames.
+SkeletonHandle CreateSkeleton(int32_t const njoints, std::mt19937 &gen) {
+  auto skeleton = std::make_shared<Skeleton>(njoints);
+
+  for (int32_t i = 0; i < njoints; ++i) {
+    auto const pose = RandomPose(gen);
+    auto const bind = glm::translate(glm::mat4(1.0f), pose.vTranslation) * glm::mat4_cast(pose.qRotation);
+    skeleton->names.push_back("joint_" + std::to_string(i));
+    skeleton->parents.push_back((i > 0) ? static_cast<int32_t>(gen() % static_cast<uint32_t>(i)) : -1);
+    skeleton->inverse_bind_matrices.push_back(glm::inverse(bind));
+    skeleton->global_bind_matrices.push_back(bind);
+  }
+
+  std::uniform_real_distribution<float> angle(-0.1f, 0.1f);
+  for (int32_t c = 0; c < 2; ++c) {
+    AnimationClip_t clip("clip", kNumFrames, kDuration);
+    clip.bLoop = true;
+    for (auto &sample : clip.samples) {
+      sample.joints.resize(njoints);
+    }
+    for (int32_t i = 0; i < njoints; ++i) {
+      auto pose = RandomPose(gen);
+      for (auto &sample : clip.samples) {
+        auto const axis = glm::normalize(glm::vec3(angle(gen), angle(gen), 1.0f));
+        pose.qRotation = glm::normalize(glm::angleAxis(angle(gen), axis) * pose.qRotation);
+        sample.joints[i] = pose;
+      }
+    }
+    skeleton->clips.push_back(clip);
+  }
+
+  return skeleton;
+}
+
+// ----------------------------------------------------------------------------
+
+// Former per-joint path, blending two clips into the skinning data.
+struct ScalarReference {
+  JointBuffer_t<JointPose_t>    local_pose;
+  JointBuffer_t<glm::mat4>      global_pose_matrices;
+  JointBuffer_t<glm::mat3x4>    skinning_matrices;
+  JointBuffer_t<glm::dualquat>  dual_quaternions;
+
+  void evaluate(Skeleton const& skeleton, float const weights[2], int32_t frame_a, int32_t frame_b, float factor) {
+    int32_t const njoints = skeleton.njoints();
+    local_pose.resize(njoints);
+    global_pose_matrices.resize(njoints);
+    skinning_matrices.resize(njoints);
+    dual_quaternions.resize(njoints);
+
+    // Sample and blend the clips, flipping the rotations to the first clip hemisphere.
+    for (int32_t i = 0; i < njoints; ++i) {
+      JointPose_t sampled[2];
+      for (int32_t c = 0; c < 2; ++c) {
+        auto const& J1 = skeleton.clips[c].samples[frame_a].joints[i];
+        auto const& J2 = skeleton.clips[c].samples[frame_b].joints[i];
+        sampled[c].qRotation    = glm::shortMix( J1.qRotation,    J2.qRotation,    factor);
+        sampled[c].vTranslation =      glm::mix( J1.vTranslation, J2.vTranslation, factor);
+      }
+      float const sign_q = (glm::dot(sampled[0].qRotation, sampled[1].qRotation) < 0.0f) ? -1.0f : 1.0f;
+
+      auto &dst = local_pose[i];
+      dst.qRotation    = glm::normalize( weights[0] * sampled[0].qRotation + (sign_q * weights[1]) * sampled[1].qRotation );
+      dst.vTranslation = weights[0] * sampled[0].vTranslation + weights[1] * sampled[1].vTranslation;
+    }
+
+    // Global matrices.
+    for (int32_t i = 0; i < njoints; ++i) {
+      auto const& joint = local_pose[i];
+      global_pose_matrices[i] = glm::translate(glm::mat4(1.0f), joint.vTranslation) * glm::mat4_cast(joint.qRotation);
+    }
+    global_pose_matrices[0] = skeleton.root_parent_matrix * global_pose_matrices[0];
+    for (int32_t i = 1; i < njoints; ++i) {
+      global_pose_matrices[i] = global_pose_matrices[skeleton.parents[i]] * global_pose_matrices[i];
+    }
+
+    // Skinning data.
+    for (int32_t i = 0; i < njoints; ++i) {
+      glm::mat4 const skin_matrix{ global_pose_matrices[i] * skeleton.inverse_bind_matrices[i] };
+      skinning_matrices[i] = glm::mat3x4(glm::transpose(skin_matrix));
+      dual_quaternions[i]  = glm::dualquat(skinning_matrices[i]);
+    }
+  }
+};
+
+} // namespace
+
+// ----------------------------------------------------------------------------
+
+int main() {
+  std::mt19937 gen(42u);
+
+  printf("%8s %12s %12s %8s %12s\n", "joints", "scalar (us)", "simd (us)", "speedup", "max error");
+
+  for (int32_t const njoints : { 64, 256, 1024 }) {
+    auto skeleton = CreateSkeleton(njoints, gen);
+
+    float const weights[2]{ 0.6f, 0.4f };
+    Sequence_t sequence;
+    for (int32_t c = 0; c < 2; ++c) {
+      SequenceClip_t sc(&skeleton->clips[c]);
+      sc.weight = weights[c];
+      sequence.push_back(sc);
+    }
+
+    float const lerped_frame = kGlobalTime * (kNumFrames / kDuration);
+    int32_t const frame_a = static_cast<int32_t>(lerped_frame);
+    float const factor = lerped_frame - static_cast<float>(frame_a);
+
+    // Scalar reference.
+    ScalarReference reference;
+    double const scalar_ms = test::Measure([&] {
+      for (int32_t run = 0; run < kNumRuns; ++run) {
+        reference.evaluate(*skeleton, weights, frame_a, frame_a + 1, factor);
+      }
+    });
+
+    // Controller kernels.
+    SkeletonController controller;
+    JointBuffer_t<glm::mat3x4> skinning_matrices(njoints);
+    JointBuffer_t<glm::dualquat> dual_quaternions(njoints);
+    double const simd_ms = test::Measure([&] {
+      for (int32_t run = 0; run < kNumRuns; ++run) {
+        controller.prepare(SkinningMode::DualQuaternion, skeleton, kGlobalTime, sequence);
+        for (int32_t block = 0; block < controller.nblocks(); ++block) {
+          controller.evaluate_local_pose(block);
+        }
+        controller.generate_global_pose_matrices();
+        for (int32_t block = 0; block < controller.nblocks(); ++block) {
+          controller.generate_skinning_data(block, skinning_matrices.data(), dual_quaternions.data());
+        }
+      }
+    });
+
+    // (nlerp differs slightly from the reference slerp between the frames)
+    float max_error = 0.0f;
+    for (int32_t i = 0; i < njoints; ++i) {
+      for (int32_t r = 0; r < 3; ++r) {
+        for (int32_t c = 0; c < 4; ++c) {
+          max_error = std::max(max_error, glm::abs(skinning_matrices[i][r][c] - reference.skinning_matrices[i][r][c]));
+        }
+      }
+    }
+
+    double const to_us = 1000.0 / kNumRuns;
+    printf("%8d %12.2f %12.2f %7.2fx %12.2e\n",
+      njoints, scalar_ms * to_us, simd_ms * to_us, scalar_ms / simd_ms, static_cast<double>(max_error)
+    );
+  }
+
+  return EXIT_SUCCESS;
+}
+
+// ----------------------------------------------------------------------------
@@ -0,0 +1,48 @@
+#ifndef BARBU_TESTS_COMMON_H_
+#define BARBU_TESTS_COMMON_H_
+
+#include <chrono>
+#include <cstdio>
+
+// ----------------------------------------------------------------------------
+//
+// Minimal helpers shared by the headless tests and the benchmarks.
+//
+// ----------------------------------------------------------------------------
+
+namespace test {
+
+/* Number of failed checks, returned by the tests main. */
+inline int& Failures() {
+  static int count = 0;
+  return count;
+}
+
+/* Return the elapsed time of a function in milliseconds, best of a few runs. */
+template<typename F>
+double Measure(F func, int const nruns = 5) {
+  using clock = std::chrono::steady_clock;
+  double best = 0.0;
+  for (int i = 0; i < nruns; ++i) {
+    auto const start = clock::now();
+    func();
+    double const ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+    best = (i == 0) ? ms : (ms < best ? ms : best);
+  }
+  return best;
+}
+
+} // namespace test
+
+// Report a failed condition without stopping the test.
+#define CHECK(cond) \
+  do { \
+    if (!(cond)) { \
+      fprintf(stderr, "%s:%d : check failed : %s\n", __FILE__, __LINE__, #cond); \
+      ++test::Failures(); \
+    } \
+  } while (0)
+
+// ----------------------------------------------------------------------------
+
+#endif // BARBU_TESTS_COMMON_H_
@@ -0,0 +1,203 @@
+// ----------------------------------------------------------------------------
+//
+// Check the AABBTree queries against a brute force scan of its leaves, while
+// inserting, moving and removing random boxes.
+//
+// ----------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "glm/gtc/matrix_transform.hpp"
+
+#include "common.h"
+#include "utils/aabb_tree.h"
+
+namespace {
+
+constexpr int32_t kNumObjects = 10000;
+constexpr int32_t kNumQueries = 64;
+constexpr float   kWorldSize  = 200.0f;
+
+struct Object_t {
+  BoundingBox_t box;
+  int32_t proxy = AABBTree::kNull;
+};
+
+/// Random box in the world, with extents up to max_extent.
+BoundingBox_t RandomBox(std::mt19937 &gen, float const max_extent) {
+  std::uniform_real_distribution<float> position(-kWorldSize, kWorldSize);
+  std::uniform_real_distribution<float> extent(0.05f, max_extent);
+  glm::vec3 const c(position(gen), position(gen), position(gen));
+  glm::vec3 const e(extent(gen), extent(gen), extent(gen));
+  return { c - e, c + e };
+}
+
+/// Random camera frustum looking at the world.
+Frustum_t RandomFrustum(std::mt19937 &gen) {
+  std::uniform_real_distribution<float> position(-kWorldSize, kWorldSize);
+  glm::vec3 const eye(position(gen), position(gen), position(gen));
+  glm::vec3 const target(position(gen), position(gen), position(gen));
+  auto const view = glm::lookAt(eye, target, glm::vec3(0.0f, 1.0f, 0.0f));
+  auto const proj = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, kWorldSize);
+  return Frustum_t(proj * view);
+}
+
+/// Check the results of a query against the expected objects, return false on mismatch.
+bool SameResults(std::vector<int32_t> results, std::vector<int32_t> expected) {
+  std::sort(results.begin(), results.end());
+  std::sort(expected.begin(), expected.end());
+  return results == expected;
+}
+
+/// Compare the tree queries with brute force scans of the objects.
+void CheckQueries(AABBTree const& tree, std::vector<Object_t> const& objects, std::mt19937 &gen) {
+  std::vector<int32_t> results;
+  std::vector<int32_t> expected;
+
+  for (int32_t q = 0; q < kNumQueries; ++q) {
+    // Frustum queries return the objects whose leaf box is not outside.
+    auto const frustum = RandomFrustum(gen);
+    results.clear();
+    tree.query(frustum, results);
+
+    expected.clear();
+    bool bMissing = false;
+    for (int32_t i = 0; i < static_cast<int32_t>(objects.size()); ++i) {
+      auto const& obj = objects[i];
+      if (AABBTree::kNull == obj.proxy) {
+        continue;
+      }
+      if (Frustum_t::Outside != frustum.test(tree.fat_bounds(obj.proxy))) {
+        expected.push_back(i);
+      }
+      // (an object visible by its own box must be reported)
+      if ((Frustum_t::Outside != frustum.test(obj.box))
+       && (std::find(results.begin(), results.end(), i) == results.end())) {
+        bMissing = true;
+      }
+    }
+    CHECK( SameResults(results, expected) );
+    CHECK( !bMissing );
+
+    // Box queries return the objects whose leaf box overlaps.
+    auto const box = RandomBox(gen, 30.0f);
+    results.clear();
+    tree.query(box, results);
+
+    expected.clear();
+    for (int32_t i = 0; i < static_cast<int32_t>(objects.size()); ++i) {
+      auto const& obj = objects[i];
+      if ((AABBTree::kNull != obj.proxy) && box.overlaps(tree.fat_bounds(obj.proxy))) {
+        expected.push_back(i);
+      }
+    }
+    CHECK( SameResults(results, expected) );
+  }
+}
+
+/// Check every live object is stored in a leaf containing its box.
+void CheckLeaves(AABBTree const& tree, std::vector<Object_t> const& objects) {
+  int32_t nobjects = 0;
+  bool bValid = true;
+  for (int32_t i = 0; i < static_cast<int32_t>(objects.size()); ++i) {
+    auto const& obj = objects[i];
+    if (AABBTree::kNull == obj.proxy) {
+      continue;
+    }
+    ++nobjects;
+    bValid = bValid
+          && (tree.user_data(obj.proxy) == i)
+          && tree.fat_bounds(obj.proxy).contains(obj.box);
+  }
+  CHECK( bValid );
+  CHECK( tree.size() == nobjects );
+
+  // The tree must stay balanced.
+  float const max_height = 2.0f * std::log2(static_cast<float>(std::max(nobjects, 2))) + 2.0f;
+  CHECK( static_cast<float>(tree.height()) <= max_height );
+}
+
+} // namespace
+
+// ----------------------------------------------------------------------------
+
+int main() {
+  std::mt19937 gen(7u);
+
+  AABBTree tree;
+  std::vector<Object_t> objects(kNumObjects);
+
+  // Empty tree.
+  {
+    std::vector<int32_t> results;
+    tree.query(RandomFrustum(gen), results);
+    tree.query(RandomBox(gen, 10.0f), results);
+    CHECK( results.empty() );
+    CHECK( 0 == tree.height() );
+  }
+
+  // Insertion.
+  for (int32_t i = 0; i < kNumObjects; ++i) {
+    auto &obj = objects[i];
+    obj.box   = RandomBox(gen, 4.0f);
+    obj.proxy = tree.insert(obj.box, i);
+  }
+  CheckLeaves(tree, objects);
+  CheckQueries(tree, objects, gen);
+
+  // Motion : small moves keep their leaf, large ones are re-inserted.
+  {
+    std::uniform_real_distribution<float> jitter(-0.004f, 0.004f);
+    std::uniform_real_distribution<float> offset(-20.0f, 20.0f);
+
+    int32_t nsmall_reinserted = 0;
+    int32_t nlarge_reinserted = 0;
+    for (int32_t i = 0; i < kNumObjects; ++i) {
+      auto &obj = objects[i];
+      bool const bLarge = (0 == (i % 8));
+      glm::vec3 const delta = bLarge ? glm::vec3(offset(gen) + 40.0f, offset(gen), offset(gen))
+                                     : glm::vec3(jitter(gen), jitter(gen), jitter(gen));
+      obj.box = { obj.box.min + delta, obj.box.max + delta };
+      bool const bReinserted = tree.move(obj.proxy, obj.box);
+      nsmall_reinserted += (!bLarge && bReinserted) ? 1 : 0;
+      nlarge_reinserted += (bLarge && bReinserted) ? 1 : 0;
+    }
+    CHECK( 0 == nsmall_reinserted );
+    CHECK( (kNumObjects + 7) / 8 == nlarge_reinserted );
+  }
+  CheckLeaves(tree, objects);
+  CheckQueries(tree, objects, gen);
+
+  // Removal then re-insertion, reusing the released nodes.
+  for (int32_t i = 0; i < kNumObjects; i += 2) {
+    tree.remove(objects[i].proxy);
+    objects[i].proxy = AABBTree::kNull;
+  }
+  CheckLeaves(tree, objects);
+  CheckQueries(tree, objects, gen);
+
+  for (int32_t i = 0; i < kNumObjects; i += 4) {
+    auto &obj = objects[i];
+    obj.box   = RandomBox(gen, 4.0f);
+    obj.proxy = tree.insert(obj.box, i);
+  }
+  CheckLeaves(tree, objects);
+  CheckQueries(tree, objects, gen);
+
+  // Clear.
+  tree.clear();
+  CHECK( 0 == tree.size() );
+  CHECK( 0 == tree.height() );
+
+  if (test::Failures() > 0) {
+    fprintf(stderr, "test_aabb_tree : %d check(s) failed.\n", test::Failures());
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
+
+// ----------------------------------------------------------------------------
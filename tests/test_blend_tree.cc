@@ -0,0 +1,116 @@
+// ----------------------------------------------------------------------------
+//
+// Check the state machines crossfades of the blend tree : a synced crossfade
+// enters the new state at the phase of the leading clip of the state left,
+// mapped through the sync markers, while an unsynced one restarts it.
+//
+// ----------------------------------------------------------------------------
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+#include "common.h"
+#include "fx/animation/blend_tree.h"
+
+namespace {
+
+constexpr float kEpsilon = 1.0e-4f;
+
+// Two looping clips of different durations, with two sync markers each.
+struct Clips_t {
+  AnimationClip_t walk{ "walk", 30, 1.0f };
+  AnimationClip_t run{ "run", 18, 0.6f };
+
+  Clips_t(std::vector<float> const& walk_markers, std::vector<float> const& run_markers) {
+    walk.bLoop = true;
+    run.bLoop  = true;
+    walk.sync_markers = walk_markers;
+    run.sync_markers  = run_markers;
+  }
+};
+
+/* Return the sequence clip of an action. */
+SequenceClip_t const& Find(Sequence_t const& sequence, Action_t const* action) {
+  for (auto const& sc : sequence) {
+    if (sc.action_ptr == action) {
+      return sc;
+    }
+  }
+  return sequence.front();
+}
+
+/* Return the phase of a sequence clip at global_time. */
+float Phase(SequenceClip_t const& sc, float const global_time) {
+  float local_time = 0.0f;
+  sc.evaluate_localtime(global_time, local_time);
+  return sc.phase(local_time) - std::floor(sc.phase(local_time));
+}
+
+/* Crossfade a machine of two Clip states from walk to run at global_time,
+ * return the run phase at the start of the crossfade. */
+float Crossfade(Clips_t &clips, bool const bSync, float const global_time) {
+  BlendTree tree;
+  int32_t const machine = tree.add_state_machine(
+    { tree.add_clip(&clips.walk), tree.add_clip(&clips.run) }, 0.25f, bSync
+  );
+  if (!tree.compile(machine)) {
+    CHECK( false );
+    return -1.0f;
+  }
+
+  BlendTreeState_t state;
+  Sequence_t sequence;
+  tree.init(state, sequence);
+
+  tree.evaluate(state, 0.0f, sequence);
+  tree.evaluate(state, 0.5f * global_time, sequence);
+
+  tree.request_state(state, machine, 1);
+  tree.evaluate(state, global_time, sequence);
+
+  // (the run clip has no weight yet, but its start is already set)
+  CHECK( Find(sequence, &clips.walk).bEnable );
+
+  return Phase(Find(sequence, &clips.run), global_time);
+}
+
+} // namespace
+
+// ----------------------------------------------------------------------------
+
+int main() {
+  // Identical markers : the entered clip takes the phase of the leader.
+  {
+    Clips_t clips({ 0.0f, 0.5f }, { 0.0f, 0.5f });
+    float const walk_phase = 0.3f;
+    float const phase = Crossfade(clips, true, 2.0f + walk_phase);
+    CHECK( std::fabs(phase - walk_phase) < kEpsilon );
+  }
+
+  // Shifted markers : the phase keeps its relative position in the markers segment.
+  {
+    Clips_t clips({ 0.0f, 0.5f }, { 0.1f, 0.6f });
+
+    // walk 0.25 is halfway in [0, 0.5], ie. run 0.35 halfway in [0.1, 0.6].
+    float phase = Crossfade(clips, true, 1.25f);
+    CHECK( std::fabs(phase - 0.35f) < kEpsilon );
+
+    // walk 0.75 is halfway in the wrapping segment [0.5, 1.0], ie. run 0.85.
+    phase = Crossfade(clips, true, 1.75f);
+    CHECK( std::fabs(phase - 0.85f) < kEpsilon );
+  }
+
+  // Unsynced crossfade : the entered clip restarts.
+  {
+    Clips_t clips({ 0.0f, 0.5f }, { 0.1f, 0.6f });
+    float const phase = Crossfade(clips, false, 1.25f);
+    CHECK( std::fabs(phase) < kEpsilon );
+  }
+
+  if (test::Failures() > 0) {
+    fprintf(stderr, "test_blend_tree : %d check(s) failed.\n", test::Failures());
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
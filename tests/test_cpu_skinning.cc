@@ -0,0 +1,235 @@
+// ----------------------------------------------------------------------------
+//
+// Check the host skinning against a scalar transcription of the vertex shader
+// (shaders/shared/inc_skinning.glsl) on random meshes and palettes, in both
+// skinning modes, and that the skinned bounds contain the skinned vertices.
+//
+// ----------------------------------------------------------------------------
+
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "common.h"
+#include "fx/animation/cpu_skinning.h"
+
+namespace {
+
+constexpr int32_t  kNumJoints   = 13;
+constexpr int32_t  kNumVertices = 4096;
+constexpr int32_t  kNumPalettes = 8;
+constexpr uint32_t kNoJoint     = 0xff;
+constexpr float    kEpsilon     = 1.0e-4f;
+
+/// Random mesh skinned to kNumJoints joints, with up to four influences per
+/// vertex, some unused (kNoJoint) and some vertices left unskinned.
+void RandomMesh(std::mt19937 &gen, MeshData &mesh) {
+  std::uniform_real_distribution<float> position(-1.0f, 1.0f);
+  std::uniform_real_distribution<float> weight(0.05f, 1.0f);
+  std::uniform_int_distribution<uint32_t> joint(0u, kNumJoints - 1u);
+  std::uniform_int_distribution<int32_t> influences(0, 4);
+
+  mesh.skeleton = std::make_shared<Skeleton>(kNumJoints);
+  for (int32_t i = 0; i < kNumJoints; ++i) {
+    mesh.skeleton->add_joint("joint" + std::to_string(i), i - 1, glm::mat4(1.0f));
+  }
+
+  mesh.vertices.resize(kNumVertices);
+  mesh.skinnings.resize(kNumVertices);
+  for (int32_t i = 0; i < kNumVertices; ++i) {
+    auto &v = mesh.vertices[i];
+    v.position = glm::vec3(position(gen), position(gen), position(gen));
+    v.texcoord = glm::vec2(0.0f);
+    v.normal   = glm::normalize(glm::vec3(position(gen), position(gen), position(gen)) + glm::vec3(0.0f, 2.0f, 0.0f));
+    v.tangent  = glm::vec4(glm::normalize(glm::cross(v.normal, glm::vec3(0.0f, 0.0f, 1.0f))), 1.0f);
+
+    // Normalized weights, the unused influences referencing no joint (the last
+    // weight is left empty, being derived from the others).
+    int32_t const n = influences(gen);
+    float w[4]{};
+    float sum = 0.0f;
+    for (int32_t k = 0; k < n; ++k) {
+      w[k] = weight(gen);
+      sum += w[k];
+    }
+    auto &s = mesh.skinnings[i];
+    for (int32_t k = 0; k < 4; ++k) {
+      s.joint_indices[k]  = (k < n) ? joint(gen) : kNoJoint;
+      s.joint_weights[k] = (k < n) && (k < 3) ? w[k] / sum : 0.0f;
+    }
+  }
+}
+
+/// Random rotation.
+glm::quat RandomRotation(std::mt19937 &gen) {
+  std::normal_distribution<float> normal;
+  return glm::normalize(glm::quat(normal(gen), normal(gen), normal(gen), normal(gen)));
+}
+
+/// Random palettes : affine skinning matrices with non uniform scales, and
+/// rigid dual quaternions.
+void RandomPalettes(std::mt19937 &gen, std::vector<glm::mat3x4> &matrices, std::vector<glm::dualquat> &dual_quaternions) {
+  std::uniform_real_distribution<float> translation(-2.0f, 2.0f);
+  std::uniform_real_distribution<float> scale(0.5f, 1.5f);
+
+  matrices.resize(kNumJoints);
+  dual_quaternions.resize(kNumJoints);
+  for (int32_t i = 0; i < kNumJoints; ++i) {
+    glm::vec3 const t(translation(gen), translation(gen), translation(gen));
+    glm::vec3 const s(scale(gen), scale(gen), scale(gen));
+
+    // Transposed, with the translation last, as sent to the shader.
+    glm::mat4 const R = glm::mat4_cast(RandomRotation(gen));
+    for (int32_t r = 0; r < 3; ++r) {
+      matrices[i][r] = glm::vec4(R[0][r] * s.x, R[1][r] * s.y, R[2][r] * s.z, t[r]);
+    }
+
+    glm::quat const q = RandomRotation(gen);
+    glm::quat const d = glm::quat(0.0f, t.x, t.y, t.z) * q;
+    dual_quaternions[i].real = q;
+    dual_quaternions[i].dual = glm::quat(0.5f * d.w, 0.5f * d.x, 0.5f * d.y, 0.5f * d.z);
+  }
+}
+
+/// Linear blend skinning of a vertex, as skinning_LBS.
+void ReferenceLBS(std::vector<glm::mat3x4> const& matrices, MeshData::Skinning_t const& skinning, glm::vec3 &v, glm::vec3 &n) {
+  glm::vec4 w = skinning.joint_weights;
+  w.w = 1.0f - (w.x + w.y + w.z);
+
+  glm::mat3x4 const identity(1.0f);
+  glm::vec3 sv(0.0f), sn(0.0f);
+  for (int32_t k = 0; k < 4; ++k) {
+    uint32_t const joint_id = skinning.joint_indices[k];
+    for (int32_t r = 0; r < 3; ++r) {
+      glm::vec4 const& row = (kNoJoint == joint_id) ? identity[r] : matrices[joint_id][r];
+      sv[r] += w[k] * (row.x * v.x + row.y * v.y + row.z * v.z + row.w);
+      sn[r] += w[k] * (row.x * n.x + row.y * n.y + row.z * n.z);
+    }
+  }
+  v = sv;
+  n = glm::normalize(sn);
+}
+
+/// Dual quaternion skinning of a vertex, as skinning_DQBS.
+void ReferenceDQS(std::vector<glm::dualquat> const& dual_quaternions, MeshData::Skinning_t const& skinning, glm::vec3 &v, glm::vec3 &n) {
+  glm::vec4 w = skinning.joint_weights;
+  w.w = 1.0f - (w.x + w.y + w.z);
+
+  glm::vec4 Ma[4], Mb[4];
+  for (int32_t k = 0; k < 4; ++k) {
+    uint32_t const joint_id = skinning.joint_indices[k];
+    glm::quat const real = (kNoJoint == joint_id) ? glm::quat(1.0f, 0.0f, 0.0f, 0.0f) : dual_quaternions[joint_id].real;
+    glm::quat const dual = (kNoJoint == joint_id) ? glm::quat(0.0f, 0.0f, 0.0f, 0.0f) : dual_quaternions[joint_id].dual;
+    Ma[k] = glm::vec4(real.x, real.y, real.z, real.w);
+    Mb[k] = glm::vec4(dual.x, dual.y, dual.z, dual.w);
+  }
+
+  // Antipodality.
+  for (int32_t k = 0; k < 3; ++k) {
+    w[k] *= (glm::dot(Ma[3], Ma[k]) < 0.0f) ? -1.0f : 1.0f;
+  }
+
+  glm::vec4 A(0.0f), B(0.0f);
+  for (int32_t k = 0; k < 4; ++k) {
+    A += w[k] * Ma[k];
+    B += w[k] * Mb[k];
+  }
+  float const inv_norm = 1.0f / std::sqrt(glm::dot(A, A));
+  A *= inv_norm;
+  B *= inv_norm;
+
+  glm::vec3 const a(A.x, A.y, A.z);
+  glm::vec3 const b(B.x, B.y, B.z);
+  v += 2.0f * glm::cross(a, glm::cross(a, v) + A.w * v);
+  v += 2.0f * (A.w * b - B.w * a + glm::cross(a, b));
+  n += 2.0f * glm::cross(a, glm::cross(a, n) + A.w * n);
+  n = glm::normalize(n);
+}
+
+/// Return true when two vectors are equal within kEpsilon per component.
+bool Near(glm::vec3 const& a, glm::vec3 const& b) {
+  return (std::fabs(a.x - b.x) < kEpsilon)
+      && (std::fabs(a.y - b.y) < kEpsilon)
+      && (std::fabs(a.z - b.z) < kEpsilon);
+}
+
+/// Return true when a point is inside a box, within kEpsilon.
+bool Inside(BoundingBox_t const& box, glm::vec3 const& p) {
+  for (int32_t r = 0; r < 3; ++r) {
+    if ((p[r] < box.min[r] - kEpsilon) || (p[r] > box.max[r] + kEpsilon)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/// Skin the mesh in a mode and compare every vertex with the reference, return
+/// the number of mismatching vertices.
+int32_t CheckSkinning(MeshData const& mesh,
+                      SkinningMode const mode,
+                      std::vector<glm::mat3x4> const& matrices,
+                      std::vector<glm::dualquat> const& dual_quaternions,
+                      std::vector<MeshData::Vertex_t> &skinned) {
+  bool const bDualQuaternion = (SkinningMode::DualQuaternion == mode);
+
+  skinned.resize(mesh.nvertices());
+  CHECK( SkinVertices(mesh, mode, matrices.data(), dual_quaternions.data(), skinned.data()) );
+
+  int32_t mismatches = 0;
+  for (int32_t i = 0; i < mesh.nvertices(); ++i) {
+    auto const& src = mesh.vertices[i];
+    auto const& skinning = mesh.skinnings[i];
+
+    // (the shader leaves the vertices without influence untouched)
+    glm::vec3 v = src.position;
+    glm::vec3 n = src.normal;
+    if (skinning.joint_weights.x > 0.0f) {
+      if (bDualQuaternion) {
+        ReferenceDQS(dual_quaternions, skinning, v, n);
+      } else {
+        ReferenceLBS(matrices, skinning, v, n);
+      }
+    }
+    mismatches += (Near(skinned[i].position, v) && Near(skinned[i].normal, n)) ? 0 : 1;
+  }
+  return mismatches;
+}
+
+} // namespace
+
+// ----------------------------------------------------------------------------
+
+int main() {
+  std::mt19937 gen(0x5c1d);
+
+  MeshData mesh;
+  RandomMesh(gen, mesh);
+  CHECK( CalculateJointBounds(mesh, *mesh.skeleton) );
+
+  std::vector<glm::mat3x4> matrices;
+  std::vector<glm::dualquat> dual_quaternions;
+  std::vector<MeshData::Vertex_t> skinned;
+
+  for (int32_t i = 0; i < kNumPalettes; ++i) {
+    RandomPalettes(gen, matrices, dual_quaternions);
+
+    CHECK( 0 == CheckSkinning(mesh, SkinningMode::DualQuaternion, matrices, dual_quaternions, skinned) );
+    CHECK( 0 == CheckSkinning(mesh, SkinningMode::LinearBlending, matrices, dual_quaternions, skinned) );
+
+    // The linear blend skinned vertices are within the skinned bounds.
+    BoundingBox_t const bounds = CalculateSkinnedBounds(*mesh.skeleton, matrices.data());
+    int32_t outside = 0;
+    for (auto const& v : skinned) {
+      outside += Inside(bounds, v.position) ? 0 : 1;
+    }
+    CHECK( 0 == outside );
+  }
+
+  if (test::Failures() > 0) {
+    fprintf(stderr, "test_cpu_skinning : %d check(s) failed.\n", test::Failures());
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
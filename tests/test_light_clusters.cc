@@ -0,0 +1,267 @@
+// ----------------------------------------------------------------------------
+//
+// Check the host reference of the clustered lights assignment on known cases,
+// and the clusters indexing used by the shaders against the clusters bounds.
+//
+// ----------------------------------------------------------------------------
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "glm/gtc/matrix_transform.hpp"
+
+#include "common.h"
+#include "fx/light_clusters.h"
+
+namespace {
+
+constexpr int32_t kWidth  = 1600;
+constexpr int32_t kHeight = 900;
+constexpr float   kAspect = static_cast<float>(kWidth) / static_cast<float>(kHeight);
+constexpr float   kZNear  = 0.1f;
+constexpr float   kZFar   = 100.0f;
+
+// Clusters of a camera at the origin looking down -Z, with a 90 degrees vertical fov.
+struct Clusters_t {
+  glm::mat4 proj;
+  LightClustersUniforms_t uniforms{};
+  std::vector<ClusterBounds_t> bounds;
+  std::vector<uint32_t> counts;
+  std::vector<uint32_t> indices;
+
+  Clusters_t() {
+    proj = glm::perspective(glm::radians(90.0f), kAspect, kZNear, kZFar);
+    LightClusters::ComputeClusterBounds(proj, kWidth, kHeight, kZNear, kZFar, bounds);
+
+    // (as LightClusters::setupClusters)
+    float const log_depth_range = std::log(kZFar / kZNear);
+    uniforms.viewMatrix = glm::mat4(1.0f);
+    uniforms.tileSize   = glm::vec2(
+      (kWidth  + CLUSTER_GRID_X - 1) / CLUSTER_GRID_X,
+      (kHeight + CLUSTER_GRID_Y - 1) / CLUSTER_GRID_Y
+    );
+    uniforms.sliceScale = CLUSTER_GRID_Z / log_depth_range;
+    uniforms.sliceBias  = - CLUSTER_GRID_Z * std::log(kZNear) / log_depth_range;
+  }
+
+  /* Assign the lights, the directional ones coming first. */
+  void assign(std::vector<LightInfo_t> const& lights) {
+    uniforms.numLights = static_cast<int32_t>(lights.size());
+    uniforms.numDirectionals = static_cast<int32_t>(std::count_if(lights.begin(), lights.end(), [](auto const& light) {
+      return LIGHT_TYPE_DIRECTIONAL == static_cast<int32_t>(light.position.w);
+    }));
+    LightClusters::AssignLights(uniforms, lights, bounds, counts, indices);
+  }
+
+  /* Return the cluster of a view-space point, as get_cluster_index in inc_clusters.glsl. */
+  int32_t cluster(glm::vec3 const& p) const {
+    glm::vec4 const clip = proj * glm::vec4(p, 1.0f);
+    glm::vec2 const frag_coord = (0.5f * glm::vec2(clip) / clip.w + 0.5f) * glm::vec2(kWidth, kHeight);
+
+    float const view_depth = -p.z;
+    int32_t const slice = static_cast<int32_t>(std::floor(std::log(view_depth) * uniforms.sliceScale + uniforms.sliceBias));
+    int32_t const x = std::clamp(static_cast<int32_t>(std::floor(frag_coord.x / uniforms.tileSize.x)), 0, CLUSTER_GRID_X - 1);
+    int32_t const y = std::clamp(static_cast<int32_t>(std::floor(frag_coord.y / uniforms.tileSize.y)), 0, CLUSTER_GRID_Y - 1);
+    int32_t const z = std::clamp(slice, 0, CLUSTER_GRID_Z - 1);
+
+    return x + CLUSTER_GRID_X * (y + CLUSTER_GRID_Y * z);
+  }
+
+  /* Return the lights indexed by a cluster. */
+  std::vector<uint32_t> lights(int32_t const cluster) const {
+    auto const first = indices.begin() + cluster * LightClusters::kMaxClusterLights;
+    return std::vector<uint32_t>(first, first + counts[cluster]);
+  }
+
+  uint32_t total() const {
+    return std::accumulate(counts.begin(), counts.end(), 0u);
+  }
+};
+
+/// Return the view-space point at the given normalized device coordinates and view depth.
+glm::vec3 ViewPoint(float const ndc_x, float const ndc_y, float const depth) {
+  // (tan(fov / 2) is 1)
+  return glm::vec3(ndc_x * depth * kAspect, ndc_y * depth, -depth);
+}
+
+/// Return the view depth at a fraction of a slice.
+float SliceDepth(int32_t const slice, float const fraction) {
+  return kZNear * std::pow(kZFar / kZNear, (static_cast<float>(slice) + fraction) / CLUSTER_GRID_Z);
+}
+
+LightInfo_t DirectionalLight() {
+  LightInfo_t light{};
+  light.position  = glm::vec4(0.0f, 10.0f, 0.0f, LIGHT_TYPE_DIRECTIONAL);
+  light.direction = glm::vec4(0.0f, -1.0f, 0.0f, 0.0f);
+  light.color     = glm::vec4(1.0f);
+  return light;
+}
+
+LightInfo_t PointLight(glm::vec3 const& position, float const range) {
+  LightInfo_t light{};
+  light.position = glm::vec4(position, LIGHT_TYPE_POINT);
+  light.color    = glm::vec4(1.0f);
+  light.params   = glm::vec4(range, 0.0f, 0.0f, 0.0f);
+  return light;
+}
+
+LightInfo_t SpotLight(glm::vec3 const& position, glm::vec3 const& direction, float const range, float const outer_angle) {
+  LightInfo_t light{};
+  light.position  = glm::vec4(position, LIGHT_TYPE_SPOT);
+  light.direction = glm::vec4(direction, 0.0f);
+  light.color     = glm::vec4(1.0f);
+  light.params    = glm::vec4(range, std::cos(outer_angle), 1.0f, 0.0f);
+  return light;
+}
+
+// ----------------------------------------------------------------------------
+
+/// The shader clusters indexing must match the clusters bounds.
+void TestClusterBounds(Clusters_t const& clusters) {
+  CHECK( clusters.bounds.size() == static_cast<size_t>(LightClusters::kNumClusters) );
+
+  std::mt19937 gen(5u);
+  std::uniform_real_distribution<float> ndc(-0.999f, 0.999f);
+  std::uniform_real_distribution<float> log_depth(std::log(kZNear) + 1e-3f, std::log(kZFar) - 1e-3f);
+
+  int32_t noutside = 0;
+  for (int32_t i = 0; i < 10000; ++i) {
+    glm::vec3 const p = ViewPoint(ndc(gen), ndc(gen), std::exp(log_depth(gen)));
+    auto const& box = clusters.bounds[clusters.cluster(p)];
+
+    float const eps = 1e-4f * std::max(1.0f, -p.z);
+    bool const bInside = glm::all(glm::lessThanEqual(glm::vec3(box.minPoint) - eps, p))
+                      && glm::all(glm::lessThanEqual(p, glm::vec3(box.maxPoint) + eps));
+    noutside += bInside ? 0 : 1;
+  }
+  CHECK( 0 == noutside );
+}
+
+/// A small light on a tile boundary belongs to the clusters on both sides only.
+void TestBoundaryLight(Clusters_t &clusters) {
+  int32_t const slice = 12;
+  float const depth = SliceDepth(slice, 0.5f);
+  float const tile_width = depth * kAspect * 2.0f / CLUSTER_GRID_X;
+
+  // On the boundary between the tiles 8 and 9, at the center of the row 4.
+  float const boundary_ndc = -1.0f + 2.0f * 9.0f / CLUSTER_GRID_X;
+  glm::vec3 const position = ViewPoint(boundary_ndc, 0.0f, depth);
+  clusters.assign({ DirectionalLight(), PointLight(position, 0.25f * tile_width) });
+
+  // (the point light comes after the directional one)
+  std::vector<uint32_t> const expected{ 1u };
+  glm::vec3 const dx(0.25f * tile_width, 0.0f, 0.0f);
+  CHECK( clusters.lights(clusters.cluster(position - dx)) == expected );
+  CHECK( clusters.lights(clusters.cluster(position + dx)) == expected );
+
+  // Farther clusters, in every directions.
+  CHECK( clusters.lights(clusters.cluster(position - 6.0f * dx)).empty() );
+  CHECK( clusters.lights(clusters.cluster(position + 6.0f * dx)).empty() );
+  CHECK( clusters.lights(clusters.cluster(ViewPoint(boundary_ndc + 0.01f, 0.5f, depth))).empty() );
+  CHECK( clusters.lights(clusters.cluster(ViewPoint(boundary_ndc + 0.01f, 0.0f, SliceDepth(slice + 2, 0.5f)))).empty() );
+  CHECK( clusters.lights(clusters.cluster(ViewPoint(boundary_ndc + 0.01f, 0.0f, SliceDepth(slice - 2, 0.5f)))).empty() );
+
+  // The directional light is never clustered.
+  bool bDirectional = false;
+  for (int32_t cluster = 0; cluster < LightClusters::kNumClusters; ++cluster) {
+    auto const lights = clusters.lights(cluster);
+    bDirectional = bDirectional || (std::find(lights.begin(), lights.end(), 0u) != lights.end());
+  }
+  CHECK( !bDirectional );
+}
+
+/// Lights behind the near plane are only assigned when their range reaches the frustum.
+void TestLightBehindNearPlane(Clusters_t &clusters) {
+  clusters.assign({ PointLight(glm::vec3(0.0f, 0.0f, 5.0f), 2.0f) });
+  CHECK( 0u == clusters.total() );
+
+  clusters.assign({ PointLight(glm::vec3(0.0f, 0.0f, 0.05f), 0.5f) });
+  std::vector<uint32_t> const expected{ 0u };
+  CHECK( clusters.lights(clusters.cluster(ViewPoint(0.01f, 0.01f, SliceDepth(0, 0.5f)))) == expected );
+  CHECK( clusters.lights(clusters.cluster(ViewPoint(0.01f, 0.01f, 1.0f))).empty() );
+}
+
+/// Spot lights are bounded along their cone, narrow and wide ones alike.
+void TestSpotLight(Clusters_t &clusters) {
+  glm::vec3 const position(0.0f, 0.0f, -1.0f);
+  glm::vec3 const direction(0.0f, 0.0f, -1.0f);
+  float const range = 20.0f;
+
+  glm::vec3 const on_axis(0.01f, 0.01f, -10.0f);
+  glm::vec3 const lateral(-17.0f, 0.01f, -10.0f);
+  glm::vec3 const behind(0.01f, 0.01f, -0.5f);
+  glm::vec3 const beyond(0.01f, 0.01f, -40.0f);
+  std::vector<uint32_t> const expected{ 0u };
+
+  // Narrow cone.
+  clusters.assign({ SpotLight(position, direction, range, 0.2f) });
+  CHECK( clusters.lights(clusters.cluster(on_axis)) == expected );
+  CHECK( clusters.lights(clusters.cluster(lateral)).empty() );
+  CHECK( clusters.lights(clusters.cluster(behind)).empty() );
+  CHECK( clusters.lights(clusters.cluster(beyond)).empty() );
+  uint32_t const narrow_total = clusters.total();
+
+  // Wide cone.
+  clusters.assign({ SpotLight(position, direction, range, 1.2f) });
+  CHECK( clusters.lights(clusters.cluster(on_axis)) == expected );
+  CHECK( clusters.lights(clusters.cluster(lateral)) == expected );
+  CHECK( clusters.lights(clusters.cluster(beyond)).empty() );
+  uint32_t const wide_total = clusters.total();
+
+  // A point light of the same range reaches the clusters behind its position.
+  clusters.assign({ PointLight(position, range) });
+  CHECK( clusters.lights(clusters.cluster(behind)) == expected );
+  CHECK( clusters.lights(clusters.cluster(lateral)) == expected );
+
+  CHECK( narrow_total < wide_total );
+  CHECK( narrow_total < clusters.total() );
+}
+
+/// Clusters keep their first lights once their slots are full.
+void TestSlotOverflow(Clusters_t &clusters) {
+  glm::vec3 const position(0.01f, 0.01f, -10.0f);
+
+  int32_t const nlights = LightClusters::kMaxClusterLights + 16;
+  std::vector<LightInfo_t> lights{ DirectionalLight() };
+  for (int32_t i = 0; i < nlights; ++i) {
+    lights.push_back(PointLight(position, 1.0f));
+  }
+  clusters.assign(lights);
+
+  int32_t const cluster = clusters.cluster(position);
+  CHECK( clusters.counts[cluster] == static_cast<uint32_t>(LightClusters::kMaxClusterLights) );
+
+  std::vector<uint32_t> expected(LightClusters::kMaxClusterLights);
+  std::iota(expected.begin(), expected.end(), 1u);
+  CHECK( clusters.lights(cluster) == expected );
+
+  for (auto const count : clusters.counts) {
+    CHECK( count <= static_cast<uint32_t>(LightClusters::kMaxClusterLights) );
+  }
+}
+
+} // namespace
+
+// ----------------------------------------------------------------------------
+
+int main() {
+  Clusters_t clusters;
+
+  TestClusterBounds(clusters);
+  TestBoundaryLight(clusters);
+  TestLightBehindNearPlane(clusters);
+  TestSpotLight(clusters);
+  TestSlotOverflow(clusters);
+
+  if (test::Failures() > 0) {
+    fprintf(stderr, "test_light_clusters : %d check(s) failed.\n", test::Failures());
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
+
+// ----------------------------------------------------------------------------